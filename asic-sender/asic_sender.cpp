@@ -1,9 +1,13 @@
 #include "../data-analyser/src/core/fpga_logger.h"
 #include "asic_sender.h"
+#include "emulated_fpga_device.h"
+#include "../intan-reader/latency_trace.h"
+#include "../intan-reader/adaptive_quantizer.h"
 #include <unistd.h>
 #include <fcntl.h>
 #include <sys/select.h>
 #include <cstring>
+#include <algorithm>
 #include <chrono>
 #include <iomanip>
 
@@ -11,25 +15,29 @@
 const size_t AsicSender::BUF_LEN = 16384; // Must be multiple of 16 for USB 3.0
 
 AsicSender::AsicSender() : device_(nullptr), running_(false), initialized_(false), data_analyzer_(nullptr) {
-    device_ = new OpalKellyLegacy::okCFrontPanel();
+#ifdef ASIC_EMULATOR_ONLY
+    device_.reset(new EmulatedFpgaDevice());
+#else
+    device_.reset(new OpalKellyFpgaDevice());
+#endif
+}
+
+AsicSender::AsicSender(std::unique_ptr<FpgaDevice> device)
+    : device_(std::move(device)), running_(false), initialized_(false), data_analyzer_(nullptr) {
 }
 
 AsicSender::~AsicSender() {
     stopSending();
-    if (device_) {
-        delete device_;
-        device_ = nullptr;
-    }
 }
 
 bool AsicSender::initialize(const std::string& deviceSerial, const std::string& bitfilePath) {
-    std::cout << "Initializing ASIC Sender..." << std::endl;
+    std::cout << "Initializing ASIC Sender (" << device_->name() << ")..." << std::endl;
     
     // Open device by serial number
-    int error = device_->OpenBySerial(deviceSerial.c_str());
+    int error = device_->openBySerial(deviceSerial);
     std::cout << "OpenBySerial ret value: " << error << std::endl;
     
-    if (error != OpalKellyLegacy::okCFrontPanel::NoError) {
+    if (error != FpgaDevice::NoError) {
         std::cerr << "Failed to open ASIC device with serial: " << deviceSerial << std::endl;
         return false;
     }
@@ -51,27 +59,27 @@ bool AsicSender::initialize(const std::string& deviceSerial, const std::string&
 bool AsicSender::configureFpga(const std::string& bitfilePath) {
     std::cout << "Configuring ASIC FPGA with bitfile: " << bitfilePath << std::endl;
     
-    int error = device_->ConfigureFPGA(bitfilePath.c_str());
+    int error = device_->configureFpga(bitfilePath);
     std::cout << "ConfigureFPGA ret value: " << error << std::endl;
     
-    return (error == OpalKellyLegacy::okCFrontPanel::NoError);
+    return (error == FpgaDevice::NoError);
 }
 
 void AsicSender::resetFifo() {
     std::cout << "Resetting ASIC FIFO..." << std::endl;
     
     // Send reset signal to FIFO
-    device_->SetWireInValue(0x10, 0xff, 0x01);
-    device_->UpdateWireIns();
+    device_->setWireInValue(0x10, 0xff, 0x01);
+    device_->updateWireIns();
     
-    device_->SetWireInValue(0x10, 0x00, 0x01);
-    device_->UpdateWireIns();
+    device_->setWireInValue(0x10, 0x00, 0x01);
+    device_->updateWireIns();
     
     std::cout << "ASIC FIFO reset complete" << std::endl;
 }
 
 bool AsicSender::writeToFpga(const std::vector<uint8_t>& data) {
-    int writeRet = device_->WriteToPipeIn(0x80, data.size(), data.data());
+    int writeRet = device_->writeToPipeIn(0x80, data.size(), data.data());
     
     // Return value is the number of bytes written, not an error code
     return (writeRet > 0);
@@ -80,7 +88,7 @@ bool AsicSender::writeToFpga(const std::vector<uint8_t>& data) {
 bool AsicSender::readFromFpga(std::vector<uint8_t>& data) {
     data.resize(BUF_LEN);
     
-    int readRet = device_->ReadFromPipeOut(0xA0, data.size(), data.data());
+    int readRet = device_->readFromPipeOut(0xA0, data.size(), data.data());
     
     // Return value is the number of bytes read, not an error code
     if (readRet > 0) {
@@ -122,12 +130,12 @@ bool AsicSender::configurePipeline(int pipelineId) {
     
     // Set pipeline configuration via WireIn
     // Address 0x01: Pipeline selection (0-9)
-    device_->SetWireInValue(0x01, pipelineId, 0x0F); // Use lower 4 bits for pipeline ID
-    device_->UpdateWireIns();
+    device_->setWireInValue(0x01, pipelineId, 0x0F); // Use lower 4 bits for pipeline ID
+    device_->updateWireIns();
     
     // Trigger configuration update
-    device_->ActivateTriggerIn(0x40, 0); // Trigger bit 0 for pipeline config
-    device_->UpdateWireIns();
+    device_->activateTriggerIn(0x40, 0); // Trigger bit 0 for pipeline config
+    device_->updateWireIns();
     
     std::cout << "Pipeline " << pipelineId << " configured successfully" << std::endl;
     return true;
@@ -143,12 +151,12 @@ bool AsicSender::enableAnalysisMode() {
     
     // Set analysis mode via WireIn
     // Address 0x02: Mode control (bit 0: analysis mode, bit 1: test mode)
-    device_->SetWireInValue(0x02, 0x01, 0x03); // Enable analysis mode, disable test mode
-    device_->UpdateWireIns();
+    device_->setWireInValue(0x02, 0x01, 0x03); // Enable analysis mode, disable test mode
+    device_->updateWireIns();
     
     // Trigger mode change
-    device_->ActivateTriggerIn(0x40, 1); // Trigger bit 1 for mode change
-    device_->UpdateWireIns();
+    device_->activateTriggerIn(0x40, 1); // Trigger bit 1 for mode change
+    device_->updateWireIns();
     
     std::cout << "Analysis mode enabled successfully" << std::endl;
     return true;
@@ -164,12 +172,12 @@ bool AsicSender::disableTestPattern() {
     
     // Disable test pattern generation
     // Address 0x03: Test pattern control (bit 0: enable/disable test pattern)
-    device_->SetWireInValue(0x03, 0x00, 0x01); // Disable test pattern
-    device_->UpdateWireIns();
+    device_->setWireInValue(0x03, 0x00, 0x01); // Disable test pattern
+    device_->updateWireIns();
     
     // Trigger test pattern disable
-    device_->ActivateTriggerIn(0x40, 2); // Trigger bit 2 for test pattern control
-    device_->UpdateWireIns();
+    device_->activateTriggerIn(0x40, 2); // Trigger bit 2 for test pattern control
+    device_->updateWireIns();
     
     std::cout << "Test pattern mode disabled successfully" << std::endl;
     return true;
@@ -189,38 +197,53 @@ bool AsicSender::setThresholds(double lowThreshold, double highThreshold) {
     
     // Set low threshold via WireIn
     // Address 0x04-0x05: Low threshold (16-bit)
-    device_->SetWireInValue(0x04, lowThresh, 0xFFFF);
-    device_->UpdateWireIns();
+    device_->setWireInValue(0x04, lowThresh, 0xFFFF);
+    device_->updateWireIns();
     
     // Set high threshold via WireIn  
     // Address 0x06-0x07: High threshold (16-bit)
-    device_->SetWireInValue(0x06, highThresh, 0xFFFF);
-    device_->UpdateWireIns();
+    device_->setWireInValue(0x06, highThresh, 0xFFFF);
+    device_->updateWireIns();
     
     // Trigger threshold update
-    device_->ActivateTriggerIn(0x40, 3); // Trigger bit 3 for threshold update
-    device_->UpdateWireIns();
+    device_->activateTriggerIn(0x40, 3); // Trigger bit 3 for threshold update
+    device_->updateWireIns();
     
     std::cout << "Thresholds set successfully" << std::endl;
     return true;
 }
 
-void AsicSender::sendWaveformData(const std::vector<uint8_t>& waveformData) {
-    if (!running_ || !initialized_) {
+void AsicSender::sendWaveformData(const std::vector<uint8_t>& waveformData, FrameTrace* trace,
+                                  const QuantizationParams* quantization) {
+    std::vector<uint8_t> processedData;
+    int channels = quantization ? (int)quantization->channels : 0;
+    if (!transferWaveformData(waveformData, processedData, trace, channels)) {
         return;
     }
     
+    // Analyze FPGA response data with original neural data
+    if (data_analyzer_) {
+        data_analyzer_->analyzeFpgaData(processedData, waveformData, trace, quantization);
+    } else if (trace) {
+        LatencyTracer::instance().record(*trace);
+    }
+}
+
+bool AsicSender::transferWaveformData(const std::vector<uint8_t>& waveformData, std::vector<uint8_t>& processedData,
+                                      FrameTrace* trace, int channels) {
+    if (!running_ || !initialized_) {
+        return false;
+    }
+    if (channels > 0) {
+        device_->setChannelInterleave(channels);
+    }
+    
     // Ensure data length is multiple of 16 for USB 3.0
     std::vector<uint8_t> paddedData = waveformData;
     while (paddedData.size() % 16 != 0) {
         paddedData.push_back(0);
     }
     
-    // Limit to BUF_LEN
-    if (paddedData.size() > BUF_LEN) {
-        paddedData.resize(BUF_LEN);
-    }
-    
     // Get current timestamp
     auto now = std::chrono::system_clock::now();
     auto time_t = std::chrono::system_clock::to_time_t(now);
@@ -230,30 +253,43 @@ void AsicSender::sendWaveformData(const std::vector<uint8_t>& waveformData) {
     std::cout << std::put_time(&tm, "%Y-%m-%d %H:%M:%S");
     std::cout << "] Sending waveform data to the FPGA..." << std::endl;
     
-    // Send data to FPGA
-    if (!writeToFpga(paddedData)) {
-        std::cerr << "Failed to write waveform data to ASIC FPGA" << std::endl;
-        return;
-    }
-    
-    // Read processed data from FPGA
-    std::vector<uint8_t> processedData;
-    if (!readFromFpga(processedData)) {
-        std::cerr << "Failed to read processed data from ASIC FPGA" << std::endl;
-        return;
-    } else {
-        // Get current timestamp for success message
-        auto now = std::chrono::system_clock::now();
-        auto time_t = std::chrono::system_clock::to_time_t(now);
-        auto tm = *std::localtime(&time_t);
+    // A transfer is at most BUF_LEN bytes, so larger frames (more than 4 streams of 32 channels) go over in
+    // BUF_LEN chunks, each written and its response read before the next; the responses are concatenated.
+    processedData.clear();
+    std::vector<uint8_t> chunkResponse;
+    for (size_t offset = 0; offset < paddedData.size(); offset += BUF_LEN) {
+        size_t chunkSize = std::min(BUF_LEN, paddedData.size() - offset);
+        std::vector<uint8_t> chunk(paddedData.begin() + offset, paddedData.begin() + offset + chunkSize);
+        
+        // Send data to FPGA
+        if (!writeToFpga(chunk)) {
+            std::cerr << "Failed to write waveform data to ASIC FPGA (bytes " << offset << "-"
+                      << offset + chunkSize << " of " << paddedData.size() << ")" << std::endl;
+            return false;
+        }
+        if (trace) {
+            trace->stamp(TraceStageAsicWrite);
+        }
         
-        std::cout << "[";
-        std::cout << std::put_time(&tm, "%Y-%m-%d %H:%M:%S");
-        std::cout << "] Data successfully read from ASIC FPGA!" << std::endl;
+        // Read processed data from FPGA
+        if (!readFromFpga(chunkResponse)) {
+            std::cerr << "Failed to read processed data from ASIC FPGA (bytes " << offset << "-"
+                      << offset + chunkSize << " of " << paddedData.size() << ")" << std::endl;
+            return false;
+        }
+        processedData.insert(processedData.end(), chunkResponse.begin(), chunkResponse.end());
+        if (trace) {
+            trace->stamp(TraceStageAsicRead);
+        }
     }
     
-    // Analyze FPGA response data with original neural data
-    if (data_analyzer_) {
-        data_analyzer_->analyzeFpgaData(processedData, waveformData);
-    }
+    // Get current timestamp for success message
+    now = std::chrono::system_clock::now();
+    time_t = std::chrono::system_clock::to_time_t(now);
+    tm = *std::localtime(&time_t);
+    
+    std::cout << "[";
+    std::cout << std::put_time(&tm, "%Y-%m-%d %H:%M:%S");
+    std::cout << "] Data successfully read from ASIC FPGA!" << std::endl;
+    return true;
 }
@@ -7,14 +7,18 @@
 #include <atomic>
 #include <thread>
 #include <memory>
-#include "okFrontPanel.h"
+#include "fpga_device.h"
 
 // Forward declaration
 class FpgaLogger;
+struct FrameTrace;
+struct QuantizationParams;
 
 class AsicSender {
 public:
     AsicSender();
+    // Use the given backend (e.g. EmulatedFpgaDevice) instead of the FrontPanel device
+    explicit AsicSender(std::unique_ptr<FpgaDevice> device);
     ~AsicSender();
     
     // Initialize ASIC FPGA connection
@@ -29,8 +33,16 @@ public:
     // Check if running
     bool isRunning() const { return running_; }
     
-    // Send waveform data (called from main pipeline)
-    void sendWaveformData(const std::vector<uint8_t>& waveformData);
+    // Send waveform data (called from main pipeline); trace, if given, gets the ASIC stages stamped.
+    // quantization (how waveformData was scaled to 8 bits) is passed through to the data analyzer.
+    void sendWaveformData(const std::vector<uint8_t>& waveformData, FrameTrace* trace = nullptr,
+                          const QuantizationParams* quantization = nullptr);
+    
+    // Write one frame to the FPGA and read its response, without analysis (AsicSenderPool merges responses
+    // from several boards before analysis). channels, if > 0, is the frame's lane interleave, passed on to
+    // the device. Returns false if not running or the transfer failed.
+    bool transferWaveformData(const std::vector<uint8_t>& waveformData, std::vector<uint8_t>& processedData,
+                              FrameTrace* trace = nullptr, int channels = 0);
     
     // Set FPGA data analyzer for response analysis
     void setDataAnalyzer(FpgaLogger* analyzer);
@@ -42,7 +54,7 @@ public:
     bool setThresholds(double lowThreshold, double highThreshold);
 
 private:
-    OpalKellyLegacy::okCFrontPanel* device_;
+    std::unique_ptr<FpgaDevice> device_;
     std::atomic<bool> running_;
     std::atomic<bool> initialized_;
     static const size_t BUF_LEN; // Must be multiple of 16 for USB 3.0
@@ -0,0 +1,260 @@
+#include "asic_sender_pool.h"
+#include "../data-analyser/src/core/fpga_logger.h"
+#include <algorithm>
+
+AsicSenderPool::AsicSenderPool()
+    : analyzer_(nullptr), running_(false), stopMode_(StopNone), nextFrameIndex_(0), framesDropped_(0),
+      framesMerged_(0) {
+}
+
+AsicSenderPool::~AsicSenderPool() {
+    stop(StopAbort);
+}
+
+bool AsicSenderPool::addBoard(std::unique_ptr<FpgaDevice> device, const std::string& serial,
+                              const std::string& bitfilePath) {
+    std::unique_ptr<Board> board(new Board());
+    board->serial = serial;
+    board->sender.reset(new AsicSender(std::move(device)));
+    if (!board->sender->initialize(serial, bitfilePath)) {
+        std::cerr << "Warning: ASIC board " << serial << " not available" << std::endl;
+        return false;
+    }
+    boards_.push_back(std::move(board));
+    return true;
+}
+
+bool AsicSenderPool::configurePipeline(int pipelineId) {
+    bool ok = !boards_.empty();
+    for (auto& board : boards_) ok = board->sender->configurePipeline(pipelineId) && ok;
+    return ok;
+}
+
+bool AsicSenderPool::enableAnalysisMode() {
+    bool ok = !boards_.empty();
+    for (auto& board : boards_) ok = board->sender->enableAnalysisMode() && ok;
+    return ok;
+}
+
+bool AsicSenderPool::disableTestPattern() {
+    bool ok = !boards_.empty();
+    for (auto& board : boards_) ok = board->sender->disableTestPattern() && ok;
+    return ok;
+}
+
+bool AsicSenderPool::setThresholds(double lowThreshold, double highThreshold) {
+    bool ok = !boards_.empty();
+    for (auto& board : boards_) ok = board->sender->setThresholds(lowThreshold, highThreshold) && ok;
+    return ok;
+}
+
+void AsicSenderPool::startSending() {
+    if (running_ || boards_.empty()) {
+        return;
+    }
+    for (auto& board : boards_) {
+        board->sender->startSending();
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        running_ = true;
+        stopMode_ = StopNone;
+    }
+    for (auto& board : boards_) {
+        board->thread = std::thread(&AsicSenderPool::boardLoop, this, board.get());
+    }
+    mergeThread_ = std::thread(&AsicSenderPool::mergeLoop, this);
+    std::cout << "ASIC sender pool started with " << boards_.size() << " board(s)" << std::endl;
+}
+
+void AsicSenderPool::stopSending() {
+    stop(StopDrain);
+}
+
+void AsicSenderPool::stop(StopMode mode) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!running_) {
+            return;
+        }
+        running_ = false;
+        stopMode_ = mode;
+    }
+    jobReady_.notify_all();
+    resultReady_.notify_all();
+    for (auto& board : boards_) {
+        if (board->thread.joinable()) {
+            board->thread.join();
+        }
+        board->sender->stopSending();
+    }
+    if (mergeThread_.joinable()) {
+        mergeThread_.join();
+    }
+    printStats(std::cout);
+}
+
+bool AsicSenderPool::submit(const std::vector<uint8_t>& waveformData, const FrameTrace* trace,
+                            const QuantizationParams* quantization) {
+    if (!running_ || waveformData.empty()) {
+        return false;
+    }
+    size_t lanes = (quantization && quantization->channels > 0) ? quantization->channels : 32;
+    lanes = std::min(lanes, waveformData.size());
+    size_t rows = (waveformData.size() + lanes - 1) / lanes;
+    size_t numBoards = boards_.size();
+
+    // Contiguous lane groups of near-equal size; a board whose group is empty sits this frame out
+    PendingFrame frame;
+    frame.trace = trace ? *trace : FrameTrace();
+    for (size_t b = 0; b < numBoards; ++b) {
+        size_t first = b * lanes / numBoards;
+        size_t last = (b + 1) * lanes / numBoards;
+        if (last == first) {
+            continue;
+        }
+        std::vector<uint8_t> input;
+        input.reserve(rows * (last - first));
+        for (size_t row = 0; row < rows; ++row) {
+            size_t begin = row * lanes + first;
+            size_t end = std::min(row * lanes + last, waveformData.size());
+            if (begin >= end) break;
+            input.insert(input.end(), waveformData.begin() + begin, waveformData.begin() + end);
+        }
+        QuantizationParams share;
+        if (quantization && quantization->channels > 0) {
+            share.channels = (uint32_t)(last - first);
+            share.scale.assign(quantization->scale.begin() + first, quantization->scale.begin() + last);
+            share.offset.assign(quantization->offset.begin() + first, quantization->offset.begin() + last);
+        }
+        frame.boards.push_back((int)b);
+        frame.inputs.push_back(std::move(input));
+        frame.lanes.push_back((int)(last - first));
+        frame.quantization.push_back(std::move(share));
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!running_) {
+            return false;
+        }
+        for (auto& board : boards_) {
+            if (board->jobs.size() >= MaxQueuedFrames) {
+                ++framesDropped_;
+                return false;
+            }
+        }
+        frame.frameIndex = nextFrameIndex_++;
+        for (size_t k = 0; k < frame.boards.size(); ++k) {
+            boards_[frame.boards[k]]->jobs.push_back(
+                BoardJob { frame.frameIndex, frame.inputs[k], frame.lanes[k], frame.trace });
+        }
+        pending_.push_back(std::move(frame));
+    }
+    jobReady_.notify_all();
+    return true;
+}
+
+void AsicSenderPool::boardLoop(Board* board) {
+    while (true) {
+        BoardJob job;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            jobReady_.wait(lock, [&]() { return stopMode_ != StopNone || !board->jobs.empty(); });
+            if (stopMode_ == StopAbort || board->jobs.empty()) {
+                return;
+            }
+            job = std::move(board->jobs.front());
+            board->jobs.pop_front();
+        }
+
+        BoardResult result { job.frameIndex, false, std::vector<uint8_t>(), job.trace };
+        result.ok = board->sender->transferWaveformData(job.input, result.response, &result.trace, job.lanes);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (result.ok) {
+                ++board->framesSent;
+            } else {
+                ++board->transferFailures;
+            }
+            board->results.push_back(std::move(result));
+        }
+        resultReady_.notify_all();
+    }
+}
+
+void AsicSenderPool::mergeLoop() {
+    while (true) {
+        PendingFrame frame;
+        std::vector<BoardResult> results;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            // Boards process their jobs in order, so the oldest pending frame is complete once every
+            // board it went to has a result at the front of its queue. A draining stop ends once every pending
+            // frame has been delivered; the boards still finish their jobs, so each of those frames completes.
+            resultReady_.wait(lock, [&]() {
+                if (stopMode_ == StopAbort) return true;
+                if (pending_.empty()) return stopMode_ == StopDrain;
+                for (int b : pending_.front().boards) {
+                    if (boards_[b]->results.empty()) return false;
+                }
+                return true;
+            });
+            if (stopMode_ == StopAbort || pending_.empty()) {
+                return;
+            }
+            frame = std::move(pending_.front());
+            pending_.pop_front();
+            for (int b : frame.boards) {
+                results.push_back(std::move(boards_[b]->results.front()));
+                boards_[b]->results.pop_front();
+            }
+            ++framesMerged_;
+        }
+
+        // The frame's ASIC stages complete when its slowest board returns
+        FrameTrace trace = frame.trace;
+        int lastOk = -1;
+        for (size_t k = 0; k < results.size(); ++k) {
+            trace.stageTimeNs[TraceStageAsicWrite] = std::max(trace.stageTimeNs[TraceStageAsicWrite],
+                                                              results[k].trace.stageTimeNs[TraceStageAsicWrite]);
+            trace.stageTimeNs[TraceStageAsicRead] = std::max(trace.stageTimeNs[TraceStageAsicRead],
+                                                             results[k].trace.stageTimeNs[TraceStageAsicRead]);
+            if (results[k].ok) lastOk = (int)k;
+        }
+        if (lastOk < 0) {
+            continue;
+        }
+        if (!analyzer_ && !responseHandler_) {
+            LatencyTracer::instance().record(trace);
+            continue;
+        }
+        // Decode/log stamps and the latency record go with the frame's last response
+        for (int k = 0; k <= lastOk; ++k) {
+            if (!results[k].ok) continue;
+            AsicResponse response;
+            response.response = std::move(results[k].response);
+            response.input = std::move(frame.inputs[k]);
+            response.quantization = std::move(frame.quantization[k]);
+            response.lastOfFrame = k == lastOk;
+            if (response.lastOfFrame) response.trace = trace;
+            if (responseHandler_) {
+                responseHandler_(response);
+            } else {
+                analyzer_->analyzeFpgaData(response.response, response.input,
+                                           response.lastOfFrame ? &response.trace : nullptr, &response.quantization);
+            }
+        }
+    }
+}
+
+void AsicSenderPool::printStats(std::ostream& out) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    out << "ASIC sender pool: " << framesMerged_ << " frames merged, " << framesDropped_
+        << " dropped (boards busy)" << std::endl;
+    for (const auto& board : boards_) {
+        out << "  board " << board->serial << ": " << board->framesSent << " transfers, "
+            << board->transferFailures << " failed" << std::endl;
+    }
+}
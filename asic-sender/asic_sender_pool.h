@@ -0,0 +1,125 @@
+#ifndef ASIC_SENDER_POOL_H
+#define ASIC_SENDER_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "asic_sender.h"
+#include "../intan-reader/latency_trace.h"
+#include "../intan-reader/adaptive_quantizer.h"
+
+// One board's response to its share of a frame, as the merge thread delivers it
+struct AsicResponse {
+    std::vector<uint8_t> response;
+    std::vector<uint8_t> input;                // the board's share of the frame
+    QuantizationParams quantization;           // scale/offset of the share's channels
+    FrameTrace trace;                          // stamped through AsicRead on the frame's last response; untraced otherwise
+    bool lastOfFrame = false;
+};
+
+// Fans hub frames out across several ASIC boards. The channel lanes of each time point are split into
+// contiguous groups, one per board; each board has its own AsicSender, I/O thread and response queue.
+// A merge thread hands the responses to the FpgaLogger in frame order, and board order within a frame.
+// With one board this is the old single-sender path, with the transfer moved off the caller's thread.
+class AsicSenderPool {
+public:
+    AsicSenderPool();
+    ~AsicSenderPool();
+
+    // Open and configure one board; returns false (and does not add it) if the board fails to initialize
+    bool addBoard(std::unique_ptr<FpgaDevice> device, const std::string& serial, const std::string& bitfilePath);
+    int getNumBoards() const { return (int)boards_.size(); }
+
+    // Applied to every board; true only if every board accepted the setting
+    bool configurePipeline(int pipelineId);
+    bool enableAnalysisMode();
+    bool disableTestPattern();
+    bool setThresholds(double lowThreshold, double highThreshold);
+    void setDataAnalyzer(FpgaLogger* analyzer) { analyzer_ = analyzer; }
+    // Hand merged responses to `handler` (on the merge thread) instead of the analyzer, e.g. to queue them
+    // for a decode stage. Set before startSending().
+    void setResponseHandler(std::function<void(AsicResponse&)> handler) { responseHandler_ = handler; }
+
+    void startSending();
+    // Stop taking frames, let every board work through its queued jobs and the merge thread deliver every
+    // pending frame, then join the threads. The destructor stops at once instead, dropping queued frames.
+    void stopSending();
+    bool isRunning() const { return running_; }
+
+    // Partition one frame ([time][lane] bytes; lanes = quantization->channels, or 32 if unknown) across
+    // the boards and queue it. Returns false and drops the whole frame if any board is still
+    // MaxQueuedFrames behind.
+    bool submit(const std::vector<uint8_t>& waveformData, const FrameTrace* trace = nullptr,
+                const QuantizationParams* quantization = nullptr);
+
+    void printStats(std::ostream& out) const;
+
+    static const size_t MaxQueuedFrames = 4;
+
+private:
+    enum StopMode {
+        StopNone,
+        StopDrain,    // threads exit once their queues are empty
+        StopAbort     // threads exit at once
+    };
+
+    struct BoardJob {
+        uint64_t frameIndex;
+        std::vector<uint8_t> input;
+        int lanes;                                // interleave of input (the board's share of the lanes)
+        FrameTrace trace;
+    };
+    struct BoardResult {
+        uint64_t frameIndex;
+        bool ok;
+        std::vector<uint8_t> response;
+        FrameTrace trace;
+    };
+    struct Board {
+        std::string serial;
+        std::unique_ptr<AsicSender> sender;
+        std::thread thread;
+        std::deque<BoardJob> jobs;
+        std::deque<BoardResult> results;
+        uint64_t framesSent = 0;
+        uint64_t transferFailures = 0;
+    };
+    // Per-frame state the merge thread needs once every board's response is in
+    struct PendingFrame {
+        uint64_t frameIndex;
+        std::vector<int> boards;                  // boards that received a share of this frame
+        std::vector<std::vector<uint8_t>> inputs; // per board in `boards`
+        std::vector<int> lanes;                   // per board in `boards`
+        std::vector<QuantizationParams> quantization;
+        FrameTrace trace;
+    };
+
+    std::vector<std::unique_ptr<Board>> boards_;
+    FpgaLogger* analyzer_;
+    std::function<void(AsicResponse&)> responseHandler_;
+    std::atomic<bool> running_;
+    std::thread mergeThread_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable jobReady_;
+    std::condition_variable resultReady_;
+    std::deque<PendingFrame> pending_;
+    StopMode stopMode_;
+    uint64_t nextFrameIndex_;
+    uint64_t framesDropped_;
+    uint64_t framesMerged_;
+
+    void stop(StopMode mode);
+    void boardLoop(Board* board);
+    void mergeLoop();
+};
+
+#endif // ASIC_SENDER_POOL_H
@@ -0,0 +1,256 @@
+#include "emulated_fpga_device.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <thread>
+
+namespace {
+    const int PipelineWire = 0x01;
+    const int ModeWire = 0x02;
+    const int TestPatternWire = 0x03;
+    const int HighThresholdWire = 0x06;
+    const int ResetWire = 0x10;
+    const int TriggerEndpoint = 0x40;
+    const int PipeInEndpoint = 0x80;
+    const int PipeOutEndpoint = 0xA0;
+
+    const int SampleMidScale = 128;    // uint8 waveform samples are offset binary
+}
+
+EmulatedFpgaDevice::EmulatedFpgaDevice(const FpgaEmulatorConfig& config)
+    : config_(config), open_(false), configured_(false), pipeline_(0), testPattern_(false), highThreshold_(0xFFFF),
+      streamChannel_(0), testCounter_(0), outputHead_(0), writes_(0), reads_(0), bytesIn_(0), bytesOut_(0),
+      bytesDropped_(0), busTime_(0) {
+    config_.channels = std::max(1, config_.channels);
+    std::memset(wireStaged_, 0, sizeof(wireStaged_));
+    std::memset(wireActive_, 0, sizeof(wireActive_));
+    neoPrev1_.assign(config_.channels, 0);
+    neoPrev2_.assign(config_.channels, 0);
+}
+
+EmulatedFpgaDevice::~EmulatedFpgaDevice() {
+    if (writes_ > 0 || reads_ > 0) {
+        printStatistics();
+    }
+}
+
+std::string EmulatedFpgaDevice::name() const {
+    return config_.kernel == FpgaEmulatorConfig::KernelEcho ? "FPGA emulator (echo)" : "FPGA emulator (HALO model)";
+}
+
+int EmulatedFpgaDevice::openBySerial(const std::string& serial) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::cout << "FPGA emulator: opened as " << (serial.empty() ? "<any>" : serial)
+              << ", transfer latency " << config_.transferLatencyUs << " us, bandwidth ";
+    if (config_.bandwidthMBps > 0.0) {
+        std::cout << config_.bandwidthMBps << " MB/s" << std::endl;
+    } else {
+        std::cout << "unlimited" << std::endl;
+    }
+    open_ = true;
+    return NoError;
+}
+
+int EmulatedFpgaDevice::configureFpga(const std::string& bitfilePath) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!open_) {
+        return DeviceNotOpen;
+    }
+    // The bitfile is not loaded; the kernel model stands in for it.
+    (void)bitfilePath;
+    configured_ = true;
+    resetFifo();
+    return NoError;
+}
+
+int EmulatedFpgaDevice::setWireInValue(int epAddr, uint32_t value, uint32_t mask) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!configured_) {
+        return DeviceNotOpen;
+    }
+    if (epAddr < 0 || epAddr >= NumWireIns) {
+        return InvalidEndpoint;
+    }
+    wireStaged_[epAddr] = (wireStaged_[epAddr] & ~mask) | (value & mask);
+    return NoError;
+}
+
+int EmulatedFpgaDevice::updateWireIns() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!configured_) {
+        return DeviceNotOpen;
+    }
+    std::memcpy(wireActive_, wireStaged_, sizeof(wireActive_));
+    if (wireActive_[ResetWire] & 0x01) {
+        resetFifo();
+    }
+    return NoError;
+}
+
+int EmulatedFpgaDevice::activateTriggerIn(int epAddr, int bit) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!configured_) {
+        return DeviceNotOpen;
+    }
+    if (epAddr != TriggerEndpoint || bit < 0 || bit > 31) {
+        return InvalidEndpoint;
+    }
+
+    switch (bit) {
+        case 0:
+            pipeline_ = wireActive_[PipelineWire] & 0x0F;
+            if (config_.kernel == FpgaEmulatorConfig::KernelHalo && (pipeline_ < 3 || pipeline_ > 6)) {
+                std::cout << "FPGA emulator: pipeline " << pipeline_
+                          << " is not modeled (LZ/DWT stages); data passes through unchanged" << std::endl;
+            }
+            break;
+        case 1:
+            testPattern_ = (wireActive_[ModeWire] & 0x02) != 0;
+            break;
+        case 2:
+            testPattern_ = (wireActive_[TestPatternWire] & 0x01) != 0;
+            break;
+        case 3:
+            // Only the high threshold (0x06) gates; the low threshold (0x04) is decoder-side.
+            highThreshold_ = wireActive_[HighThresholdWire] & 0xFFFF;
+            break;
+        default:
+            break;
+    }
+    return NoError;
+}
+
+long EmulatedFpgaDevice::writeToPipeIn(int epAddr, long length, const uint8_t* data) {
+    if (epAddr != PipeInEndpoint) {
+        return InvalidEndpoint;
+    }
+    if (length <= 0) {
+        return 0;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!configured_) {
+        return DeviceNotOpen;
+    }
+    modelTransfer(length);
+    runKernel(data, length);
+    ++writes_;
+    bytesIn_ += length;
+    return length;
+}
+
+long EmulatedFpgaDevice::readFromPipeOut(int epAddr, long length, uint8_t* data) {
+    if (epAddr != PipeOutEndpoint) {
+        return InvalidEndpoint;
+    }
+    if (length <= 0) {
+        return 0;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!configured_) {
+        return DeviceNotOpen;
+    }
+    size_t available = outputFifo_.size() - outputHead_;
+    if (available == 0) {
+        modelTransfer(0);
+        return Timeout;
+    }
+
+    size_t count = std::min(available, (size_t)length);
+    modelTransfer(count);
+    std::memcpy(data, outputFifo_.data() + outputHead_, count);
+    outputHead_ += count;
+    if (outputHead_ == outputFifo_.size()) {
+        outputFifo_.clear();
+        outputHead_ = 0;
+    }
+    ++reads_;
+    bytesOut_ += count;
+    return count;
+}
+
+void EmulatedFpgaDevice::setChannelInterleave(int channels) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    channels = std::max(1, channels);
+    if (channels == config_.channels) {
+        return;
+    }
+    config_.channels = channels;
+    neoPrev1_.assign(channels, 0);
+    neoPrev2_.assign(channels, 0);
+    streamChannel_ = 0;
+}
+
+void EmulatedFpgaDevice::printStatistics() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::cout << "FPGA emulator: " << writes_ << " writes (" << bytesIn_ << " bytes), "
+              << reads_ << " reads (" << bytesOut_ << " bytes), "
+              << std::chrono::duration<double, std::milli>(busTime_).count() << " ms modeled transfer time";
+    if (bytesDropped_ > 0) {
+        std::cout << ", " << bytesDropped_ << " bytes dropped on output FIFO overflow";
+    }
+    std::cout << std::endl;
+}
+
+void EmulatedFpgaDevice::resetFifo() {
+    outputFifo_.clear();
+    outputHead_ = 0;
+    std::fill(neoPrev1_.begin(), neoPrev1_.end(), 0);
+    std::fill(neoPrev2_.begin(), neoPrev2_.end(), 0);
+    streamChannel_ = 0;
+    testCounter_ = 0;
+}
+
+// HALO pipelines 4-6 gate the raw ADC_a stream with NEO -> THR on ADC_b (both are the input here).
+// NEO is evaluated causally per channel, one sample late: psi[n-1] = x[n-1]^2 - x[n-2] * x[n], with x
+// centred on mid-scale, and compared against the high threshold scaled to the decoder's 128^2 range.
+// A closed gate outputs mid-scale.
+void EmulatedFpgaDevice::runKernel(const uint8_t* data, size_t length) {
+    const bool gate = config_.kernel == FpgaEmulatorConfig::KernelHalo && pipeline_ >= 4 && pipeline_ <= 6;
+    const long threshold = (long)highThreshold_ * SampleMidScale * SampleMidScale / 0xFFFF;
+
+    for (size_t i = 0; i < length; ++i) {
+        uint8_t out = data[i];
+        if (config_.kernel == FpgaEmulatorConfig::KernelHalo && testPattern_) {
+            out = testCounter_++;
+        } else if (gate) {
+            int x = data[i] - SampleMidScale;
+            int& prev1 = neoPrev1_[streamChannel_];
+            int& prev2 = neoPrev2_[streamChannel_];
+            long psi = (long)prev1 * prev1 - (long)prev2 * x;
+            out = psi >= threshold ? (uint8_t)(prev1 + SampleMidScale) : (uint8_t)SampleMidScale;
+            prev2 = prev1;
+            prev1 = x;
+            if (++streamChannel_ == neoPrev1_.size()) {
+                streamChannel_ = 0;
+            }
+        }
+        pushOutput(out);
+    }
+}
+
+void EmulatedFpgaDevice::pushOutput(uint8_t value) {
+    if (outputFifo_.size() - outputHead_ >= config_.fifoBytes) {
+        ++bytesDropped_;
+        return;
+    }
+    if (outputHead_ > 0 && outputFifo_.size() == outputFifo_.capacity()) {
+        outputFifo_.erase(outputFifo_.begin(), outputFifo_.begin() + outputHead_);
+        outputHead_ = 0;
+    }
+    outputFifo_.push_back(value);
+}
+
+void EmulatedFpgaDevice::modelTransfer(size_t bytes) {
+    double delayUs = config_.transferLatencyUs;
+    if (config_.bandwidthMBps > 0.0) {
+        delayUs += bytes / config_.bandwidthMBps;   // bytes / (MB/s) = microseconds
+    }
+    if (delayUs <= 0.0) {
+        return;
+    }
+    std::chrono::nanoseconds delay((int64_t)(delayUs * 1000.0));
+    busTime_ += delay;
+    std::this_thread::sleep_for(delay);
+}
@@ -0,0 +1,90 @@
+#ifndef EMULATED_FPGA_DEVICE_H
+#define EMULATED_FPGA_DEVICE_H
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#include "fpga_device.h"
+
+struct FpgaEmulatorConfig {
+    enum Kernel {
+        KernelHalo,    // model the configured HALO pipeline (NEO -> THR -> GATE for pipelines 4-6)
+        KernelEcho     // return every byte written, unchanged
+    };
+
+    Kernel kernel = KernelHalo;
+    int channels = 32;                 // channel interleave of the pipe stream ([sample][channel]) until
+                                       // the sender sets it per transfer (setChannelInterleave)
+    double transferLatencyUs = 0.0;    // fixed cost of every pipe transfer (USB round trip)
+    double bandwidthMBps = 0.0;        // pipe throughput in MB/s; 0 = unlimited
+    size_t fifoBytes = 65536;          // output FIFO between the kernel and pipe 0xA0
+};
+
+// In-process stand-in for the XEM6310 + HALO bitfile. Implements the endpoints AsicSender uses:
+//   WireIn 0x01 pipeline, 0x02 mode, 0x03 test pattern, 0x04/0x06 low/high threshold, 0x10 FIFO reset
+//   TriggerIn 0x40 bits 0-3 latch the corresponding wires
+//   PipeIn 0x80 -> kernel -> output FIFO -> PipeOut 0xA0
+// Every pipe transfer blocks for transferLatencyUs + bytes / bandwidthMBps. Transfers are serialized, as
+// on the shared USB bus, so several sender threads see the same contention as with the real board.
+class EmulatedFpgaDevice : public FpgaDevice {
+public:
+    explicit EmulatedFpgaDevice(const FpgaEmulatorConfig& config = FpgaEmulatorConfig());
+    ~EmulatedFpgaDevice() override;
+
+    std::string name() const override;
+
+    int openBySerial(const std::string& serial) override;
+    int configureFpga(const std::string& bitfilePath) override;
+
+    int setWireInValue(int epAddr, uint32_t value, uint32_t mask) override;
+    int updateWireIns() override;
+    int activateTriggerIn(int epAddr, int bit) override;
+
+    long writeToPipeIn(int epAddr, long length, const uint8_t* data) override;
+    long readFromPipeOut(int epAddr, long length, uint8_t* data) override;
+    // A change restarts the per-channel NEO history, which belongs to the old channel layout
+    void setChannelInterleave(int channels) override;
+
+    void printStatistics() const;
+
+private:
+    static const int NumWireIns = 0x20;
+
+    FpgaEmulatorConfig config_;
+    mutable std::mutex mutex_;
+    bool open_;
+    bool configured_;
+
+    uint32_t wireStaged_[NumWireIns];
+    uint32_t wireActive_[NumWireIns];
+
+    // State latched by TriggerIn 0x40
+    int pipeline_;
+    bool testPattern_;
+    uint16_t highThreshold_;
+
+    // Per-channel NEO history (previous two centred samples) and stream position
+    std::vector<int> neoPrev1_;
+    std::vector<int> neoPrev2_;
+    size_t streamChannel_;
+    uint8_t testCounter_;
+
+    std::vector<uint8_t> outputFifo_;
+    size_t outputHead_;
+
+    uint64_t writes_;
+    uint64_t reads_;
+    uint64_t bytesIn_;
+    uint64_t bytesOut_;
+    uint64_t bytesDropped_;
+    std::chrono::nanoseconds busTime_;
+
+    void resetFifo();
+    void runKernel(const uint8_t* data, size_t length);
+    void pushOutput(uint8_t value);
+    void modelTransfer(size_t bytes);
+};
+
+#endif // EMULATED_FPGA_DEVICE_H
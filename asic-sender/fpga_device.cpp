@@ -0,0 +1,41 @@
+#include "fpga_device.h"
+
+#ifndef ASIC_EMULATOR_ONLY
+
+#include "okFrontPanel.h"
+
+OpalKellyFpgaDevice::OpalKellyFpgaDevice() : device_(new OpalKellyLegacy::okCFrontPanel()) {
+}
+
+OpalKellyFpgaDevice::~OpalKellyFpgaDevice() {
+}
+
+int OpalKellyFpgaDevice::openBySerial(const std::string& serial) {
+    return device_->OpenBySerial(serial.c_str());
+}
+
+int OpalKellyFpgaDevice::configureFpga(const std::string& bitfilePath) {
+    return device_->ConfigureFPGA(bitfilePath.c_str());
+}
+
+int OpalKellyFpgaDevice::setWireInValue(int epAddr, uint32_t value, uint32_t mask) {
+    return device_->SetWireInValue(epAddr, value, mask);
+}
+
+int OpalKellyFpgaDevice::updateWireIns() {
+    return device_->UpdateWireIns();
+}
+
+int OpalKellyFpgaDevice::activateTriggerIn(int epAddr, int bit) {
+    return device_->ActivateTriggerIn(epAddr, bit);
+}
+
+long OpalKellyFpgaDevice::writeToPipeIn(int epAddr, long length, const uint8_t* data) {
+    return device_->WriteToPipeIn(epAddr, length, data);
+}
+
+long OpalKellyFpgaDevice::readFromPipeOut(int epAddr, long length, uint8_t* data) {
+    return device_->ReadFromPipeOut(epAddr, length, data);
+}
+
+#endif // ASIC_EMULATOR_ONLY
@@ -0,0 +1,73 @@
+#ifndef FPGA_DEVICE_H
+#define FPGA_DEVICE_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+// The FrontPanel surface AsicSender uses (wires, triggers, pipes), so the sender can run against the
+// XEM6310 or an in-process emulator. Return values follow FrontPanel: 0 on success or a negative
+// ok_ErrorCode; pipe transfers return the number of bytes moved or a negative error code.
+class FpgaDevice {
+public:
+    // Same values as ok_ErrorCode in okFrontPanel.h
+    enum ErrorCode {
+        NoError = 0,
+        Failed = -1,
+        Timeout = -2,
+        FileError = -7,
+        DeviceNotOpen = -8,
+        InvalidEndpoint = -9,
+        FIFOOverflow = -17
+    };
+
+    virtual ~FpgaDevice() {}
+
+    virtual std::string name() const = 0;
+
+    virtual int openBySerial(const std::string& serial) = 0;
+    virtual int configureFpga(const std::string& bitfilePath) = 0;
+
+    virtual int setWireInValue(int epAddr, uint32_t value, uint32_t mask) = 0;
+    virtual int updateWireIns() = 0;
+    virtual int activateTriggerIn(int epAddr, int bit) = 0;
+
+    virtual long writeToPipeIn(int epAddr, long length, const uint8_t* data) = 0;
+    virtual long readFromPipeOut(int epAddr, long length, uint8_t* data) = 0;
+
+    // Channel interleave ([sample][channel]) of the pipe data that follows. The bitfile takes the stream as
+    // it comes, so only backends that model per-channel state (the emulator) use this.
+    virtual void setChannelInterleave(int channels) { (void)channels; }
+};
+
+#ifndef ASIC_EMULATOR_ONLY
+
+namespace OpalKellyLegacy {
+    class okCFrontPanel;
+}
+
+// FrontPanel backend (XEM6310 over USB)
+class OpalKellyFpgaDevice : public FpgaDevice {
+public:
+    OpalKellyFpgaDevice();
+    ~OpalKellyFpgaDevice() override;
+
+    std::string name() const override { return "Opal Kelly FrontPanel"; }
+
+    int openBySerial(const std::string& serial) override;
+    int configureFpga(const std::string& bitfilePath) override;
+
+    int setWireInValue(int epAddr, uint32_t value, uint32_t mask) override;
+    int updateWireIns() override;
+    int activateTriggerIn(int epAddr, int bit) override;
+
+    long writeToPipeIn(int epAddr, long length, const uint8_t* data) override;
+    long readFromPipeOut(int epAddr, long length, uint8_t* data) override;
+
+private:
+    std::unique_ptr<OpalKellyLegacy::okCFrontPanel> device_;
+};
+
+#endif // ASIC_EMULATOR_ONLY
+
+#endif // FPGA_DEVICE_H
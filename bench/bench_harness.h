@@ -0,0 +1,126 @@
+#ifndef BENCH_HARNESS_H
+#define BENCH_HARNESS_H
+
+// Minimal microbenchmark harness shared by pipeline_bench and rhx_bench.
+// Each benchmark runs a warm-up, then enough iterations per trial to take ~BenchTrialSec, and reports
+// the median of BenchTrials trials as ns/sample and MB/s. Results are printed as a table and, with
+// --json PATH, written as JSON so runs can be compared across commits.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+const uint32_t BenchSeed = 20240611;    // fixed seed for every generated input
+const double BenchTrialSec = 0.2;
+const int BenchTrials = 5;
+
+struct BenchResult {
+    std::string name;
+    uint64_t samplesPerOp;    // samples (channel x time points) processed by one call
+    uint64_t bytesPerOp;      // input bytes touched by one call
+    double nsPerOp;
+    double nsPerSample() const { return samplesPerOp ? nsPerOp / samplesPerOp : 0.0; }
+    double megabytesPerSec() const { return nsPerOp > 0.0 ? bytesPerOp / nsPerOp * 1.0e3 : 0.0; }
+};
+
+// Keep the optimizer from discarding a benchmark's result
+template <typename T>
+inline void benchKeep(const T& value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+class BenchSuite {
+public:
+    // Reports go to the process's stdout even if std::cout is redirected later (to silence a component)
+    BenchSuite(const std::string& suiteName, int argc, char* argv[]) : suiteName_(suiteName), out_(std::cout.rdbuf()) {
+        for (int i = 1; i < argc; ++i) {
+            if (std::strcmp(argv[i], "--json") == 0 && i + 1 < argc) {
+                jsonPath_ = argv[++i];
+            } else if (std::strcmp(argv[i], "--filter") == 0 && i + 1 < argc) {
+                filter_ = argv[++i];
+            } else if (std::strcmp(argv[i], "--label") == 0 && i + 1 < argc) {
+                label_ = argv[++i];
+            }
+        }
+        out_ << std::left << std::setw(44) << suiteName_ << std::right
+                  << std::setw(14) << "ns/op" << std::setw(12) << "ns/sample" << std::setw(12) << "MB/s" << std::endl;
+    }
+
+    void run(const std::string& name, uint64_t samplesPerOp, uint64_t bytesPerOp, const std::function<void()>& op) {
+        if (!filter_.empty() && name.find(filter_) == std::string::npos) {
+            return;
+        }
+        using Clock = std::chrono::steady_clock;
+
+        // Warm-up and calibration: grow the iteration count until one trial takes long enough
+        uint64_t iterations = 1;
+        while (true) {
+            Clock::time_point start = Clock::now();
+            for (uint64_t i = 0; i < iterations; ++i) op();
+            double sec = std::chrono::duration<double>(Clock::now() - start).count();
+            if (sec >= BenchTrialSec / 4 || iterations >= (1ull << 30)) {
+                iterations = std::max<uint64_t>(1, (uint64_t)(iterations * BenchTrialSec / std::max(sec, 1e-9)));
+                break;
+            }
+            iterations *= 4;
+        }
+
+        std::vector<double> trials;
+        for (int t = 0; t < BenchTrials; ++t) {
+            Clock::time_point start = Clock::now();
+            for (uint64_t i = 0; i < iterations; ++i) op();
+            trials.push_back(std::chrono::duration<double, std::nano>(Clock::now() - start).count() / iterations);
+        }
+        std::sort(trials.begin(), trials.end());
+
+        BenchResult result { name, samplesPerOp, bytesPerOp, trials[trials.size() / 2] };
+        results_.push_back(result);
+        out_ << std::left << std::setw(44) << name << std::right << std::fixed
+                  << std::setw(14) << std::setprecision(1) << result.nsPerOp
+                  << std::setw(12) << std::setprecision(3) << result.nsPerSample()
+                  << std::setw(12) << std::setprecision(1) << result.megabytesPerSec()
+                  << std::defaultfloat << std::endl;
+    }
+
+    // Write the JSON report if --json was given; returns the process exit code
+    int finish() {
+        if (jsonPath_.empty()) {
+            return 0;
+        }
+        std::ofstream out(jsonPath_);
+        if (!out) {
+            std::cerr << "Error: cannot write " << jsonPath_ << std::endl;
+            return 1;
+        }
+        out << "{\n  \"suite\": \"" << suiteName_ << "\",\n  \"label\": \"" << label_
+            << "\",\n  \"unix_time\": " << (long long)std::time(nullptr)
+            << ",\n  \"seed\": " << BenchSeed << ",\n  \"results\": [";
+        for (size_t i = 0; i < results_.size(); ++i) {
+            const BenchResult& r = results_[i];
+            out << (i ? ",\n" : "\n") << "    {\"name\": \"" << r.name << "\", \"ns_per_op\": " << r.nsPerOp
+                << ", \"ns_per_sample\": " << r.nsPerSample() << ", \"mb_per_s\": " << r.megabytesPerSec()
+                << ", \"samples_per_op\": " << r.samplesPerOp << ", \"bytes_per_op\": " << r.bytesPerOp << "}";
+        }
+        out << "\n  ]\n}\n";
+        out_ << "Results written to " << jsonPath_ << std::endl;
+        return out ? 0 : 1;
+    }
+
+private:
+    std::string suiteName_;
+    std::string jsonPath_;
+    std::string filter_;
+    std::string label_;
+    std::vector<BenchResult> results_;
+    std::ostream out_;
+};
+
+#endif // BENCH_HARNESS_H
@@ -0,0 +1,121 @@
+// Microbenchmarks for the standalone pipeline hot paths: hub publish/consume, HALO response decoding,
+// HDF5 logging and latency recording. Build and run with `make bench` from the repository root.
+//
+//   bench/pipeline_bench [--json PATH] [--filter SUBSTRING] [--label TEXT]
+
+#include <cstdio>
+#include <random>
+
+#include "bench_harness.h"
+#include "intan-reader/shared_memory_writer.h"
+#include "intan-reader/shared_memory_reader.h"
+#include "intan-reader/latency_trace.h"
+#include "data-analyser/src/core/halo_response_decoder.h"
+#include "data-analyser/src/core/hdf5_writer.h"
+
+namespace {
+    const char* BenchShmName = "/intan_rhx_shm_bench";   // private segment; never touches a live hub
+    const int SamplesPerBlock = 128;
+
+    // [stream][channel][sample] ADC codes around mid-scale, as IntanReader hands to the writer
+    std::vector<std::vector<std::vector<int>>> makeAmplifierData(int streams, int channels, std::mt19937& rng) {
+        std::normal_distribution<double> noise(32768.0, 400.0);
+        std::vector<std::vector<std::vector<int>>> data(streams,
+            std::vector<std::vector<int>>(channels, std::vector<int>(SamplesPerBlock)));
+        for (auto& stream : data)
+            for (auto& channel : stream)
+                for (int& code : channel)
+                    code = std::min(65535, std::max(0, (int)noise(rng)));
+        return data;
+    }
+
+    void benchHub(BenchSuite& suite, int streams, int channels, std::mt19937& rng) {
+        std::string shape = std::to_string(streams) + "x" + std::to_string(channels);
+        auto amplifierData = makeAmplifierData(streams, channels, rng);
+        const uint64_t samples = (uint64_t)streams * channels * SamplesPerBlock;
+
+        SharedMemoryWriter writer(BenchShmName);
+        if (!writer.initialize(streams, channels, 1000)) {
+            std::cerr << "Error: cannot create " << BenchShmName << std::endl;
+            return;
+        }
+        uint32_t timestamp = 0;
+        suite.run("SharedMemoryWriter::writeDataBlock " + shape, samples, samples * sizeof(IntanDataBlock), [&]() {
+            writer.writeDataBlock(timestamp, amplifierData);
+            timestamp += SamplesPerBlock;
+        });
+
+        SharedMemoryReader reader(BenchShmName);
+        if (reader.initialize()) {
+            // The reader only returns a block it has not returned before, so each read follows a publish
+            std::vector<uint8_t> waveform;
+            suite.run("SharedMemoryWriter+Reader publish/read " + shape, samples, samples * sizeof(IntanDataBlock), [&]() {
+                writer.writeDataBlock(timestamp, amplifierData);
+                timestamp += SamplesPerBlock;
+                reader.readLatestData(waveform);
+                benchKeep(waveform.data());
+            });
+        }
+    }
+
+    void benchDecoder(BenchSuite& suite, std::mt19937& rng) {
+        HaloResponseDecoder decoder;
+        decoder.setPipeline(HaloPipeline::PIPELINE_6);
+        decoder.setThresholds(0.3, 0.7);
+        for (size_t bytes : { (size_t)4096, (size_t)16384 }) {
+            std::vector<uint8_t> response(bytes);
+            for (uint8_t& b : response) b = (uint8_t)rng();
+            suite.run("HaloResponseDecoder::decodeResponse " + std::to_string(bytes) + "B", bytes, bytes, [&]() {
+                HaloResponse decoded = decoder.decodeResponse(response);
+                benchKeep(decoded.activity_level);
+            });
+        }
+    }
+
+    void benchHdf5(BenchSuite& suite, std::mt19937& rng) {
+        // Same row shape as FpgaLogger: 32 channels + 4 metadata columns
+        const uint32_t numSignals = 36;
+        std::string path = "/tmp/pipeline_bench.h5";
+        Hdf5Writer writer;
+        IntanHeaderInfo info { 0x494E5441, 1, numSignals, 1000 };
+        if (!writer.open(path, info)) {
+            std::cerr << "Error: cannot create " << path << std::endl;
+            return;
+        }
+        std::vector<uint16_t> codes(numSignals);
+        std::vector<float> microvolts(numSignals);
+        for (uint32_t i = 0; i < numSignals; ++i) {
+            codes[i] = (uint16_t)rng();
+            microvolts[i] = (codes[i] - 32768) * 0.195f;
+        }
+        suite.run("Hdf5Writer::appendFrame 36", numSignals, numSignals * (sizeof(uint16_t) + sizeof(float)), [&]() {
+            writer.appendFrame(codes, microvolts);
+        });
+        writer.close();
+        std::remove(path.c_str());
+    }
+
+    void benchLatencyHistogram(BenchSuite& suite, std::mt19937& rng) {
+        LatencyHistogram histogram;
+        std::vector<uint64_t> latencies(4096);
+        std::lognormal_distribution<double> latency(13.0, 1.0);   // ~0.4 ms median
+        for (uint64_t& v : latencies) v = (uint64_t)latency(rng);
+        suite.run("LatencyHistogram::record 4096", latencies.size(), latencies.size() * sizeof(uint64_t), [&]() {
+            for (uint64_t v : latencies) histogram.record(v);
+        });
+    }
+}
+
+int main(int argc, char* argv[]) {
+    BenchSuite suite("pipeline_bench", argc, argv);
+    std::mt19937 rng(BenchSeed);
+
+    // 32 channels per stream, as the hub is published today: one headstage, and the 1024-channel maximum
+    benchHub(suite, 1, 32, rng);
+    benchHub(suite, 32, 32, rng);
+    benchDecoder(suite, rng);
+    benchHdf5(suite, rng);
+    benchLatencyHistogram(suite, rng);
+
+    return suite.finish();
+}
@@ -0,0 +1,157 @@
+// Microbenchmarks for the RHX processing kernels the pipelined GUI runs per block: the BiquadFilter family,
+// FastFourierTransform, and the shared-memory ingest of PipelineDataRHXController. Needs QtCore, so it is
+// built with qmake (bench/rhx_bench.pro); `make bench` builds and runs it.
+//
+//   bench/rhx_bench [--json PATH] [--filter SUBSTRING] [--label TEXT]
+//
+// CPUInterface::processDataBlock is not covered here: it needs a full SystemState (QtWidgets and most of
+// the engine). Its filter cascade is the BiquadFilter family below; use the in-app CPU speed test for it.
+
+#include <cmath>
+#include <memory>
+#include <random>
+#include <sstream>
+
+#include "bench_harness.h"
+#include "filter.h"
+#include "fastfouriertransform.h"
+#include "pipelinedatarhxcontroller.h"
+
+namespace {
+    const double SampleRate = 30000.0;
+    const unsigned int FilterLength = 4096;     // samples per filter call (32 blocks of one channel)
+
+    std::vector<float> makeNeuralTrace(unsigned int length, std::mt19937& rng) {
+        std::normal_distribution<float> noise(0.0f, 20.0f);
+        std::vector<float> trace(length);
+        for (unsigned int i = 0; i < length; ++i) {
+            trace[i] = 50.0f * (float)std::sin(2.0 * Pi * 60.0 * i / SampleRate) + noise(rng);
+        }
+        return trace;
+    }
+
+    void benchFilter(BenchSuite& suite, const std::string& name, Filter& filter, const std::vector<float>& in) {
+        std::vector<float> out(in.size());
+        suite.run(name, in.size(), in.size() * sizeof(float), [&]() {
+            filter.filter(in.data(), out.data(), (unsigned int)in.size());
+            benchKeep(out[0]);
+        });
+    }
+
+    void benchFilters(BenchSuite& suite, std::mt19937& rng) {
+        std::vector<float> trace = makeNeuralTrace(FilterLength, rng);
+
+        FirstOrderLowpassFilter lowpass1(7500.0, SampleRate);
+        FirstOrderHighpassFilter highpass1(1.0, SampleRate);
+        SecondOrderLowpassFilter lowpass2(300.0, 0.7071, SampleRate);
+        SecondOrderHighpassFilter highpass2(300.0, 0.7071, SampleRate);
+        SecondOrderNotchFilter notch2(60.0, 10.0, SampleRate);
+        NotchFilter notch(60.0, 10.0, SampleRate);
+        BesselLowpassFilter bessel4(4, 250.0, SampleRate);
+        BesselLowpassFilter bessel8(8, 250.0, SampleRate);
+
+        benchFilter(suite, "FirstOrderLowpassFilter 4096", lowpass1, trace);
+        benchFilter(suite, "FirstOrderHighpassFilter 4096", highpass1, trace);
+        benchFilter(suite, "SecondOrderLowpassFilter 4096", lowpass2, trace);
+        benchFilter(suite, "SecondOrderHighpassFilter 4096", highpass2, trace);
+        benchFilter(suite, "SecondOrderNotchFilter 4096", notch2, trace);
+        benchFilter(suite, "NotchFilter 4096", notch, trace);
+        benchFilter(suite, "BesselLowpassFilter order 4 4096", bessel4, trace);
+        benchFilter(suite, "BesselLowpassFilter order 8 4096", bessel8, trace);
+    }
+
+    void benchFft(BenchSuite& suite, std::mt19937& rng) {
+        const unsigned int batch = 32;   // one transform per channel of a headstage
+        for (unsigned int length : { 1024u, 4096u }) {
+            std::string n = std::to_string(length);
+            FastFourierTransform fft((float)SampleRate, length);
+            std::vector<float> input = makeNeuralTrace(length * batch, rng);
+            std::vector<float> work(input.size());
+            std::vector<float> psd((length / 2 + 1) * batch);
+
+            suite.run("FastFourierTransform::realInputFft " + n, length, length * sizeof(float), [&]() {
+                std::copy(input.begin(), input.begin() + length, work.begin());
+                FastFourierTransform::realInputFft(work.data(), length);
+                benchKeep(work[1]);
+            });
+            suite.run("FastFourierTransform::realFft " + n, length, length * sizeof(float), [&]() {
+                std::copy(input.begin(), input.begin() + length, work.begin());
+                fft.realFft(work.data());
+                benchKeep(work[1]);
+            });
+            suite.run("FastFourierTransform::logSqrtPsdBatch 32x" + n, (uint64_t)length * batch,
+                      (uint64_t)length * batch * sizeof(float), [&]() {
+                std::copy(input.begin(), input.end(), work.begin());
+                fft.logSqrtPowerSpectralDensityBatch(work.data(), batch, psd.data());
+                benchKeep(psd[1]);
+            });
+        }
+    }
+
+    // One hub frame (IntanDataHeader + [sample][stream][channel] blocks) as SharedMemoryWriter lays it out
+    std::vector<char> makeHubFrame(uint32_t streams, uint32_t channels, std::mt19937& rng) {
+        const uint32_t samples = 128;
+        size_t size = sizeof(IntanDataHeader) + (size_t)samples * streams * channels * sizeof(IntanDataBlock);
+        std::vector<char> frame(size);
+        IntanDataHeader* header = reinterpret_cast<IntanDataHeader*>(frame.data());
+        *header = IntanDataHeader();
+        header->magic = 0x494E5441;
+        header->dataSize = (uint32_t)size;
+        header->streamCount = streams;
+        header->channelCount = channels;
+        header->sampleRate = (uint32_t)SampleRate;
+        IntanDataBlock* blocks = reinterpret_cast<IntanDataBlock*>(frame.data() + sizeof(IntanDataHeader));
+        std::normal_distribution<float> noise(0.0f, 50.0f);
+        size_t w = 0;
+        for (uint32_t t = 0; t < samples; ++t)
+            for (uint32_t s = 0; s < streams; ++s)
+                for (uint32_t ch = 0; ch < channels; ++ch)
+                    blocks[w++] = { s, ch, noise(rng) };
+        return frame;
+    }
+
+    void benchPipelineController(BenchSuite& suite, std::mt19937& rng) {
+        // The controller logs every frame it ingests; keep that out of the report
+        std::ostringstream discard;
+        std::streambuf* coutBuffer = std::cout.rdbuf(discard.rdbuf());
+
+        const uint32_t streams = 4;
+        const uint32_t channels = 32;
+        std::unique_ptr<PipelineDataRHXController> controller(
+            new PipelineDataRHXController(ControllerRecordUSB3, SampleRate30000Hz));
+        for (uint32_t s = 0; s < streams; ++s) controller->enableDataStream(s, true);
+        controller->setPacingEnabled(false);
+
+        std::vector<char> frame = makeHubFrame(streams, channels, rng);
+        const uint64_t frameSamples = 128ull * streams * channels;
+        suite.run("PipelineDataRHXController::convertTCPDataToRHXBlock 4x32", frameSamples, frame.size(), [&]() {
+            controller->convertTCPDataToRHXBlock(frame.data(), frame.size());
+            discard.str(std::string());
+        });
+
+        // readDataBlocksRaw() composes USB-format blocks from the ingested samples (writeBlocksFromTCP). The frame
+        // is re-ingested each call so the data stays fresh; subtract the row above for the compose cost.
+        const int numBlocks = 1;
+        std::vector<uint8_t> usbBuffer(BytesPerWord * RHXDataBlock::dataBlockSizeInWords(ControllerRecordUSB3, streams) *
+                                       numBlocks);
+        suite.run("PipelineDataRHXController::convert+writeBlocksFromTCP 4x32", frameSamples, usbBuffer.size(), [&]() {
+            controller->convertTCPDataToRHXBlock(frame.data(), frame.size());
+            discard.str(std::string());
+            benchKeep(controller->readDataBlocksRaw(numBlocks, usbBuffer.data()));
+        });
+
+        controller.reset();
+        std::cout.rdbuf(coutBuffer);
+    }
+}
+
+int main(int argc, char* argv[]) {
+    BenchSuite suite("rhx_bench", argc, argv);
+    std::mt19937 rng(BenchSeed);
+
+    benchFilters(suite, rng);
+    benchFft(suite, rng);
+    benchPipelineController(suite, rng);
+
+    return suite.finish();
+}
@@ -0,0 +1,33 @@
+# Microbenchmarks for the RHX processing kernels (filters, FFT, PipelineDataRHXController ingest).
+# Needs QtCore for the RHX sources. Build and run with `make bench` from the repository root, or:
+#   qmake rhx_bench.pro && make && ./rhx_bench --json results/rhx.json
+
+QT -= gui
+CONFIG += c++17 console release
+CONFIG -= app_bundle
+
+TARGET = rhx_bench
+
+RHX = ../modified-intan-rhx/Engine
+
+INCLUDEPATH += . \
+               .. \
+               ../intan-reader \
+               $$RHX/API/Abstract \
+               $$RHX/API/Hardware \
+               $$RHX/API/Synthetic \
+               $$RHX/Processing
+
+SOURCES += rhx_bench.cpp \
+           $$RHX/Processing/filter.cpp \
+           $$RHX/Processing/fastfouriertransform.cpp \
+           $$RHX/API/Abstract/abstractrhxcontroller.cpp \
+           $$RHX/API/Hardware/rhxdatablock.cpp \
+           $$RHX/API/Hardware/rhxregisters.cpp \
+           $$RHX/API/Synthetic/randomnumber.cpp \
+           $$RHX/API/Synthetic/synthdatablockgenerator.cpp \
+           $$RHX/API/Synthetic/pipelinedatarhxcontroller.cpp
+
+HEADERS += bench_harness.h
+
+linux: LIBS += -lrt
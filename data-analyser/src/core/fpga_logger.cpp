@@ -1,5 +1,7 @@
 #include "fpga_logger.h"
 #include "hdf5_writer.h"
+#include "../../../intan-reader/latency_trace.h"
+#include "../../../intan-reader/adaptive_quantizer.h"
 #include <iostream>
 #include <filesystem>
 #include <cstdlib>
@@ -18,17 +20,36 @@ FpgaLogger::~FpgaLogger() {
     // HDF5 writers will be automatically closed when unique_ptr goes out of scope
 }
 
-void FpgaLogger::analyzeFpgaData(const std::vector<uint8_t>& fpgaData, const std::vector<uint8_t>& originalData) {
+void FpgaLogger::analyzeFpgaData(const std::vector<uint8_t>& fpgaData, const std::vector<uint8_t>& originalData,
+                                 FrameTrace* trace, const QuantizationParams* quantization) {
     if (fpgaData.empty()) {
         return;
     }
 
+    HaloResponse response = decodeFpgaData(fpgaData, trace);
+    logDecodedResponse(response, fpgaData, originalData, trace, quantization);
+}
+
+HaloResponse FpgaLogger::decodeFpgaData(const std::vector<uint8_t>& fpgaData, FrameTrace* trace) {
     // Decode the HALO response
     HaloResponse response = decoder_.decodeResponse(fpgaData);
     responseCount_++;
-    
+    if (trace) {
+        trace->stamp(TraceStageDecode);
+    }
+    return response;
+}
+
+void FpgaLogger::logDecodedResponse(const HaloResponse& response, const std::vector<uint8_t>& fpgaData,
+                                    const std::vector<uint8_t>& originalData, FrameTrace* trace,
+                                    const QuantizationParams* quantization) {
     // Log FPGA response to HDF5 (all responses, not just seizures)
-    logFpgaResponseToHdf5(response, fpgaData, originalData);
+    static const QuantizationParams fixedScale;
+    logFpgaResponseToHdf5(response, fpgaData, originalData, quantization ? *quantization : fixedScale);
+    if (trace) {
+        trace->stamp(TraceStageLog);
+        LatencyTracer::instance().record(*trace);
+    }
 }
 
 void FpgaLogger::setHaloPipeline(HaloPipeline pipeline) {
@@ -40,7 +61,8 @@ void FpgaLogger::setThresholds(double lowThreshold, double highThreshold) {
 }
 
 
-void FpgaLogger::logFpgaResponseToHdf5(const HaloResponse& response, const std::vector<uint8_t>& processedData, const std::vector<uint8_t>& originalData) {
+void FpgaLogger::logFpgaResponseToHdf5(const HaloResponse& response, const std::vector<uint8_t>& processedData, const std::vector<uint8_t>& originalData,
+                                       const QuantizationParams& quantization) {
     // Get current hour
     int currentHour = getCurrentHour();
     
@@ -64,10 +86,8 @@ void FpgaLogger::logFpgaResponseToHdf5(const HaloResponse& response, const std::
     // Store original neural data from all channels (0-31)
     size_t dataSize = std::min(originalData.size(), static_cast<size_t>(32));
     for (size_t i = 0; i < dataSize; ++i) {
-        // Convert back from scaled uint8_t to microvolts
-        // Original scaling: (value + 1000.0f) / 8.0f = uint8_t
-        // Reverse: (uint8_t * 8.0f) - 1000.0f = original microvolts
-        float originalMicrovolts = (static_cast<float>(originalData[i]) * 8.0f) - 1000.0f;
+        // Convert back from the quantized uint8_t to microvolts with the frame's own per-channel scale/offset
+        float originalMicrovolts = quantization.toMicrovolts(i, originalData[i]);
         
         codes[i] = static_cast<uint16_t>(originalData[i]) << 8; // Convert to 16-bit
         microvolts[i] = originalMicrovolts; // Store original microvolts
@@ -8,6 +8,9 @@
 
 #include "halo_response_decoder.h"
 
+struct FrameTrace;
+struct QuantizationParams;
+
 class FpgaLogger {
 private:
     HaloResponseDecoder decoder_;
@@ -18,8 +21,18 @@ public:
     FpgaLogger();
     ~FpgaLogger();
     
-    // Analyze FPGA response data with HALO decoding
-    void analyzeFpgaData(const std::vector<uint8_t>& fpgaData, const std::vector<uint8_t>& originalData);
+    // Analyze FPGA response data with HALO decoding; a traced frame gets its decode and log stages
+    // stamped and is then recorded in LatencyTracer. quantization is the per-channel scale/offset
+    // originalData was quantized with (SharedMemoryReader::getQuantization()); null = legacy fixed scale.
+    void analyzeFpgaData(const std::vector<uint8_t>& fpgaData, const std::vector<uint8_t>& originalData,
+                         FrameTrace* trace = nullptr, const QuantizationParams* quantization = nullptr);
+    
+    // The two halves of analyzeFpgaData. They share no state, so decoding and HDF5 logging can run on
+    // separate threads (one thread each).
+    HaloResponse decodeFpgaData(const std::vector<uint8_t>& fpgaData, FrameTrace* trace = nullptr);
+    void logDecodedResponse(const HaloResponse& response, const std::vector<uint8_t>& fpgaData,
+                            const std::vector<uint8_t>& originalData, FrameTrace* trace = nullptr,
+                            const QuantizationParams* quantization = nullptr);
     
     // Set HALO pipeline configuration
     void setHaloPipeline(HaloPipeline pipeline);
@@ -28,7 +41,8 @@ public:
     void setThresholds(double lowThreshold, double highThreshold);
     
 private:
-    void logFpgaResponseToHdf5(const HaloResponse& response, const std::vector<uint8_t>& processedData, const std::vector<uint8_t>& originalData);
+    void logFpgaResponseToHdf5(const HaloResponse& response, const std::vector<uint8_t>& processedData, const std::vector<uint8_t>& originalData,
+                               const QuantizationParams& quantization);
     void createHourlyWriter(int hour);
     std::string getDateString() const;
     std::string getHourString() const;
@@ -2,8 +2,13 @@
 #include <filesystem>
 #include <iostream>
 #include <iomanip>
+#include <mutex>
 #include <sstream>
 
+// The HDF5 library is not reentrant unless built thread-safe, so readers on different threads take turns
+// on every HDF5 call. Decoding what was read happens outside the lock.
+static std::mutex hdf5LibraryMutex;
+
 Hdf5Reader::Hdf5Reader() : file_(nullptr), dset_codes_(nullptr), dset_uv_(nullptr) {}
 
 Hdf5Reader::~Hdf5Reader() { close(); }
@@ -16,6 +21,7 @@ bool Hdf5Reader::open(const std::string& path) {
         return false;
     }
     
+    std::lock_guard<std::mutex> lock(hdf5LibraryMutex);
     hid_t file = H5Fopen(path.c_str(), H5F_ACC_RDONLY, H5P_DEFAULT);
     if (file < 0) {
         std::cerr << "[ERROR] Failed to open HDF5 file: " << path << std::endl;
@@ -46,6 +52,7 @@ bool Hdf5Reader::open(const std::string& path) {
 }
 
 void Hdf5Reader::close() {
+    std::lock_guard<std::mutex> lock(hdf5LibraryMutex);
     if (dset_codes_) { 
         H5Dclose(static_cast<hid_t>(reinterpret_cast<intptr_t>(dset_codes_))); 
         dset_codes_ = nullptr; 
@@ -64,6 +71,7 @@ bool Hdf5Reader::readHeader(IntanHeaderInfo& info) {
     if (!file_ || !dset_codes_) return false;
     
     hid_t dsetC = static_cast<hid_t>(reinterpret_cast<intptr_t>(dset_codes_));
+    std::lock_guard<std::mutex> lock(hdf5LibraryMutex);
     
     // Read attributes
     auto read_attr_u32 = [&](const char* name, uint32_t& value) -> bool {
@@ -97,34 +105,42 @@ std::vector<SeizureDetectionData> Hdf5Reader::readSeizureDetections() {
     hid_t dsetC = static_cast<hid_t>(reinterpret_cast<intptr_t>(dset_codes_));
     hid_t dsetU = static_cast<hid_t>(reinterpret_cast<intptr_t>(dset_uv_));
     
-    // Get dataset dimensions
-    hid_t spaceC = H5Dget_space(dsetC);
-    int ndims = H5Sget_simple_extent_ndims(spaceC);
-    if (ndims != 2) {
-        std::cerr << "[ERROR] Expected 2D dataset, got " << ndims << "D" << std::endl;
+    hsize_t numFrames = 0;
+    hsize_t numSignals = 0;
+    std::vector<uint16_t> codes;
+    std::vector<float> microvolts;
+    {
+        std::lock_guard<std::mutex> lock(hdf5LibraryMutex);
+
+        // Get dataset dimensions
+        hid_t spaceC = H5Dget_space(dsetC);
+        int ndims = H5Sget_simple_extent_ndims(spaceC);
+        if (ndims != 2) {
+            std::cerr << "[ERROR] Expected 2D dataset, got " << ndims << "D" << std::endl;
+            H5Sclose(spaceC);
+            return detections;
+        }
+        
+        hsize_t dims[2];
+        H5Sget_simple_extent_dims(spaceC, dims, nullptr);
         H5Sclose(spaceC);
-        return detections;
-    }
-    
-    hsize_t dims[2];
-    H5Sget_simple_extent_dims(spaceC, dims, nullptr);
-    H5Sclose(spaceC);
-    
-    hsize_t numFrames = dims[0];
-    hsize_t numSignals = dims[1];
-    
-    if (numFrames == 0) return detections;
-    
-    // Read all data at once
-    std::vector<uint16_t> codes(numFrames * numSignals);
-    std::vector<float> microvolts(numFrames * numSignals);
-    
-    herr_t status1 = H5Dread(dsetC, H5T_NATIVE_UINT16, H5S_ALL, H5S_ALL, H5P_DEFAULT, codes.data());
-    herr_t status2 = H5Dread(dsetU, H5T_NATIVE_FLOAT, H5S_ALL, H5S_ALL, H5P_DEFAULT, microvolts.data());
-    
-    if (status1 < 0 || status2 < 0) {
-        std::cerr << "[ERROR] Failed to read HDF5 data" << std::endl;
-        return detections;
+        
+        numFrames = dims[0];
+        numSignals = dims[1];
+        
+        if (numFrames == 0) return detections;
+        
+        // Read all data at once
+        codes.resize(numFrames * numSignals);
+        microvolts.resize(numFrames * numSignals);
+        
+        herr_t status1 = H5Dread(dsetC, H5T_NATIVE_UINT16, H5S_ALL, H5S_ALL, H5P_DEFAULT, codes.data());
+        herr_t status2 = H5Dread(dsetU, H5T_NATIVE_FLOAT, H5S_ALL, H5S_ALL, H5P_DEFAULT, microvolts.data());
+        
+        if (status1 < 0 || status2 < 0) {
+            std::cerr << "[ERROR] Failed to read HDF5 data" << std::endl;
+            return detections;
+        }
     }
     
     // Process each frame
@@ -251,6 +267,7 @@ std::vector<float> Hdf5Reader::readChannelData(int channelIndex) {
     
     hid_t dsetC = static_cast<hid_t>(reinterpret_cast<intptr_t>(dset_codes_));
     hid_t dsetU = static_cast<hid_t>(reinterpret_cast<intptr_t>(dset_uv_));
+    std::lock_guard<std::mutex> lock(hdf5LibraryMutex);
     
     // Get dataset dimensions
     hid_t spaceC = H5Dget_space(dsetC);
@@ -10,12 +10,24 @@
 #include <QDebug>
 #include <QTextStream>
 #include <QRegularExpression>
+#include <QMutexLocker>
+#include <QThread>
+#include <algorithm>
 #include <chrono>
+#include <iterator>
+
+static const int NumChannels = 32;
+static const int LatestDetectionCount = 20;
+static const int ChannelDataPoints = 50;
 
 SeizureAnalyzer::SeizureAnalyzer(QWidget *parent)
     : QMainWindow(parent)
     , centralWidget(nullptr)
+    , latestDetections(NumChannels)
     , fileWatcher(nullptr)
+    , channelDataLoading(false)
+    , channelDataReloadRequested(false)
+    , channelDataGeneration(0)
     , updateTimer(nullptr)
     , selectedChannel(0)
 {
@@ -30,12 +42,15 @@ SeizureAnalyzer::SeizureAnalyzer(QWidget *parent)
     }
     
     setupUI();
-    scanLogFiles();
     
-    // Set up file watcher
+    // Hour files are parsed in the background; HDF5 reads are serialized, the decoding runs in parallel
+    indexPool.setMaxThreadCount(qBound(1, QThread::idealThreadCount(), 4));
+    
+    // Set up file watcher (directories, plus today's hour files while they are being written)
     fileWatcher = new QFileSystemWatcher(this);
-    fileWatcher->addPath(logsDirectory);
-    connect(fileWatcher, &QFileSystemWatcher::directoryChanged, this, &SeizureAnalyzer::onFileChanged);
+    connect(fileWatcher, &QFileSystemWatcher::directoryChanged, this, &SeizureAnalyzer::onDirectoryChanged);
+    connect(fileWatcher, &QFileSystemWatcher::fileChanged, this, &SeizureAnalyzer::onFileChanged);
+    scanLogFiles();
     
     // Set up update timer (check every 5 seconds)
     
@@ -49,6 +64,8 @@ SeizureAnalyzer::SeizureAnalyzer(QWidget *parent)
 
 SeizureAnalyzer::~SeizureAnalyzer()
 {
+    indexPool.clear();
+    indexPool.waitForDone();
 }
 
 void SeizureAnalyzer::setupUI()
@@ -153,18 +170,58 @@ void SeizureAnalyzer::updateDisplay()
     lastUpdateLabel->setText("Last Update: " + QDateTime::currentDateTime().toString("hh:mm:ss"));
 }
 
+void SeizureAnalyzer::onDirectoryChanged(const QString &path)
+{
+    if (QDir(path) == QDir(logsDirectory)) {
+        // A day directory appeared or went away
+        QDir logsDir(logsDirectory);
+        QStringList watchedDirs = fileWatcher->directories();
+        for (const QString &dateDir : logsDir.entryList(QDir::Dirs | QDir::NoDotAndDotDot)) {
+            QString dirPath = logsDir.absoluteFilePath(dateDir);
+            if (!watchedDirs.contains(dirPath)) {
+                rescanDirectory(dirPath);
+            }
+        }
+        for (const QString &dirPath : watchedDirs) {
+            if (!QDir(dirPath).exists()) {
+                rescanDirectory(dirPath);
+            }
+        }
+    } else {
+        rescanDirectory(path);
+    }
+    updateDisplay();
+}
+
 void SeizureAnalyzer::onFileChanged(const QString &path)
 {
-    Q_UNUSED(path)
-    // File system changed, reload data
-    reloadData();
+    // Reparse only the file that changed
+    if (QFileInfo::exists(path)) {
+        indexFile(path);
+    } else {
+        removeFileDetections(path);
+        updateDisplay();
+    }
 }
 
 void SeizureAnalyzer::scanLogFiles()
 {
-    allDetections.clear();
-    dailyCounts.clear();
-    monthlyCounts.clear();
+    // Drop queued work and wait for the files already being parsed, then start over
+    indexPool.clear();
+    indexPool.waitForDone();
+    {
+        QMutexLocker locker(&completedMutex);
+        completedFiles.clear();
+    }
+    filesInFlight.clear();
+    reindexRequested.clear();
+    indexedFiles.clear();
+    dailyChannelCounts.clear();
+    latestDetections.fill(LatestDetections());
+    filesByNewestDetection.clear();
+    channelDataGeneration++;   // a read queued before the rescan no longer counts
+    channelDataLoading = false;
+    channelDataReloadRequested = false;
     
     // Debug: Print current working directory and logs directory
     QString currentDir = QDir::currentPath();
@@ -182,106 +239,280 @@ void SeizureAnalyzer::scanLogFiles()
         QMessageBox::warning(this, "Warning", errorMsg);
         return;
     }
+    if (!fileWatcher->directories().contains(logsDir.absolutePath())) {
+        fileWatcher->addPath(logsDir.absolutePath());
+    }
     
-    // Scan all date directories (no debug output for long-term stability)
+    // Queue every hour file of every date directory (no debug output for long-term stability)
     QStringList dateDirs = logsDir.entryList(QDir::Dirs | QDir::NoDotAndDotDot);
     for (const QString &dateDir : dateDirs) {
-        QDir dayDir(logsDir.absoluteFilePath(dateDir));
-        QStringList h5Files = dayDir.entryList(QStringList() << "*.h5", QDir::Files);
+        rescanDirectory(logsDir.absoluteFilePath(dateDir));
+    }
+}
+
+// Bring one date directory up to date: index new or modified hour files and forget deleted ones
+void SeizureAnalyzer::rescanDirectory(const QString &dirPath)
+{
+    QDir dayDir(dirPath);
+    QString dirPrefix = dayDir.absolutePath() + "/";
+    QSet<QString> present;
+    
+    if (dayDir.exists()) {
+        if (!fileWatcher->directories().contains(dayDir.absolutePath())) {
+            fileWatcher->addPath(dayDir.absolutePath());
+        }
+        bool today = QDate::fromString(dayDir.dirName(), "yyyy-MM-dd") == QDate::currentDate();
+        QStringList watchedFiles = fileWatcher->files();
         
-        for (const QString &h5File : h5Files) {
-            QString filePath = dayDir.absoluteFilePath(h5File);
-            parseHdf5File(filePath);
+        QFileInfoList h5Files = dayDir.entryInfoList(QStringList() << "hour_*.h5", QDir::Files);
+        for (const QFileInfo &fileInfo : h5Files) {
+            QString filePath = fileInfo.absoluteFilePath();
+            present.insert(filePath);
+            if (today && !watchedFiles.contains(filePath)) {
+                fileWatcher->addPath(filePath);
+            }
+            
+            QMap<QString, IndexedHourFile>::const_iterator known = indexedFiles.constFind(filePath);
+            if (known == indexedFiles.constEnd() || known->lastModified != fileInfo.lastModified() ||
+                known->size != fileInfo.size()) {
+                indexFile(filePath);
+            }
+        }
+    } else if (fileWatcher->directories().contains(dirPath)) {
+        fileWatcher->removePath(dirPath);
+    }
+    
+    QStringList removed;
+    for (auto it = indexedFiles.constBegin(); it != indexedFiles.constEnd(); ++it) {
+        if (it.key().startsWith(dirPrefix) && !present.contains(it.key())) {
+            removed.append(it.key());
+        }
+    }
+    for (const QString &filePath : removed) {
+        removeFileDetections(filePath);
+    }
+}
+
+void SeizureAnalyzer::indexFile(const QString &filePath)
+{
+    if (filesInFlight.contains(filePath)) {
+        reindexRequested.insert(filePath);
+        return;
+    }
+    filesInFlight.insert(filePath);
+    
+    indexPool.start([this, filePath]() {
+        IndexedHourFile file = parseHdf5File(filePath);
+        bool firstOfBatch;
+        {
+            QMutexLocker locker(&completedMutex);
+            firstOfBatch = completedFiles.isEmpty();
+            completedFiles.append(file);
+        }
+        // One queued call picks up everything that completes before the GUI thread gets to it
+        if (firstOfBatch) {
+            QMetaObject::invokeMethod(this, &SeizureAnalyzer::applyIndexedFiles, Qt::QueuedConnection);
         }
+    });
+}
+
+void SeizureAnalyzer::applyIndexedFiles()
+{
+    QList<IndexedHourFile> batch;
+    {
+        QMutexLocker locker(&completedMutex);
+        batch.swap(completedFiles);
+    }
+    if (batch.isEmpty()) {
+        return;
     }
+    
+    for (const IndexedHourFile &file : batch) {
+        filesInFlight.remove(file.filePath);
+        if (file.ok) {
+            removeFileDetections(file.filePath);
+            addFileDetections(file);
+        }
+        if (reindexRequested.remove(file.filePath)) {
+            indexFile(file.filePath);
+        }
+    }
+    updateDisplay();
 }
 
-void SeizureAnalyzer::parseHdf5File(const QString &filePath)
+void SeizureAnalyzer::addFileDetections(const IndexedHourFile &file)
+{
+    QVector<QList<SeizureDetection>> channelDetections(NumChannels);
+    QDateTime newest;
+    for (const SeizureDetection &detection : file.detections) {
+        if (detection.timestamp > newest) {
+            newest = detection.timestamp;
+        }
+        if (detection.channelIndex < 0 || detection.channelIndex >= NumChannels) continue;
+        QVector<int> &counts = dailyChannelCounts[detection.timestamp.date()];
+        if (counts.isEmpty()) {
+            counts.fill(0, NumChannels);
+        }
+        counts[detection.channelIndex]++;
+        channelDetections[detection.channelIndex].append(detection);
+    }
+    for (int channel = 0; channel < NumChannels; ++channel) {
+        if (!channelDetections[channel].isEmpty()) {
+            mergeLatestDetections(latestDetections[channel], channelDetections[channel]);
+        }
+    }
+    if (newest.isValid()) {
+        filesByNewestDetection.insert(newest, file.filePath);
+    }
+    indexedFiles.insert(file.filePath, file);
+}
+
+void SeizureAnalyzer::removeFileDetections(const QString &filePath)
+{
+    QMap<QString, IndexedHourFile>::iterator it = indexedFiles.find(filePath);
+    if (it == indexedFiles.end()) {
+        return;
+    }
+    QDateTime newest;
+    for (const SeizureDetection &detection : it->detections) {
+        if (detection.timestamp > newest) {
+            newest = detection.timestamp;
+        }
+        if (detection.channelIndex < 0 || detection.channelIndex >= NumChannels) continue;
+        QMap<QDate, QVector<int>>::iterator day = dailyChannelCounts.find(detection.timestamp.date());
+        if (day == dailyChannelCounts.end()) continue;
+        (*day)[detection.channelIndex]--;
+        if (std::all_of(day->constBegin(), day->constEnd(), [](int count) { return count == 0; })) {
+            dailyChannelCounts.erase(day);
+        }
+    }
+    if (newest.isValid()) {
+        filesByNewestDetection.remove(newest, filePath);
+    }
+    
+    // Only the file's own entries leave the latest lists; a list that drops below
+    // LatestDetectionCount is refilled from the other files when it is next shown
+    for (LatestDetections &latest : latestDetections) {
+        latest.detections.erase(std::remove_if(latest.detections.begin(), latest.detections.end(),
+                                               [&filePath](const SeizureDetection &detection) {
+                                                   return detection.filePath == filePath;
+                                               }),
+                                latest.detections.end());
+    }
+    indexedFiles.erase(it);
+}
+
+void SeizureAnalyzer::mergeLatestDetections(LatestDetections &latest, const QList<SeizureDetection> &additions)
+{
+    for (const SeizureDetection &detection : additions) {
+        if (!latest.floor.isValid() || detection.timestamp > latest.floor) {
+            latest.detections.append(detection);
+        }
+    }
+    std::stable_sort(latest.detections.begin(), latest.detections.end(),
+                     [](const SeizureDetection &a, const SeizureDetection &b) {
+                         return a.timestamp > b.timestamp;
+                     });
+    if (latest.detections.size() > LatestDetectionCount) {
+        latest.floor = latest.detections[LatestDetectionCount].timestamp;
+        latest.detections.erase(latest.detections.begin() + LatestDetectionCount, latest.detections.end());
+    }
+}
+
+// Full scan of one channel, only needed after removals trimmed its list below LatestDetectionCount
+void SeizureAnalyzer::rebuildLatestDetections(int channel)
+{
+    LatestDetections &latest = latestDetections[channel];
+    latest = LatestDetections();
+    for (const IndexedHourFile &file : indexedFiles) {
+        QList<SeizureDetection> channelDetections;
+        for (const SeizureDetection &detection : file.detections) {
+            if (detection.channelIndex == channel) {
+                channelDetections.append(detection);
+            }
+        }
+        if (!channelDetections.isEmpty()) {
+            mergeLatestDetections(latest, channelDetections);
+        }
+    }
+}
+
+// Runs on an index worker: touches nothing but its own result
+IndexedHourFile SeizureAnalyzer::parseHdf5File(const QString &filePath)
 {
     QFileInfo fileInfo(filePath);
     QString fileName = fileInfo.fileName();
     
+    IndexedHourFile result;
+    result.filePath = filePath;
+    result.lastModified = fileInfo.lastModified();
+    result.size = fileInfo.size();
+    result.ok = false;
+    
     // Check if this is an hourly FPGA response file
-    if (fileName.startsWith("hour_") && fileName.endsWith(".h5")) {
-        // Extract hour from filename
-        QRegularExpression hourRegex("hour_(\\d+)\\.h5");
-        QRegularExpressionMatch match = hourRegex.match(fileName);
-        if (match.hasMatch()) {
-            // Extract hour from filename (for potential future use)
-            int hour = match.captured(1).toInt();
-            Q_UNUSED(hour); // Suppress unused variable warning
+    QRegularExpression hourRegex("hour_(\\d+)\\.h5");
+    QRegularExpressionMatch match = hourRegex.match(fileName);
+    if (!match.hasMatch()) {
+        return result;
+    }
+    
+    // Extract date from directory name
+    QString dateStr = fileInfo.dir().dirName();
+    QDate date = QDate::fromString(dateStr, "yyyy-MM-dd");
+    if (!date.isValid()) {
+        return result;
+    }
+    
+    // Parse the actual HDF5 file
+    Hdf5Reader reader;
+    if (!reader.open(filePath.toStdString())) {
+        qDebug() << "Failed to open HDF5 file:" << filePath;
+        return result;
+    }
+    std::vector<SeizureDetectionData> detections = reader.readSeizureDetections();
+    reader.close();
+    
+    for (const auto& detection : detections) {
+        // Only add seizure detections (not normal activity)
+        QString detectionType = QString::fromStdString(detection.responseType);
+        if (detectionType == "SEIZURE_DETECTED" || detectionType == "THRESHOLD_EXCEEDED") {
+            SeizureDetection qtDetection;
             
-            // Extract date from directory name
-            QString dateStr = fileInfo.dir().dirName();
-            QDate date = QDate::fromString(dateStr, "yyyy-MM-dd");
+            // Convert std::chrono::time_point to QDateTime
+            auto time_t = std::chrono::system_clock::to_time_t(detection.timestamp);
+            qtDetection.timestamp = QDateTime::fromSecsSinceEpoch(time_t);
             
-            if (date.isValid()) {
-                // Parse the actual HDF5 file
-                Hdf5Reader reader;
-                if (reader.open(filePath.toStdString())) {
-                    std::vector<SeizureDetectionData> detections = reader.readSeizureDetections();
-                    
-                    for (const auto& detection : detections) {
-                        // Only add seizure detections (not normal activity)
-                        QString detectionType = QString::fromStdString(detection.responseType);
-                        if (detectionType == "SEIZURE_DETECTED" || detectionType == "THRESHOLD_EXCEEDED") {
-                            SeizureDetection qtDetection;
-                            
-                            // Convert std::chrono::time_point to QDateTime
-                            auto time_t = std::chrono::system_clock::to_time_t(detection.timestamp);
-                            qtDetection.timestamp = QDateTime::fromSecsSinceEpoch(time_t);
-                            
-                            qtDetection.type = detectionType;
-                            qtDetection.confidence = detection.confidence;
-                            qtDetection.activityLevel = detection.activityLevel;
-                            qtDetection.rawData = detection.rawData;
-                            qtDetection.filePath = filePath;
-                            qtDetection.channelIndex = detection.channelIndex;
-                            
-                            allDetections.append(qtDetection);
-                        }
-                    }
-                    
-                    reader.close();
-                } else {
-                    qDebug() << "Failed to open HDF5 file:" << filePath;
-                }
-            }
+            qtDetection.type = detectionType;
+            qtDetection.confidence = detection.confidence;
+            qtDetection.activityLevel = detection.activityLevel;
+            qtDetection.rawData = detection.rawData;
+            qtDetection.filePath = filePath;
+            qtDetection.channelIndex = detection.channelIndex;
+            
+            result.detections.append(qtDetection);
         }
     }
-    
-    // Also check for neural data files (intan_shm_*.h5)
-    if (fileName.startsWith("intan_shm_") && fileName.endsWith(".h5")) {
-        // For neural data files, we could parse them too if needed
-        // For now, just count them as potential seizure sources
-    }
+    result.ok = true;
+    return result;
 }
 
 void SeizureAnalyzer::updateSeizureCounts()
 {
-    // Filter detections by selected channel
-    QList<SeizureDetection> channelDetections;
-    for (const SeizureDetection &detection : allDetections) {
-        if (detection.channelIndex == selectedChannel) {
-            channelDetections.append(detection);
-        }
-    }
-    
-    int totalSeizures = channelDetections.size();
+    // Sum the per-day counts of the selected channel
+    int totalSeizures = 0;
     int todaySeizures = 0;
     int monthlySeizures = 0;
     
     QDate today = QDate::currentDate();
-    QString currentMonth = today.toString("yyyy-MM");
     
-    for (const SeizureDetection &detection : channelDetections) {
-        if (detection.timestamp.date() == today) {
-            todaySeizures++;
+    for (auto it = dailyChannelCounts.constBegin(); it != dailyChannelCounts.constEnd(); ++it) {
+        int count = it.value()[selectedChannel];
+        totalSeizures += count;
+        if (it.key() == today) {
+            todaySeizures += count;
         }
-        
-        QString detectionMonth = detection.timestamp.date().toString("yyyy-MM");
-        if (detectionMonth == currentMonth) {
-            monthlySeizures++;
+        if (it.key().year() == today.year() && it.key().month() == today.month()) {
+            monthlySeizures += count;
         }
     }
     
@@ -292,26 +523,17 @@ void SeizureAnalyzer::updateSeizureCounts()
 
 void SeizureAnalyzer::updateLatestDetections()
 {
-    // Filter detections by selected channel
-    QList<SeizureDetection> channelDetections;
-    for (const SeizureDetection &detection : allDetections) {
-        if (detection.channelIndex == selectedChannel) {
-            channelDetections.append(detection);
-        }
+    // The selected channel's running list, newest first
+    LatestDetections &latest = latestDetections[selectedChannel];
+    if (latest.detections.size() < LatestDetectionCount && latest.floor.isValid()) {
+        rebuildLatestDetections(selectedChannel);
     }
     
-    // Sort detections by timestamp (newest first)
-    std::sort(channelDetections.begin(), channelDetections.end(), 
-              [](const SeizureDetection &a, const SeizureDetection &b) {
-                  return a.timestamp > b.timestamp;
-              });
-    
-    // Take latest 20
-    int count = qMin(20, channelDetections.size());
+    int count = qMin(LatestDetectionCount, latest.detections.size());
     latestDetectionsTable->setRowCount(count);
     
     for (int i = 0; i < count; ++i) {
-        const SeizureDetection &detection = channelDetections[i];
+        const SeizureDetection &detection = latest.detections[i];
         
         latestDetectionsTable->setItem(i, 0, new QTableWidgetItem(detection.timestamp.toString("yyyy-MM-dd hh:mm:ss")));
         latestDetectionsTable->setItem(i, 1, new QTableWidgetItem(detection.type));
@@ -323,24 +545,19 @@ void SeizureAnalyzer::updateLatestDetections()
 
 void SeizureAnalyzer::updateDailyCounts()
 {
-    // Count seizures per day for selected channel
-    dailyCounts.clear();
-    for (const SeizureDetection &detection : allDetections) {
-        if (detection.channelIndex == selectedChannel) {
-            QDate date = detection.timestamp.date();
-            dailyCounts[date]++;
+    // Days with seizures on the selected channel, newest first
+    QList<QDate> dates;
+    for (auto it = dailyChannelCounts.constBegin(); it != dailyChannelCounts.constEnd(); ++it) {
+        if (it.value()[selectedChannel] > 0) {
+            dates.prepend(it.key());
         }
     }
     
-    // Update table
-    dailyCountsTable->setRowCount(dailyCounts.size());
-    
-    QList<QDate> dates = dailyCounts.keys();
-    std::sort(dates.begin(), dates.end(), std::greater<QDate>());
+    dailyCountsTable->setRowCount(dates.size());
     
     for (int i = 0; i < dates.size(); ++i) {
         QDate date = dates[i];
-        int count = dailyCounts[date];
+        int count = dailyChannelCounts[date][selectedChannel];
         
         dailyCountsTable->setItem(i, 0, new QTableWidgetItem(date.toString("yyyy-MM-dd")));
         dailyCountsTable->setItem(i, 1, new QTableWidgetItem(QString::number(count)));
@@ -361,53 +578,104 @@ void SeizureAnalyzer::onChannelChanged(int channel)
 
 void SeizureAnalyzer::updateChannelData()
 {
-    channelDataTable->setRowCount(0);
-    
-    if (allDetections.isEmpty()) {
+    // Channel data comes from the hour file holding the most recent detection
+    if (filesByNewestDetection.isEmpty()) {
+        channelData = ChannelDataSnapshot();
+        channelDataReloadRequested = false;
+        channelDataTable->setRowCount(0);
         return;
     }
-    
-    // Get the most recent HDF5 file to read channel data from
-    QString latestFile;
-    QDateTime latestTime;
-    
-    for (const SeizureDetection &detection : allDetections) {
-        if (detection.timestamp > latestTime) {
-            latestTime = detection.timestamp;
-            latestFile = detection.filePath;
+    QMultiMap<QDateTime, QString>::const_iterator newest = std::prev(filesByNewestDetection.constEnd());
+    
+    ChannelDataSnapshot request;
+    request.filePath = newest.value();
+    request.lastModified = indexedFiles.value(request.filePath).lastModified;
+    request.channel = selectedChannel;
+    request.baseTime = newest.key();
+    
+    if (request.filePath == channelData.filePath && request.lastModified == channelData.lastModified &&
+        request.channel == channelData.channel) {
+        // Samples already shown; only their timestamps may have moved
+        if (request.baseTime != channelData.baseTime) {
+            channelData.baseTime = request.baseTime;
+            showChannelData();
         }
+        return;
     }
-    
-    if (latestFile.isEmpty()) {
+    loadChannelData(request);
+}
+
+void SeizureAnalyzer::loadChannelData(const ChannelDataSnapshot &request)
+{
+    // One read at a time; whatever is wanted once it finishes is requested then
+    if (channelDataLoading) {
+        channelDataReloadRequested = true;
         return;
     }
+    channelDataLoading = true;
+    
+    // Ahead of queued hour files, so the table does not wait for a whole month to be indexed
+    quint64 generation = channelDataGeneration;
+    indexPool.start([this, request, generation]() {
+        ChannelDataSnapshot snapshot = readChannelTail(request);
+        QMetaObject::invokeMethod(this, [this, snapshot, generation]() {
+            applyChannelData(snapshot, generation);
+        }, Qt::QueuedConnection);
+    }, 1);
+}
+
+// Runs on an index worker: touches nothing but its own result
+ChannelDataSnapshot SeizureAnalyzer::readChannelTail(const ChannelDataSnapshot &request)
+{
+    ChannelDataSnapshot snapshot = request;
     
-    // Read channel data from the latest file
     Hdf5Reader reader;
-    if (!reader.open(latestFile.toStdString())) {
-        return;
+    if (!reader.open(request.filePath.toStdString())) {
+        return snapshot;
     }
-    
-    std::vector<float> channelData = reader.readChannelData(selectedChannel);
+    std::vector<float> samples = reader.readChannelData(request.channel);
     reader.close();
     
-    if (channelData.empty()) {
+    // Keep only the points the table shows
+    int numPoints = qMin(ChannelDataPoints, static_cast<int>(samples.size()));
+    snapshot.firstIndex = static_cast<int>(samples.size()) - numPoints;
+    snapshot.values.reserve(numPoints);
+    for (int i = snapshot.firstIndex; i < static_cast<int>(samples.size()); ++i) {
+        snapshot.values.append(samples[i]);
+    }
+    return snapshot;
+}
+
+void SeizureAnalyzer::applyChannelData(const ChannelDataSnapshot &snapshot, quint64 generation)
+{
+    // A rescan started over while this read was running
+    if (generation != channelDataGeneration) {
         return;
     }
+    channelDataLoading = false;
+    channelData = snapshot;
+    showChannelData();
     
-    // Show the last 50 data points
-    int numPoints = qMin(50, static_cast<int>(channelData.size()));
+    if (channelDataReloadRequested) {
+        channelDataReloadRequested = false;
+        updateChannelData();
+    }
+}
+
+void SeizureAnalyzer::showChannelData()
+{
+    int numPoints = channelData.values.size();
     channelDataTable->setRowCount(numPoints);
     
     for (int i = 0; i < numPoints; ++i) {
-        int dataIndex = channelData.size() - numPoints + i;
-        float value = channelData[dataIndex];
+        int dataIndex = channelData.firstIndex + i;
+        float value = channelData.values[i];
         
         // Generate timestamp (approximate based on data index)
-        QDateTime timestamp = latestTime.addSecs(dataIndex);
+        QDateTime timestamp = channelData.baseTime.addSecs(dataIndex);
         
         channelDataTable->setItem(i, 0, new QTableWidgetItem(timestamp.toString("hh:mm:ss")));
         channelDataTable->setItem(i, 1, new QTableWidgetItem(QString::number(value, 'f', 3)));
-        channelDataTable->setItem(i, 2, new QTableWidgetItem(QFileInfo(latestFile).fileName()));
+        channelDataTable->setItem(i, 2, new QTableWidgetItem(QFileInfo(channelData.filePath).fileName()));
     }
 }
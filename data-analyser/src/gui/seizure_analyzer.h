@@ -14,6 +14,10 @@
 #include <QDate>
 #include <QFileSystemWatcher>
 #include <QComboBox>
+#include <QMutex>
+#include <QSet>
+#include <QThreadPool>
+#include <QVector>
 #include "../core/hdf5_reader.h"
 
 QT_BEGIN_NAMESPACE
@@ -32,6 +36,32 @@ struct SeizureDetection {
     // Channel where detection occurred (0-31)
 };
 
+// Result of indexing one hour file on a worker thread
+struct IndexedHourFile {
+    QString filePath;
+    QDateTime lastModified;   // as seen before parsing; a later change triggers a reparse
+    qint64 size;
+    bool ok;                  // false if the file could not be read (e.g. still being written)
+    QList<SeizureDetection> detections;
+};
+
+// Newest detections of one channel, newest first. Every detection newer than floor is in the
+// list; older ones were trimmed away (an invalid floor means nothing was trimmed)
+struct LatestDetections {
+    QList<SeizureDetection> detections;
+    QDateTime floor;
+};
+
+// Tail of one channel's samples from an hour file, read on a worker thread
+struct ChannelDataSnapshot {
+    QString filePath;
+    QDateTime lastModified;   // of the indexed file the samples were requested for
+    int channel = -1;
+    QDateTime baseTime;       // newest detection time, the samples are timestamped from it
+    int firstIndex = 0;       // sample index of values[0] within the file
+    QVector<float> values;
+};
+
 class SeizureAnalyzer : public QMainWindow
 {
     Q_OBJECT
@@ -43,17 +73,29 @@ public:
 private slots:
     void reloadData();
     void updateDisplay();
+    void onDirectoryChanged(const QString &path);
     void onFileChanged(const QString &path);
     void onChannelChanged(int channel);
 
 private:
     void setupUI();
     void scanLogFiles();
-    void parseHdf5File(const QString &filePath);
+    void rescanDirectory(const QString &dirPath);
+    void indexFile(const QString &filePath);
+    static IndexedHourFile parseHdf5File(const QString &filePath);
+    void applyIndexedFiles();
+    void addFileDetections(const IndexedHourFile &file);
+    void removeFileDetections(const QString &filePath);
+    void mergeLatestDetections(LatestDetections &latest, const QList<SeizureDetection> &additions);
+    void rebuildLatestDetections(int channel);
     void updateSeizureCounts();
     void updateLatestDetections();
     void updateDailyCounts();
     void updateChannelData();
+    void loadChannelData(const ChannelDataSnapshot &request);
+    static ChannelDataSnapshot readChannelTail(const ChannelDataSnapshot &request);
+    void applyChannelData(const ChannelDataSnapshot &snapshot, quint64 generation);
+    void showChannelData();
     
     // UI Components
     QWidget *centralWidget;
@@ -76,11 +118,27 @@ private:
     QTableWidget *dailyCountsTable;
     QTableWidget *channelDataTable;
     
-    // Data
-    QList<SeizureDetection> allDetections;
-    QMap<QDate, int> dailyCounts;
-    QMap<QString, int> monthlyCounts;
+    // Data: detections per hour file, and per-day counts for each channel kept in step with them
+    QMap<QString, IndexedHourFile> indexedFiles;
+    QMap<QDate, QVector<int>> dailyChannelCounts;
+    QVector<LatestDetections> latestDetections;               // per channel
+    QMultiMap<QDateTime, QString> filesByNewestDetection;     // hour files keyed by their newest detection
     QFileSystemWatcher *fileWatcher;
+
+    // Background indexing: workers parse hour files and queue the results; the GUI thread merges
+    // whatever has completed in one batch
+    QThreadPool indexPool;
+    QMutex completedMutex;
+    QList<IndexedHourFile> completedFiles;
+    QSet<QString> filesInFlight;
+    QSet<QString> reindexRequested;   // changed again while being parsed
+    
+    // Channel data table: samples are read on indexPool as well and kept until the newest file,
+    // its modification time or the channel changes
+    ChannelDataSnapshot channelData;
+    bool channelDataLoading;
+    bool channelDataReloadRequested;   // wanted different samples while a read was running
+    quint64 channelDataGeneration;     // bumped by every rescan
     QTimer *updateTimer;
     
     QString logsDirectory;
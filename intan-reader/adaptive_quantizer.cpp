@@ -0,0 +1,160 @@
+#include "adaptive_quantizer.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define QUANTIZE_SSE2
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define QUANTIZE_NEON
+#endif
+
+static_assert(sizeof(IntanDataBlock) == 3 * sizeof(float), "hub blocks are read as float triples");
+
+namespace {
+    // Copy one time point's values out of the {streamId, channelId, value} blocks and fold them into the
+    // per-channel frame min/max. SIMD paths take four blocks (three 16-byte loads) per step.
+    void gatherRow(const IntanDataBlock* blocks, size_t count, float* __restrict values,
+                   float* __restrict frameMin, float* __restrict frameMax) {
+        const float* in = reinterpret_cast<const float*>(blocks);
+        size_t c = 0;
+#if defined(QUANTIZE_SSE2)
+        for (; c + 4 <= count; c += 4) {
+            __m128 a = _mm_loadu_ps(in + 3 * c);        // s0 c0 v0 s1
+            __m128 b = _mm_loadu_ps(in + 3 * c + 4);    // c1 v1 s2 c2
+            __m128 d = _mm_loadu_ps(in + 3 * c + 8);    // v2 s3 c3 v3
+            __m128 ab = _mm_shuffle_ps(a, b, _MM_SHUFFLE(1, 1, 2, 2));
+            __m128 dd = _mm_shuffle_ps(d, d, _MM_SHUFFLE(3, 3, 0, 0));
+            __m128 v = _mm_shuffle_ps(ab, dd, _MM_SHUFFLE(2, 0, 2, 0));
+            _mm_storeu_ps(values + c, v);
+            _mm_storeu_ps(frameMin + c, _mm_min_ps(v, _mm_loadu_ps(frameMin + c)));
+            _mm_storeu_ps(frameMax + c, _mm_max_ps(v, _mm_loadu_ps(frameMax + c)));
+        }
+#elif defined(QUANTIZE_NEON)
+        for (; c + 4 <= count; c += 4) {
+            float32x4_t v = vld3q_f32(in + 3 * c).val[2];
+            vst1q_f32(values + c, v);
+            vst1q_f32(frameMin + c, vminq_f32(v, vld1q_f32(frameMin + c)));
+            vst1q_f32(frameMax + c, vmaxq_f32(v, vld1q_f32(frameMax + c)));
+        }
+#endif
+        for (; c < count; ++c) {
+            float v = in[3 * c + 2];
+            values[c] = v;
+            frameMin[c] = v < frameMin[c] ? v : frameMin[c];
+            frameMax[c] = v > frameMax[c] ? v : frameMax[c];
+        }
+    }
+
+    // Quantize `count` contiguous channels of one time point: round((v - offset) * inverseScale), saturated
+    // to 0..255. Every path rounds to nearest-even; the SIMD paths saturate in the integer packs.
+    void quantizeRow(const float* values, const float* offset, const float* inverseScale, size_t count,
+                     uint8_t* out) {
+        size_t c = 0;
+#if defined(QUANTIZE_SSE2)
+        for (; c + 16 <= count; c += 16) {
+            __m128i q[4];
+            for (int k = 0; k < 4; ++k) {
+                __m128 v = _mm_sub_ps(_mm_loadu_ps(values + c + 4 * k), _mm_loadu_ps(offset + c + 4 * k));
+                q[k] = _mm_cvtps_epi32(_mm_mul_ps(v, _mm_loadu_ps(inverseScale + c + 4 * k)));
+            }
+            __m128i packed = _mm_packus_epi16(_mm_packs_epi32(q[0], q[1]), _mm_packs_epi32(q[2], q[3]));
+            _mm_storeu_si128((__m128i*)(out + c), packed);
+        }
+#elif defined(QUANTIZE_NEON)
+        for (; c + 16 <= count; c += 16) {
+            int32x4_t q[4];
+            for (int k = 0; k < 4; ++k) {
+                float32x4_t v = vsubq_f32(vld1q_f32(values + c + 4 * k), vld1q_f32(offset + c + 4 * k));
+                q[k] = vcvtnq_s32_f32(vmulq_f32(v, vld1q_f32(inverseScale + c + 4 * k)));
+            }
+            int16x8_t low = vcombine_s16(vqmovn_s32(q[0]), vqmovn_s32(q[1]));
+            int16x8_t high = vcombine_s16(vqmovn_s32(q[2]), vqmovn_s32(q[3]));
+            vst1q_u8(out + c, vcombine_u8(vqmovun_s16(low), vqmovun_s16(high)));
+        }
+#endif
+        for (; c < count; ++c) {
+            float scaled = (values[c] - offset[c]) * inverseScale[c];
+            scaled = std::max(0.0f, std::min(255.0f, scaled));
+            out[c] = static_cast<uint8_t>(std::nearbyint(scaled));
+        }
+    }
+}
+
+AdaptiveQuantizer::AdaptiveQuantizer(const QuantizerConfig& config) : config_(config) {
+}
+
+void AdaptiveQuantizer::reset() {
+    params_ = QuantizationParams();
+    low_.clear();
+    high_.clear();
+}
+
+void AdaptiveQuantizer::quantize(const IntanDataBlock* blocks, size_t numBlocks, uint32_t channels,
+                                 std::vector<uint8_t>& out) {
+    out.resize(numBlocks);
+    if (numBlocks == 0 || channels == 0) {
+        return;
+    }
+    if (channels != params_.channels) {
+        reset();
+        params_.channels = channels;
+        params_.scale.assign(channels, 0.0f);
+        params_.offset.assign(channels, 0.0f);
+        inverseScale_.assign(channels, 0.0f);
+        frameMin_.resize(channels);
+        frameMax_.resize(channels);
+    }
+
+    // Deinterleave the values and take each channel's frame min/max in one pass over the blocks
+    values_.resize(numBlocks);
+    size_t rows = (numBlocks + channels - 1) / channels;
+    // Channels with no sample in a short frame keep min > max, and updateEnvelopes leaves them alone
+    std::fill(frameMin_.begin(), frameMin_.end(), std::numeric_limits<float>::infinity());
+    std::fill(frameMax_.begin(), frameMax_.end(), -std::numeric_limits<float>::infinity());
+    for (size_t row = 0; row < rows; ++row) {
+        size_t first = row * channels;
+        size_t count = std::min<size_t>(channels, numBlocks - first);
+        gatherRow(blocks + first, count, &values_[first], frameMin_.data(), frameMax_.data());
+    }
+    updateEnvelopes(channels);
+
+    for (size_t row = 0; row < rows; ++row) {
+        size_t first = row * channels;
+        size_t count = std::min<size_t>(channels, numBlocks - first);
+        quantizeRow(&values_[first], params_.offset.data(), inverseScale_.data(), count, &out[first]);
+    }
+}
+
+void AdaptiveQuantizer::updateEnvelopes(uint32_t channels) {
+    float minSpan = std::max(config_.minSpanUv, 1.0e-3f);
+    bool first = low_.empty();
+    if (first) {
+        low_.assign(frameMin_.begin(), frameMin_.end());
+        high_.assign(frameMax_.begin(), frameMax_.end());
+    }
+    for (uint32_t c = 0; c < channels; ++c) {
+        bool sampled = frameMin_[c] <= frameMax_[c];
+        if (!sampled && first) {
+            low_[c] = high_[c] = 0.0f;
+        } else if (!sampled) {
+            continue;
+        } else if (!first) {
+            float lowGap = frameMin_[c] - low_[c];
+            float highGap = frameMax_[c] - high_[c];
+            low_[c] += (lowGap < 0.0f ? config_.attack : config_.release) * lowGap;
+            high_[c] += (highGap > 0.0f ? config_.attack : config_.release) * highGap;
+        }
+        float span = high_[c] - low_[c];
+        float offset = low_[c];
+        if (!(span >= minSpan)) {
+            offset = 0.5f * (low_[c] + high_[c] - minSpan);
+            span = minSpan;
+        }
+        params_.offset[c] = offset;
+        params_.scale[c] = span / 255.0f;
+        inverseScale_[c] = 255.0f / span;
+    }
+}
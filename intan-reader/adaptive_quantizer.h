@@ -0,0 +1,64 @@
+#ifndef ADAPTIVE_QUANTIZER_H
+#define ADAPTIVE_QUANTIZER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "intan_data_types.h"
+
+// Per-channel float µV -> uint8 quantization for the ASIC input. Each channel keeps a running [low, high]
+// envelope (AGC): it widens towards a frame's extremes by `attack` and narrows towards them by `release`,
+// as the fraction of the gap closed per frame. With attack = 1 a frame is never clipped; quiet channels
+// shrink to their own range and keep the full 8 bits.
+
+struct QuantizerConfig {
+    float attack = 1.0f;        // 1 = expand to a new peak within the same frame
+    float release = 0.05f;      // ~20 frames (about 2 s at the ASIC thread's 100 ms poll) to settle
+    float minSpanUv = 20.0f;    // floor on the envelope width, so a flat channel is not amplified into noise
+};
+
+// Inverse mapping of one quantized frame. Byte i of the frame belongs to channel i % channels
+// (frames are laid out [time][stream][channel]); µV = offset[channel] + code * scale[channel].
+struct QuantizationParams {
+    uint32_t channels = 0;       // streamCount * channelCount; 0 = legacy fixed mapping
+    std::vector<float> scale;    // µV per code step
+    std::vector<float> offset;   // µV at code 0
+
+    float toMicrovolts(size_t index, uint8_t code) const {
+        if (channels == 0) {
+            return code * 8.0f - 1000.0f;   // legacy (v + 1000) / 8 clamp
+        }
+        size_t channel = index % channels;
+        return offset[channel] + code * scale[channel];
+    }
+};
+
+class AdaptiveQuantizer {
+public:
+    explicit AdaptiveQuantizer(const QuantizerConfig& config = QuantizerConfig());
+
+    void setConfig(const QuantizerConfig& config) { config_ = config; }
+    const QuantizerConfig& getConfig() const { return config_; }
+
+    // Quantize numBlocks hub blocks of `channels` interleaved channels into out (resized to numBlocks).
+    // Updates the envelopes from this frame first, so params() describes exactly this frame.
+    void quantize(const IntanDataBlock* blocks, size_t numBlocks, uint32_t channels, std::vector<uint8_t>& out);
+
+    const QuantizationParams& params() const { return params_; }
+    void reset();
+
+private:
+    QuantizerConfig config_;
+    QuantizationParams params_;
+    std::vector<float> low_;
+    std::vector<float> high_;
+    std::vector<float> inverseScale_;
+    std::vector<float> frameMin_;
+    std::vector<float> frameMax_;
+    std::vector<float> values_;    // frame values, deinterleaved from the 12-byte hub blocks
+
+    void updateEnvelopes(uint32_t channels);
+};
+
+#endif // ADAPTIVE_QUANTIZER_H
@@ -0,0 +1,468 @@
+#include "hub_capture.h"
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <thread>
+
+namespace {
+    const uint32_t HubMagic = 0x494E5441;      // "INTA", see SharedMemoryWriter::initializeHeader
+    const uint32_t HubSamplesPerBlock = 128;   // fixed by SharedMemoryWriter
+    const float MicroVoltsPerBit = 0.195f;
+
+    uint64_t nanosecondsSince(std::chrono::steady_clock::time_point start) {
+        return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start).count();
+    }
+}
+
+// ---------------------------------------------------------------------------------------------------------------
+// HubRecorder
+
+HubRecorder::HubRecorder()
+    : running_(false), file_(nullptr), shmFd_(-1), shmBase_(nullptr), shmSize_(0), header_(nullptr), blocks_(nullptr),
+      valuesPerBlock_(0), samplesPerBlock_(HubSamplesPerBlock), framesRecorded_(0), framesMissed_(0), framesTorn_(0),
+      bytesWritten_(0) {
+}
+
+HubRecorder::~HubRecorder() {
+    close();
+}
+
+bool HubRecorder::mapHub() {
+    shmFd_ = shm_open(INTAN_SHM_NAME, O_RDONLY, 0666);
+    if (shmFd_ == -1) {
+        std::cerr << "HubRecorder: failed to open shared memory " << INTAN_SHM_NAME << ": " << strerror(errno)
+                  << " (is a producer running?)" << std::endl;
+        return false;
+    }
+
+    struct stat shmStat;
+    if (fstat(shmFd_, &shmStat) == -1) {
+        std::cerr << "HubRecorder: failed to get shared memory size: " << strerror(errno) << std::endl;
+        unmapHub();
+        return false;
+    }
+    shmSize_ = shmStat.st_size;
+
+    shmBase_ = mmap(nullptr, shmSize_, PROT_READ, MAP_SHARED, shmFd_, 0);
+    if (shmBase_ == MAP_FAILED) {
+        shmBase_ = nullptr;
+        std::cerr << "HubRecorder: failed to map shared memory: " << strerror(errno) << std::endl;
+        unmapHub();
+        return false;
+    }
+
+    header_ = static_cast<const volatile IntanDataHeader*>(shmBase_);
+    blocks_ = reinterpret_cast<const IntanDataBlock*>(static_cast<const uint8_t*>(shmBase_) + sizeof(IntanDataHeader));
+    if (header_->magic != HubMagic) {
+        std::cerr << "HubRecorder: shared memory header has unexpected magic 0x" << std::hex << header_->magic
+                  << std::dec << std::endl;
+        unmapHub();
+        return false;
+    }
+
+    valuesPerBlock_ = (size_t)header_->streamCount * header_->channelCount * samplesPerBlock_;
+    if (valuesPerBlock_ == 0 || sizeof(IntanDataHeader) + valuesPerBlock_ * sizeof(IntanDataBlock) > shmSize_) {
+        std::cerr << "HubRecorder: shared memory size " << shmSize_ << " does not match header (streams="
+                  << header_->streamCount << " channels=" << header_->channelCount << ")" << std::endl;
+        unmapHub();
+        return false;
+    }
+    return true;
+}
+
+void HubRecorder::unmapHub() {
+    if (shmBase_) {
+        munmap(shmBase_, shmSize_);
+        shmBase_ = nullptr;
+    }
+    if (shmFd_ != -1) {
+        ::close(shmFd_);
+        shmFd_ = -1;
+    }
+    header_ = nullptr;
+    blocks_ = nullptr;
+}
+
+bool HubRecorder::open(const std::string& filename) {
+    if (!mapHub()) {
+        return false;
+    }
+
+    file_ = fopen(filename.c_str(), "wb");
+    if (!file_) {
+        std::cerr << "HubRecorder: cannot create " << filename << ": " << strerror(errno) << std::endl;
+        unmapHub();
+        return false;
+    }
+
+    CaptureFileHeader fileHeader;
+    memset(&fileHeader, 0, sizeof(fileHeader));
+    fileHeader.magic = CaptureFileMagic;
+    fileHeader.version = CaptureFileVersion;
+    fileHeader.streamCount = header_->streamCount;
+    fileHeader.channelCount = header_->channelCount;
+    fileHeader.sampleRate = header_->sampleRate;
+    fileHeader.samplesPerBlock = samplesPerBlock_;
+    fileHeader.startTimeUnixNs = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    if (fwrite(&fileHeader, sizeof(fileHeader), 1, file_) != 1) {
+        std::cerr << "HubRecorder: failed to write file header" << std::endl;
+        close();
+        return false;
+    }
+    bytesWritten_ = sizeof(fileHeader);
+
+    values_.resize(valuesPerBlock_);
+    codes_.resize(valuesPerBlock_);
+
+    std::cout << "Recording hub to " << filename << ": streams=" << fileHeader.streamCount
+              << " channels=" << fileHeader.channelCount << " sampleRate=" << fileHeader.sampleRate << std::endl;
+    return true;
+}
+
+void HubRecorder::run(double durationSec) {
+    if (!file_ || !header_) {
+        std::cerr << "HubRecorder: run() called before open()" << std::endl;
+        return;
+    }
+
+    running_ = true;
+    const auto start = std::chrono::steady_clock::now();
+    auto lastReport = start;
+    const uint64_t maxTimeNs = durationSec > 0.0 ? (uint64_t)(durationSec * 1.0e9) : 0;
+
+    // The block present when we attach may be stale; start with the first block published after it.
+    uint32_t lastTimestamp = header_->timestamp;
+    bool haveFrame = false;
+
+    while (running_) {
+        uint64_t nowNs = nanosecondsSince(start);
+        if (maxTimeNs != 0 && nowNs >= maxTimeNs) {
+            break;
+        }
+
+        uint32_t timestamp = header_->timestamp;
+        if (timestamp == lastTimestamp) {
+            usleep(200);
+            continue;
+        }
+
+        // SharedMemoryWriter updates the timestamp after the data, so a block is complete once its timestamp is
+        // visible. If the timestamp moves again while we copy, the producer has started overwriting the block;
+        // drop this copy and take the newer block. (Best effort: the hub has no sequence lock.)
+        std::atomic_thread_fence(std::memory_order_acquire);
+        for (size_t i = 0; i < valuesPerBlock_; ++i) {
+            values_[i] = blocks_[i].value;
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (header_->timestamp != timestamp) {
+            ++framesTorn_;
+            continue;
+        }
+
+        if (haveFrame) {
+            uint32_t delta = timestamp - lastTimestamp;
+            if (delta > samplesPerBlock_) {
+                framesMissed_ += delta / samplesPerBlock_ - 1;
+            }
+        }
+        if (!appendFrame(timestamp, nowNs)) {
+            break;
+        }
+        lastTimestamp = timestamp;
+        haveFrame = true;
+
+        auto now = std::chrono::steady_clock::now();
+        if (now - lastReport >= std::chrono::seconds(10)) {
+            std::cout << "HubRecorder: " << framesRecorded_ << " frames (" << bytesWritten_ / (1024.0 * 1024.0)
+                      << " MB), " << framesMissed_ << " missed" << std::endl;
+            lastReport = now;
+        }
+    }
+
+    running_ = false;
+    std::cout << "HubRecorder: recorded " << framesRecorded_ << " frames, " << framesMissed_ << " missed, "
+              << framesTorn_ << " torn reads retried, " << bytesWritten_ / (1024.0 * 1024.0) << " MB" << std::endl;
+}
+
+bool HubRecorder::appendFrame(uint32_t producerTimestamp, uint64_t captureTimeNs) {
+    // Store ADC codes when every value converts back bit-exactly, as it does for SharedMemoryWriter output.
+    bool codesExact = true;
+    for (size_t i = 0; i < valuesPerBlock_; ++i) {
+        float value = values_[i];
+        long code = std::lround(value / MicroVoltsPerBit) + 32768;
+        if (code < 0 || code > 65535) {
+            codesExact = false;
+            break;
+        }
+        float converted = (float)(((int)code - 32768) * MicroVoltsPerBit);
+        if (memcmp(&converted, &value, sizeof(float)) != 0) {
+            codesExact = false;
+            break;
+        }
+        codes_[i] = (uint16_t)code;
+    }
+
+    CaptureFrameHeader frame;
+    frame.magic = CaptureFrameMagic;
+    frame.producerTimestamp = producerTimestamp;
+    frame.captureTimeNs = captureTimeNs;
+    frame.encoding = codesExact ? CaptureEncodingAdcCodes : CaptureEncodingFloat;
+    frame.payloadBytes = (uint32_t)(valuesPerBlock_ * (codesExact ? sizeof(uint16_t) : sizeof(float)));
+    const void* payload = codesExact ? (const void*)codes_.data() : (const void*)values_.data();
+
+    if (fwrite(&frame, sizeof(frame), 1, file_) != 1 || fwrite(payload, frame.payloadBytes, 1, file_) != 1 ||
+        fflush(file_) != 0) {
+        std::cerr << "HubRecorder: write failed: " << strerror(errno) << std::endl;
+        return false;
+    }
+    bytesWritten_ += sizeof(frame) + frame.payloadBytes;
+    ++framesRecorded_;
+    return true;
+}
+
+void HubRecorder::close() {
+    running_ = false;
+    if (file_) {
+        fclose(file_);
+        file_ = nullptr;
+    }
+    unmapHub();
+}
+
+// ---------------------------------------------------------------------------------------------------------------
+// HubReplayer
+
+HubReplayer::HubReplayer()
+    : running_(false), file_(nullptr), firstFrameOffset_(0), valuesPerBlock_(0), framesReplayed_(0) {
+    memset(&fileHeader_, 0, sizeof(fileHeader_));
+}
+
+HubReplayer::~HubReplayer() {
+    close();
+}
+
+bool HubReplayer::open(const std::string& filename) {
+    file_ = fopen(filename.c_str(), "rb");
+    if (!file_) {
+        std::cerr << "HubReplayer: cannot open " << filename << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+    if (fread(&fileHeader_, sizeof(fileHeader_), 1, file_) != 1 || fileHeader_.magic != CaptureFileMagic) {
+        std::cerr << "HubReplayer: " << filename << " is not a hub capture file" << std::endl;
+        close();
+        return false;
+    }
+    if (fileHeader_.version != CaptureFileVersion || fileHeader_.samplesPerBlock != HubSamplesPerBlock) {
+        std::cerr << "HubReplayer: unsupported capture version " << fileHeader_.version << " / block size "
+                  << fileHeader_.samplesPerBlock << std::endl;
+        close();
+        return false;
+    }
+    firstFrameOffset_ = ftell(file_);
+    valuesPerBlock_ = (size_t)fileHeader_.streamCount * fileHeader_.channelCount * fileHeader_.samplesPerBlock;
+    values_.resize(valuesPerBlock_);
+    payload_.resize(valuesPerBlock_ * sizeof(float));
+
+    sharedMemoryWriter_ = std::make_unique<SharedMemoryWriter>();
+    if (!sharedMemoryWriter_->initialize((int)fileHeader_.streamCount, (int)fileHeader_.channelCount,
+                                         (int)fileHeader_.sampleRate)) {
+        std::cerr << "HubReplayer: failed to initialize shared memory writer" << std::endl;
+        close();
+        return false;
+    }
+    if (sharedMemoryWriter_->valuesPerBlock() != valuesPerBlock_) {
+        std::cerr << "HubReplayer: capture block size does not match shared memory writer" << std::endl;
+        close();
+        return false;
+    }
+    return true;
+}
+
+// Read the next frame into values_. Returns false at end of file or on a truncated or malformed frame.
+bool HubReplayer::readFrame(CaptureFrameHeader& frame) {
+    if (fread(&frame, sizeof(frame), 1, file_) != 1) {
+        return false;
+    }
+    size_t valueSize = frame.encoding == CaptureEncodingAdcCodes ? sizeof(uint16_t) : sizeof(float);
+    if (frame.magic != CaptureFrameMagic || frame.encoding > CaptureEncodingFloat ||
+        frame.payloadBytes != valuesPerBlock_ * valueSize) {
+        std::cerr << "HubReplayer: malformed frame after " << framesReplayed_ << " frames; stopping" << std::endl;
+        return false;
+    }
+    if (fread(payload_.data(), frame.payloadBytes, 1, file_) != 1) {
+        return false;  // truncated trailing frame
+    }
+
+    if (frame.encoding == CaptureEncodingAdcCodes) {
+        const uint16_t* codes = reinterpret_cast<const uint16_t*>(payload_.data());
+        for (size_t i = 0; i < valuesPerBlock_; ++i) {
+            values_[i] = (float)(((int)codes[i] - 32768) * MicroVoltsPerBit);  // same conversion as SharedMemoryWriter
+        }
+    } else {
+        memcpy(values_.data(), payload_.data(), frame.payloadBytes);
+    }
+    return true;
+}
+
+bool HubReplayer::waitForAck(sem_t* ackSem) {
+    auto waitStart = std::chrono::steady_clock::now();
+    auto lastWarning = waitStart;
+    while (running_) {
+        if (sem_trywait(ackSem) == 0) {
+            return true;
+        }
+        auto now = std::chrono::steady_clock::now();
+        if (now - lastWarning >= std::chrono::seconds(5)) {
+            std::cout << "HubReplayer: waiting for consumer to acknowledge frame " << framesReplayed_ << "..." << std::endl;
+            lastWarning = now;
+        }
+        usleep(100);
+    }
+    return false;
+}
+
+void HubReplayer::run(Pacing pacing, double speed, bool loop) {
+    if (!file_ || !sharedMemoryWriter_) {
+        std::cerr << "HubReplayer: run() called before open()" << std::endl;
+        return;
+    }
+    if (pacing == PacingRealTime && speed <= 0.0) {
+        std::cerr << "HubReplayer: speed must be positive" << std::endl;
+        return;
+    }
+
+    sem_t* stepSem = SEM_FAILED;
+    sem_t* ackSem = SEM_FAILED;
+    if (pacing == PacingLockstep) {
+        sem_unlink(INTAN_SHM_STEP_SEM_NAME);
+        sem_unlink(INTAN_SHM_ACK_SEM_NAME);
+        stepSem = sem_open(INTAN_SHM_STEP_SEM_NAME, O_CREAT | O_EXCL, 0666, 0);
+        ackSem = sem_open(INTAN_SHM_ACK_SEM_NAME, O_CREAT | O_EXCL, 0666, 0);
+        if (stepSem == SEM_FAILED || ackSem == SEM_FAILED) {
+            std::cerr << "HubReplayer: failed to create lock-step semaphores: " << strerror(errno) << std::endl;
+            if (stepSem != SEM_FAILED) sem_close(stepSem);
+            if (ackSem != SEM_FAILED) sem_close(ackSem);
+            sem_unlink(INTAN_SHM_STEP_SEM_NAME);
+            sem_unlink(INTAN_SHM_ACK_SEM_NAME);
+            return;
+        }
+        std::cout << "HubReplayer: lock-step mode; start the consumer now" << std::endl;
+    }
+
+    running_ = true;
+    const auto start = std::chrono::steady_clock::now();
+    const double nsPerSample = 1.0e9 / fileHeader_.sampleRate / speed;
+
+    uint64_t samplesElapsed = 0;      // recorded sample clock since the first frame, across loops
+    uint32_t timestampOffset = 0;     // added to recorded timestamps so they keep increasing across loops
+    bool haveFrame = false;
+    uint32_t firstTimestamp = 0;
+    uint32_t lastTimestamp = 0;
+
+    while (running_) {
+        CaptureFrameHeader frame;
+        if (!readFrame(frame)) {
+            if (!loop || !haveFrame) {
+                break;
+            }
+            // Continue the sample clock one block past the last frame of this pass.
+            timestampOffset += (lastTimestamp - firstTimestamp) + fileHeader_.samplesPerBlock;
+            samplesElapsed += fileHeader_.samplesPerBlock;
+            fseek(file_, firstFrameOffset_, SEEK_SET);
+            haveFrame = false;
+            continue;
+        }
+
+        if (!haveFrame) {
+            if (framesReplayed_ == 0) {
+                firstTimestamp = frame.producerTimestamp;
+            }
+            haveFrame = true;
+        } else {
+            samplesElapsed += (uint32_t)(frame.producerTimestamp - lastTimestamp);
+        }
+        lastTimestamp = frame.producerTimestamp;
+
+        if (pacing == PacingRealTime) {
+            auto due = start + std::chrono::nanoseconds((int64_t)(samplesElapsed * nsPerSample));
+            std::this_thread::sleep_until(due);
+        }
+
+        sharedMemoryWriter_->writeMicrovoltBlock(frame.producerTimestamp + timestampOffset, values_.data());
+        ++framesReplayed_;
+
+        if (pacing == PacingLockstep) {
+            sem_post(stepSem);
+            if (!waitForAck(ackSem)) {
+                break;
+            }
+        }
+    }
+
+    double elapsedSec = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    double recordedSec = (double)samplesElapsed / fileHeader_.sampleRate;
+    std::cout << "HubReplayer: replayed " << framesReplayed_ << " frames (" << recordedSec << " s of data) in "
+              << elapsedSec << " s" << std::endl;
+
+    if (pacing == PacingLockstep) {
+        sem_close(stepSem);
+        sem_close(ackSem);
+        sem_unlink(INTAN_SHM_STEP_SEM_NAME);
+        sem_unlink(INTAN_SHM_ACK_SEM_NAME);
+    }
+    running_ = false;
+}
+
+void HubReplayer::close() {
+    running_ = false;
+    if (file_) {
+        fclose(file_);
+        file_ = nullptr;
+    }
+    sharedMemoryWriter_.reset();
+}
+
+bool HubReplayer::summarize(const std::string& filename, CaptureFileHeader& header, uint64_t& numFrames,
+                            double& durationSec) {
+    numFrames = 0;
+    durationSec = 0.0;
+    FILE* file = fopen(filename.c_str(), "rb");
+    if (!file) {
+        std::cerr << "Cannot open " << filename << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+    if (fread(&header, sizeof(header), 1, file) != 1 || header.magic != CaptureFileMagic) {
+        std::cerr << filename << " is not a hub capture file" << std::endl;
+        fclose(file);
+        return false;
+    }
+
+    uint64_t samples = 0;
+    uint32_t lastTimestamp = 0;
+    CaptureFrameHeader frame;
+    while (fread(&frame, sizeof(frame), 1, file) == 1 && frame.magic == CaptureFrameMagic) {
+        if (fseek(file, frame.payloadBytes, SEEK_CUR) != 0) {
+            break;
+        }
+        if (numFrames > 0) {
+            samples += (uint32_t)(frame.producerTimestamp - lastTimestamp);
+        }
+        lastTimestamp = frame.producerTimestamp;
+        ++numFrames;
+    }
+    if (numFrames > 0) {
+        samples += header.samplesPerBlock;
+    }
+    durationSec = header.sampleRate > 0 ? (double)samples / header.sampleRate : 0.0;
+    fclose(file);
+    return true;
+}
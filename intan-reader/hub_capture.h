@@ -0,0 +1,132 @@
+#ifndef HUB_CAPTURE_H
+#define HUB_CAPTURE_H
+
+#include <semaphore.h>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "intan_data_types.h"
+#include "shared_memory_writer.h"
+
+// Record-and-replay for the /intan_rhx_shm_v1 hub.
+//
+// Capture file (little-endian, append-only):
+//   CaptureFileHeader
+//   { CaptureFrameHeader, payload }*
+// Payload is the hub block in hub order [sample][stream][channel]. Values that came from ADC codes
+// (every current producer) are stored as the uint16 code, which converts back to the identical float;
+// a block with any other value is stored as raw float32. A truncated trailing frame (e.g. after a
+// crash) is ignored on replay.
+
+const uint32_t CaptureFileMagic = 0x50414348;   // "HCAP"
+const uint32_t CaptureFrameMagic = 0x454D5246;  // "FRME"
+const uint32_t CaptureFileVersion = 1;
+
+enum CaptureEncoding : uint32_t {
+    CaptureEncodingAdcCodes = 0,  // uint16 per value
+    CaptureEncodingFloat = 1      // float32 microvolts per value
+};
+
+struct CaptureFileHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t streamCount;
+    uint32_t channelCount;
+    uint32_t sampleRate;
+    uint32_t samplesPerBlock;
+    uint64_t startTimeUnixNs;      // wall clock at start of capture
+    uint32_t reserved[8];
+};
+
+struct CaptureFrameHeader {
+    uint32_t magic;
+    uint32_t producerTimestamp;    // IntanDataHeader::timestamp of the block
+    uint64_t captureTimeNs;        // steady-clock time since start of capture
+    uint32_t encoding;             // CaptureEncoding
+    uint32_t payloadBytes;
+};
+
+// Taps the hub read-only and appends every new block to a capture file.
+class HubRecorder {
+public:
+    HubRecorder();
+    ~HubRecorder();
+
+    bool open(const std::string& filename);
+    void run(double durationSec = 0.0);   // until stop() or durationSec of capture
+    void stop() { running_ = false; }
+    void close();
+
+    uint64_t getFramesRecorded() const { return framesRecorded_; }
+    uint64_t getFramesMissed() const { return framesMissed_; }
+
+private:
+    std::atomic<bool> running_;
+    FILE* file_;
+    int shmFd_;
+    void* shmBase_;
+    size_t shmSize_;
+    const volatile IntanDataHeader* header_;
+    const IntanDataBlock* blocks_;
+    size_t valuesPerBlock_;
+    uint32_t samplesPerBlock_;
+
+    std::vector<float> values_;
+    std::vector<uint16_t> codes_;
+
+    uint64_t framesRecorded_;
+    uint64_t framesMissed_;
+    uint64_t framesTorn_;
+    uint64_t bytesWritten_;
+
+    bool mapHub();
+    void unmapHub();
+    bool appendFrame(uint32_t producerTimestamp, uint64_t captureTimeNs);
+};
+
+// Re-publishes a capture file into the hub.
+class HubReplayer {
+public:
+    enum Pacing {
+        PacingRealTime,    // at speed x the recorded sample clock (speed 1 = real time)
+        PacingMaximum,     // as fast as possible
+        PacingLockstep     // one frame per consumer acknowledgment (see SharedMemoryReader)
+    };
+
+    HubReplayer();
+    ~HubReplayer();
+
+    bool open(const std::string& filename);
+    void run(Pacing pacing, double speed = 1.0, bool loop = false);
+    void stop() { running_ = false; }
+    void close();
+
+    const CaptureFileHeader& getFileHeader() const { return fileHeader_; }
+    uint64_t getFramesReplayed() const { return framesReplayed_; }
+
+    // Scan the whole file: frame count and recorded span; returns false on a malformed file
+    static bool summarize(const std::string& filename, CaptureFileHeader& header, uint64_t& numFrames,
+                          double& durationSec);
+
+private:
+    std::atomic<bool> running_;
+    FILE* file_;
+    std::unique_ptr<SharedMemoryWriter> sharedMemoryWriter_;
+    CaptureFileHeader fileHeader_;
+    long firstFrameOffset_;
+    size_t valuesPerBlock_;
+
+    std::vector<float> values_;
+    std::vector<uint8_t> payload_;
+
+    uint64_t framesReplayed_;
+
+    bool readFrame(CaptureFrameHeader& frame);
+    bool waitForAck(sem_t* ackSem);
+};
+
+#endif // HUB_CAPTURE_H
@@ -0,0 +1,117 @@
+// Record-and-replay tool for the /intan_rhx_shm_v1 shared-memory hub.
+// GOAL: reproduce exactly what the ASIC sender and the FPGA logger saw. "record" taps
+// the hub read-only next to the running pipeline and appends every block with its
+// producer timestamp to a compact capture file; "replay" re-publishes a capture
+// into the hub at real time, N x speed, flat out, or in lock-step with the consumer.
+
+#include <csignal>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+#include "hub_capture.h"
+
+static HubRecorder* activeRecorder = nullptr;
+static HubReplayer* activeReplayer = nullptr;
+
+static void handleSignal(int) {
+    if (activeRecorder) activeRecorder->stop();
+    if (activeReplayer) activeReplayer->stop();
+}
+
+static void printUsage(const char* program) {
+    std::cout << "Usage:\n"
+              << "  " << program << " record <file> [--duration SEC]\n"
+              << "  " << program << " replay <file> [--speed N | --max | --lockstep] [--loop]\n"
+              << "  " << program << " info <file>\n"
+              << "\n"
+              << "  --speed N     replay at N x the recorded sample rate (default 1)\n"
+              << "  --max         replay as fast as possible\n"
+              << "  --lockstep    publish one frame per consumer read (run_pipeline --external-hub)\n"
+              << "  --loop        restart at end of file, continuing the timestamps\n";
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 3) {
+        printUsage(argv[0]);
+        return -1;
+    }
+    std::string command = argv[1];
+    std::string filename = argv[2];
+
+    std::signal(SIGINT, handleSignal);
+    std::signal(SIGTERM, handleSignal);
+
+    if (command == "record") {
+        double durationSec = 0.0;
+        for (int i = 3; i < argc; ++i) {
+            std::string arg = argv[i];
+            if (arg == "--duration" && i + 1 < argc) {
+                durationSec = std::atof(argv[++i]);
+            } else {
+                std::cerr << "Unknown or incomplete option: " << arg << std::endl;
+                printUsage(argv[0]);
+                return -1;
+            }
+        }
+
+        HubRecorder recorder;
+        if (!recorder.open(filename)) {
+            return -1;
+        }
+        activeRecorder = &recorder;
+        recorder.run(durationSec);
+        activeRecorder = nullptr;
+        recorder.close();
+        return 0;
+    }
+
+    if (command == "replay") {
+        HubReplayer::Pacing pacing = HubReplayer::PacingRealTime;
+        double speed = 1.0;
+        bool loop = false;
+        for (int i = 3; i < argc; ++i) {
+            std::string arg = argv[i];
+            if (arg == "--speed" && i + 1 < argc) {
+                pacing = HubReplayer::PacingRealTime;
+                speed = std::atof(argv[++i]);
+            } else if (arg == "--max") {
+                pacing = HubReplayer::PacingMaximum;
+            } else if (arg == "--lockstep") {
+                pacing = HubReplayer::PacingLockstep;
+            } else if (arg == "--loop") {
+                loop = true;
+            } else {
+                std::cerr << "Unknown or incomplete option: " << arg << std::endl;
+                printUsage(argv[0]);
+                return -1;
+            }
+        }
+
+        HubReplayer replayer;
+        if (!replayer.open(filename)) {
+            return -1;
+        }
+        activeReplayer = &replayer;
+        replayer.run(pacing, speed, loop);
+        activeReplayer = nullptr;
+        replayer.close();
+        return 0;
+    }
+
+    if (command == "info") {
+        CaptureFileHeader header;
+        uint64_t numFrames = 0;
+        double durationSec = 0.0;
+        if (!HubReplayer::summarize(filename, header, numFrames, durationSec)) {
+            return -1;
+        }
+        std::cout << filename << ": version " << header.version << ", streams=" << header.streamCount
+                  << " channels=" << header.channelCount << " sampleRate=" << header.sampleRate
+                  << ", " << numFrames << " frames, " << durationSec << " s" << std::endl;
+        return 0;
+    }
+
+    printUsage(argv[0]);
+    return -1;
+}
@@ -1487,14 +1487,16 @@ bool Rhd2000EvalBoardUsb3::readDataBlock(Rhd2000DataBlockUsb3 *dataBlock)
 }
 
 // Reads a certain number of USB data blocks, if the specified number is available, and writes the raw bytes
-// to a buffer.  Returns total number of bytes read.
-long Rhd2000EvalBoardUsb3::readDataBlocksRaw(int numBlocks, unsigned char* buffer)
+// to a buffer.  Returns total number of bytes read.  A caller that has just queried the FIFO level may pass it
+// as knownWordsInFifo to skip a second WireOut round trip; the FIFO only fills between the two calls, so the
+// earlier count is a safe lower bound.
+long Rhd2000EvalBoardUsb3::readDataBlocksRaw(int numBlocks, unsigned char* buffer, unsigned int knownWordsInFifo)
 {
     lock_guard<mutex> lockOk(okMutex);
 
     unsigned int numWordsToRead = numBlocks * Rhd2000DataBlockUsb3::calculateDataBlockSizeInWords(numDataStreams);
 
-    if (numWordsInFifo() < numWordsToRead)
+    if (knownWordsInFifo < numWordsToRead && numWordsInFifo() < numWordsToRead)
         return 0;
 
     long result = dev->ReadFromBlockPipeOut(PipeOutData, USB3_BLOCK_SIZE, 2 * numWordsToRead, buffer);
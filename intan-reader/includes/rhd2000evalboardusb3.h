@@ -149,7 +149,7 @@ public:
 
     void flush();
     bool readDataBlock(Rhd2000DataBlockUsb3 *dataBlock);
-    long readDataBlocksRaw(int numBlocks, unsigned char* buffer);
+    long readDataBlocksRaw(int numBlocks, unsigned char* buffer, unsigned int knownWordsInFifo = 0);
     bool readDataBlocks(int numBlocks, queue<Rhd2000DataBlockUsb3> &dataQueue);
     int queueToFile(queue<Rhd2000DataBlockUsb3> &dataQueue, std::ofstream &saveOut);
     int getBoardMode();
@@ -1,6 +1,14 @@
 #ifndef INTAN_DATA_TYPES_H
 #define INTAN_DATA_TYPES_H
 
+#include <cstdint>
+
+// Shared memory hub segment, and the semaphores used by hub_capture replay in lock-step mode
+// (the replayer posts the step semaphore per published frame and waits for the consumer's ack)
+#define INTAN_SHM_NAME "/intan_rhx_shm_v1"
+#define INTAN_SHM_STEP_SEM_NAME "/intan_rhx_shm_v1_step"
+#define INTAN_SHM_ACK_SEM_NAME "/intan_rhx_shm_v1_ack"
+
 // Intan data structures for shared memory communication
 struct IntanDataHeader {
     uint32_t magic;        // Magic number "INTA" (0x494E5441)
@@ -9,6 +17,10 @@ struct IntanDataHeader {
     uint32_t streamCount;  // Number of streams
     uint32_t channelCount; // Number of channels
     uint32_t sampleRate;   // Sample rate
+    uint32_t sequenceId;   // Published block counter (latency tracing)
+    uint32_t reserved;
+    uint64_t acquisitionTimeNs; // CLOCK_MONOTONIC when the block was acquired
+    uint64_t publishTimeNs;     // CLOCK_MONOTONIC when the block was complete in shared memory
 };
 
 struct IntanDataBlock { 
@@ -1,10 +1,51 @@
 #include "intan_reader.h"
+#include "latency_trace.h"
 #include <iostream>
 #include <thread>
 #include <chrono>
+#include <cmath>
+#include <algorithm>
 
-IntanReader::IntanReader() 
-    : running_(false) {
+namespace {
+    // Chip IDs from ROM register 63, and register 59 of an RHD2164 on its MISO A line
+    const int ChipRhd2132 = 1;
+    const int ChipRhd2216 = 2;
+    const int ChipRhd2164 = 4;
+    const int ChipRhd2164MisoB = 1000;
+    const int Register59MisoA = 53;
+
+    const int NumMisoLines = 2 * MAX_NUM_SPI_PORTS;
+
+    // Chip ID read back by the AuxCmd3 register-config sequence on this stream, or -1 if the ROM
+    // does not read 'INTAN'/'RHD' (no chip, or bad MISO timing at this cable delay)
+    int readChipId(const Rhd2000DataBlockUsb3& block, int stream, int& register59Value) {
+        const std::vector<int>& aux = block.auxiliaryData[stream][2];
+        bool intanChipPresent = ((char)aux[32] == 'I' && (char)aux[33] == 'N' && (char)aux[34] == 'T' &&
+                                 (char)aux[35] == 'A' && (char)aux[36] == 'N' &&
+                                 (char)aux[24] == 'R' && (char)aux[25] == 'H' && (char)aux[26] == 'D');
+        if (!intanChipPresent) {
+            register59Value = -1;
+            return -1;
+        }
+        register59Value = aux[23];
+        return aux[19];
+    }
+}
+
+IntanReader::IntanReader(const IntanReaderConfig& config) 
+    : running_(false), config_(config), sampleRateHz_(0.0), usbReads_(0), blocksRead_(0) {
+}
+
+bool IntanReader::sampleRateFromHz(double hz, Rhd2000EvalBoardUsb3::AmplifierSampleRate& sampleRate) {
+    static const double rates[] = { 1000.0, 1250.0, 1500.0, 2000.0, 2500.0, 3000.0, 3333.0, 4000.0, 5000.0,
+                                    6250.0, 8000.0, 10000.0, 12500.0, 15000.0, 20000.0, 25000.0, 30000.0 };
+    for (int i = 0; i <= (int)Rhd2000EvalBoardUsb3::SampleRate30000Hz; ++i) {
+        if (std::fabs(hz - rates[i]) < 1.0) {
+            sampleRate = (Rhd2000EvalBoardUsb3::AmplifierSampleRate)i;
+            return true;
+        }
+    }
+    return false;
 }
 
 IntanReader::~IntanReader() {
@@ -18,17 +59,6 @@ bool IntanReader::initialize() {
     std::cout << "Initializing Intan Reader..." << std::endl;
     controller_ = std::make_unique<Rhd2000EvalBoardUsb3>();
     
-    // Initialize shared memory writer with device parameters
-    sharedMemoryWriter_ = std::make_unique<SharedMemoryWriter>();
-    int numStreams = 1; // Will be set after device is opened
-    int numChannels = CHANNELS_PER_STREAM; // 32 channels per stream
-    int sampleRate = 1000; // 1kHz sample rate
-    
-    if (!sharedMemoryWriter_->initialize(numStreams, numChannels, sampleRate)) {
-        std::cerr << "Failed to initialize shared memory writer." << std::endl;
-        return false;
-    }
-    
     if (!openDevice()) {
         return false;
     }
@@ -41,6 +71,13 @@ bool IntanReader::initialize() {
         return false;
     }
     
+    // Size the shared memory hub for every enabled stream; consumers take the layout from its header
+    sharedMemoryWriter_ = std::make_unique<SharedMemoryWriter>();
+    if (!sharedMemoryWriter_->initialize(getNumStreams(), CHANNELS_PER_STREAM, (int)std::lround(sampleRateHz_))) {
+        std::cerr << "Failed to initialize shared memory writer." << std::endl;
+        return false;
+    }
+    
     std::cout << "Intan Reader initialized successfully!" << std::endl;
     return true;
 }
@@ -85,24 +122,26 @@ bool IntanReader::configureDevice() {
     // Initialize the controller
     controller_->initialize();
     
-    controller_->setSampleRate(Rhd2000EvalBoardUsb3::SampleRate1000Hz);
-    controller_->setCableLengthFeet(Rhd2000EvalBoardUsb3::PortA, 3.0);
-    controller_->enableDataStream(0, true);
+    controller_->setSampleRate(config_.sampleRate);
+    sampleRateHz_ = controller_->getSampleRate();
 
-    Rhd2000RegistersUsb3* chipRegisters = new Rhd2000RegistersUsb3(controller_->getSampleRate());
+    Rhd2000RegistersUsb3 chipRegisters(sampleRateHz_);
     
     // Before generating register configuration command sequences, set amplifier
     // bandwidth paramters.
 
-    // set amplifier bandwidths and DSP cutoff before building register lists
-    double dspCutoffFreq = chipRegisters->setDspCutoffFreq(10.0);
-    chipRegisters->setLowerBandwidth(1.0);
-    chipRegisters->setUpperBandwidth(500.0); // Reduced from 7500.0 to be within Nyquist limit (500 Hz for 1000 Hz sampling)
+    // set amplifier bandwidths and DSP cutoff before building register lists; the upper bandwidth
+    // stays within the Nyquist limit of the selected sample rate
+    double upperBandwidth = std::min(7500.0, sampleRateHz_ / 2.0);
+    double dspCutoffFreq = chipRegisters.setDspCutoffFreq(10.0);
+    chipRegisters.setLowerBandwidth(1.0);
+    chipRegisters.setUpperBandwidth(upperBandwidth);
     
     std::cout << "Amplifier configuration:" << std::endl;
+    std::cout << "  Sample rate: " << sampleRateHz_ << " Hz" << std::endl;
     std::cout << "  DSP cutoff frequency: " << dspCutoffFreq << " Hz" << std::endl;
     std::cout << "  Lower bandwidth: 1.0 Hz" << std::endl;
-    std::cout << "  Upper bandwidth: 500.0 Hz" << std::endl;
+    std::cout << "  Upper bandwidth: " << upperBandwidth << " Hz" << std::endl;
     
     std::vector<int> commandList;
     int commandSequenceLength = 0;
@@ -110,11 +149,11 @@ bool IntanReader::configureDevice() {
     // AuxCmd1
     // First, let's create a command list for the AuxCmd1 slot.  This command
     // sequence will create a 100 Hz, full-scale sine wave for impedance testing.
-    commandSequenceLength = chipRegisters->createCommandListZcheckDac(commandList, 100.0, 128.0);
+    commandSequenceLength = chipRegisters.createCommandListZcheckDac(commandList, 100.0, 128.0);
     if (commandSequenceLength > 0) {
         controller_->uploadCommandList(commandList, Rhd2000EvalBoardUsb3::AuxCmd1, 0);
         controller_->selectAuxCommandLength(Rhd2000EvalBoardUsb3::AuxCmd1, 0, commandSequenceLength - 1);
-        controller_->selectAuxCommandBank(Rhd2000EvalBoardUsb3::PortA, Rhd2000EvalBoardUsb3::AuxCmd1, 0);
+        selectAuxCommandBankAllPorts(Rhd2000EvalBoardUsb3::AuxCmd1, 0);
     } else {
         std::cerr << "Warning: Failed to create AuxCmd1 command list" << std::endl;
     }
@@ -122,11 +161,11 @@ bool IntanReader::configureDevice() {
     // AuxCmd2
     // Next, we'll create a command list for the AuxCmd2 slot.  This command sequence
     // will sample the temperature sensor and other auxiliary ADC inputs.
-    commandSequenceLength = chipRegisters->createCommandListTempSensor(commandList);
+    commandSequenceLength = chipRegisters.createCommandListTempSensor(commandList);
     if (commandSequenceLength > 0) {
         controller_->uploadCommandList(commandList, Rhd2000EvalBoardUsb3::AuxCmd2, 0);
         controller_->selectAuxCommandLength(Rhd2000EvalBoardUsb3::AuxCmd2, 0, commandSequenceLength - 1);
-        controller_->selectAuxCommandBank(Rhd2000EvalBoardUsb3::PortA, Rhd2000EvalBoardUsb3::AuxCmd2, 0);
+        selectAuxCommandBankAllPorts(Rhd2000EvalBoardUsb3::AuxCmd2, 0);
     } else {
         std::cerr << "Warning: Failed to create AuxCmd2 command list" << std::endl;
     }
@@ -135,14 +174,29 @@ bool IntanReader::configureDevice() {
     // For the AuxCmd3 slot, we will create two command sequences.  Both sequences
     // will configure and read back the RHD2000 chip registers, but one sequence will
     // also run ADC calibration.
-    int lenNoCal = chipRegisters->createCommandListRegisterConfig(commandList, false);
+    int lenNoCal = chipRegisters.createCommandListRegisterConfig(commandList, false);
     controller_->uploadCommandList(commandList, Rhd2000EvalBoardUsb3::AuxCmd3, 0);
-    int lenCal = chipRegisters->createCommandListRegisterConfig(commandList, true);
+    int lenCal = chipRegisters.createCommandListRegisterConfig(commandList, true);
     controller_->uploadCommandList(commandList, Rhd2000EvalBoardUsb3::AuxCmd3, 1);
     
+    // Find the chips on every port and enable their streams (this also sets each port's cable delay)
+    int numChips = config_.scanPorts ? findConnectedChips(lenNoCal) : 0;
+    if (numChips == 0) {
+        if (config_.scanPorts) {
+            std::cerr << "Warning: no chips detected on ports A-H; using stream 0 on Port A." << std::endl;
+        }
+        for (int stream = 0; stream < MAX_NUM_DATA_STREAMS; ++stream) {
+            controller_->enableDataStream(stream, stream == 0);
+        }
+        controller_->setCableLengthFeet(Rhd2000EvalBoardUsb3::PortA, 3.0);
+        streams_.assign(1, IntanStreamInfo { 0, 0, ChipRhd2132 });
+    }
+    std::cout << "Acquiring " << getNumStreams() << " stream(s), " << getNumStreams() * CHANNELS_PER_STREAM
+              << " channels at " << sampleRateHz_ << " Hz" << std::endl;
+    
     // Run calibration once on bank 1
     controller_->selectAuxCommandLength(Rhd2000EvalBoardUsb3::AuxCmd3, 0, lenCal - 1);
-    controller_->selectAuxCommandBank(Rhd2000EvalBoardUsb3::PortA, Rhd2000EvalBoardUsb3::AuxCmd3, 1);
+    selectAuxCommandBankAllPorts(Rhd2000EvalBoardUsb3::AuxCmd3, 1);
     controller_->setMaxTimeStep(128);
     controller_->setContinuousRunMode(false);
     controller_->run();
@@ -154,13 +208,100 @@ bool IntanReader::configureDevice() {
     
     // Switch to bank 0 for normal acquisition
     controller_->selectAuxCommandLength(Rhd2000EvalBoardUsb3::AuxCmd3, 0, lenNoCal - 1);
-    controller_->selectAuxCommandBank(Rhd2000EvalBoardUsb3::PortA, Rhd2000EvalBoardUsb3::AuxCmd3, 0);
+    selectAuxCommandBankAllPorts(Rhd2000EvalBoardUsb3::AuxCmd3, 0);
     controller_->setContinuousRunMode(true);
     controller_->run();
     
     return true;
 }
 
+void IntanReader::selectAuxCommandBankAllPorts(Rhd2000EvalBoardUsb3::AuxCmdSlot slot, int bank) {
+    for (int port = 0; port < MAX_NUM_SPI_PORTS; ++port) {
+        controller_->selectAuxCommandBank((Rhd2000EvalBoardUsb3::BoardPort)port, slot, bank);
+    }
+}
+
+// Same procedure as RHXController::findConnectedChips for the USB3 controller: read each MISO line's chip
+// ROM at all 16 MISO sampling delays, keep the delay in the middle of the good range per port, then enable
+// one stream per RHD2132/RHD2216 and two (MISO A and B, DDR) per RHD2164. Returns the number of chips.
+int IntanReader::findConnectedChips(int auxCmd3Length) {
+    // MISO line i is read on stream 2 * i; its DDR (RHD2164 MISO B) data is on stream 2 * i + 1
+    for (int stream = 0; stream < MAX_NUM_DATA_STREAMS; ++stream) {
+        controller_->enableDataStream(stream, stream % 2 == 0);
+    }
+    controller_->selectAuxCommandLength(Rhd2000EvalBoardUsb3::AuxCmd3, 0, auxCmd3Length - 1);
+    selectAuxCommandBankAllPorts(Rhd2000EvalBoardUsb3::AuxCmd3, 0);
+
+    Rhd2000DataBlockUsb3 block(controller_->getNumEnabledDataStreams());
+    controller_->setMaxTimeStep(SAMPLES_PER_DATA_BLOCK);
+    controller_->setContinuousRunMode(false);
+
+    std::vector<std::vector<int>> goodDelays(NumMisoLines, std::vector<int>(16, 0));
+    std::vector<int> chipId(NumMisoLines, -1);
+    for (int delay = 0; delay < 16; ++delay) {
+        for (int port = 0; port < MAX_NUM_SPI_PORTS; ++port) {
+            controller_->setCableDelay((Rhd2000EvalBoardUsb3::BoardPort)port, delay);
+        }
+        controller_->run();
+        while (controller_->isRunning()) {
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+        }
+        if (!controller_->readDataBlock(&block)) {
+            continue;
+        }
+        for (int line = 0; line < NumMisoLines; ++line) {
+            int register59Value;
+            int id = readChipId(block, line, register59Value);
+            if (id == ChipRhd2132 || id == ChipRhd2216 || (id == ChipRhd2164 && register59Value == Register59MisoA)) {
+                goodDelays[line][delay]++;
+                chipId[line] = id;
+            }
+        }
+    }
+
+    std::vector<int> optimumDelay(NumMisoLines, 0);
+    for (int line = 0; line < NumMisoLines; ++line) {
+        if (chipId[line] == -1) {
+            continue;
+        }
+        int bestCount = *std::max_element(goodDelays[line].begin(), goodDelays[line].end());
+        int numBest = (int)std::count(goodDelays[line].begin(), goodDelays[line].end(), bestCount);
+        int bestDelay = (int)(std::find(goodDelays[line].begin(), goodDelays[line].end(), bestCount) - goodDelays[line].begin());
+        if (numBest == 2 && chipId[line] == ChipRhd2164) {
+            bestDelay = (int)(goodDelays[line].rend() - std::find(goodDelays[line].rbegin(), goodDelays[line].rend(), bestCount)) - 1;
+        } else if (numBest > 2) {
+            // If 3 or more valid delays, don't use the shortest (or the longest)
+            bestDelay = (int)(std::find(goodDelays[line].begin() + bestDelay + 1, goodDelays[line].end(), bestCount) - goodDelays[line].begin());
+        }
+        optimumDelay[line] = bestDelay;
+    }
+    for (int port = 0; port < MAX_NUM_SPI_PORTS; ++port) {
+        controller_->setCableDelay((Rhd2000EvalBoardUsb3::BoardPort)port,
+                                   std::max(optimumDelay[2 * port], optimumDelay[2 * port + 1]));
+    }
+
+    streams_.clear();
+    int numChips = 0;
+    for (int line = 0; line < NumMisoLines; ++line) {
+        int port = line / 2;
+        bool present = chipId[line] != -1;
+        bool ddr = present && chipId[line] == ChipRhd2164;
+        controller_->enableDataStream(2 * line, present);
+        controller_->enableDataStream(2 * line + 1, ddr);
+        if (present) {
+            ++numChips;
+            streams_.push_back(IntanStreamInfo { 2 * line, port, chipId[line] });
+            if (ddr) {
+                streams_.push_back(IntanStreamInfo { 2 * line + 1, port, ChipRhd2164MisoB });
+            }
+            std::cout << "  Port " << (char)('A' + port) << " MISO " << (line % 2 == 0 ? 'A' : 'B')
+                      << ": chip ID " << chipId[line] << ", cable delay " << optimumDelay[line] << std::endl;
+        }
+    }
+    std::cout << "Detected " << numChips << " chip(s) on " << getNumStreams() << " stream(s)" << std::endl;
+    return numChips;
+}
+
 bool IntanReader::start() {
     if (running_) {
         std::cout << "Reader is already running." << std::endl;
@@ -169,11 +310,16 @@ bool IntanReader::start() {
     
     std::cout << "Starting continuous data acquisition..." << std::endl;
     
+    // A few batches in flight let the USB thread keep reading while the parser catches up
+    const int numBatches = 4;
+    fullBatches_.reset(new SpscQueue<UsbBatch>("usb->parse", numBatches));
+    freeBatches_.reset(new SpscQueue<UsbBatch>("parse->usb", numBatches + 1, OverflowDropNewest));
+    usbReads_ = 0;
+    blocksRead_ = 0;
     running_ = true;
     
-    // Start data reading loop in a separate thread
-    std::thread dataThread(&IntanReader::readDataLoop, this);
-    dataThread.detach();
+    usbThread_ = std::thread(&IntanReader::readDataLoop, this);
+    parseThread_ = std::thread(&IntanReader::parseDataLoop, this);
     
     return true;
 }
@@ -185,6 +331,15 @@ void IntanReader::stop() {
     
     std::cout << "Stopping data acquisition..." << std::endl;
     
+    // The USB thread finishes its current read and closes the queue; the parser drains what was read
+    running_ = false;
+    if (usbThread_.joinable()) {
+        usbThread_.join();
+    }
+    if (parseThread_.joinable()) {
+        parseThread_.join();
+    }
+    
     try {
         if (controller_) {
             controller_->flush();
@@ -193,59 +348,95 @@ void IntanReader::stop() {
         // Ignore any exceptions during flush
     }
     
-    running_ = false;
+    if (usbReads_ > 0) {
+        std::cout << "USB reads: " << usbReads_ << ", " << (double)blocksRead_ / usbReads_ << " blocks per read" << std::endl;
+    }
     std::cout << "Data acquisition stopped." << std::endl;
 }
 
+// USB thread: one FIFO level query and one block-pipe read per batch (the queried level is handed to
+// readDataBlocksRaw so it does not query again). The batch normally covers config_.readLatencyMs of data;
+// when the FIFO holds more than that (we fell behind) everything available is read in one go, up to
+// config_.maxBlocksPerRead.
 void IntanReader::readDataLoop() {
 
     const int streams = controller_->getNumEnabledDataStreams();
-    Rhd2000DataBlockUsb3 block(streams);
     const unsigned int wordsPerBlock = Rhd2000DataBlockUsb3::calculateDataBlockSizeInWords(streams);
+    const double blockDurationUs = 1e6 * SAMPLES_PER_DATA_BLOCK / sampleRateHz_;
+    const int maxBlocks = std::max(1, config_.maxBlocksPerRead);
+    const int targetBlocks = std::min(maxBlocks,
+        std::max(1, (int)(config_.readLatencyMs * 1000.0 / blockDurationUs)));
     
-    std::cout << "HW publisher: wordsPerBlock=" << wordsPerBlock << " streams=" << streams << std::endl;
+    std::cout << "HW publisher: wordsPerBlock=" << wordsPerBlock << " streams=" << streams
+              << " blocksPerRead=" << targetBlocks << "-" << maxBlocks << std::endl;
     std::cout << "Reading waveform data continuously..." << std::endl;
     
-    uint32_t timestamp = 0;
-    
+    double failureBackoffUs = blockDurationUs;
     while (running_) {
-        unsigned int fifoWords = controller_->getNumWordsInFifo();
-        if (fifoWords < wordsPerBlock) { 
-            usleep(200); 
-            continue; 
+        unsigned int wordsInFifo = controller_->getNumWordsInFifo();
+        int blocksAvailable = (int)(wordsInFifo / wordsPerBlock);
+        if (blocksAvailable < targetBlocks) {
+            // Sleep about as long as the missing blocks take to arrive, but stay responsive to stop()
+            double waitUs = (targetBlocks - blocksAvailable) * blockDurationUs;
+            std::this_thread::sleep_for(std::chrono::microseconds((int64_t)std::min(waitUs, 5000.0)));
+            continue;
         }
+        int numBlocks = std::min(blocksAvailable, maxBlocks);
         
-        while (controller_->getNumWordsInFifo() >= wordsPerBlock) {
-            if (!controller_->readDataBlock(&block)) break;
+        UsbBatch batch;
+        freeBatches_->tryPop(batch);
+        batch.bytes.resize((size_t)numBlocks * 2 * wordsPerBlock);
+        long result = controller_->readDataBlocksRaw(numBlocks, batch.bytes.data(), wordsInFifo);
+        if (result <= 0) {
+            // Failed pipe read: back off (doubling, capped like the wait above) instead of hammering the device
+            std::this_thread::sleep_for(std::chrono::microseconds((int64_t)failureBackoffUs));
+            failureBackoffUs = std::min(2.0 * failureBackoffUs, 5000.0);
+            continue;
+        }
+        failureBackoffUs = blockDurationUs;
+        batch.numBlocks = numBlocks;
+        batch.readTimeNs = traceNowNs();
+        ++usbReads_;
+        blocksRead_ += numBlocks;
+        fullBatches_->push(std::move(batch));
+    }
+    fullBatches_->close();
+}
+
+// Parse thread: split each batch into data blocks and publish them to the shared-memory hub
+void IntanReader::parseDataLoop() {
+
+    const int streams = controller_->getNumEnabledDataStreams();
+    Rhd2000DataBlockUsb3 block(streams);
+    
+    uint32_t timestamp = 0;
+    std::vector<std::vector<std::vector<int>>> amplifierData(streams,
+        std::vector<std::vector<int>>(CHANNELS_PER_STREAM, std::vector<int>(SAMPLES_PER_DATA_BLOCK)));
+    
+    UsbBatch batch;
+    while (fullBatches_->pop(batch)) {
+        for (int b = 0; b < batch.numBlocks; ++b) {
+            block.fillFromUsbBuffer(batch.bytes.data(), b, streams);
             
             if (sharedMemoryWriter_) {
-                // Create a 3D array: [stream][channel][sample]
-                std::vector<std::vector<std::vector<int>>> amplifierData;
-                const int channelsPerStream = CHANNELS_PER_STREAM;
-                const int samplesPerBlock = SAMPLES_PER_DATA_BLOCK;
-                
-                amplifierData.resize(streams);
-                
-                // Use EXACT same loop structure and data access as working Decoupled version
-                auto computeIndex = [streams](int s, int ch, int t) { 
-                    return (t * streams * CHANNELS_PER_STREAM) + (ch * streams) + s; 
-                };
-                
+                // [stream][channel][sample] for the writer; block data is [sample][channel][stream]
                 for (int stream = 0; stream < streams; ++stream) {
-                    amplifierData[stream].resize(channelsPerStream);
-                    for (int ch = 0; ch < channelsPerStream; ++ch) {
-                        amplifierData[stream][ch].resize(samplesPerBlock);
-                        for (int t = 0; t < samplesPerBlock; ++t) {
-                            amplifierData[stream][ch][t] = block.amplifierDataFast[computeIndex(stream, ch, t)];
+                    for (int ch = 0; ch < CHANNELS_PER_STREAM; ++ch) {
+                        std::vector<int>& samples = amplifierData[stream][ch];
+                        for (int t = 0; t < SAMPLES_PER_DATA_BLOCK; ++t) {
+                            samples[t] = block.amplifierDataFast[(t * streams * CHANNELS_PER_STREAM) + (ch * streams) + stream];
                         }
                     }
                 }
                 
-                sharedMemoryWriter_->writeDataBlock(timestamp, amplifierData);
+                // Every block of a batch left the board by the time of the read
+                sharedMemoryWriter_->writeDataBlock(timestamp, amplifierData, batch.readTimeNs);
             }
             
             timestamp += SAMPLES_PER_DATA_BLOCK;
         }
+        batch.numBlocks = 0;
+        freeBatches_->push(std::move(batch));
+        batch = UsbBatch();
     }
-    
-}
\ No newline at end of file
+}
@@ -4,19 +4,35 @@
 #include <iostream>
 #include <atomic>
 #include <memory>
+#include <thread>
 #include <vector>
 
 #include "includes/rhd2000evalboardusb3.h"
 #include "includes/rhd2000datablockusb3.h"
 #include "includes/rhd2000registersusb3.h"
 #include "shared_memory_writer.h"
+#include "../pipeline-runtime/spsc_queue.h"
+
+struct IntanReaderConfig {
+    Rhd2000EvalBoardUsb3::AmplifierSampleRate sampleRate = Rhd2000EvalBoardUsb3::SampleRate1000Hz;
+    bool scanPorts = true;    // detect chips on ports A-H; false = stream 0 on Port A with a 3 ft cable
+    double readLatencyMs = 10.0;  // wait for about this much data before a USB read (at least one block)
+    int maxBlocksPerRead = 64;    // cap on one bulk read while catching up on a backlog
+};
+
+// One enabled USB data stream (32 amplifier channels) and the chip behind it
+struct IntanStreamInfo {
+    int stream;     // USB data stream (0-31); MISO line = stream / 2
+    int port;       // SPI port, 0 = A ... 7 = H
+    int chipId;     // ROM register 63: 1 = RHD2132, 2 = RHD2216 (16 valid channels), 4 = RHD2164, 1000 = RHD2164 MISO B
+};
 
 class IntanReader {
 public:
-    IntanReader();
+    explicit IntanReader(const IntanReaderConfig& config = IntanReaderConfig());
     ~IntanReader();
     
-    // Initialize the reader with default settings
+    // Open the board, detect connected chips and size the shared-memory hub for every enabled stream
     bool initialize();
     
     // Start continuous data acquisition
@@ -27,18 +43,44 @@ public:
     
     // Check if reader is running
     bool isRunning() const { return running_; }
-    
+
+    int getNumStreams() const { return (int)streams_.size(); }
+    const std::vector<IntanStreamInfo>& getStreams() const { return streams_; }
+    double getSampleRate() const { return sampleRateHz_; }
+
+    // Map a rate in Hz (e.g. 30000) to the board's AmplifierSampleRate; false if the board has no such rate
+    static bool sampleRateFromHz(double hz, Rhd2000EvalBoardUsb3::AmplifierSampleRate& sampleRate);
 
 private:
+    // Raw bytes of one bulk read, passed from the USB thread to the parse thread
+    struct UsbBatch {
+        std::vector<unsigned char> bytes;
+        int numBlocks = 0;
+        uint64_t readTimeNs = 0;
+    };
+
     std::unique_ptr<Rhd2000EvalBoardUsb3> controller_;
     std::atomic<bool> running_;
     std::unique_ptr<SharedMemoryWriter> sharedMemoryWriter_;
+    IntanReaderConfig config_;
+    std::vector<IntanStreamInfo> streams_;
+    double sampleRateHz_;
+
+    std::thread usbThread_;
+    std::thread parseThread_;
+    std::unique_ptr<SpscQueue<UsbBatch>> fullBatches_;   // USB thread -> parse thread
+    std::unique_ptr<SpscQueue<UsbBatch>> freeBatches_;   // buffers handed back for reuse
+    uint64_t usbReads_;
+    uint64_t blocksRead_;
     
     // Internal methods
     bool openDevice();
     bool uploadBitfile();
     bool configureDevice();
+    int findConnectedChips(int auxCmd3Length);
+    void selectAuxCommandBankAllPorts(Rhd2000EvalBoardUsb3::AuxCmdSlot slot, int bank);
     void readDataLoop();
+    void parseDataLoop();
 };
 
 #endif // INTAN_READER_H
@@ -0,0 +1,160 @@
+#include "latency_trace.h"
+#include <fstream>
+#include <iomanip>
+
+LatencyHistogram::LatencyHistogram() {
+    reset();
+}
+
+void LatencyHistogram::reset() {
+    for (int i = 0; i < NumBuckets; ++i) {
+        buckets_[i].store(0, std::memory_order_relaxed);
+    }
+    count_.store(0, std::memory_order_relaxed);
+    sum_.store(0, std::memory_order_relaxed);
+    max_.store(0, std::memory_order_relaxed);
+}
+
+int LatencyHistogram::bucketIndex(uint64_t valueNs) {
+    if (valueNs < (2ull << SubBucketBits)) {
+        return (int)valueNs;
+    }
+    int exponent = 63 - __builtin_clzll(valueNs);
+    if (exponent > MaxExponent) {
+        return NumBuckets - 1;
+    }
+    int shift = exponent - SubBucketBits;
+    return (shift << SubBucketBits) + (int)(valueNs >> shift);
+}
+
+uint64_t LatencyHistogram::bucketUpperBound(int index) {
+    if (index < (2 << SubBucketBits)) {
+        return index;
+    }
+    int shift = (index >> SubBucketBits) - 1;
+    uint64_t mantissa = index - (shift << SubBucketBits);
+    return ((mantissa + 1) << shift) - 1;
+}
+
+void LatencyHistogram::record(uint64_t valueNs) {
+    buckets_[bucketIndex(valueNs)].fetch_add(1, std::memory_order_relaxed);
+    count_.fetch_add(1, std::memory_order_relaxed);
+    sum_.fetch_add(valueNs, std::memory_order_relaxed);
+    uint64_t previous = max_.load(std::memory_order_relaxed);
+    while (valueNs > previous && !max_.compare_exchange_weak(previous, valueNs, std::memory_order_relaxed)) {
+    }
+}
+
+double LatencyHistogram::meanNs() const {
+    uint64_t n = count();
+    return n > 0 ? (double)sum_.load(std::memory_order_relaxed) / n : 0.0;
+}
+
+uint64_t LatencyHistogram::percentileNs(double percentile) const {
+    uint64_t n = count();
+    if (n == 0) {
+        return 0;
+    }
+    uint64_t target = (uint64_t)(percentile / 100.0 * n + 0.5);
+    if (target < 1) {
+        target = 1;
+    }
+    uint64_t seen = 0;
+    for (int i = 0; i < NumBuckets; ++i) {
+        seen += buckets_[i].load(std::memory_order_relaxed);
+        if (seen >= target) {
+            uint64_t bound = bucketUpperBound(i);
+            return bound < maxNs() ? bound : maxNs();
+        }
+    }
+    return maxNs();
+}
+
+LatencyTracer& LatencyTracer::instance() {
+    static LatencyTracer tracer;
+    return tracer;
+}
+
+LatencyTracer::LatencyTracer() : frames_(0), lastSequenceId_(0), sequenceGaps_(0) {
+}
+
+const char* LatencyTracer::stageName(TraceStage stage) {
+    switch (stage) {
+        case TraceStagePublish: return "publish";
+        case TraceStageConsume: return "consume";
+        case TraceStageAsicWrite: return "asic_write";
+        case TraceStageAsicRead: return "asic_read";
+        case TraceStageDecode: return "decode";
+        case TraceStageLog: return "log";
+        default: return "unknown";
+    }
+}
+
+void LatencyTracer::record(const FrameTrace& trace) {
+    if (!trace.valid()) {
+        return;
+    }
+    for (int stage = 0; stage < NumTraceStages; ++stage) {
+        uint64_t t = trace.stageTimeNs[stage];
+        if (t >= trace.acquisitionTimeNs) {
+            stages_[stage].record(t - trace.acquisitionTimeNs);
+        }
+    }
+
+    // Frames the consumer never saw (it samples the latest block rather than every block)
+    uint32_t previous = lastSequenceId_.exchange(trace.sequenceId, std::memory_order_relaxed);
+    if (frames_.fetch_add(1, std::memory_order_relaxed) > 0 && trace.sequenceId - previous > 1) {
+        sequenceGaps_.fetch_add(trace.sequenceId - previous - 1, std::memory_order_relaxed);
+    }
+}
+
+void LatencyTracer::reset() {
+    for (int stage = 0; stage < NumTraceStages; ++stage) {
+        stages_[stage].reset();
+    }
+    frames_.store(0, std::memory_order_relaxed);
+    sequenceGaps_.store(0, std::memory_order_relaxed);
+}
+
+void LatencyTracer::printSummary(std::ostream& out) const {
+    out << "Latency since acquisition (" << framesRecorded() << " frames, "
+        << sequenceGaps_.load(std::memory_order_relaxed) << " frames not consumed):" << std::endl;
+    out << std::fixed << std::setprecision(3);
+    for (int stage = 0; stage < NumTraceStages; ++stage) {
+        const LatencyHistogram& h = stages_[stage];
+        if (h.count() == 0) {
+            continue;
+        }
+        out << "  " << std::left << std::setw(11) << stageName((TraceStage)stage) << std::right
+            << " p50 " << h.percentileNs(50.0) / 1.0e6 << " ms"
+            << "  p99 " << h.percentileNs(99.0) / 1.0e6 << " ms"
+            << "  p99.9 " << h.percentileNs(99.9) / 1.0e6 << " ms"
+            << "  max " << h.maxNs() / 1.0e6 << " ms" << std::endl;
+    }
+    out << std::defaultfloat;
+}
+
+bool LatencyTracer::exportJson(const std::string& path) const {
+    std::ofstream out(path);
+    if (!out) {
+        return false;
+    }
+    out << "{\n  \"frames\": " << framesRecorded()
+        << ",\n  \"frames_not_consumed\": " << sequenceGaps_.load(std::memory_order_relaxed)
+        << ",\n  \"stages\": {";
+    bool first = true;
+    for (int stage = 0; stage < NumTraceStages; ++stage) {
+        const LatencyHistogram& h = stages_[stage];
+        out << (first ? "\n" : ",\n") << "    \"" << stageName((TraceStage)stage) << "\": {"
+            << "\"count\": " << h.count()
+            << ", \"mean_ns\": " << (uint64_t)h.meanNs()
+            << ", \"p50_ns\": " << h.percentileNs(50.0)
+            << ", \"p90_ns\": " << h.percentileNs(90.0)
+            << ", \"p99_ns\": " << h.percentileNs(99.0)
+            << ", \"p999_ns\": " << h.percentileNs(99.9)
+            << ", \"max_ns\": " << h.maxNs() << "}";
+        first = false;
+    }
+    out << "\n  }\n}\n";
+    return (bool)out;
+}
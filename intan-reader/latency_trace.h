@@ -0,0 +1,96 @@
+#ifndef LATENCY_TRACE_H
+#define LATENCY_TRACE_H
+
+#include <time.h>
+#include <atomic>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+// End-to-end latency tracing for hub frames. The producer stamps each frame in IntanDataHeader with a
+// sequence id, its acquisition time and its publish time; consumers carry a FrameTrace alongside the
+// frame and stamp it as it passes each stage. All times are CLOCK_MONOTONIC nanoseconds, which are
+// comparable across processes on the same host.
+
+inline uint64_t traceNowNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+enum TraceStage {
+    TraceStagePublish = 0,   // block complete in the hub
+    TraceStageConsume,       // picked up by SharedMemoryReader
+    TraceStageAsicWrite,     // pipe-in to the ASIC FPGA returned
+    TraceStageAsicRead,      // pipe-out from the ASIC FPGA returned
+    TraceStageDecode,        // HALO response decoded
+    TraceStageLog,           // HDF5 row written
+    NumTraceStages
+};
+
+struct FrameTrace {
+    uint32_t sequenceId = 0;
+    uint64_t acquisitionTimeNs = 0;           // 0 = frame not traced (producer without tracing)
+    uint64_t stageTimeNs[NumTraceStages] = {};
+
+    bool valid() const { return acquisitionTimeNs != 0; }
+    void stamp(TraceStage stage) { stageTimeNs[stage] = traceNowNs(); }
+};
+
+// Log-linear (HDR-style) histogram of nanosecond latencies: exact below 64 ns, then 32 sub-buckets per
+// power of two (<= 3.1% relative error) up to ~2^40 ns. Recording is wait-free; reading while recording
+// gives a consistent-enough snapshot for monitoring.
+class LatencyHistogram {
+public:
+    static const int SubBucketBits = 5;
+    static const int MaxExponent = 40;
+    static const int NumBuckets = (MaxExponent - SubBucketBits + 2) << SubBucketBits;
+
+    LatencyHistogram();
+
+    void record(uint64_t valueNs);
+    void reset();
+
+    uint64_t count() const { return count_.load(std::memory_order_relaxed); }
+    uint64_t maxNs() const { return max_.load(std::memory_order_relaxed); }
+    double meanNs() const;
+    // Upper bound of the bucket holding the given percentile (0-100); 0 when empty
+    uint64_t percentileNs(double percentile) const;
+
+private:
+    std::atomic<uint64_t> buckets_[NumBuckets];
+    std::atomic<uint64_t> count_;
+    std::atomic<uint64_t> sum_;
+    std::atomic<uint64_t> max_;
+
+    static int bucketIndex(uint64_t valueNs);
+    static uint64_t bucketUpperBound(int index);
+};
+
+// Process-wide per-stage histograms of latency since acquisition.
+class LatencyTracer {
+public:
+    static LatencyTracer& instance();
+
+    // Record every stamped stage of a completed frame; untraced frames are ignored
+    void record(const FrameTrace& trace);
+    void reset();
+
+    uint64_t framesRecorded() const { return frames_.load(std::memory_order_relaxed); }
+    const LatencyHistogram& stageHistogram(TraceStage stage) const { return stages_[stage]; }
+
+    void printSummary(std::ostream& out) const;
+    bool exportJson(const std::string& path) const;
+
+    static const char* stageName(TraceStage stage);
+
+private:
+    LatencyTracer();
+
+    LatencyHistogram stages_[NumTraceStages];
+    std::atomic<uint64_t> frames_;
+    std::atomic<uint32_t> lastSequenceId_;
+    std::atomic<uint64_t> sequenceGaps_;
+};
+
+#endif // LATENCY_TRACE_H
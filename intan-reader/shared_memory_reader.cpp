@@ -1,10 +1,12 @@
 #include "shared_memory_reader.h"
 #include <iostream>
+#include <atomic>
 #include <cstring>
 
-SharedMemoryReader::SharedMemoryReader() 
-    : shmFd(-1), shmBase(nullptr), shmSize(0), shmName("/intan_rhx_shm_v1"), 
-      header(nullptr), shmInput(nullptr), lastTimestamp(0) {
+SharedMemoryReader::SharedMemoryReader(const char* name) 
+    : shmFd(-1), shmBase(nullptr), shmSize(0), shmName(name), 
+      header(nullptr), shmInput(nullptr), lastTimestamp(0), lastSequenceId(0), hasFrame(false), missedFrames(0),
+      stepSem(SEM_FAILED), ackSem(SEM_FAILED), awaitingAck(false) {
 }
 
 SharedMemoryReader::~SharedMemoryReader() {
@@ -12,7 +14,40 @@ SharedMemoryReader::~SharedMemoryReader() {
 }
 
 bool SharedMemoryReader::initialize() {
-    return openSharedMemory();
+    if (!openSharedMemory()) {
+        return false;
+    }
+
+    // Lock-step replay semaphores exist only while hub_capture is replaying with --lockstep.
+    if (std::strcmp(shmName, INTAN_SHM_NAME) == 0) {
+        stepSem = sem_open(INTAN_SHM_STEP_SEM_NAME, 0);
+    }
+    if (stepSem != SEM_FAILED) {
+        ackSem = sem_open(INTAN_SHM_ACK_SEM_NAME, 0);
+        if (ackSem == SEM_FAILED) {
+            sem_close(stepSem);
+            stepSem = SEM_FAILED;
+        } else {
+            std::cout << "Shared memory reader: lock-step replay detected" << std::endl;
+        }
+    }
+    return true;
+}
+
+// Acknowledge the previously returned frame, then wait up to 100 ms for the replayer to publish the next one.
+bool SharedMemoryReader::waitForLockstepFrame() {
+    if (awaitingAck) {
+        sem_post(ackSem);
+        awaitingAck = false;
+    }
+    for (int i = 0; i < 100; ++i) {
+        if (sem_trywait(stepSem) == 0) {
+            awaitingAck = true;
+            return true;
+        }
+        usleep(1000);
+    }
+    return false;
 }
 
 bool SharedMemoryReader::openSharedMemory() {
@@ -49,41 +84,76 @@ bool SharedMemoryReader::openSharedMemory() {
 }
 
 bool SharedMemoryReader::readLatestData(std::vector<uint8_t>& waveformData) {
+    size_t numBlocks = 0;
+    if (!beginFrame(numBlocks)) {
+        return false;
+    }
+    
+    // Quantize to the ASIC's 8-bit input with per-channel AGC; blocks are [time][stream][channel]
+    quantizer.quantize(shmInput, numBlocks, header->streamCount * header->channelCount, waveformData);
+    frameTrace.stamp(TraceStageConsume);
+    
+    // Debug output removed for long-term stability
+    return true;
+}
+
+bool SharedMemoryReader::readLatestBlocks(std::vector<IntanDataBlock>& blocks, uint32_t& channels) {
+    size_t numBlocks = 0;
+    if (!beginFrame(numBlocks)) {
+        return false;
+    }
+    
+    blocks.assign(shmInput, shmInput + numBlocks);
+    channels = header->streamCount * header->channelCount;
+    frameTrace.stamp(TraceStageConsume);
+    return true;
+}
+
+bool SharedMemoryReader::beginFrame(size_t& numBlocks) {
     if (!shmBase || !header || !shmInput) {
         return false;
     }
+
+    if (isLockstep() && !waitForLockstepFrame()) {
+        return false;
+    }
     
-    lastTimestamp = header->timestamp;
+    // The writer stores the timestamp last, so an unchanged timestamp means no new block since the last frame
+    // (lock-step replay already waited for the replayer's step, so that frame is new by construction)
+    uint32_t timestamp = header->timestamp;
+    if (hasFrame && !isLockstep() && timestamp == lastTimestamp) {
+        return false;
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    uint32_t sequenceId = header->sequenceId;
+    if (hasFrame && sequenceId - lastSequenceId > 1) {
+        missedFrames += sequenceId - lastSequenceId - 1;
+    }
+    lastTimestamp = timestamp;
+    lastSequenceId = sequenceId;
+    hasFrame = true;
+    frameTrace = FrameTrace();
+    frameTrace.sequenceId = sequenceId;
+    frameTrace.acquisitionTimeNs = header->acquisitionTimeNs;
+    frameTrace.stageTimeNs[TraceStagePublish] = header->publishTimeNs;
     
-    // Calculate number of data blocks (all channels from all streams)
+    // Calculate number of data blocks (all channels from all streams); dataSize covers the whole segment
     size_t dataSize = header->dataSize;
-    size_t numBlocks = dataSize / sizeof(IntanDataBlock);
+    numBlocks = dataSize > sizeof(IntanDataHeader) ? (dataSize - sizeof(IntanDataHeader)) / sizeof(IntanDataBlock) : 0;
     
     // Verify we have the expected number of channels
     if (header->channelCount != 32) {
         std::cerr << "[WARNING] Expected 32 channels, got " << header->channelCount << std::endl;
     }
-    
-    // Convert neural data to waveform format for all channels
-    waveformData.clear();
-    waveformData.reserve(numBlocks); // Reserve space for all data blocks
-    
-    for (size_t i = 0; i < numBlocks; ++i) {
-        IntanDataBlock& block = shmInput[i];
-        
-        // Convert float to uint8_t (scale from neural range to 0-255)
-        // Neural data is typically in microvolts, scale to reasonable range
-        float scaledValue = (block.value + 1000.0f) / 8.0f; // Scale to 0-255 range
-        scaledValue = std::max(0.0f, std::min(255.0f, scaledValue));
-        
-        uint8_t byteValue = static_cast<uint8_t>(scaledValue);
-        waveformData.push_back(byteValue);
-    }
-    
-    // Debug output removed for long-term stability
     return true;
 }
 
+uint64_t SharedMemoryReader::takeMissedFrames() {
+    uint64_t missed = missedFrames;
+    missedFrames = 0;
+    return missed;
+}
+
 void SharedMemoryReader::cleanup() {
     if (shmBase && shmBase != MAP_FAILED) {
         munmap(shmBase, shmSize);
@@ -95,6 +165,19 @@ void SharedMemoryReader::cleanup() {
         shmFd = -1;
     }
     
+    if (ackSem != SEM_FAILED) {
+        if (awaitingAck) {
+            sem_post(ackSem);
+            awaitingAck = false;
+        }
+        sem_close(ackSem);
+        ackSem = SEM_FAILED;
+    }
+    if (stepSem != SEM_FAILED) {
+        sem_close(stepSem);
+        stepSem = SEM_FAILED;
+    }
+    
     header = nullptr;
     shmInput = nullptr;
 }
@@ -5,23 +5,49 @@
 #include <fcntl.h>
 #include <unistd.h>
 #include <sys/stat.h>
+#include <semaphore.h>
 #include <vector>
 #include <mutex>
 #include <chrono>
 
 #include "intan_data_types.h"
+#include "latency_trace.h"
+#include "adaptive_quantizer.h"
 
 class SharedMemoryReader {
 public:
-    SharedMemoryReader();
+    explicit SharedMemoryReader(const char* name = INTAN_SHM_NAME);
     ~SharedMemoryReader();
     
     bool initialize();
+    // Both readers return false when the hub holds no frame newer than the one last returned, so a
+    // caller may poll faster than the producer publishes without seeing a frame twice.
     bool readLatestData(std::vector<uint8_t>& waveformData);
+    // Copy the latest frame's blocks out unquantized, for a quantize stage on another thread;
+    // channels = streamCount * channelCount. Stamps the frame trace like readLatestData().
+    bool readLatestBlocks(std::vector<IntanDataBlock>& blocks, uint32_t& channels);
+
+    // Frames the producer published that were overwritten in the single-slot hub before they were read
+    // (gaps in sequenceId) since the previous call; resets the count.
+    uint64_t takeMissedFrames();
     void cleanup();
 
+    // True when a hub_capture replay in lock-step mode was found at initialize(): each readLatestData()
+    // call then acknowledges the previous frame and waits for the next one.
+    bool isLockstep() const { return stepSem != SEM_FAILED; }
+
+    // Trace of the frame returned by the last readLatestData(): sequence id, acquisition time, and the
+    // publish and consume stages; downstream stages stamp a copy as the frame moves on.
+    const FrameTrace& getFrameTrace() const { return frameTrace; }
+
+    // Per-channel scale/offset of the frame returned by the last readLatestData(), for the exact inverse
+    // downstream (FpgaLogger); the quantizer's AGC attack/release are set here.
+    const QuantizationParams& getQuantization() const { return quantizer.params(); }
+    void setQuantizerConfig(const QuantizerConfig& config) { quantizer.setConfig(config); }
+
 private:
     bool openSharedMemory();
+    bool beginFrame(size_t& numBlocks);
     
     int shmFd;
     void* shmBase;
@@ -32,6 +58,16 @@ private:
     IntanDataHeader* header;
     IntanDataBlock* shmInput;
     uint32_t lastTimestamp;
+    uint32_t lastSequenceId;
+    bool hasFrame;            // lastTimestamp/lastSequenceId describe a frame already returned
+    uint64_t missedFrames;
+    FrameTrace frameTrace;
+    AdaptiveQuantizer quantizer;
+
+    sem_t* stepSem;
+    sem_t* ackSem;
+    bool awaitingAck;
+    bool waitForLockstepFrame();
 };
 
 #endif // SHARED_MEMORY_READER_H
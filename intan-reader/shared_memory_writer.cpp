@@ -1,9 +1,11 @@
 #include "shared_memory_writer.h"
+#include "latency_trace.h"
+#include <atomic>
 #include <iostream>
 #include <cstring>
 
-SharedMemoryWriter::SharedMemoryWriter() 
-    : shmFd(-1), shmBase(nullptr), shmSize(0), shmName("/intan_rhx_shm_v1"), frameCounter(0),
+SharedMemoryWriter::SharedMemoryWriter(const char* name) 
+    : shmFd(-1), shmBase(nullptr), shmSize(0), shmName(name), frameCounter(0),
       header(nullptr), shmOutput(nullptr), numStreams_(0), numChannels_(0), samplesPerBlock_(128) {
 }
 
@@ -72,7 +74,8 @@ bool SharedMemoryWriter::createSharedMemory() {
     return true;
 }
 
-void SharedMemoryWriter::writeDataBlock(uint32_t timestamp, const std::vector<std::vector<std::vector<int>>>& amplifierData) {
+void SharedMemoryWriter::writeDataBlock(uint32_t timestamp, const std::vector<std::vector<std::vector<int>>>& amplifierData,
+                                        uint64_t acquisitionTimeNs) {
     std::lock_guard<std::mutex> lock(writeMutex);
     
     if (!shmOutput || amplifierData.empty() || amplifierData[0].empty()) {
@@ -83,10 +86,41 @@ void SharedMemoryWriter::writeDataBlock(uint32_t timestamp, const std::vector<st
     // Write data blocks 
     writeDataBlocks(amplifierData);
     
-    // Update timestamp
-    header->timestamp = timestamp;
-    
+    // Update trace fields and timestamp
+    publishFrame(timestamp, acquisitionTimeNs);
+}
+
+void SharedMemoryWriter::writeMicrovoltBlock(uint32_t timestamp, const float* microvolts, uint64_t acquisitionTimeNs) {
+    std::lock_guard<std::mutex> lock(writeMutex);
+
+    if (!shmOutput || !microvolts) {
+        std::cerr << "SharedMemoryWriter: Invalid data or no shared memory" << std::endl;
+        return;
+    }
+
+    size_t w = 0;
+    for (int t = 0; t < samplesPerBlock_; ++t) {
+        for (int s = 0; s < numStreams_; ++s) {
+            for (int ch = 0; ch < numChannels_; ++ch) {
+                shmOutput[w] = { (uint32_t)s, (uint32_t)ch, microvolts[w] };
+                ++w;
+            }
+        }
+    }
+
+    publishFrame(timestamp, acquisitionTimeNs);
+}
+
+// Consumers treat a timestamp change as "new block complete", so the trace fields go first and the
+// timestamp last, behind a release fence.
+void SharedMemoryWriter::publishFrame(uint32_t timestamp, uint64_t acquisitionTimeNs) {
+    uint64_t nowNs = traceNowNs();
     frameCounter++;
+    header->sequenceId = frameCounter;
+    header->acquisitionTimeNs = acquisitionTimeNs != 0 ? acquisitionTimeNs : nowNs;
+    header->publishTimeNs = nowNs;
+    std::atomic_thread_fence(std::memory_order_release);
+    header->timestamp = timestamp;
 }
 
 void SharedMemoryWriter::initializeHeader(int numStreams, int numChannels, int sampleRate) {
@@ -97,6 +131,10 @@ void SharedMemoryWriter::initializeHeader(int numStreams, int numChannels, int s
     header->sampleRate = sampleRate;
     header->dataSize = static_cast<uint32_t>(shmSize);
     header->timestamp = 0;
+    header->sequenceId = 0;
+    header->reserved = 0;
+    header->acquisitionTimeNs = 0;
+    header->publishTimeNs = 0;
 }
 
 void SharedMemoryWriter::writeDataBlocks(const std::vector<std::vector<std::vector<int>>>& amplifierData) {
@@ -13,17 +13,24 @@
 
 class SharedMemoryWriter {
 public:
-    SharedMemoryWriter();
+    // name: shared memory segment; benchmarks use a private one instead of the hub
+    explicit SharedMemoryWriter(const char* name = INTAN_SHM_NAME);
     ~SharedMemoryWriter();
     
     bool initialize(int numStreams, int numChannels, int sampleRate);
-    void writeDataBlock(uint32_t timestamp, const std::vector<std::vector<std::vector<int>>>& amplifierData);
+    // acquisitionTimeNs: traceNowNs() when the block was acquired (0 = now); stamped into the header for latency tracing
+    void writeDataBlock(uint32_t timestamp, const std::vector<std::vector<std::vector<int>>>& amplifierData,
+                        uint64_t acquisitionTimeNs = 0);
+    // Write one block of already-converted values in hub order [sample][stream][channel] (used by replay)
+    void writeMicrovoltBlock(uint32_t timestamp, const float* microvolts, uint64_t acquisitionTimeNs = 0);
+    size_t valuesPerBlock() const { return (size_t)numStreams_ * numChannels_ * samplesPerBlock_; }
     void cleanup();
 
 private:
     bool createSharedMemory();
     void initializeHeader(int numStreams, int numChannels, int sampleRate);
     void writeDataBlocks(const std::vector<std::vector<std::vector<int>>>& amplifierData);
+    void publishFrame(uint32_t timestamp, uint64_t acquisitionTimeNs);
     
     int shmFd;
     void* shmBase;
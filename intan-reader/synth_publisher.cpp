@@ -0,0 +1,208 @@
+#include "synth_publisher.h"
+#include "latency_trace.h"
+#include "randomnumber.h"
+#include "synthdatablockgenerator.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <thread>
+
+namespace {
+    const int SamplesPerBlock = 128;          // matches SharedMemoryWriter
+    const double MicroVoltsPerBit = 0.195;
+    const double BurstRampSec = 2.0;          // onset/offset ramp of each burst
+    const double BurstMinFrequencyHz = 3.0;   // spike-wave discharge rate at burst onset/offset
+    const double BurstMaxFrequencyHz = 8.0;   // ... and at the middle of the burst
+}
+
+bool SynthPublisherConfig::validate() const {
+    if (numStreams < 1 || numStreams > MaxStreams) {
+        std::cerr << "SynthPublisher: stream count must be 1-" << MaxStreams << std::endl;
+        return false;
+    }
+    if (numChannels < 1 || numChannels > MaxChannels) {
+        std::cerr << "SynthPublisher: channel count must be 1-" << MaxChannels << std::endl;
+        return false;
+    }
+    if (sampleRate < MinSampleRate || sampleRate > MaxSampleRate) {
+        std::cerr << "SynthPublisher: sample rate must be " << MinSampleRate << "-" << MaxSampleRate << " Hz" << std::endl;
+        return false;
+    }
+    if (numSources < 0 || unitsPerSource < 0) {
+        std::cerr << "SynthPublisher: source and unit counts must not be negative" << std::endl;
+        return false;
+    }
+    if (burstIntervalSec > 0.0 && (burstDurationSec <= 0.0 || burstDurationSec >= burstIntervalSec)) {
+        std::cerr << "SynthPublisher: burst duration must be positive and shorter than the burst interval" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+SynthPublisher::SynthPublisher(const SynthPublisherConfig& config)
+    : config_(config), running_(false), timestamp_(0), sampleIndex_(0), blocksPublished_(0), lateBlocks_(0),
+      inBurst_(false), burstPhase_(0.0) {
+}
+
+SynthPublisher::~SynthPublisher() {
+    stop();
+}
+
+bool SynthPublisher::initialize() {
+    if (!config_.validate()) {
+        return false;
+    }
+
+    const int totalChannels = config_.numStreams * config_.numChannels;
+    const int numSources = config_.numSources > 0 ? std::min(config_.numSources, totalChannels) : totalChannels;
+
+    std::cout << "Initializing synthetic publisher: streams=" << config_.numStreams
+              << " channels=" << config_.numChannels
+              << " sampleRate=" << config_.sampleRate
+              << " sources=" << numSources
+              << (config_.freeRunning ? " (free-running)" : " (real time)") << std::endl;
+
+    // Same spike/LFP model as the RHX synthetic controller. Channels beyond numSources reuse a source,
+    // as SynthDataBlockGenerator does across streams, to keep generation cost bounded at 1024 channels.
+    randomGenerator_ = std::make_unique<RandomNumber>();
+    sources_.clear();
+    for (int i = 0; i < numSources; ++i) {
+        sources_.push_back(std::make_unique<NeuralSynthSource>(randomGenerator_.get(), (double)config_.sampleRate,
+                                                               config_.unitsPerSource));
+    }
+    sourceSamples_.assign(numSources, 32768);
+
+    channelSource_.resize(totalChannels);
+    channelBurstGain_.resize(totalChannels);
+    for (int i = 0; i < totalChannels; ++i) {
+        channelSource_[i] = i % numSources;
+        channelBurstGain_[i] = randomGenerator_->randomUniform(0.5, 1.0);
+    }
+
+    amplifierData_.assign(config_.numStreams,
+                          std::vector<std::vector<int>>(config_.numChannels, std::vector<int>(SamplesPerBlock, 32768)));
+
+    sharedMemoryWriter_ = std::make_unique<SharedMemoryWriter>();
+    if (!sharedMemoryWriter_->initialize(config_.numStreams, config_.numChannels, config_.sampleRate)) {
+        std::cerr << "Failed to initialize shared memory writer." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+void SynthPublisher::run() {
+    if (!sharedMemoryWriter_) {
+        std::cerr << "SynthPublisher: run() called before initialize()" << std::endl;
+        return;
+    }
+
+    using Clock = std::chrono::steady_clock;
+    const std::chrono::nanoseconds blockPeriod((int64_t)std::llround(1.0e9 * SamplesPerBlock / config_.sampleRate));
+    const uint64_t maxBlocks = config_.durationSec > 0.0 ?
+        (uint64_t)std::ceil(config_.durationSec * config_.sampleRate / SamplesPerBlock) : 0;
+
+    running_ = true;
+    const Clock::time_point start = Clock::now();
+    Clock::time_point deadline = start;
+    Clock::time_point lastReport = start;
+    uint64_t blocksAtLastReport = 0;
+
+    while (running_ && (maxBlocks == 0 || blocksPublished_ < maxBlocks)) {
+        uint64_t acquisitionTimeNs = traceNowNs();
+        generateBlock();
+        sharedMemoryWriter_->writeDataBlock(timestamp_, amplifierData_, acquisitionTimeNs);
+        timestamp_ += SamplesPerBlock;
+        ++blocksPublished_;
+
+        Clock::time_point now = Clock::now();
+        if (!config_.freeRunning) {
+            deadline += blockPeriod;
+            if (now < deadline) {
+                std::this_thread::sleep_until(deadline);
+            } else if (now - deadline > std::chrono::seconds(1)) {
+                // Generation cannot keep up; resynchronize rather than bursting to catch up.
+                lateBlocks_ += (now - deadline) / blockPeriod;
+                deadline = now;
+            }
+        }
+
+        if (now - lastReport >= std::chrono::seconds(1)) {
+            reportThroughput(blocksPublished_ - blocksAtLastReport,
+                             std::chrono::duration<double>(now - lastReport).count());
+            lastReport = now;
+            blocksAtLastReport = blocksPublished_;
+        }
+    }
+
+    double elapsedSec = std::chrono::duration<double>(Clock::now() - start).count();
+    std::cout << "Synthetic publisher stopped: " << blocksPublished_ << " blocks in " << elapsedSec << " s";
+    if (lateBlocks_ > 0) {
+        std::cout << ", " << lateBlocks_ << " blocks behind real time";
+    }
+    std::cout << std::endl;
+    running_ = false;
+}
+
+void SynthPublisher::generateBlock() {
+    const double tStepSec = 1.0 / config_.sampleRate;
+    const bool burstsEnabled = config_.burstIntervalSec > 0.0;
+
+    for (int t = 0; t < SamplesPerBlock; ++t) {
+        for (size_t i = 0; i < sources_.size(); ++i) {
+            sourceSamples_[i] = sources_[i]->nextSample();
+        }
+
+        double burstMicroVolts = burstsEnabled ? burstVoltage(sampleIndex_ * tStepSec) : 0.0;
+
+        int channelIndex = 0;
+        for (int s = 0; s < config_.numStreams; ++s) {
+            for (int ch = 0; ch < config_.numChannels; ++ch, ++channelIndex) {
+                int code = sourceSamples_[channelSource_[channelIndex]];
+                if (burstMicroVolts != 0.0) {
+                    code += (int)std::lround(burstMicroVolts * channelBurstGain_[channelIndex] / MicroVoltsPerBit);
+                    code = std::min(std::max(code, 0), 65535);
+                }
+                amplifierData_[s][ch][t] = code;
+            }
+        }
+        ++sampleIndex_;
+    }
+}
+
+// Seizure-like spike-wave discharge: a sharp negative spike followed by a slow positive wave, repeating at a
+// rate that rises from 3 Hz to 8 Hz and back over the burst, with amplitude ramped in and out.
+double SynthPublisher::burstVoltage(double tSec) {
+    // Burst k (k >= 1) occupies [k * burstIntervalSec, k * burstIntervalSec + burstDurationSec).
+    double tBurst = std::fmod(tSec, config_.burstIntervalSec);
+    bool burstNow = tSec >= config_.burstIntervalSec && tBurst < config_.burstDurationSec;
+    if (burstNow != inBurst_) {
+        inBurst_ = burstNow;
+        burstPhase_ = 0.0;
+        std::cout << (burstNow ? "Seizure-like burst started" : "Seizure-like burst ended")
+                  << " at timestamp " << sampleIndex_ << std::endl;
+    }
+    if (!burstNow) {
+        return 0.0;
+    }
+
+    double progress = tBurst / config_.burstDurationSec;
+    double frequencyHz = BurstMinFrequencyHz + (BurstMaxFrequencyHz - BurstMinFrequencyHz) * std::sin(Pi * progress);
+    burstPhase_ += frequencyHz / config_.sampleRate;
+
+    double envelope = std::min(1.0, std::min(tBurst, config_.burstDurationSec - tBurst) / BurstRampSec);
+    double p = burstPhase_ - std::floor(burstPhase_);
+    double spike = -std::exp(-std::pow((p - 0.1) / 0.03, 2.0));
+    double wave = p > 0.25 ? 0.35 * std::sin(Pi * (p - 0.25) / 0.75) : 0.0;
+    return config_.burstAmplitudeMicroVolts * envelope * (spike + wave);
+}
+
+void SynthPublisher::reportThroughput(uint64_t blocks, double elapsedSec) const {
+    if (elapsedSec <= 0.0) {
+        return;
+    }
+    double samplesPerSec = blocks * SamplesPerBlock / elapsedSec;
+    double channelSamplesPerSec = samplesPerSec * config_.numStreams * config_.numChannels;
+    std::cout << "Synthetic publisher: " << blocks / elapsedSec << " blocks/s, "
+              << channelSamplesPerSec / 1.0e6 << " M channel-samples/s ("
+              << samplesPerSec / config_.sampleRate << "x real time)" << std::endl;
+}
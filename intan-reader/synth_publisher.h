@@ -0,0 +1,83 @@
+#ifndef SYNTH_PUBLISHER_H
+#define SYNTH_PUBLISHER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "shared_memory_writer.h"
+
+class RandomNumber;
+class NeuralSynthSource;
+
+// Hardware-free producer for /intan_rhx_shm_v1. Drives the same SharedMemoryWriter as
+// IntanReader from the RHX NeuralSynthSource models (spikes + LFP), optionally with
+// seizure-like spike-wave bursts, so the ASIC sender, logger and pipelined GUI can be
+// load-tested without an XEM7310.
+struct SynthPublisherConfig {
+    int numStreams = 1;
+    int numChannels = 32;              // channels per stream
+    int sampleRate = 1000;             // Hz, 1000-30000
+    int numSources = 0;                // independent synth sources; 0 = one per channel
+    int unitsPerSource = 2;            // simulated neurons per source
+    bool freeRunning = false;          // publish as fast as possible instead of at sampleRate
+    double durationSec = 0.0;          // 0 = run until stop()
+    double burstIntervalSec = 0.0;     // seizure-like burst every N seconds; 0 = disabled
+    double burstDurationSec = 10.0;
+    double burstAmplitudeMicroVolts = 600.0;
+
+    static const int MaxStreams = 32;
+    static const int MaxChannels = 1024;
+    static const int MinSampleRate = 1000;
+    static const int MaxSampleRate = 30000;
+
+    bool validate() const;
+};
+
+class SynthPublisher {
+public:
+    explicit SynthPublisher(const SynthPublisherConfig& config);
+    ~SynthPublisher();
+
+    // Create the synth sources and the shared memory segment
+    bool initialize();
+
+    // Publish blocks on the calling thread until stop() or the configured duration elapses
+    void run();
+
+    // Request run() to return; safe to call from a signal handler
+    void stop() { running_ = false; }
+
+    bool isRunning() const { return running_; }
+    uint64_t getBlocksPublished() const { return blocksPublished_; }
+
+private:
+    SynthPublisherConfig config_;
+    std::atomic<bool> running_;
+    std::unique_ptr<SharedMemoryWriter> sharedMemoryWriter_;
+    std::unique_ptr<RandomNumber> randomGenerator_;
+    std::vector<std::unique_ptr<NeuralSynthSource>> sources_;
+
+    // Per-channel mapping onto sources_ and burst gain (channels see the burst at different strengths)
+    std::vector<int> channelSource_;
+    std::vector<double> channelBurstGain_;
+
+    // [stream][channel][sample] block handed to SharedMemoryWriter, allocated once
+    std::vector<std::vector<std::vector<int>>> amplifierData_;
+    std::vector<uint16_t> sourceSamples_;
+
+    uint32_t timestamp_;
+    uint64_t sampleIndex_;
+    uint64_t blocksPublished_;
+    uint64_t lateBlocks_;
+    bool inBurst_;
+    double burstPhase_;                // spike-wave cycles elapsed in the current burst
+
+    void generateBlock();
+    double burstVoltage(double tSec);
+    void reportThroughput(uint64_t blocks, double elapsedSec) const;
+};
+
+#endif // SYNTH_PUBLISHER_H
@@ -0,0 +1,32 @@
+# Hardware-free publisher for the /intan_rhx_shm_v1 shared-memory hub.
+# Reuses the RHX synthetic signal models, which depend on QtCore (QRandomGenerator).
+# Build with:  qmake synth_publisher.pro && make && ./synth_publisher --help
+
+QT -= gui
+CONFIG += c++17 console release
+CONFIG -= app_bundle
+
+TARGET = synth_publisher
+
+RHX = ../modified-intan-rhx/Engine/API
+
+INCLUDEPATH += . \
+               $$RHX/Abstract \
+               $$RHX/Hardware \
+               $$RHX/Synthetic
+
+SOURCES += synth_publisher_main.cpp \
+           synth_publisher.cpp \
+           shared_memory_writer.cpp \
+           $$RHX/Abstract/abstractrhxcontroller.cpp \
+           $$RHX/Hardware/rhxdatablock.cpp \
+           $$RHX/Hardware/rhxregisters.cpp \
+           $$RHX/Synthetic/randomnumber.cpp \
+           $$RHX/Synthetic/synthdatablockgenerator.cpp
+
+HEADERS += synth_publisher.h \
+           shared_memory_writer.h \
+           latency_trace.h \
+           intan_data_types.h
+
+linux: LIBS += -lrt
@@ -0,0 +1,87 @@
+// Standalone synthetic publisher for the /intan_rhx_shm_v1 shared-memory hub.
+// GOAL: exercise the ASIC sender, the logger and the pipelined RHX GUI without an
+// XEM7310 by publishing NeuralSynthSource data (spikes + LFP, optional seizure-like
+// bursts) through the same SharedMemoryWriter that intan_reader uses.
+
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+#include "synth_publisher.h"
+
+static SynthPublisher* activePublisher = nullptr;
+
+static void handleSignal(int) {
+    if (activePublisher) {
+        activePublisher->stop();
+    }
+}
+
+static void printUsage(const char* program) {
+    std::cout << "Usage: " << program << " [options]\n"
+              << "  --streams N          data streams (1-" << SynthPublisherConfig::MaxStreams << ", default 1)\n"
+              << "  --channels N         channels per stream (1-" << SynthPublisherConfig::MaxChannels << ", default 32)\n"
+              << "  --rate HZ            sample rate (" << SynthPublisherConfig::MinSampleRate << "-"
+              << SynthPublisherConfig::MaxSampleRate << " Hz, default 1000)\n"
+              << "  --sources N          independent synth sources shared across channels (default: one per channel)\n"
+              << "  --units N            simulated neurons per source (default 2)\n"
+              << "  --burst-every SEC    inject a seizure-like burst every SEC seconds (default off)\n"
+              << "  --burst-length SEC   burst duration (default 10)\n"
+              << "  --burst-amplitude UV burst peak amplitude in microvolts (default 600)\n"
+              << "  --duration SEC       stop after SEC seconds of data (default: run until Ctrl-C)\n"
+              << "  --free-run           publish as fast as possible instead of in real time\n";
+}
+
+int main(int argc, char* argv[]) {
+    SynthPublisherConfig config;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--free-run") {
+            config.freeRunning = true;
+        } else if (arg == "--help" || arg == "-h") {
+            printUsage(argv[0]);
+            return 0;
+        } else if (hasValue && arg == "--streams") {
+            config.numStreams = std::atoi(argv[++i]);
+        } else if (hasValue && arg == "--channels") {
+            config.numChannels = std::atoi(argv[++i]);
+        } else if (hasValue && arg == "--rate") {
+            config.sampleRate = std::atoi(argv[++i]);
+        } else if (hasValue && arg == "--sources") {
+            config.numSources = std::atoi(argv[++i]);
+        } else if (hasValue && arg == "--units") {
+            config.unitsPerSource = std::atoi(argv[++i]);
+        } else if (hasValue && arg == "--burst-every") {
+            config.burstIntervalSec = std::atof(argv[++i]);
+        } else if (hasValue && arg == "--burst-length") {
+            config.burstDurationSec = std::atof(argv[++i]);
+        } else if (hasValue && arg == "--burst-amplitude") {
+            config.burstAmplitudeMicroVolts = std::atof(argv[++i]);
+        } else if (hasValue && arg == "--duration") {
+            config.durationSec = std::atof(argv[++i]);
+        } else {
+            std::cerr << "Unknown or incomplete option: " << arg << std::endl;
+            printUsage(argv[0]);
+            return -1;
+        }
+    }
+
+    SynthPublisher publisher(config);
+    if (!publisher.initialize()) {
+        std::cerr << "Failed to initialize synthetic publisher." << std::endl;
+        return -1;
+    }
+
+    activePublisher = &publisher;
+    std::signal(SIGINT, handleSignal);
+    std::signal(SIGTERM, handleSignal);
+
+    publisher.run();
+
+    activePublisher = nullptr;
+    return 0;
+}
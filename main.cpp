@@ -18,28 +18,161 @@
 #include <cmath>
 #include <cstdlib>
 #include <algorithm>
+#include <cstring>
+#include <csignal>
+#include <atomic>
 
 #include "intan-reader/intan_reader.h"
 #include "intan-reader/shared_memory_reader.h"
 #include "asic-sender/asic_sender.h"
+#include "asic-sender/asic_sender_pool.h"
+#include "asic-sender/emulated_fpga_device.h"
 #include "data-analyser/src/core/fpga_logger.h"
 #include "data-analyser/src/core/halo_response_decoder.h"
+#include "intan-reader/latency_trace.h"
+#include "intan-reader/adaptive_quantizer.h"
+#include "pipeline-runtime/stage_graph.h"
+
+// SIGUSR1 exports the latency histograms without stopping the pipeline
+static std::atomic<bool> latencyReportRequested(false);
+
+static void handleLatencyReportSignal(int) {
+    latencyReportRequested = true;
+}
+
+static void writeLatencyReport(const std::string& path) {
+    LatencyTracer::instance().printSummary(std::cout);
+    if (LatencyTracer::instance().exportJson(path)) {
+        std::cout << "Latency histograms written to " << path << std::endl;
+    } else {
+        std::cerr << "Warning: could not write latency report to " << path << std::endl;
+    }
+}
+
+// Items on the stage graph's edges
+struct RawFrame {
+    std::vector<IntanDataBlock> blocks;
+    uint32_t channels = 0;
+    FrameTrace trace;
+};
+
+struct QuantizedFrame {
+    std::vector<uint8_t> waveform;
+    QuantizationParams quantization;
+    FrameTrace trace;
+};
+
+struct DecodedResponse {
+    HaloResponse halo;
+    AsicResponse asic;
+};
+
+static std::vector<std::string> splitList(const std::string& list) {
+    std::vector<std::string> items;
+    size_t start = 0;
+    while (start <= list.size()) {
+        size_t comma = std::min(list.find(',', start), list.size());
+        if (comma > start) {
+            items.push_back(list.substr(start, comma - start));
+        }
+        start = comma + 1;
+    }
+    return items;
+}
+
+static StageOptions stageOptions(const std::vector<int>& stageCpus, size_t stage) {
+    StageOptions options;
+    if (stage < stageCpus.size()) {
+        options.cpu = stageCpus[stage];
+    }
+    return options;
+}
+
+int main(int argc, char* argv[]) {
+    // --external-hub: do not open the Intan device; consume a hub published by another process
+    // (intan-reader/synth_publisher or intan-reader/hub_capture replay).
+    bool externalHub = false;
+    // --emulate-asic[=echo]: run the ASIC path against the in-process FPGA emulator instead of the XEM6310,
+    // with --asic-latency-us / --asic-bandwidth-mbps modeling the USB link.
+    bool emulateAsic = false;
+    FpgaEmulatorConfig emulatorConfig;
+    // --latency-report PATH: where the per-stage latency histograms are exported (on SIGUSR1 and at exit)
+    std::string latencyReportPath = "data-analyser/logs/latency.json";
+    // --agc-attack / --agc-release: per-frame envelope coefficients of the ASIC input quantizer (0-1]
+    QuantizerConfig quantizerConfig;
+    // --sample-rate HZ: amplifier sample rate (1000-30000, one of the board's rates);
+    // --no-port-scan: skip chip detection and acquire Port A stream 0 only;
+    // --read-latency-ms MS: data to wait for before each bulk USB read
+    IntanReaderConfig readerConfig;
+    // --asic-serials S1,S2,...: ASIC boards to fan the channel groups out to (one contiguous group per board)
+    std::vector<std::string> asicSerials = { "2437001CWG" };
+    // --pin-stages C0,C1,...: CPUs for the acquire, quantize, asic, decode and log stage threads (-1 = unpinned)
+    std::vector<int> stageCpus;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--external-hub") == 0) {
+            externalHub = true;
+        } else if (std::strcmp(argv[i], "--emulate-asic") == 0) {
+            emulateAsic = true;
+        } else if (std::strcmp(argv[i], "--emulate-asic=echo") == 0) {
+            emulateAsic = true;
+            emulatorConfig.kernel = FpgaEmulatorConfig::KernelEcho;
+        } else if (std::strcmp(argv[i], "--asic-latency-us") == 0 && i + 1 < argc) {
+            emulatorConfig.transferLatencyUs = std::atof(argv[++i]);
+        } else if (std::strcmp(argv[i], "--asic-bandwidth-mbps") == 0 && i + 1 < argc) {
+            emulatorConfig.bandwidthMBps = std::atof(argv[++i]);
+        } else if (std::strcmp(argv[i], "--latency-report") == 0 && i + 1 < argc) {
+            latencyReportPath = argv[++i];
+        } else if (std::strcmp(argv[i], "--agc-attack") == 0 && i + 1 < argc) {
+            quantizerConfig.attack = std::atof(argv[++i]);
+        } else if (std::strcmp(argv[i], "--agc-release") == 0 && i + 1 < argc) {
+            quantizerConfig.release = std::atof(argv[++i]);
+        } else if (std::strcmp(argv[i], "--sample-rate") == 0 && i + 1 < argc) {
+            double hz = std::atof(argv[++i]);
+            if (!IntanReader::sampleRateFromHz(hz, readerConfig.sampleRate)) {
+                std::cerr << "Unsupported sample rate: " << argv[i] << " Hz" << std::endl;
+                return -1;
+            }
+        } else if (std::strcmp(argv[i], "--no-port-scan") == 0) {
+            readerConfig.scanPorts = false;
+        } else if (std::strcmp(argv[i], "--read-latency-ms") == 0 && i + 1 < argc) {
+            readerConfig.readLatencyMs = std::atof(argv[++i]);
+        } else if (std::strcmp(argv[i], "--asic-serials") == 0 && i + 1 < argc) {
+            asicSerials = splitList(argv[++i]);
+        } else if (std::strcmp(argv[i], "--pin-stages") == 0 && i + 1 < argc) {
+            for (const std::string& cpu : splitList(argv[++i])) {
+                stageCpus.push_back(std::atoi(cpu.c_str()));
+            }
+        }
+    }
 
-int main(int /* argc */, char* /* argv */[]) {
     std::cout << "Testing Pipeline - Main Entry Point" << std::endl;
-    std::cout << "Starting Intan RHX Device Reader..." << std::endl;
+    std::signal(SIGUSR1, handleLatencyReportSignal);
     
     try {
         // Create and initialize the reader
-        IntanReader reader;
-        if (!reader.initialize()) {
-            std::cerr << "Failed to initialize Intan Reader." << std::endl;
-            return -1;
+        IntanReader reader(readerConfig);
+        if (externalHub) {
+            std::cout << "Using external shared-memory hub; Intan RHX Device Reader disabled." << std::endl;
+        } else {
+            std::cout << "Starting Intan RHX Device Reader..." << std::endl;
+            if (!reader.initialize()) {
+                std::cerr << "Failed to initialize Intan Reader." << std::endl;
+                return -1;
+            }
         }
         
-        // Create and initialize the ASIC sender (optional)
-        AsicSender asicSender;
-        bool asicInitialized = asicSender.initialize("2437001CWG", "asic-sender/First.bit");
+        // Create and initialize the ASIC boards (optional); boards that fail to open are left out
+        AsicSenderPool asicSender;
+        for (const std::string& serial : asicSerials) {
+            std::unique_ptr<FpgaDevice> asicDevice;
+            if (emulateAsic) {
+                asicDevice.reset(new EmulatedFpgaDevice(emulatorConfig));
+            } else {
+                asicDevice.reset(new OpalKellyFpgaDevice());
+            }
+            asicSender.addBoard(std::move(asicDevice), serial, "asic-sender/First.bit");
+        }
+        bool asicInitialized = asicSender.getNumBoards() > 0;
         if (!asicInitialized) {
             std::cerr << "Warning: ASIC Sender not available, continuing without FPGA processing." << std::endl;
         }
@@ -56,8 +189,6 @@ int main(int /* argc */, char* /* argv */[]) {
         std::unique_ptr<FpgaLogger> fpgaLogger;
         if (asicInitialized) {
             fpgaLogger = std::make_unique<FpgaLogger>();
-            // Connect the FPGA logger to the ASIC sender
-            asicSender.setDataAnalyzer(fpgaLogger.get());
             
             // Configure FPGA for real analysis (instead of test)
             std::cout << "Configuring FPGA for seizure detection analysis..." << std::endl;
@@ -90,60 +221,111 @@ int main(int /* argc */, char* /* argv */[]) {
         }
         
         // Start data acquisition
-        if (!reader.start()) {
+        if (!externalHub && !reader.start()) {
             std::cerr << "Failed to start data acquisition." << std::endl;
             return -1;
         }
         
-        // Start ASIC sender only if initialized
-        std::thread asicThread;
+        // Stage graph: acquire -> quantize -> asic (board pool) -> decode -> log, one thread per stage.
+        // Acquisition and quantization drop frames rather than wait; the HDF5 log has a deep queue and
+        // drops rows (counted) instead of stalling decode when the disk is slow.
+        AdaptiveQuantizer quantizer(quantizerConfig);
+        bool hasReceivedData = false;
+        const auto noDataTimeout = std::chrono::seconds(5);
+        auto lastDataTime = std::chrono::steady_clock::now();
+        StageGraph graph;
         if (asicInitialized) {
-            asicSender.startSending();
-            
-            // Create ASIC sender thread
-            asicThread = std::thread([&asicSender, &sharedMemoryReader]() {
-                std::vector<uint8_t> waveformData;
-                bool hasReceivedData = false;
-                int noDataCount = 0;
-                const int MAX_NO_DATA_COUNT = 50; // 5 seconds at 100ms intervals
-                
-                while (asicSender.isRunning()) {
-                    // Try to read real data from Intan device
-                    if (sharedMemoryReader.readLatestData(waveformData)) {
-                        if (!hasReceivedData) {
-                            std::cout << "Now sending REAL neural data from Intan device to ASIC!" << std::endl;
-                            hasReceivedData = true;
-                        }
-                        asicSender.sendWaveformData(waveformData);
-                        noDataCount = 0; // Reset counter
-                    } else {
-                        noDataCount++;
-                        
-                        // If we've been waiting too long for data, halt the pipeline
-                        if (noDataCount >= MAX_NO_DATA_COUNT) {
-                            std::cerr << "ERROR: No real neural data received from Intan device for 5 seconds!" << std::endl;
-                            std::cerr << "Pipeline cannot proceed without real data. Halting." << std::endl;
-                            asicSender.stopSending();
-                            return;
-                        }
+            auto& rawFrames = graph.addQueue<RawFrame>("acquire->quantize", 4, OverflowDropNewest);
+            auto& quantizedFrames = graph.addQueue<QuantizedFrame>("quantize->asic", 4, OverflowBlock);
+            auto& asicResponses = graph.addQueue<AsicResponse>("asic->decode", 64, OverflowBlock);
+            auto& decodedResponses = graph.addQueue<DecodedResponse>("decode->log", 1024, OverflowDropNewest);
+
+            // The hub holds one block at a time; poll well inside the shortest block period (128 samples at
+            // 30 kS/s is 4.3 ms) so every block is seen once. Blocks overwritten before we got to them are
+            // counted as drops on the acquire edge.
+            StageOptions acquireOptions = stageOptions(stageCpus, 0);
+            acquireOptions.pollIntervalUs = 1000;
+            graph.addSource<RawFrame>("acquire", rawFrames, [&](RawFrame& frame) {
+                // Try to read real data from Intan device
+                if (sharedMemoryReader.readLatestBlocks(frame.blocks, frame.channels)) {
+                    if (!hasReceivedData) {
+                        std::cout << "Now sending REAL neural data from Intan device to ASIC!" << std::endl;
+                        hasReceivedData = true;
                     }
-                    
-                    std::this_thread::sleep_for(std::chrono::milliseconds(100)); // Check every 100ms
+                    rawFrames.addDropped(sharedMemoryReader.takeMissedFrames());
+                    frame.trace = sharedMemoryReader.getFrameTrace();
+                    lastDataTime = std::chrono::steady_clock::now();
+                    return StageEmit;
+                }
+                // If we've been waiting too long for data, halt the pipeline
+                if (std::chrono::steady_clock::now() - lastDataTime >= noDataTimeout) {
+                    std::cerr << "ERROR: No real neural data received from Intan device for 5 seconds!" << std::endl;
+                    std::cerr << "Pipeline cannot proceed without real data. Halting." << std::endl;
+                    return StageFinish;
                 }
+                return StageSkip;
+            }, acquireOptions);
+
+            graph.addTransform<RawFrame, QuantizedFrame>("quantize", rawFrames, quantizedFrames,
+                [&quantizer](RawFrame& frame, QuantizedFrame& out) {
+                    quantizer.quantize(frame.blocks.data(), frame.blocks.size(), frame.channels, out.waveform);
+                    out.quantization = quantizer.params();
+                    out.trace = frame.trace;
+                    return StageEmit;
+                }, stageOptions(stageCpus, 1));
+
+            // The pool's merge thread is the producer of asic->decode; once the asic stage has drained, stop
+            // the boards and end that edge so decode and log drain behind it
+            asicSender.setResponseHandler([&asicResponses](AsicResponse& response) {
+                asicResponses.push(std::move(response));
             });
+            StageOptions asicOptions = stageOptions(stageCpus, 2);
+            asicOptions.onFinish = [&asicSender, &asicResponses]() {
+                asicSender.stopSending();
+                asicResponses.close();
+            };
+            graph.addSink<QuantizedFrame>("asic", quantizedFrames, [&asicSender](QuantizedFrame& frame) {
+                asicSender.submit(frame.waveform, &frame.trace, &frame.quantization);
+            }, asicOptions);
+
+            FpgaLogger* logger = fpgaLogger.get();
+            graph.addTransform<AsicResponse, DecodedResponse>("decode", asicResponses, decodedResponses,
+                [logger](AsicResponse& response, DecodedResponse& out) {
+                    if (response.response.empty()) {
+                        return StageSkip;
+                    }
+                    out.halo = logger->decodeFpgaData(response.response,
+                                                      response.lastOfFrame ? &response.trace : nullptr);
+                    out.asic = std::move(response);
+                    return StageEmit;
+                }, stageOptions(stageCpus, 3));
+            graph.addSink<DecodedResponse>("log", decodedResponses, [logger](DecodedResponse& decoded) {
+                logger->logDecodedResponse(decoded.halo, decoded.asic.response, decoded.asic.input,
+                                           decoded.asic.lastOfFrame ? &decoded.asic.trace : nullptr,
+                                           &decoded.asic.quantization);
+            }, stageOptions(stageCpus, 4));
+
+            asicSender.startSending();
+            graph.start();
         }
         
-        // Main loop - wait for reader to finish
-        while (reader.isRunning()) {
+        // Main loop - wait for reader (or, with an external hub, the stage graph) to finish
+        while (externalHub ? (asicInitialized && graph.isRunning()) : reader.isRunning()) {
             std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            if (latencyReportRequested.exchange(false)) {
+                writeLatencyReport(latencyReportPath);
+                graph.printStats(std::cout);
+            }
         }
         
-        // Stop ASIC sender and wait for thread
+        // Stop the sources and let the rest of the graph drain
         if (asicInitialized) {
-            asicSender.stopSending();
+            graph.stop();
+            graph.join();
+            graph.printStats(std::cout);
         }
-        if (asicThread.joinable()) {
-            asicThread.join();
+        if (LatencyTracer::instance().framesRecorded() > 0) {
+            writeLatencyReport(latencyReportPath);
         }
         
     } catch (const std::exception& e) {
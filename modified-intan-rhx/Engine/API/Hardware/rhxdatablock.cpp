@@ -34,6 +34,14 @@
 #include <cstring>
 #include "rhxdatablock.h"
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define USB_HEADER_SCAN_SSE2
+#elif defined(__ARM_NEON) && defined(__GNUC__)
+#include <arm_neon.h>
+#define USB_HEADER_SCAN_NEON
+#endif
+
 RHXDataBlock::RHXDataBlock(ControllerType type_, int numDataStreams_) :
     type(type_),
     numDataStreams(numDataStreams_),
@@ -334,6 +342,67 @@ bool RHXDataBlock::checkUsbHeader(const uint8_t* usbBuffer, int index) const
     return checkUsbHeader(usbBuffer, index, type);
 }
 
+// Search usbBuffer for the first complete USB header beginning at a 16-bit word offset in the range
+// [startIndex, endIndex - USBHeaderSizeInBytes], where endIndex is one past the last valid byte.  Returns the
+// byte index of the header, or -1 if no header was found.  Sixteen bytes (eight candidate word offsets) are
+// screened per step by matching the first two header words; only candidates passing the screen are compared
+// in full.
+int RHXDataBlock::findUsbHeader(const uint8_t* usbBuffer, int startIndex, int endIndex, ControllerType type_)
+{
+    uint64_t header = headerMagicNumber(type_);
+    uint8_t headerBytes[USBHeaderSizeInBytes];
+    for (int i = 0; i < USBHeaderSizeInBytes; ++i) {
+        headerBytes[i] = (uint8_t) ((header >> (8 * i)) & 0xffU);
+    }
+
+    int index = startIndex;
+
+#if defined(USB_HEADER_SCAN_SSE2) || defined(USB_HEADER_SCAN_NEON)
+    // Header words in native byte order, so they compare directly against words loaded from usbBuffer.
+    uint16_t word0, word1;
+    memcpy(&word0, &headerBytes[0], sizeof(word0));
+    memcpy(&word1, &headerBytes[2], sizeof(word1));
+
+    // Each step loads 16 bytes at index and 16 bytes at index + 2.
+    const int ScanBytes = 16;
+    while (index + ScanBytes + 2 <= endIndex) {
+#if defined(USB_HEADER_SCAN_SSE2)
+        __m128i first = _mm_loadu_si128((const __m128i*) &usbBuffer[index]);
+        __m128i second = _mm_loadu_si128((const __m128i*) &usbBuffer[index + 2]);
+        __m128i match = _mm_and_si128(_mm_cmpeq_epi16(first, _mm_set1_epi16((short) word0)),
+                                      _mm_cmpeq_epi16(second, _mm_set1_epi16((short) word1)));
+        unsigned int mask = (unsigned int) _mm_movemask_epi8(match);  // two bits per matching word
+        for (int offset = 0; mask != 0; offset += 2, mask >>= 2) {
+            if ((mask & 1U) && index + offset + USBHeaderSizeInBytes <= endIndex &&
+                memcmp(&usbBuffer[index + offset], headerBytes, USBHeaderSizeInBytes) == 0) {
+                return index + offset;
+            }
+        }
+#else
+        uint16x8_t first = vreinterpretq_u16_u8(vld1q_u8(&usbBuffer[index]));
+        uint16x8_t second = vreinterpretq_u16_u8(vld1q_u8(&usbBuffer[index + 2]));
+        uint16x8_t match = vandq_u16(vceqq_u16(first, vdupq_n_u16(word0)), vceqq_u16(second, vdupq_n_u16(word1)));
+        uint64_t mask = vget_lane_u64(vreinterpret_u64_u8(vmovn_u16(match)), 0);  // one byte per matching word
+        for (int offset = 0; mask != 0; offset += 2, mask >>= 8) {
+            if ((mask & 0xffU) && index + offset + USBHeaderSizeInBytes <= endIndex &&
+                memcmp(&usbBuffer[index + offset], headerBytes, USBHeaderSizeInBytes) == 0) {
+                return index + offset;
+            }
+        }
+#endif
+        index += ScanBytes;
+    }
+#endif
+
+    for (; index + USBHeaderSizeInBytes <= endIndex; index += 2) {
+        if (usbBuffer[index] == headerBytes[0] &&
+            memcmp(&usbBuffer[index], headerBytes, USBHeaderSizeInBytes) == 0) {
+            return index;
+        }
+    }
+    return -1;
+}
+
 // This function assumes that a command list created either by createCommandListRHDRegisterConfig
 // or createCommandListRHSRegisterConfig from RHXRegisters has been uploaded and run, and the resulting
 // RHXDataBlock read first.
@@ -365,6 +365,25 @@ int PipelineDataRHXController::findConnectedChips(std::vector<ChipType> &chipTyp
         }
     }
 
+    else if ((type == ControllerRecordUSB2 || type == ControllerRecordUSB3) && hubStreamCount() > 0) {
+        // Mirror the producer's layout from the hub header: one 32-channel chip per published stream,
+        // filling each port's streams before moving to the next port (as a real scan would)
+        int numStreams = (std::min)(hubStreamCount(), maxNumStreams);
+        int streamsPerPort = maxNumStreams / maxSPIPorts;
+        const IntanDataHeader* hdr = reinterpret_cast<const IntanDataHeader*>(shmBase);
+        ChipType hubChip = hdr->channelCount <= 16 ? RHD2216Chip : RHD2132Chip;
+        for (int stream = 0; stream < maxNumStreams; ++stream) {
+            bool used = stream < numStreams;
+            enableDataStream(stream, used);
+            if (!used) continue;
+            int port = stream / streamsPerPort;
+            chipType[stream] = hubChip;
+            portIndex[stream] = port;
+            commandStream[stream] = stream;
+            numChannelsOnPort[port] += hubChip == RHD2216Chip ? 16 : 32;
+        }
+    }
+
     else {
         if (type == ControllerRecordUSB2 || type == ControllerRecordUSB3) {
             chipType[0] = RHD2132Chip;
@@ -416,6 +435,15 @@ int PipelineDataRHXController::findConnectedChips(std::vector<ChipType> &chipTyp
     return 1;
 }
 
+// Number of streams the shared-memory producer publishes, or 0 if no hub is mapped yet.
+int PipelineDataRHXController::hubStreamCount() const
+{
+    if (!shmConnected || !shmBase || shmSize < sizeof(IntanDataHeader)) return 0;
+    const IntanDataHeader* hdr = reinterpret_cast<const IntanDataHeader*>(shmBase);
+    if (hdr->magic != 0x494E5441) return 0;
+    return (int) hdr->streamCount;
+}
+
 // Return the number of 16-bit words in the USB FIFO.  The user should never attempt to read more data than the
 // FIFO currently contains, as it is not protected against underflow.
 unsigned int PipelineDataRHXController::numWordsInFifo()
@@ -495,10 +523,7 @@ void PipelineDataRHXController::tcpThreadFunction()
                         producerSampleRateHz = static_cast<double>(hdr->sampleRate);
                         dataBlockPeriodNs = 1.0e9 * ((double)RHXDataBlock::samplesPerDataBlock(type)) / producerSampleRateHz;
                     }
-                    if (convertTCPDataToRHXBlock(base, hdr->dataSize)) {
-                        hasTCPData = true;
-                        lastTCPDataTime = std::chrono::steady_clock::now();
-                    }
+                    convertTCPDataToRHXBlock(base, hdr->dataSize);
                 }
             }
         }
@@ -573,6 +598,7 @@ bool PipelineDataRHXController::convertTCPDataToRHXBlock(const char* tcpData, si
     }
 
     // Update freshness on successful parse
+    hasTCPData = true;
     lastTCPDataTime = std::chrono::steady_clock::now();
     return true;
 }
@@ -601,6 +627,8 @@ bool PipelineDataRHXController::isTCPFresh()
 
 bool PipelineDataRHXController::isPacingReady(int numBlocks)
 {
+    if (!pacingEnabled) return true;
+
     auto now = std::chrono::steady_clock::now();
     double elapsedNs = (double)std::chrono::duration_cast<std::chrono::nanoseconds>(now - pacingStart).count();
     // Pace to the producer's sample rate if known to keep receive and render frequencies aligned
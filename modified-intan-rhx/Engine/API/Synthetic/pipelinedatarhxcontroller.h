@@ -51,6 +51,10 @@ struct IntanDataHeader {
     uint32_t streamCount;  // Number of streams
     uint32_t channelCount; // Number of channels
     uint32_t sampleRate;   // Sample rate
+    uint32_t sequenceId;   // Published block counter (latency tracing)
+    uint32_t reserved;
+    uint64_t acquisitionTimeNs; // CLOCK_MONOTONIC when the block was acquired
+    uint64_t publishTimeNs;     // CLOCK_MONOTONIC when the block was complete in shared memory
 };
 
 struct IntanDataBlock {
@@ -144,6 +148,10 @@ public:
     void injectTCPDataIntoGenerator();
     void tcpThreadFunction();
 
+    // Pacing holds readDataBlocksRaw() to the producer's sample rate; disable to build blocks as fast as
+    // possible (benchmarks)
+    void setPacingEnabled(bool enabled) { pacingEnabled = enabled; }
+
 private:
     unsigned int numWordsInFifo() override;
     bool isDcmProgDone() const override { return true; }
@@ -177,10 +185,12 @@ private:
     uint32_t tIndex = 0; // timestamp counter for synthetic/dummy/TCP-built blocks
     std::chrono::steady_clock::time_point pacingStart;
     double pacingDeficitNs = 0.0;
+    bool pacingEnabled = true;
     double dataBlockPeriodNs = 0.0; // computed as samplesPerBlock / producerSampleRateHz
     double producerSampleRateHz = 0.0; // latest sample rate reported by producer (SHM header)
 
     // Helpers
+    int hubStreamCount() const;
     bool isTCPFresh();
     bool isPacingReady(int numBlocks);
     long writeBlocksFromTCP(int numBlocks, uint8_t* buffer);
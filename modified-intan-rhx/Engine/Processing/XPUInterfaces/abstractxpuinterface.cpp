@@ -103,6 +103,20 @@ void AbstractXPUInterface::updateNumStreams(int numStreams_)
     updateMemory();
 }
 
+void AbstractXPUInterface::processDataBlocks(uint16_t* data, int numBlocks, uint16_t* lowChunk, uint16_t* wideChunk,
+                                             uint16_t* highChunk, uint32_t* spikeChunk, uint8_t* spikeIDChunk)
+{
+    for (int block = 0; block < numBlocks; block++) {
+        processDataBlock(data, lowChunk, wideChunk, highChunk, spikeChunk, spikeIDChunk);
+        data += wordsPerBlock;
+        lowChunk += FramesPerBlock * channels;
+        wideChunk += FramesPerBlock * channels;
+        highChunk += FramesPerBlock * channels;
+        spikeChunk += SnippetsPerBlock * channels;
+        spikeIDChunk += SnippetsPerBlock * channels;
+    }
+}
+
 void AbstractXPUInterface::runDiagnostic(int XPUIndex)
 { 
     uint16_t* dataOriginal = new uint16_t[DiagnosticBlocks * wordsPerBlock];
@@ -120,23 +134,8 @@ void AbstractXPUInterface::runDiagnostic(int XPUIndex)
         highOriginal[i] = 0;
     }
 
-    uint16_t* data_ = dataOriginal;
-    uint16_t* low_ = lowOriginal;
-    uint16_t* wide_ = wideOriginal;
-    uint16_t* high_ = highOriginal;
-    uint32_t* spike_ = spike;
-    uint8_t* spikeIDs_ = spikeIDs;
-
     auto start = std::chrono::steady_clock::now();
-    for (int block = 0; block < DiagnosticBlocks; block++) {
-        processDataBlock(data_, low_, wide_, high_, spike_, spikeIDs_);
-        data_ += wordsPerBlock;
-        low_ += FramesPerBlock * channels;
-        wide_ += FramesPerBlock * channels;
-        high_ += FramesPerBlock * channels;
-        spike_ += SnippetsPerBlock * channels;
-        spikeIDs_ += SnippetsPerBlock * channels;
-    }
+    processDataBlocks(dataOriginal, DiagnosticBlocks, lowOriginal, wideOriginal, highOriginal, spike, spikeIDs);
     auto end = std::chrono::steady_clock::now();
 
     delete [] dataOriginal;
@@ -272,6 +271,9 @@ void AbstractXPUInterface::updateFromState()
 
     // Update GPU arrays (to substitute structs) with new values from hoops
     updateHoopsVariables();
+
+    // Hand the new filter and detection settings to the processing thread
+    updateProcessingParameters();
 }
 
 // Default implementation - do nothing (should only be reimplemented by GPUInterface)
@@ -293,3 +295,8 @@ void AbstractXPUInterface::updateConstChars()
 void AbstractXPUInterface::updateConstFloats()
 {
 }
+
+// Default implementation - do nothing (should only be reimplemented by CPUInterface)
+void AbstractXPUInterface::updateProcessingParameters()
+{
+}
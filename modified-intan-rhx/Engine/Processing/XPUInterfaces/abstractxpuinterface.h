@@ -103,6 +103,10 @@ public:
     void resetPrev();
     virtual void processDataBlock(uint16_t* data, uint16_t* lowChunk, uint16_t* wideChunk,
                                   uint16_t* highChunk, uint32_t* spikeChunk, uint8_t* spikeIDChunk) = 0;
+    // Process numBlocks consecutive data blocks. Each output holds one block after another, laid out as a single
+    // block's output would be (FramesPerBlock * channels samples, SnippetsPerBlock * channels spikes per block).
+    virtual void processDataBlocks(uint16_t* data, int numBlocks, uint16_t* lowChunk, uint16_t* wideChunk,
+                                   uint16_t* highChunk, uint32_t* spikeChunk, uint8_t* spikeIDChunk);
     void updateNumStreams(int numStreams_);
     void updateFromState();
     virtual void speedTest() = 0;
@@ -117,6 +121,7 @@ protected:
     virtual void updateFilterConstArray();
     virtual void updateConstChars();
     virtual void updateConstFloats();
+    virtual void updateProcessingParameters();
     std::mutex filterMutex;
 
     bool allocated;
@@ -30,8 +30,167 @@
 
 #include "cpuinterface.h"
 
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define SPIKE_SCAN_SSE2
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define SPIKE_SCAN_NEON
+#endif
+
+namespace {
+
+// The high-pass output of the previous block's last SnippetSize samples followed by this block, padded to a
+// multiple of 4 floats. A spike candidate at threshS (-SnippetSize <= threshS < FramesPerBlock - SnippetSize)
+// starts at highHistory[SnippetSize + threshS], so snippets are read in place rather than copied.
+const int HighHistoryLength = (SnippetSize + FramesPerBlock + 3) & ~3;
+const int HighHistoryWords = (HighHistoryLength + 63) / 64;
+
+enum CompareOp {
+    CompareGreater,
+    CompareLess,
+    CompareGreaterOrEqual,
+    CompareLessOrEqual
+};
+
+// Compare four floats against four others; bit i of the result is set where (a[i] op b[i]).
+inline unsigned int compare4(const float* a, const float* b, CompareOp op)
+{
+#if defined(SPIKE_SCAN_SSE2)
+    __m128 x = _mm_loadu_ps(a);
+    __m128 y = _mm_loadu_ps(b);
+    __m128 r;
+    switch (op) {
+    case CompareGreater: r = _mm_cmpgt_ps(x, y); break;
+    case CompareLess: r = _mm_cmplt_ps(x, y); break;
+    case CompareGreaterOrEqual: r = _mm_cmpge_ps(x, y); break;
+    default: r = _mm_cmple_ps(x, y); break;
+    }
+    return (unsigned int) _mm_movemask_ps(r);
+#elif defined(SPIKE_SCAN_NEON)
+    float32x4_t x = vld1q_f32(a);
+    float32x4_t y = vld1q_f32(b);
+    uint32x4_t r;
+    switch (op) {
+    case CompareGreater: r = vcgtq_f32(x, y); break;
+    case CompareLess: r = vcltq_f32(x, y); break;
+    case CompareGreaterOrEqual: r = vcgeq_f32(x, y); break;
+    default: r = vcleq_f32(x, y); break;
+    }
+    static const uint32_t laneBits[4] = { 1, 2, 4, 8 };
+    return vaddvq_u32(vandq_u32(r, vld1q_u32(laneBits)));
+#else
+    unsigned int bits = 0;
+    for (int i = 0; i < 4; ++i) {
+        bool r;
+        switch (op) {
+        case CompareGreater: r = a[i] > b[i]; break;
+        case CompareLess: r = a[i] < b[i]; break;
+        case CompareGreaterOrEqual: r = a[i] >= b[i]; break;
+        default: r = a[i] <= b[i]; break;
+        }
+        if (r) bits |= 1u << i;
+    }
+    return bits;
+#endif
+}
+
+// Set bit i of mask where (x[i] op y[i]), for i in [0, n). n must be a multiple of 4; mask holds (n + 63) / 64 words.
+void compareMask(const float* x, const float* y, int n, CompareOp op, uint64_t* mask)
+{
+    for (int word = 0; word < (n + 63) / 64; ++word) {
+        mask[word] = 0;
+    }
+    for (int i = 0; i < n; i += 4) {
+        mask[i / 64] |= (uint64_t) compare4(x + i, y + i, op) << (i % 64);
+    }
+}
+
+// As above, against a single value.
+void compareMask(const float* x, float value, int n, CompareOp op, uint64_t* mask)
+{
+    const float y[4] = { value, value, value, value };
+    for (int word = 0; word < (n + 63) / 64; ++word) {
+        mask[word] = 0;
+    }
+    for (int i = 0; i < n; i += 4) {
+        mask[i / 64] |= (uint64_t) compare4(x + i, y, op) << (i % 64);
+    }
+}
+
+#if defined(_MSC_VER)
+inline int lowestSetBit(uint64_t word)
+{
+    unsigned long index;
+    _BitScanForward64(&index, word);
+    return (int) index;
+}
+#else
+inline int lowestSetBit(uint64_t word) { return __builtin_ctzll(word); }
+#endif
+
+// Lowest set bit of mask at or after begin and before end, or end if there is none.
+int nextSetBit(const uint64_t* mask, int begin, int end)
+{
+    for (int bit = begin; bit < end; ) {
+        uint64_t word = mask[bit / 64] >> (bit % 64);
+        if (word) {
+            int found = bit + lowestSetBit(word);
+            return found < end ? found : end;
+        }
+        bit = (bit / 64 + 1) * 64;
+    }
+    return end;
+}
+
+// True if any bit of mask in [begin, end) is set.
+bool anySetBit(const uint64_t* mask, int begin, int end)
+{
+    return nextSetBit(mask, begin, end) < end;
+}
+
+}
+
+// Everything processDataBlock() writes while filtering one channel. The scratch arrays are fully rewritten
+// before they are read, so they are neither cleared nor reallocated between blocks.
+struct CPUInterface::ProcessingContext
+{
+    // The last SnippetSize high-pass samples of one channel, as they were written to highChunk
+    struct alignas(64) ChannelHistory
+    {
+        float high[SnippetSize];
+    };
+
+    explicit ProcessingContext(int channels) : history(channels)
+    {
+        for (ChannelHistory &channel : history) {
+            for (int s = 0; s < SnippetSize; ++s) {
+                channel.high[s] = 0.0f;
+            }
+        }
+        for (int a = SnippetSize + FramesPerBlock; a < HighHistoryLength; ++a) {
+            highHistory[a] = 0.0f;
+        }
+    }
+
+    std::vector<ChannelHistory> history;
+
+    alignas(64) float inFloat[FramesPerBlock];
+    alignas(64) float wideFloat[FramesPerBlock];
+    alignas(64) float lowFloat[4][FramesPerBlock];
+    alignas(64) float highFloat[4][FramesPerBlock];
+    alignas(64) float filteredLow[FramesPerBlock];
+    alignas(64) float highHistory[HighHistoryLength];
+    uint64_t crossingMask[HighHistoryWords];
+    uint64_t spikeMaxMask[HighHistoryWords];
+};
+
 CPUInterface::CPUInterface(SystemState *state_, QObject *parent) :
-    AbstractXPUInterface(state_, parent)
+    AbstractXPUInterface(state_, parent),
+    context(nullptr)
 {
     updateFromState();
 }
@@ -46,8 +205,6 @@ CPUInterface::~CPUInterface()
 void CPUInterface::processDataBlock(uint16_t * data, uint16_t *lowChunk, uint16_t *wideChunk, uint16_t *highChunk,
                                     uint32_t *spikeChunk, uint8_t *spikeIDChunk)
 {
-    std::lock_guard<std::mutex> lockFilter(filterMutex);
-
     if (channels == 0)
         return;
 
@@ -55,57 +212,39 @@ void CPUInterface::processDataBlock(uint16_t * data, uint16_t *lowChunk, uint16_
 
     float samplePeriod = 1.0f / sampleRate;
 
-    float notchB2 = filterParameters.notchParams.b2;
-    float notchB1 = filterParameters.notchParams.b1;
-    float notchB0 = filterParameters.notchParams.b0;
-    float notchA2 = filterParameters.notchParams.a2;
-    float notchA1 = filterParameters.notchParams.a1;
-
-    float lowB2[4];
-    float lowB1[4];
-    float lowB0[4];
-    float lowA2[4];
-    float lowA1[4];
-
-    for (uint8_t filterIndex = 0; filterIndex < 4; ++filterIndex) {
-        lowB2[filterIndex] = filterParameters.lowParams[filterIndex].b2;
-        lowB1[filterIndex] = filterParameters.lowParams[filterIndex].b1;
-        lowB0[filterIndex] = filterParameters.lowParams[filterIndex].b0;
-        lowA2[filterIndex] = filterParameters.lowParams[filterIndex].a2;
-        lowA1[filterIndex] = filterParameters.lowParams[filterIndex].a1;
-    }
+    std::shared_ptr<const ProcessingParameters> parameters = std::atomic_load(&currentParameters);
 
-    float highB2[4];
-    float highB1[4];
-    float highB0[4];
-    float highA2[4];
-    float highA1[4];
-
-    for (uint8_t filterIndex = 0; filterIndex < 4; ++filterIndex) {
-        highB2[filterIndex] = filterParameters.highParams[filterIndex].b2;
-        highB1[filterIndex] = filterParameters.highParams[filterIndex].b1;
-        highB0[filterIndex] = filterParameters.highParams[filterIndex].b0;
-        highA2[filterIndex] = filterParameters.highParams[filterIndex].a2;
-        highA1[filterIndex] = filterParameters.highParams[filterIndex].a1;
-    }
+    const float notchB2 = parameters->notchB2;
+    const float notchB1 = parameters->notchB1;
+    const float notchB0 = parameters->notchB0;
+    const float notchA2 = parameters->notchA2;
+    const float notchA1 = parameters->notchA1;
+
+    const float* lowB2 = parameters->lowB2;
+    const float* lowB1 = parameters->lowB1;
+    const float* lowB0 = parameters->lowB0;
+    const float* lowA2 = parameters->lowA2;
+    const float* lowA1 = parameters->lowA1;
+
+    const float* highB2 = parameters->highB2;
+    const float* highB1 = parameters->highB1;
+    const float* highB0 = parameters->highB0;
+    const float* highA2 = parameters->highA2;
+    const float* highA1 = parameters->highA1;
+
+    const int numLowFilterIterations = parameters->numLowFilterIterations;
+    const int numHighFilterIterations = parameters->numHighFilterIterations;
 
     const unsigned int snippetsPerBlock = (int) ceil((double) ((double) FramesPerBlock / (double) SnippetSize) + 1.0);
 
-    float inFloat[FramesPerBlock];
-    float prevHighFloat[FramesPerBlock];
-    float lowFloat[4][FramesPerBlock];
-    float wideFloat[FramesPerBlock];
-    float highFloat[4][FramesPerBlock];
-
-    for (int a = 0; a < FramesPerBlock; ++a) {
-        inFloat[a] = 0.0f;
-        prevHighFloat[a] = 0.0f;
-        wideFloat[a] = 0.0f;
-        for (int b = 0; b < 4; ++b) {
-            lowFloat[b][a] = 0.0f;
-            highFloat[b][a] = 0.0f;
-        }
-    }
+    float* inFloat = context->inFloat;
+    float (*lowFloat)[FramesPerBlock] = context->lowFloat;
+    float* wideFloat = context->wideFloat;
+    float (*highFloat)[FramesPerBlock] = context->highFloat;
+    float* filteredLow = context->filteredLow;
+    float* highHistory = context->highHistory;
+    uint64_t* crossingMask = context->crossingMask;
+    uint64_t* spikeMaxMask = context->spikeMaxMask;
 
     uint32_t low2ndToLastIndex[4];
     uint32_t lowLastIndex[4];
@@ -147,16 +286,18 @@ void CPUInterface::processDataBlock(uint16_t * data, uint16_t *lowChunk, uint16_
         float inLast = prevLast2[inLastIndex];
         float wide2ndToLast = prevLast2[wide2ndToLastIndex];
         float wideLast = prevLast2[wideLastIndex];
-        float threshold = hoops[channelIndex].threshold;
-        bool useHoops = (hoops[channelIndex].useHoops == 1) ? true : false;
+        const ChannelHoopsStruct &channelHoops = parameters->channelHoops[channelIndex];
+        float threshold = channelHoops.threshold;
+        bool useHoops = (channelHoops.useHoops == 1) ? true : false;
 
         for (s = 0; s < snippetsPerBlock; ++s) {
             spikeChunk[s * channels + channelIndex] = 0;
             spikeIDChunk[s * channels + channelIndex] = 0;
         }
 
+        float* channelHistory = context->history[channelIndex].high;
         for (s = 0; s < SnippetSize; ++s) {
-            prevHighFloat[s] = (float) (0.195f * (((double)parsedPrevHigh[s * channels + channelIndex]) - 32768));
+            highHistory[s] = channelHistory[s];
         }
 
         int32_t inIndexStream, inIndexChannel;
@@ -181,9 +322,6 @@ void CPUInterface::processDataBlock(uint16_t * data, uint16_t *lowChunk, uint16_
             inFloat[frame] = (float)(0.195f * (((double)acSample) - 32768));
         }
 
-        int numLowFilterIterations = floor((float)(filterParameters.lowOrder - 1) / 2.0f) + 1;
-        int numHighFilterIterations = floor((float)(filterParameters.highOrder - 1) / 2.0f) + 1;
-
         // s == 0 condition
         // (1) IIR notch filter into wideFloat
 
@@ -287,8 +425,7 @@ void CPUInterface::processDataBlock(uint16_t * data, uint16_t *lowChunk, uint16_
             }
         }
 
-        float filteredHigh[FramesPerBlock];
-        float filteredLow[FramesPerBlock];
+        float* filteredHigh = &highHistory[SnippetSize];
 
         for (int s = 0; s < FramesPerBlock; ++s) {
             filteredHigh[s] = highFloat[numHighFilterIterations - 1][s];
@@ -299,211 +436,77 @@ void CPUInterface::processDataBlock(uint16_t * data, uint16_t *lowChunk, uint16_
         // determine valid t0. Add earliest t0 for each rectangle to 'spike' output.
         snippetIndex = 0;
 
+        // Bit (SnippetSize + threshS) of crossingMask is set where the sample at threshS surpasses the threshold
+        // (threshS < 0 reaches back into the previous block). Candidate positions only go up to
+        // FramesPerBlock - SnippetSize, so their snippets never run past the end of this block.
+        const int numCandidates = FramesPerBlock;
+        compareMask(highHistory, threshold, numCandidates, threshold >= 0 ? CompareGreater : CompareLess, crossingMask);
+        if (parameters->spikeMaxEnabled) {
+            compareMask(highHistory, parameters->spikeMax, HighHistoryLength,
+                        parameters->spikeMax >= 0 ? CompareGreaterOrEqual : CompareLessOrEqual, spikeMaxMask);
+        }
+
         // Start with threshS = startSearchPos[channelIndex]. This is 0 unless the previous data block ended with a spike.
         // In that case, threshS is a non-zero offset to avoid double-detecting a snippet.
-        for (int threshS = startSearchPos[channelIndex] - SnippetSize; threshS < FramesPerBlock - SnippetSize; ++threshS) {
-
-            startSearchPos[channelIndex] = 0;
-
-            // Look to both this data block and the previous block to determine if the threshold was surpassed.
-            bool surpassed = false;
-
-            if (threshold >= 0) {  // If threshold was positive:
-                if (threshS >= 0) {
-                    if (filteredHigh[threshS] > threshold) surpassed = true;
-                } else {
-                    if (prevHighFloat[SnippetSize + threshS] > threshold) surpassed = true;
+        int candidate = startSearchPos[channelIndex];
+        startSearchPos[channelIndex] = 0;
+        while ((candidate = nextSetBit(crossingMask, candidate, numCandidates)) < numCandidates) {
+            int threshS = candidate - SnippetSize;
+            const float* thisSnippet = &highHistory[candidate];
+
+            // If spikeMaxEnabled is true, then see if any samples in this snippet surpass spikeMax.
+            bool maxSurpassed = parameters->spikeMaxEnabled &&
+                    anySetBit(spikeMaxMask, candidate, candidate + SnippetSize);
+
+            uchar ID = 0;
+            // Determine correct ID
+
+
+            if (maxSurpassed) {  // If max has been detected, ID is 128 for max surpassing.
+                ID = 128;
+            } else if (true) {
+            //} else if (!useHoops) {  // If useHoops is false, ID is 1 to signify threshold crossing.
+                ID = 1;
+            } else {  // If useHoops is true, ID is either (a) an active unit or (b) just a threshold crossing.
+                // (a) If a unit is active, ID is either 1, 2, 4, or 8 for the unit.
+                uint8_t units = useHoops ? matchUnits(thisSnippet, channelHoops, samplePeriod) : 0x0f;
+                if (units) {
+                    ID = units & (uint8_t) -units;  // lowest matching unit
                 }
-            } else {  // If threshold was negative:
-                if (threshS >= 0) {
-                    if (filteredHigh[threshS] < threshold) surpassed = true;
-                } else {
-                    if (prevHighFloat[SnippetSize + threshS] < threshold) surpassed = true;
-                }
-            }
 
-            // Threshold was surpassed.
-            if (surpassed) {
-                // For ease of understanding, move the samples from [threshS, threshS + SnippetSize] to [0, snippetSize].
-                float thisSnippet[FramesPerBlock];
-                for (int i = 0; i < SnippetSize; ++i) {
-                    int thisS = threshS + i;
-                    if (thisS < 0) {
-                        thisSnippet[i] = prevHighFloat[SnippetSize + thisS];
-                    } else {
-                        thisSnippet[i] = filteredHigh[thisS];
-                    }
-                }
-
-                // Create a struct to hold this channel's hoop info.
-                ChannelDetectionStruct detection;
-                for (int unit = 0; unit < 4; ++unit) {
-                    for (int hoop = 0; hoop < 4; ++hoop) {
-                        detection.units[unit].hoops[hoop] = false;
-                    }
-                }
-                detection.maxSurpassed = false;
-
-                // If spikeMaxEnabled is true, then see if any samples in this snippet surpass spikeMax. If they do,
-                // then mark detetion.maxSurpassed as true and save which sample.
-                if (globalParameters.spikeMaxEnabled) {
-                    for (int i = 0; i < SnippetSize; ++i) {
-                        if (globalParameters.spikeMax >= 0 && thisSnippet[i] >= globalParameters.spikeMax) {
-                            detection.maxSurpassed = true;
-                            break;
-                        }
-                        if (globalParameters.spikeMax < 0 && thisSnippet[i] <= globalParameters.spikeMax) {
-                            detection.maxSurpassed = true;
-                            break;
-                        }
-                    }
-                }
-
-                // If useHoops is true, then go through all units populating detection.units[unit].hoops[hoop].
-                if (useHoops) {
-                    // Go through all units.
-                    for (int unit = 0; unit < 4; ++unit) {
-
-                        // If this unit has no valid hoops (all tA values are -1.0f), then this is an inactive unit which
-                        // should be treated as having no intersect; just go on to the next unit.
-                        if (hoops[channelIndex].unitHoops[unit].hoopInfo[0].tA == -1.0f &&
-                                hoops[channelIndex].unitHoops[unit].hoopInfo[1].tA == -1.0f &&
-                                hoops[channelIndex].unitHoops[unit].hoopInfo[2].tA == -1.0f &&
-                                hoops[channelIndex].unitHoops[unit].hoopInfo[3].tA == -1.0f) {
-                            continue;
-                        }
-
-                        // Go through all hoops.
-                        for (int hoop = 0; hoop < 4; ++hoop) {
-                            HoopInfoStruct thisHoop = hoops[channelIndex].unitHoops[unit].hoopInfo[hoop];
-
-                            // If this hoop info is invalid (tA is -1.0f), then this is an inactive hoop, which by default passes.
-                            // Set true and continue. If all hoops are inactive, then we would have already passed on to the next
-                            // unit without flaggin an intersect.
-                            if (thisHoop.tA == -1.0f) {
-                                detection.units[unit].hoops[hoop] = true;
-                                continue;
-                            }
-
-                            float tA = thisHoop.tA;
-                            float yA = thisHoop.yA;
-                            float tB = thisHoop.tB;
-                            float yB = thisHoop.yB;
-
-                            // In range [tA, tB], does line segment from (t1, y1) to (t2, y2) intersect user-defined hoop?
-                            // If so, mark hoop as jumped through by setting intersect to true.
-                            bool intersect = false;
-
-                            // Round tA down and tB up to the nearest discrete sample.
-                            int sA = floor(sampleRate * tA);
-                            int sB = ceil(sampleRate * tB);
-
-                            // Special case: vertical hoop
-                            if (sA == sB) {
-                                float y1Data = thisSnippet[sA];
-                                if (yB > yA) {
-                                    intersect = (y1Data < yB && y1Data > yA);
-                                } else {
-                                    intersect = (y1Data > yB && y1Data < yA);
-                                }
-                            } else {
-                                // General case: non-vertical hoop
-                                float slope = (yB - yA) / (tB - tA);
-                                // Examine every two adjacent samples in the range [sA, sB] and determine if they intersect the hoop.
-                                for (int s1 = sA; s1 < sB - 1; ++s1) {
-                                    int s2 = s1 + 1;
-                                    float y1Data = thisSnippet[s1];
-                                    float y2Data = thisSnippet[s2];
-
-                                    // Convert s1 and s2 to the float t1 and t2 domain.
-                                    float t1 = ((float) s1) * samplePeriod;
-                                    float t2 = ((float) s2) * samplePeriod;
-
-                                    float y1Hoop = yA + slope * (t1 - tA);
-                                    float y2Hoop = yA + slope * (t2 - tA);
-
-                                    // If the data transitions from below to above the hoop (or vice versa), then an intersection
-                                    // occurred. Break the loop for checking this hoop.
-                                    if ((y1Data >= y1Hoop && y2Data <= y2Hoop) ||
-                                            (y1Data <= y1Hoop && y2Data >= y2Hoop)) {
-                                        intersect = true;
-                                        break;
-                                    }
-
-                                    // Otherwise, keep looking over the course of this hoop.
-                                }
-                            }
-
-                            if (intersect) {  // If intersect occurred, mark this hoop as jumped through.
-                                detection.units[unit].hoops[hoop] = true;
-                            } else {
-                                // If not, exit the hoop loop (default value is false, so effectively setting it false)
-                                // and move on to the next unit.
-                                break;
-                            }
-                        } // End loop across all hoops.
-                    } // End loop across all units.
-                } else {  // If useHoops is false, then just populate detection.units[unit].hoops[hoop] with true.
-                    for (int unit = 0; unit < 4; ++unit) {
-                        for (int hoop = 0; hoop < 4; ++hoop) {
-                            detection.units[unit].hoops[hoop] = true;
-                        }
-                    }
-                }
-
-                uchar ID = 0;
-                // Determine correct ID
-
-
-                if (detection.maxSurpassed) {  // If max has been detected, ID is 128 for max surpassing.
-                    ID = 128;
-                } else if (true) {
-                //} else if (!useHoops) {  // If useHoops is false, ID is 1 to signify threshold crossing.
-                    ID = 1;
-                } else {  // If useHoops is true, ID is either (a) an active unit or (b) just a threshold crossing.
-                    // (a) If a unit is active, ID is either 1, 2, 4, or 8 for the unit.
-                    for (uint8_t unit = 0; unit < 4; ++unit) {
-                        if (detection.units[unit].hoops[0] && detection.units[unit].hoops[1] &&
-                                detection.units[unit].hoops[2] && detection.units[unit].hoops[3]) {
-//                            ID = (uint8_t) pow(2.0f, (float) unit);
-                            ID = 1u << unit;  // faster implementation of 2^unit
-                            break;
-                        }
-                    }
-
-                    // (b) If no unit is active, ID is 64 to signify threshold crossing.
-                    if (ID == 0) ID = 64;
-                }
+                // (b) If no unit is active, ID is 64 to signify threshold crossing.
+                if (ID == 0) ID = 64;
+            }
 
-                // Populate spike with timestamp
-                // Extract the timestamp of the first frame in this data block
-                uint32_t timestampLSW = rawBlock[4]; // Timestamp is always the bytes 8-11 of the datablock (16-bit words 4-5).
-                uint32_t timestampMSW = rawBlock[5];
-                uint32_t timestamp = (timestampMSW << 16) + timestampLSW;
+            // Populate spike with timestamp
+            // Extract the timestamp of the first frame in this data block
+            uint32_t timestampLSW = rawBlock[4]; // Timestamp is always the bytes 8-11 of the datablock (16-bit words 4-5).
+            uint32_t timestampMSW = rawBlock[5];
+            uint32_t timestamp = (timestampMSW << 16) + timestampLSW;
 
-                // Add threshS to this timestamp to index right (for positive threshS) or left (for negative threshS).
-                timestamp += threshS;
+            // Add threshS to this timestamp to index right (for positive threshS) or left (for negative threshS).
+            timestamp += threshS;
 
-                // Write spike detection at this timestamp.
-                spikeChunk[snippetIndex * channels + channelIndex] = timestamp;
+            // Write spike detection at this timestamp.
+            spikeChunk[snippetIndex * channels + channelIndex] = timestamp;
 
-                // Populate spikeID with correct ID.
-                spikeIDChunk[snippetIndex * channels + channelIndex] = ID;
+            // Populate spikeID with correct ID.
+            spikeIDChunk[snippetIndex * channels + channelIndex] = ID;
 
-                // Advance by SnippetSize samples since activity up until then will already be flagged as a spike.
-                threshS += SnippetSize;
+            // Advance by SnippetSize samples since activity up until then will already be flagged as a spike.
+            threshS += SnippetSize;
 
-                // Continue detection, preparing for another spike in this block to take the next snippetIndex;
-                ++snippetIndex;
+            // Continue detection, preparing for another spike in this block to take the next snippetIndex;
+            ++snippetIndex;
 
-                // If the end of this spike snippet is encroaching on the territory of the next data block
-                // (with SnippetSize of the next block's start), populate startSearchPos[channel] with
-                // the end position of this snippet. This allows the next block to start at a later sample,
-                // so there's no risk of double-counting a spike.
-                if (threshS > FramesPerBlock - SnippetSize) {
-                    startSearchPos[channelIndex] = threshS - (FramesPerBlock - SnippetSize);
-                }
+            // If the end of this spike snippet is encroaching on the territory of the next data block
+            // (with SnippetSize of the next block's start), populate startSearchPos[channel] with
+            // the end position of this snippet. This allows the next block to start at a later sample,
+            // so there's no risk of double-counting a spike.
+            if (threshS > FramesPerBlock - SnippetSize) {
+                startSearchPos[channelIndex] = threshS - (FramesPerBlock - SnippetSize);
             }
+            candidate = threshS + SnippetSize + 1;
         }
 
         for (s = 0; s < FramesPerBlock; ++s) {
@@ -525,12 +528,21 @@ void CPUInterface::processDataBlock(uint16_t * data, uint16_t *lowChunk, uint16_
             highChunk[outIndex] = (uint16_t) round((filteredHigh[s] / 0.195f) + 32768);
         }
 
-        // Update 'prevLast2' array with this block's samples.
+        // Keep the last SnippetSize high-pass samples, as written out, for the next block's spike detection.
+        for (s = 0; s < SnippetSize; ++s) {
+            outIndex = (FramesPerBlock - SnippetSize + s) * channels + channelIndex;
+            channelHistory[s] = (float) (0.195f * (((double)highChunk[outIndex]) - 32768));
+        }
+
+        // Update 'prevLast2' array with this block's samples. Filter stages beyond the current order were not run
+        // this block; their history restarts from zero if the order is raised later.
         for (int filterIndex = 0; filterIndex < 4; ++filterIndex) {
-            prevLast2[low2ndToLastIndex[filterIndex]] = lowFloat[filterIndex][FramesPerBlock - 2];
-            prevLast2[lowLastIndex[filterIndex]] = lowFloat[filterIndex][FramesPerBlock - 1];
-            prevLast2[high2ndToLastIndex[filterIndex]] = highFloat[filterIndex][FramesPerBlock - 2];
-            prevLast2[highLastIndex[filterIndex]] = highFloat[filterIndex][FramesPerBlock - 1];
+            bool lowUsed = filterIndex < numLowFilterIterations;
+            bool highUsed = filterIndex < numHighFilterIterations;
+            prevLast2[low2ndToLastIndex[filterIndex]] = lowUsed ? lowFloat[filterIndex][FramesPerBlock - 2] : 0.0f;
+            prevLast2[lowLastIndex[filterIndex]] = lowUsed ? lowFloat[filterIndex][FramesPerBlock - 1] : 0.0f;
+            prevLast2[high2ndToLastIndex[filterIndex]] = highUsed ? highFloat[filterIndex][FramesPerBlock - 2] : 0.0f;
+            prevLast2[highLastIndex[filterIndex]] = highUsed ? highFloat[filterIndex][FramesPerBlock - 1] : 0.0f;
         }
 
         prevLast2[in2ndToLastIndex] = inFloat[FramesPerBlock - 2];
@@ -538,10 +550,67 @@ void CPUInterface::processDataBlock(uint16_t * data, uint16_t *lowChunk, uint16_
         prevLast2[wide2ndToLastIndex] = wideFloat[FramesPerBlock - 2];
         prevLast2[wideLastIndex] = wideFloat[FramesPerBlock - 1];
     }
+}
+
+// Hoop classifier: bit u of the result is set if the snippet passes through every active hoop of unit u. A unit
+// with no active hoops never matches; an inactive hoop (tA == -1) always passes. For each hoop the snippet is
+// compared against the hoop line over its whole window at once, and a crossing is any pair of adjacent samples
+// that changes sides of the line.
+uint8_t CPUInterface::matchUnits(const float* snippet, const ChannelHoopsStruct &channelHoops, float samplePeriod) const
+{
+    uint8_t matched = 0;
+    for (int unit = 0; unit < 4; ++unit) {
+        const HoopInfoStruct* unitHoops = channelHoops.unitHoops[unit].hoopInfo;
+        if (unitHoops[0].tA == -1.0f && unitHoops[1].tA == -1.0f && unitHoops[2].tA == -1.0f && unitHoops[3].tA == -1.0f) {
+            continue;
+        }
+
+        bool allPassed = true;
+        for (int hoop = 0; hoop < 4 && allPassed; ++hoop) {
+            const HoopInfoStruct &thisHoop = unitHoops[hoop];
+            if (thisHoop.tA == -1.0f) continue;
 
-    // Set the last 50 samples of high to parsedPrevHigh so that they can be used in the next data block
-//    memcpy(parsedPrevHigh, &highChunk[(FramesPerBlock - SnippetSize) * channels], SnippetSize * sizeof(uint16_t));
-    parsedPrevHigh = &highChunk[(FramesPerBlock - SnippetSize) * channels];
+            // Round tA down and tB up to the nearest discrete sample.
+            int sA = std::max((int) floor(sampleRate * thisHoop.tA), 0);
+            int sB = std::min((int) ceil(sampleRate * thisHoop.tB), SnippetSize);
+
+            if (sA == sB) {
+                // Special case: vertical hoop
+                float y1Data = snippet[sA];
+                if (thisHoop.yB > thisHoop.yA) {
+                    allPassed = y1Data < thisHoop.yB && y1Data > thisHoop.yA;
+                } else {
+                    allPassed = y1Data > thisHoop.yB && y1Data < thisHoop.yA;
+                }
+                continue;
+            }
+
+            // General case: samples [sA, sB) against the hoop line, rounded up to whole groups of 4.
+            int length = sB - sA;
+            if (length < 2) {
+                allPassed = false;
+                continue;
+            }
+            float slope = (thisHoop.yB - thisHoop.yA) / (thisHoop.tB - thisHoop.tA);
+            float hoopLine[SnippetSize + 4];
+            int paddedLength = (length + 3) & ~3;
+            for (int i = 0; i < paddedLength; ++i) {
+                float t = ((float) (sA + i)) * samplePeriod;
+                hoopLine[i] = thisHoop.yA + slope * (t - thisHoop.tA);
+            }
+            uint64_t above, below;
+            compareMask(snippet + sA, hoopLine, paddedLength, CompareGreaterOrEqual, &above);
+            compareMask(snippet + sA, hoopLine, paddedLength, CompareLessOrEqual, &below);
+
+            // Sample pairs (s1, s1 + 1) with s1 in [sA, sB - 2]
+            uint64_t crossings = (above & (below >> 1)) | (below & (above >> 1));
+            allPassed = (crossings & ((1ULL << (length - 1)) - 1)) != 0;
+        }
+        if (allPassed) {
+            matched |= 1u << unit;
+        }
+    }
+    return matched;
 }
 
 void CPUInterface::freeMemory()
@@ -551,7 +620,8 @@ void CPUInterface::freeMemory()
     delete [] prevLast2;
     delete [] startSearchPos;
     delete [] hoops;
-    delete [] parsedPrevHighOriginal;
+    delete context;
+    context = nullptr;
 
     allocated = false;
 }
@@ -617,15 +687,54 @@ void CPUInterface::initializeMemory()
     }
 
     // Prep before loop.
-    parsedPrevHighOriginal = new uint16_t[SnippetSize * channels];
-    for (int s = 0; s < SnippetSize * channels; ++s) {
-        parsedPrevHighOriginal[s] = 32768;
-    }
-    parsedPrevHigh = parsedPrevHighOriginal;
+    context = new ProcessingContext(channels);
 
     inputIndex = 0;
     outputIndex = 0;
     spikeIndex = 0;
 
     allocated = true;
+
+    // Publish thresholds and hoops for the new channel count.
+    std::lock_guard<std::mutex> lockFilter(filterMutex);
+    updateProcessingParameters();
+}
+
+// Copy the current filter coefficients and detection settings into a new snapshot and make it current.
+// Called with filterMutex held.
+void CPUInterface::updateProcessingParameters()
+{
+    std::shared_ptr<ProcessingParameters> parameters = std::make_shared<ProcessingParameters>();
+    parameters->notchB2 = filterParameters.notchParams.b2;
+    parameters->notchB1 = filterParameters.notchParams.b1;
+    parameters->notchB0 = filterParameters.notchParams.b0;
+    parameters->notchA2 = filterParameters.notchParams.a2;
+    parameters->notchA1 = filterParameters.notchParams.a1;
+
+    for (int filterIndex = 0; filterIndex < 4; ++filterIndex) {
+        parameters->lowB2[filterIndex] = filterParameters.lowParams[filterIndex].b2;
+        parameters->lowB1[filterIndex] = filterParameters.lowParams[filterIndex].b1;
+        parameters->lowB0[filterIndex] = filterParameters.lowParams[filterIndex].b0;
+        parameters->lowA2[filterIndex] = filterParameters.lowParams[filterIndex].a2;
+        parameters->lowA1[filterIndex] = filterParameters.lowParams[filterIndex].a1;
+
+        parameters->highB2[filterIndex] = filterParameters.highParams[filterIndex].b2;
+        parameters->highB1[filterIndex] = filterParameters.highParams[filterIndex].b1;
+        parameters->highB0[filterIndex] = filterParameters.highParams[filterIndex].b0;
+        parameters->highA2[filterIndex] = filterParameters.highParams[filterIndex].a2;
+        parameters->highA1[filterIndex] = filterParameters.highParams[filterIndex].a1;
+    }
+
+    parameters->numLowFilterIterations = floor((float)(filterParameters.lowOrder - 1) / 2.0f) + 1;
+    parameters->numHighFilterIterations = floor((float)(filterParameters.highOrder - 1) / 2.0f) + 1;
+
+    parameters->spikeMax = globalParameters.spikeMax;
+    parameters->spikeMaxEnabled = globalParameters.spikeMaxEnabled == 1;
+
+    // hoops only exists once memory is allocated; initializeMemory() publishes again at that point.
+    if (allocated) {
+        parameters->channelHoops.assign(hoops, hoops + channels);
+    }
+
+    std::atomic_store(&currentParameters, std::shared_ptr<const ProcessingParameters>(std::move(parameters)));
 }
@@ -31,6 +31,8 @@
 #ifndef CPUINTERFACE_H
 #define CPUINTERFACE_H
 
+#include <memory>
+#include <vector>
 #include "abstractxpuinterface.h"
 
 typedef struct _UnitDetection
@@ -57,9 +59,37 @@ public:
     bool setupMemory() override;
     bool cleanupMemory() override;
 
+protected:
+    void updateProcessingParameters() override;
+
 private:
+    // Filter coefficients and detection settings as processDataBlock() reads them. updateFromState() publishes
+    // a new snapshot; processDataBlock() loads the current one once per block, so filtering never waits on
+    // filterMutex while the GUI thread recalculates the filters.
+    struct ProcessingParameters
+    {
+        float notchB2, notchB1, notchB0, notchA2, notchA1;
+        float lowB2[4], lowB1[4], lowB0[4], lowA2[4], lowA1[4];
+        float highB2[4], highB1[4], highB0[4], highA2[4], highA1[4];
+        int numLowFilterIterations;
+        int numHighFilterIterations;
+        float spikeMax;
+        bool spikeMaxEnabled;
+        std::vector<ChannelHoopsStruct> channelHoops;  // per channel (threshold, useHoops, hoop geometry);
+                                                       // empty until memory is allocated
+    };
+
+    // Per-channel state and scratch arrays for processDataBlock(), allocated once in initializeMemory()
+    struct ProcessingContext;
+
+    // Only accessed with std::atomic_load/atomic_store. A block holds its own reference to the snapshot it
+    // loaded, so a replaced snapshot is freed when the last block using it finishes.
+    std::shared_ptr<const ProcessingParameters> currentParameters;
+    ProcessingContext* context;
+
     void initializeMemory();
     void freeMemory();
+    uint8_t matchUnits(const float* snippet, const ChannelHoopsStruct &channelHoops, float samplePeriod) const;
 };
 
 #endif // CPUINTERFACE_H
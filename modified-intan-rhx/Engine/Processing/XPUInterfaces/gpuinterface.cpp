@@ -44,10 +44,19 @@ GPUInterface::~GPUInterface()
 }
 
 void GPUInterface::processDataBlock(uint16_t *data, uint16_t *lowChunk, uint16_t *wideChunk, uint16_t *highChunk, uint32_t *spikeChunk, uint8_t *spikeIDChunk)
+{
+    processDataBlocks(data, 1, lowChunk, wideChunk, highChunk, spikeChunk, spikeIDChunk);
+}
+
+// Settings, filter state and the previous high-pass tail are uploaded once per batch. Between blocks, the filter
+// state and search positions the kernel wrote stay on the device, the high-pass tail is copied on the device,
+// and outputs are read back without blocking; the in-order queue keeps every block's commands in sequence.
+void GPUInterface::processDataBlocks(uint16_t *data, int numBlocks, uint16_t *lowChunk, uint16_t *wideChunk,
+                                     uint16_t *highChunk, uint32_t *spikeChunk, uint8_t *spikeIDChunk)
 {
     std::lock_guard<std::mutex> lockFilter(filterMutex);
 
-    if (channels == 0)
+    if (channels == 0 || numBlocks < 1)
         return;
 
     // Load all inputs
@@ -60,9 +69,6 @@ void GPUInterface::processDataBlock(uint16_t *data, uint16_t *lowChunk, uint16_t
     ret = clEnqueueWriteBuffer(commandQueue, gpuHoopsHandle, CL_TRUE, 0, channels * sizeof(ChannelHoopsStruct), hoops, 0, nullptr, nullptr);
     if (ret != CL_SUCCESS) qDebug() << "Error A2";
 
-    ret = clEnqueueWriteBuffer(commandQueue, gpuDatablockBuffHandle, CL_TRUE, 0, wordsPerBlock * sizeof(uint16_t), data, 0, nullptr, nullptr);
-    if (ret != CL_SUCCESS) qDebug() << "Error A3";
-
     ret = clEnqueueWriteBuffer(commandQueue, gpuPrevLast2BuffHandle, CL_TRUE, 0, channels * 20 * sizeof(float), prevLast2, 0, nullptr, nullptr);
     if (ret != CL_SUCCESS) qDebug() << "Error A4";
 
@@ -72,35 +78,55 @@ void GPUInterface::processDataBlock(uint16_t *data, uint16_t *lowChunk, uint16_t
     ret = clEnqueueWriteBuffer(commandQueue, gpuStartSearchPosHandle, CL_TRUE, 0, channels * sizeof(uint16_t), startSearchPos, 0, nullptr, nullptr);
     if (ret != CL_SUCCESS) qDebug() << "Error A7";
 
-    // Execute kernel
-    size_t globalItemSize = channels;
-    ret = clEnqueueNDRangeKernel(commandQueue, kernel, 1, nullptr, &globalItemSize, nullptr, 0, nullptr, nullptr);
-    if (ret != CL_SUCCESS) qDebug() << "clEnqueueNDRangeKernel() failed. Ret: " << ret;
+    const size_t samplesPerBlock = FramesPerBlock * channels;
+    const size_t spikesPerBlock = SnippetsPerBlock * channels;
 
-    // Read all outputs
-    ret = clEnqueueReadBuffer(commandQueue, gpuPrevLast2BuffHandle, CL_TRUE, 0, channels * 20 * sizeof(float), prevLast2, 0, nullptr, nullptr);
-    if (ret != CL_SUCCESS) qDebug() << "Error C0";
+    for (int block = 0; block < numBlocks; ++block) {
+        if (block > 0) {
+            // The previous block's last SnippetSize high-pass samples are still in the high output buffer.
+            ret = clEnqueueCopyBuffer(commandQueue, gpuHighBuffHandle, gpuPrevHighHandle,
+                                      (FramesPerBlock - SnippetSize) * channels * sizeof(uint16_t), 0,
+                                      SnippetSize * channels * sizeof(uint16_t), 0, nullptr, nullptr);
+            if (ret != CL_SUCCESS) qDebug() << "Error A6";
+        }
 
-    ret = clEnqueueReadBuffer(commandQueue, gpuStartSearchPosHandle, CL_TRUE, 0, channels * sizeof(uint16_t), startSearchPos, 0, nullptr, nullptr);
-    if (ret != CL_SUCCESS) qDebug() << "Error C1";
+        ret = clEnqueueWriteBuffer(commandQueue, gpuDatablockBuffHandle, CL_FALSE, 0, wordsPerBlock * sizeof(uint16_t), data + block * wordsPerBlock, 0, nullptr, nullptr);
+        if (ret != CL_SUCCESS) qDebug() << "Error A3";
+
+        // Execute kernel
+        size_t globalItemSize = channels;
+        ret = clEnqueueNDRangeKernel(commandQueue, kernel, 1, nullptr, &globalItemSize, nullptr, 0, nullptr, nullptr);
+        if (ret != CL_SUCCESS) qDebug() << "clEnqueueNDRangeKernel() failed. Ret: " << ret;
 
-    ret = clEnqueueReadBuffer(commandQueue, gpuLowBuffHandle, CL_TRUE, 0, FramesPerBlock * channels * sizeof(uint16_t), lowChunk, 0, nullptr, nullptr);
-    if (ret != CL_SUCCESS) qDebug() << "Error C2";
+        // Read this block's outputs
+        ret = clEnqueueReadBuffer(commandQueue, gpuLowBuffHandle, CL_FALSE, 0, samplesPerBlock * sizeof(uint16_t), lowChunk + block * samplesPerBlock, 0, nullptr, nullptr);
+        if (ret != CL_SUCCESS) qDebug() << "Error C2";
 
-    ret = clEnqueueReadBuffer(commandQueue, gpuWideBuffHandle, CL_TRUE, 0, FramesPerBlock * channels * sizeof(uint16_t), wideChunk, 0, nullptr, nullptr);
-    if (ret != CL_SUCCESS) qDebug() << "Error C3";
+        ret = clEnqueueReadBuffer(commandQueue, gpuWideBuffHandle, CL_FALSE, 0, samplesPerBlock * sizeof(uint16_t), wideChunk + block * samplesPerBlock, 0, nullptr, nullptr);
+        if (ret != CL_SUCCESS) qDebug() << "Error C3";
 
-    ret = clEnqueueReadBuffer(commandQueue, gpuHighBuffHandle, CL_TRUE, 0, FramesPerBlock * channels * sizeof(uint16_t), highChunk, 0, nullptr, nullptr);
-    if (ret != CL_SUCCESS) qDebug() << "Error C4";
+        ret = clEnqueueReadBuffer(commandQueue, gpuHighBuffHandle, CL_FALSE, 0, samplesPerBlock * sizeof(uint16_t), highChunk + block * samplesPerBlock, 0, nullptr, nullptr);
+        if (ret != CL_SUCCESS) qDebug() << "Error C4";
 
-    ret = clEnqueueReadBuffer(commandQueue, gpuSpikeBuffHandle, CL_TRUE, 0, channels * SnippetsPerBlock * sizeof(uint32_t), spikeChunk, 0, nullptr, nullptr);
-    if (ret != CL_SUCCESS) qDebug() << "Error C5";
+        ret = clEnqueueReadBuffer(commandQueue, gpuSpikeBuffHandle, CL_FALSE, 0, spikesPerBlock * sizeof(uint32_t), spikeChunk + block * spikesPerBlock, 0, nullptr, nullptr);
+        if (ret != CL_SUCCESS) qDebug() << "Error C5";
 
-    ret = clEnqueueReadBuffer(commandQueue, gpuSpikeIDsHandle, CL_TRUE, 0, channels * SnippetsPerBlock * sizeof(uint8_t), spikeIDChunk, 0, nullptr, nullptr);
-    if (ret != CL_SUCCESS) qDebug() << "Error C6";
+        ret = clEnqueueReadBuffer(commandQueue, gpuSpikeIDsHandle, CL_FALSE, 0, spikesPerBlock * sizeof(uint8_t), spikeIDChunk + block * spikesPerBlock, 0, nullptr, nullptr);
+        if (ret != CL_SUCCESS) qDebug() << "Error C6";
+    }
+
+    // Read the filter state and search positions left by the last block
+    ret = clEnqueueReadBuffer(commandQueue, gpuPrevLast2BuffHandle, CL_TRUE, 0, channels * 20 * sizeof(float), prevLast2, 0, nullptr, nullptr);
+    if (ret != CL_SUCCESS) qDebug() << "Error C0";
+
+    ret = clEnqueueReadBuffer(commandQueue, gpuStartSearchPosHandle, CL_TRUE, 0, channels * sizeof(uint16_t), startSearchPos, 0, nullptr, nullptr);
+    if (ret != CL_SUCCESS) qDebug() << "Error C1";
+
+    ret = clFinish(commandQueue);
+    if (ret != CL_SUCCESS) qDebug() << "Error C7";
 
     // Set the last 50 samples of high to parsedPrevHigh so that they can be used in the next data block.
-    parsedPrevHigh = &highChunk[(FramesPerBlock - SnippetSize) * channels];
+    parsedPrevHigh = &highChunk[(numBlocks - 1) * samplesPerBlock + (FramesPerBlock - SnippetSize) * channels];
 }
 
 void GPUInterface::speedTest()
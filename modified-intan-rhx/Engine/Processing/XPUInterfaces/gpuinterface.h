@@ -45,6 +45,8 @@ public:
     // Called within class in runDiagnostic(), and externally in waveformprocessorthread
     void processDataBlock(uint16_t* data, uint16_t* lowChunk, uint16_t* wideChunk,
                           uint16_t* highChunk, uint32_t* spikeChunk, uint8_t* spikeIDChunk) override;
+    void processDataBlocks(uint16_t* data, int numBlocks, uint16_t* lowChunk, uint16_t* wideChunk,
+                           uint16_t* highChunk, uint32_t* spikeChunk, uint8_t* spikeIDChunk) override;
     bool setupMemory() override;
     bool cleanupMemory() override;
     void speedTest() override;
@@ -64,6 +64,12 @@ void XPUController::processDataBlock(uint16_t *data, uint16_t *lowChunk, uint16_
     activeInterface->processDataBlock(data, lowChunk, wideChunk, highChunk, spikeChunk, spikeIDChunk);
 }
 
+void XPUController::processDataBlocks(uint16_t *data, int numBlocks, uint16_t *lowChunk, uint16_t *wideChunk,
+                                      uint16_t *highChunk, uint32_t *spikeChunk, uint8_t *spikeIDChunk)
+{
+    activeInterface->processDataBlocks(data, numBlocks, lowChunk, wideChunk, highChunk, spikeChunk, spikeIDChunk);
+}
+
 void XPUController::updateNumStreams(int numStreams)
 {
     cpuInterface->updateNumStreams(numStreams);
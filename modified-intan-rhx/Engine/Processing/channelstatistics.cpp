@@ -0,0 +1,286 @@
+//------------------------------------------------------------------------------
+//
+//  Intan Technologies RHX Data Acquisition Software
+//  Version 3.4.0
+//
+//  Copyright (c) 2020-2025 Intan Technologies
+//
+//  This file is part of the Intan Technologies RHX Data Acquisition Software.
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published
+//  by the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//  This software is provided 'as-is', without any express or implied warranty.
+//  In no event will the authors be held liable for any damages arising from
+//  the use of this software.
+//
+//  See <http://www.intantech.com> for documentation and product information.
+//
+//------------------------------------------------------------------------------
+
+
+#include <cmath>
+#include <algorithm>
+#include <limits>
+#include "channelstatistics.h"
+
+ChannelStatistics::ChannelStatistics() :
+    numChannels(0),
+    samplesPerBlock(0),
+    historyBlocks(0),
+    blocksWritten(0),
+    sequence(0),
+    resetRequested(false)
+{
+}
+
+void ChannelStatistics::allocate(int numChannels_, int samplesPerBlock_, int historyBlocks_)
+{
+    numChannels = numChannels_;
+    samplesPerBlock = samplesPerBlock_;
+    historyBlocks = std::max(2, historyBlocks_);
+
+    size_t ringSize = (size_t) historyBlocks * numChannels;
+    totalSumOfSquares.reset(new std::atomic<double>[ringSize]);
+    totalSpikes.reset(new std::atomic<uint32_t>[ringSize]);
+    windowMin.reset(new std::atomic<float>[numChannels]);
+    windowMax.reset(new std::atomic<float>[numChannels]);
+
+    runningSumOfSquares.resize(numChannels);
+    runningSpikes.resize(numChannels);
+    pendingSpikes.resize(numChannels);
+    blockSumOfSquares.resize(numChannels);
+    blockMin.resize(numChannels);
+    blockMax.resize(numChannels);
+    minQueueBlock.resize(ringSize);
+    minQueueValue.resize(ringSize);
+    minQueueFront.resize(numChannels);
+    minQueueSize.resize(numChannels);
+    maxQueueBlock.resize(ringSize);
+    maxQueueValue.resize(ringSize);
+    maxQueueFront.resize(numChannels);
+    maxQueueSize.resize(numChannels);
+
+    reset();
+}
+
+void ChannelStatistics::release()
+{
+    numChannels = 0;
+    historyBlocks = 0;
+    totalSumOfSquares.reset();
+    totalSpikes.reset();
+    windowMin.reset();
+    windowMax.reset();
+    std::vector<double>().swap(runningSumOfSquares);
+    std::vector<uint32_t>().swap(runningSpikes);
+    std::vector<uint32_t>().swap(pendingSpikes);
+    std::vector<float>().swap(blockSumOfSquares);
+    std::vector<float>().swap(blockMin);
+    std::vector<float>().swap(blockMax);
+    std::vector<uint64_t>().swap(minQueueBlock);
+    std::vector<float>().swap(minQueueValue);
+    std::vector<uint64_t>().swap(maxQueueBlock);
+    std::vector<float>().swap(maxQueueValue);
+    blocksWritten = 0;
+}
+
+void ChannelStatistics::reset()
+{
+    uint64_t seq = sequence.load(std::memory_order_relaxed);
+    sequence.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    blocksWritten.store(0, std::memory_order_relaxed);
+    for (int channel = 0; channel < numChannels; ++channel) {
+        windowMin[channel].store(0.0F, std::memory_order_relaxed);
+        windowMax[channel].store(0.0F, std::memory_order_relaxed);
+        runningSumOfSquares[channel] = 0.0;
+        runningSpikes[channel] = 0;
+        pendingSpikes[channel] = 0;
+        minQueueFront[channel] = 0;
+        minQueueSize[channel] = 0;
+        maxQueueFront[channel] = 0;
+        maxQueueSize[channel] = 0;
+    }
+
+    sequence.store(seq + 2, std::memory_order_release);
+}
+
+void ChannelStatistics::applyRequestedReset()
+{
+    if (resetRequested.load(std::memory_order_relaxed) && resetRequested.exchange(false, std::memory_order_acquire)) {
+        reset();
+    }
+}
+
+void ChannelStatistics::addSpike(int channel)
+{
+    applyRequestedReset();
+    if (channel >= 0 && channel < numChannels) {
+        ++pendingSpikes[channel];
+    }
+}
+
+void ChannelStatistics::addDataBlock(const uint16_t* data)
+{
+    if (numChannels == 0) return;
+    applyRequestedReset();
+
+    // Per-block partials first; the channel loop is contiguous in memory and vectorizes.
+    std::fill(blockSumOfSquares.begin(), blockSumOfSquares.end(), 0.0F);
+    std::fill(blockMin.begin(), blockMin.end(), std::numeric_limits<float>::max());
+    std::fill(blockMax.begin(), blockMax.end(), std::numeric_limits<float>::lowest());
+    for (int t = 0; t < samplesPerBlock; ++t) {
+        const uint16_t* frame = data + (size_t) t * numChannels;
+        for (int channel = 0; channel < numChannels; ++channel) {
+            float sample = 0.195F * (((float) frame[channel]) - 32768.0F);
+            blockSumOfSquares[channel] += sample * sample;
+            blockMin[channel] = std::min(blockMin[channel], sample);
+            blockMax[channel] = std::max(blockMax[channel], sample);
+        }
+    }
+
+    uint64_t block = blocksWritten.load(std::memory_order_relaxed);
+    size_t slot = (size_t) (block % historyBlocks) * numChannels;
+
+    uint64_t seq = sequence.load(std::memory_order_relaxed);
+    sequence.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    for (int channel = 0; channel < numChannels; ++channel) {
+        runningSumOfSquares[channel] += blockSumOfSquares[channel];
+        runningSpikes[channel] += pendingSpikes[channel];
+        pendingSpikes[channel] = 0;
+        totalSumOfSquares[slot + channel].store(runningSumOfSquares[channel], std::memory_order_relaxed);
+        totalSpikes[slot + channel].store(runningSpikes[channel], std::memory_order_relaxed);
+
+        pushExtreme(channel, block, blockMin[channel], false);
+        pushExtreme(channel, block, blockMax[channel], true);
+        windowMin[channel].store(minQueueValue[(size_t) channel * historyBlocks + minQueueFront[channel]], std::memory_order_relaxed);
+        windowMax[channel].store(maxQueueValue[(size_t) channel * historyBlocks + maxQueueFront[channel]], std::memory_order_relaxed);
+    }
+    blocksWritten.store(block + 1, std::memory_order_relaxed);
+
+    sequence.store(seq + 2, std::memory_order_release);
+}
+
+// Append one block's extreme to a channel's monotonic queue and drop entries that left the history window.
+void ChannelStatistics::pushExtreme(int channel, uint64_t block, float value, bool isMax)
+{
+    std::vector<uint64_t>& queueBlock = isMax ? maxQueueBlock : minQueueBlock;
+    std::vector<float>& queueValue = isMax ? maxQueueValue : minQueueValue;
+    int& front = isMax ? maxQueueFront[channel] : minQueueFront[channel];
+    int& size = isMax ? maxQueueSize[channel] : minQueueSize[channel];
+    size_t base = (size_t) channel * historyBlocks;
+
+    // Values that can never again be the extreme (older and no more extreme than this one) leave from the back.
+    while (size > 0) {
+        int back = (front + size - 1) % historyBlocks;
+        float backValue = queueValue[base + back];
+        if (isMax ? (backValue > value) : (backValue < value)) break;
+        --size;
+    }
+    // Entries older than the history window leave from the front.
+    while (size > 0 && queueBlock[base + front] + historyBlocks <= block) {
+        front = (front + 1) % historyBlocks;
+        --size;
+    }
+    int back = (front + size) % historyBlocks;
+    queueBlock[base + back] = block;
+    queueValue[base + back] = value;
+    ++size;
+}
+
+int ChannelStatistics::windowBlocks(int numSamples, uint64_t written) const
+{
+    int blocks = (numSamples + samplesPerBlock - 1) / samplesPerBlock;
+    blocks = std::min(blocks, historyBlocks - 1);   // the oldest ring entry is the baseline for the full window
+    if ((uint64_t) blocks > written) blocks = (int) written;
+    return blocks;
+}
+
+void ChannelStatistics::getStatistics(std::vector<ChannelStats>& stats, int numSamples) const
+{
+    stats.resize(numChannels);
+    if (numChannels == 0) return;
+
+    uint64_t seq;
+    do {
+        seq = sequence.load(std::memory_order_acquire);
+        if (seq & 1) continue;
+
+        uint64_t written = blocksWritten.load(std::memory_order_relaxed);
+        int blocks = windowBlocks(numSamples, written);
+        size_t newest = (size_t) ((written + historyBlocks - 1) % historyBlocks) * numChannels;
+        size_t oldest = (size_t) ((written + historyBlocks - 1 - blocks) % historyBlocks) * numChannels;
+        bool fromStart = (uint64_t) blocks == written;   // window reaches back to the first block
+        int samples = blocks * samplesPerBlock;
+
+        for (int channel = 0; channel < numChannels; ++channel) {
+            ChannelStats& s = stats[channel];
+            if (blocks == 0) {
+                s = ChannelStats{ 0.0F, 0.0F, 0.0F, 0, 0 };
+                continue;
+            }
+            double sumOfSquares = totalSumOfSquares[newest + channel].load(std::memory_order_relaxed);
+            uint32_t spikes = totalSpikes[newest + channel].load(std::memory_order_relaxed);
+            if (!fromStart) {
+                sumOfSquares -= totalSumOfSquares[oldest + channel].load(std::memory_order_relaxed);
+                spikes -= totalSpikes[oldest + channel].load(std::memory_order_relaxed);
+            }
+            s.rms = (float) std::sqrt(std::max(0.0, sumOfSquares) / samples);
+            s.minimum = windowMin[channel].load(std::memory_order_relaxed);
+            s.maximum = windowMax[channel].load(std::memory_order_relaxed);
+            s.spikeCount = (int) spikes;
+            s.numSamples = samples;
+        }
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+    } while ((seq & 1) || sequence.load(std::memory_order_relaxed) != seq);
+}
+
+ChannelStats ChannelStatistics::getStatistics(int channel, int numSamples) const
+{
+    ChannelStats s{ 0.0F, 0.0F, 0.0F, 0, 0 };
+    if (channel < 0 || channel >= numChannels) return s;
+
+    uint64_t seq;
+    do {
+        seq = sequence.load(std::memory_order_acquire);
+        if (seq & 1) continue;
+
+        uint64_t written = blocksWritten.load(std::memory_order_relaxed);
+        int blocks = windowBlocks(numSamples, written);
+        if (blocks == 0) {
+            s = ChannelStats{ 0.0F, 0.0F, 0.0F, 0, 0 };
+        } else {
+            size_t newest = (size_t) ((written + historyBlocks - 1) % historyBlocks) * numChannels + channel;
+            size_t oldest = (size_t) ((written + historyBlocks - 1 - blocks) % historyBlocks) * numChannels + channel;
+            double sumOfSquares = totalSumOfSquares[newest].load(std::memory_order_relaxed);
+            uint32_t spikes = totalSpikes[newest].load(std::memory_order_relaxed);
+            if ((uint64_t) blocks < written) {
+                sumOfSquares -= totalSumOfSquares[oldest].load(std::memory_order_relaxed);
+                spikes -= totalSpikes[oldest].load(std::memory_order_relaxed);
+            }
+            s.numSamples = blocks * samplesPerBlock;
+            s.rms = (float) std::sqrt(std::max(0.0, sumOfSquares) / s.numSamples);
+            s.minimum = windowMin[channel].load(std::memory_order_relaxed);
+            s.maximum = windowMax[channel].load(std::memory_order_relaxed);
+            s.spikeCount = (int) spikes;
+        }
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+    } while ((seq & 1) || sequence.load(std::memory_order_relaxed) != seq);
+    return s;
+}
@@ -0,0 +1,119 @@
+//------------------------------------------------------------------------------
+//
+//  Intan Technologies RHX Data Acquisition Software
+//  Version 3.4.0
+//
+//  Copyright (c) 2020-2025 Intan Technologies
+//
+//  This file is part of the Intan Technologies RHX Data Acquisition Software.
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published
+//  by the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//  This software is provided 'as-is', without any express or implied warranty.
+//  In no event will the authors be held liable for any damages arising from
+//  the use of this software.
+//
+//  See <http://www.intantech.com> for documentation and product information.
+//
+//------------------------------------------------------------------------------
+
+
+#ifndef CHANNELSTATISTICS_H
+#define CHANNELSTATISTICS_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Statistics of one amplifier channel over a recent window of data.
+struct ChannelStats
+{
+    float rms;          // microvolts
+    float minimum;      // microvolts, over the whole history window
+    float maximum;
+    int spikeCount;     // spikes other than likely artifacts
+    int numSamples;     // samples covered by rms and spikeCount
+};
+
+// Sliding-window statistics of every amplifier channel, kept up to date by the waveform processing thread
+// one data block at a time, so readers never rescan sample data.
+//
+// For each block the writer stores per-channel running totals (sum of squares, spike count) into a ring of
+// historyBlocks entries; the totals over the last k blocks are then the difference of two ring entries, for
+// any k up to the history length.  Minimum and maximum over the whole history are kept with monotonic
+// queues of per-block extrema.
+//
+// There is one writer.  Readers on any thread take a consistent snapshot without locking: the writer bumps
+// a sequence number around each update and a reader retries if the number changed while it was copying.
+
+class ChannelStatistics
+{
+public:
+    ChannelStatistics();
+
+    void allocate(int numChannels_, int samplesPerBlock_, int historyBlocks_);
+    void release();
+    void reset();   // Writer side, or while the writer is stopped.
+
+    // Any thread.  The writer resets before its next addSpike() or addDataBlock().
+    void requestReset() { resetRequested.store(true, std::memory_order_release); }
+
+    // Writer side.  Spikes are counted in the next block added.
+    void addSpike(int channel);
+    void addDataBlock(const uint16_t* data);   // samplesPerBlock x numChannels raw amplifier codes, [sample][channel]
+
+    // Reader side, any thread.  numSamples is rounded up to whole blocks and limited to the data available.
+    void getStatistics(std::vector<ChannelStats>& stats, int numSamples) const;
+    ChannelStats getStatistics(int channel, int numSamples) const;
+    int getNumChannels() const { return numChannels; }
+    int maxWindowSamples() const { return (historyBlocks - 1) * samplesPerBlock; }
+
+private:
+    int numChannels;
+    int samplesPerBlock;
+    int historyBlocks;
+
+    // Shared with readers.  Entry (b % historyBlocks) holds the totals up to and including block b.
+    std::unique_ptr<std::atomic<double>[]> totalSumOfSquares;
+    std::unique_ptr<std::atomic<uint32_t>[]> totalSpikes;
+    std::unique_ptr<std::atomic<float>[]> windowMin;
+    std::unique_ptr<std::atomic<float>[]> windowMax;
+    std::atomic<uint64_t> blocksWritten;
+    std::atomic<uint64_t> sequence;
+    std::atomic<bool> resetRequested;
+
+    // Writer only.
+    std::vector<double> runningSumOfSquares;
+    std::vector<uint32_t> runningSpikes;
+    std::vector<uint32_t> pendingSpikes;
+    std::vector<float> blockSumOfSquares;
+    std::vector<float> blockMin;
+    std::vector<float> blockMax;
+    // Per channel, a circular queue of (block, value) with values monotonic from front to back.
+    std::vector<uint64_t> minQueueBlock;
+    std::vector<float> minQueueValue;
+    std::vector<int> minQueueFront;
+    std::vector<int> minQueueSize;
+    std::vector<uint64_t> maxQueueBlock;
+    std::vector<float> maxQueueValue;
+    std::vector<int> maxQueueFront;
+    std::vector<int> maxQueueSize;
+
+    void applyRequestedReset();
+    void pushExtreme(int channel, uint64_t block, float value, bool isMax);
+    int windowBlocks(int numSamples, uint64_t written) const;
+};
+
+#endif // CHANNELSTATISTICS_H
@@ -89,6 +89,7 @@ ControllerInterface::ControllerInterface(SystemState* state_, AbstractRHXControl
     usbDataThread->setNumUsbBlocksToRead(state->playback->getValue() ? 1 : RHXDataBlock::blocksFor30Hz(state->getSampleRateEnum()));
     connect(usbDataThread, SIGNAL(finished()), usbDataThread, SLOT(deleteLater()));
     connect(usbDataThread, SIGNAL(hardwareFifoReport(double)), this, SLOT(updateHardwareFifo(double)));
+    connect(usbDataThread, SIGNAL(usbGlitchReport(int)), this, SLOT(updateUsbGlitches(int)));
 
     initializeController();
 
@@ -107,7 +108,8 @@ ControllerInterface::ControllerInterface(SystemState* state_, AbstractRHXControl
     double samplesPerDataBlock = (double) RHXDataBlock::samplesPerDataBlock(state->getControllerTypeEnum());
     int waveformFifoMemoryDataBlocks = ceil(waveformMemoryInSeconds * sampleRate / samplesPerDataBlock);
     int waveformFifoBufferDataBlocks = ceil((waveformMemoryInSeconds + waveformExtraBufferInSeconds) * sampleRate / samplesPerDataBlock);
-    waveformFifo = new WaveformFifo(state->signalSources, waveformFifoBufferDataBlocks, waveformFifoMemoryDataBlocks, 1, state);
+    waveformFifo = new WaveformFifo(state->signalSources, waveformFifoBufferDataBlocks, waveformFifoMemoryDataBlocks,
+                                    WaveformProcessorThread::MaxBatchDataBlocks, state);
     if (!waveformFifo->memoryWasAllocated(memoryRequired)) {
         outOfMemoryError(memoryRequired);
     }
@@ -1059,8 +1061,16 @@ void ControllerInterface::runControllerSilently(double nSeconds, QProgressDialog
 float ControllerInterface::measureRmsLevel(std::string waveName, double timeSec) const
 {
     int numSamples = round(state->sampleRate->getNumericValue() * timeSec);
-    float* waveform = new float [numSamples];
     GpuWaveformAddress gpuWaveformAddress = waveformFifo->getGpuWaveformAddress(waveName);
+    if (gpuWaveformAddress.waveformIndex < 0) return 0.0F;
+
+    // Highpass statistics are kept running by the waveform processor; other bands still need a pass over the data.
+    if (gpuWaveformAddress.waveformType == GpuWaveformHighpass &&
+            numSamples <= waveformFifo->highpassStatistics()->maxWindowSamples()) {
+        return waveformFifo->highpassStatistics()->getStatistics(gpuWaveformAddress.waveformIndex, numSamples).rms;
+    }
+
+    float* waveform = new float [numSamples];
     waveformFifo->copyGpuAmplifierData(WaveformFifo::ReaderDisplay, waveform, gpuWaveformAddress, -numSamples, numSamples);
 
     // Calculate RMS value of waveform.
@@ -1097,10 +1107,19 @@ void ControllerInterface::setAllSpikeDetectionThresholds()
         runControllerSilently(numSecondsToMeasure + 1.0, progress);  // Add one second at beginning so we ignore starting transients.
         delete progress;
 
+        // One snapshot of every channel's highpass RMS level over the measurement window.
+        int numSamplesToMeasure = round(state->sampleRate->getNumericValue() * numSecondsToMeasure);
+        const ChannelStatistics* statistics = waveformFifo->highpassStatistics();
+        bool useStatistics = numSamplesToMeasure <= statistics->maxWindowSamples();
+        std::vector<ChannelStats> channelStats;
+        if (useStatistics) statistics->getStatistics(channelStats, numSamplesToMeasure);
+
         std::vector<std::string> waveNameList = state->signalSources->amplifierChannelsNameList();
         for (int i = 0; i < (int) waveNameList.size(); ++i) {
             std::string waveName = waveNameList[i] + "|HIGH";  // Measure RMS levels of highpass filtered signal for spike threshold calculation.
-            float rmsLevel = measureRmsLevel(waveName, numSecondsToMeasure);
+            int waveformIndex = waveformFifo->getGpuWaveformAddress(waveName).waveformIndex;
+            float rmsLevel = (useStatistics && waveformIndex >= 0 && waveformIndex < (int) channelStats.size()) ?
+                        channelStats[waveformIndex].rms : measureRmsLevel(waveName, numSecondsToMeasure);
             Channel* channel = state->signalSources->channelByName(waveNameList[i]);
             if (channel) {
                 if (channel->isEnabled()) {
@@ -150,6 +150,7 @@ signals:
     void setTopStatusLabel(QString text);
     void haveStopped();
     void setHardwareFifoStatus(double percentFull);
+    void setUsbGlitchCount(int numGlitchesRecovered);
     void cpuLoadPercent(double percent);
     void TCPErrorMessage(QString errorMessage);
 
@@ -162,6 +163,7 @@ public slots:
 
 private slots:
     void updateHardwareFifo(double percentFull) { emit setHardwareFifoStatus(percentFull); }
+    void updateUsbGlitches(int numGlitchesRecovered) { emit setUsbGlitchCount(numGlitchesRecovered); }
     void updateWaveformProcessorCpuLoad(double percentLoad) { waveformProcessorCpuLoad = percentLoad; }
 
 private:
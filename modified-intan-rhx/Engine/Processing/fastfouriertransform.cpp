@@ -57,6 +57,7 @@ void FastFourierTransform::setLength(int length_)
     createWindow();
     createPsdVector();
     createFrequencyVector();
+    createPlan();
 }
 
 void FastFourierTransform::createWindow()
@@ -115,6 +116,50 @@ void FastFourierTransform::createFrequencyVector()
     }
 }
 
+// Precalculate the tables used by realFft() for the current length, which must be a power of two.
+void FastFourierTransform::createPlan()
+{
+    unsigned int n = length >> 1;   // realFft() uses a complex FFT of half the length
+    unsigned int log2n = 0;
+    while ((1u << log2n) < n) ++log2n;
+
+    bitReverseSwaps.clear();
+    for (unsigned int i = 0; i < n; ++i) {
+        unsigned int j = 0;
+        for (unsigned int bit = 0; bit < log2n; ++bit) {
+            if (i & (1u << bit)) j |= 1u << (log2n - 1 - bit);
+        }
+        if (j > i) {
+            bitReverseSwaps.push_back(i);
+            bitReverseSwaps.push_back(j);
+        }
+    }
+
+    // A radix-4 pass with butterfly span h combines the radix-2 stages of span h and 2h.  When log2(n) is odd, a
+    // single radix-2 stage (with trivial twiddle factors) is done first.
+    stageTwiddles.clear();
+    radix2FirstStage = (log2n % 2) != 0;
+    unsigned int h = radix2FirstStage ? 2 : 1;
+    while (h < n) {
+        for (unsigned int k = 0; k < h; ++k) {
+            double theta1 = -TwoPi * (double)k / (double)(2 * h);   // we use negative angles to match MATLAB fft()
+            double theta2 = -TwoPi * (double)k / (double)(4 * h);
+            stageTwiddles.push_back((float) cos(theta1));
+            stageTwiddles.push_back((float) sin(theta1));
+            stageTwiddles.push_back((float) cos(theta2));
+            stageTwiddles.push_back((float) sin(theta2));
+        }
+        h <<= 2;
+    }
+
+    realTwiddles.clear();
+    for (unsigned int k = 0; k < (length >> 2); ++k) {
+        double theta = -Pi * (double)k / (double)n;
+        realTwiddles.push_back((float) cos(theta));
+        realTwiddles.push_back((float) sin(theta));
+    }
+}
+
 // Perform an FFT of an array of n complex numbers, where n must be a power of two.
 // The complex numbers are stored in data, an array of length 2n, where
 // data[0] = input_real[t]
@@ -226,6 +271,122 @@ void FastFourierTransform::realInputFft(float *data, unsigned int n)
     data[1] = h1Real - data[1];
 }
 
+// Planned version of complexInputFft() for n = length/2 complex numbers (same data format).
+void FastFourierTransform::complexFft(float *data) const
+{
+    unsigned int n = length >> 1;
+
+    // Reverse-binary reindexing
+    for (unsigned int p = 0; p < bitReverseSwaps.size(); p += 2) {
+        unsigned int i = bitReverseSwaps[p] << 1;
+        unsigned int j = bitReverseSwaps[p + 1] << 1;
+        std::swap(data[i], data[j]);
+        std::swap(data[i + 1], data[j + 1]);
+    }
+
+    unsigned int h = 1;
+    if (radix2FirstStage) {
+        // Radix-2 stage with span 1; all twiddle factors are 1.
+        for (unsigned int i = 0; i < (n << 1); i += 4) {
+            float aReal = data[i];
+            float aImag = data[i + 1];
+            data[i] = aReal + data[i + 2];
+            data[i + 1] = aImag + data[i + 3];
+            data[i + 2] = aReal - data[i + 2];
+            data[i + 3] = aImag - data[i + 3];
+        }
+        h = 2;
+    }
+
+    // Radix-4 passes
+    const float* twiddle = stageTwiddles.data();
+    while (h < n) {
+        unsigned int span = h << 2;
+        for (unsigned int block = 0; block < n; block += span) {
+            float* a = data + 2 * block;
+            float* b = a + 2 * h;
+            float* c = b + 2 * h;
+            float* d = c + 2 * h;
+            for (unsigned int k = 0; k < h; ++k) {
+                const float w1Real = twiddle[4 * k];
+                const float w1Imag = twiddle[4 * k + 1];
+                const float w2Real = twiddle[4 * k + 2];
+                const float w2Imag = twiddle[4 * k + 3];
+                const unsigned int re = 2 * k;
+                const unsigned int im = re + 1;
+
+                // First stage (span h): butterflies (a, b) and (c, d), both with twiddle factor w1.
+                float tReal = w1Real * b[re] - w1Imag * b[im];
+                float tImag = w1Real * b[im] + w1Imag * b[re];
+                float a1Real = a[re] + tReal;
+                float a1Imag = a[im] + tImag;
+                float b1Real = a[re] - tReal;
+                float b1Imag = a[im] - tImag;
+                tReal = w1Real * d[re] - w1Imag * d[im];
+                tImag = w1Real * d[im] + w1Imag * d[re];
+                float c1Real = c[re] + tReal;
+                float c1Imag = c[im] + tImag;
+                float d1Real = c[re] - tReal;
+                float d1Imag = c[im] - tImag;
+
+                // Second stage (span 2h): butterflies (a, c) with twiddle factor w2, and (b, d) with w2 * -i.
+                tReal = w2Real * c1Real - w2Imag * c1Imag;
+                tImag = w2Real * c1Imag + w2Imag * c1Real;
+                a[re] = a1Real + tReal;
+                a[im] = a1Imag + tImag;
+                c[re] = a1Real - tReal;
+                c[im] = a1Imag - tImag;
+                tReal = w2Real * d1Imag + w2Imag * d1Real;
+                tImag = -(w2Real * d1Real - w2Imag * d1Imag);
+                b[re] = b1Real + tReal;
+                b[im] = b1Imag + tImag;
+                d[re] = b1Real - tReal;
+                d[im] = b1Imag - tImag;
+            }
+        }
+        twiddle += 4 * h;
+        h = span;
+    }
+}
+
+void FastFourierTransform::realFft(float *data) const
+{
+    complexFft(data);
+
+    // Separate the spectrum of the real input from the half-length complex FFT, as in realInputFft().
+    unsigned int nPlus1 = length + 1;
+    unsigned int i1, i2, i3, i4;
+    float h1Real, h1Imag, h2Real, h2Imag, wReal, wImag;
+    for (unsigned int i = 2; i <= (length >> 2); ++i) {
+        wReal = realTwiddles[2 * (i - 1)];
+        wImag = realTwiddles[2 * (i - 1) + 1];
+        i1 = (i << 1) - 2;
+        i2 = i1 + 1;
+        i3 = nPlus1 - i2;
+        i4 = i3 + 1;
+        h1Real = 0.5F * (data[i1] + data[i3]);
+        h1Imag = 0.5F * (data[i2] - data[i4]);
+        h2Real = 0.5F * (data[i2] + data[i4]);
+        h2Imag = 0.5F * (data[i3] - data[i1]);
+        data[i1] = h1Real + wReal * h2Real - wImag * h2Imag;
+        data[i2] = h1Imag + wReal * h2Imag + wImag * h2Real;
+        data[i3] = h1Real - wReal * h2Real + wImag * h2Imag;
+        data[i4] = -h1Imag + wReal * h2Imag + wImag * h2Real;
+    }
+    data[(length >> 1) + 1] *= -1.0F;    // we flip this imaginary value sign to match MATLAB fft()
+
+    h1Real = data[0];
+    data[0] += data[1];
+    data[1] = h1Real - data[1];
+}
+
+void FastFourierTransform::realFftBatch(float *data, unsigned int numTransforms) const
+{
+    for (unsigned int t = 0; t < numTransforms; ++t) {
+        realFft(data + t * length);
+    }
+}
+
 // Calculate the logarithm of the square root of the PSD of data and normalizes values to facilitate calculation
 // of signal amplitude from PSD.  The values in data are overwritten with intermediate results.
 // Returns a pointer to the results, an array (length/2 + 1) long.
@@ -237,8 +398,28 @@ float* FastFourierTransform::logSqrtPowerSpectralDensity(float *data)
     }
 
     // Calculate FFT.
-    realInputFft(data, length);
+    realFft(data);
+
+    calculateLogPsd(data, logPsd);
+    return logPsd;
+}
+
+// Calculate logSqrtPowerSpectralDensity() for numTransforms consecutive arrays of length samples in data, writing
+// numTransforms consecutive results (each length/2 + 1 long) to dest.  The values in data are overwritten.
+void FastFourierTransform::logSqrtPowerSpectralDensityBatch(float *data, unsigned int numTransforms, float *dest) const
+{
+    for (unsigned int t = 0; t < numTransforms; ++t) {
+        float *transformData = data + t * length;
+        for (unsigned int i = 0; i < length; ++i) {
+            transformData[i] *= window[i];
+        }
+        realFft(transformData);
+        calculateLogPsd(transformData, dest + t * ((length >> 1) + 1));
+    }
+}
 
+void FastFourierTransform::calculateLogPsd(const float *data, float *dest) const
+{
     float normalizationFactor = log10f(2.0F / (float) length); // add this to facilitate estimate of narrowband signal amplitude
                                                                // from PSD.
     const float windowCorrectionFactor = 0.267789F; // empirical correction factor; only valid for Hamming window!
@@ -246,19 +427,22 @@ float* FastFourierTransform::logSqrtPowerSpectralDensity(float *data)
 
     float epsilon = std::numeric_limits<float>::min();   // add tiny number to PSD results before
                                                     // calculating log to avoid log(0) = -inf.
-    logPsd[0] = 0.5F * log10f(0.25F * data[0] * data[0] + epsilon) + normalizationFactor;    // no imaginary component here
-    unsigned int i = 1;
-    unsigned int j = 2;
-    for ( ; i < (length >> 1); ++i) {
-        // PSD = |FFT|^2 = real^2 + imaginary^2
-        // Then take the square root (moved outside the logarithm as a factor of 1/2) to go from uV^2/Hz to uV/sqrt(Hz).
-        // Then take logarithm to compress wide dynamic range for viewing.  And add normalization factor to normalize to
-        // the number of samples in the FFT and to compensate for weighting of FFT window function.
-        logPsd[i] = 0.5F * log10f(data[j] * data[j] + data[j+1] * data[j+1] + epsilon) + normalizationFactor;
-        j += 2;
+    unsigned int nHalf = length >> 1;
+
+    // First pass: PSD = |FFT|^2 = real^2 + imaginary^2.  Kept separate from the logarithm below so that this
+    // loop (with no function calls) can be vectorized by the compiler.
+    dest[0] = 0.25F * data[0] * data[0];    // no imaginary component here
+    for (unsigned int i = 1; i < nHalf; ++i) {
+        dest[i] = data[2 * i] * data[2 * i] + data[2 * i + 1] * data[2 * i + 1];
+    }
+    dest[nHalf] = 0.25F * data[1] * data[1];    // no imaginary component here
+
+    // Second pass: take the square root (moved outside the logarithm as a factor of 1/2) to go from uV^2/Hz to
+    // uV/sqrt(Hz).  Then take logarithm to compress wide dynamic range for viewing.  And add normalization factor to
+    // normalize to the number of samples in the FFT and to compensate for weighting of FFT window function.
+    for (unsigned int i = 0; i <= nHalf; ++i) {
+        dest[i] = 0.5F * log10f(dest[i] + epsilon) + normalizationFactor;
     }
-    logPsd[i] = 0.5F * log10f(0.25F * data[1] * data[1] + epsilon) + normalizationFactor;    // no imaginary component here
-    return logPsd;
 }
 
 // Return frequency for an index ranging from zero to (length/2).
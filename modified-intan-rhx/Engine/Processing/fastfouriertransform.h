@@ -30,6 +30,8 @@
 #ifndef FASTFOURIERTRANSFORM_H
 #define FASTFOURIERTRANSFORM_H
 
+#include <vector>
+
 class FastFourierTransform
 {
 public:
@@ -46,7 +48,14 @@ public:
     void setLength(int length_);
     static void complexInputFft(float *data, unsigned int n);
     static void realInputFft(float *data, unsigned int n);
+
+    // Faster versions of realInputFft() for the current length, using bit-reversal and twiddle factor tables
+    // calculated once in setLength() and radix-4 butterflies.  Output format is identical to realInputFft().
+    void realFft(float *data) const;
+    void realFftBatch(float *data, unsigned int numTransforms) const;  // numTransforms consecutive arrays of length
+
     float* logSqrtPowerSpectralDensity(float *data);
+    void logSqrtPowerSpectralDensityBatch(float *data, unsigned int numTransforms, float *dest) const;
     float getFrequency(int index) const;
 
 private:
@@ -58,9 +67,18 @@ private:
     float *logPsd;
     float *frequency;
 
+    // FFT plan for current length
+    std::vector<unsigned int> bitReverseSwaps;  // Pairs of complex indices to swap
+    std::vector<float> stageTwiddles;           // For each radix-4 pass, interleaved complex w1, w2 for each butterfly
+    std::vector<float> realTwiddles;            // Interleaved complex twiddles for separating real-input spectrum
+    bool radix2FirstStage;                      // True if log2(length/2) is odd
+
     void createWindow();
     void createPsdVector();
     void createFrequencyVector();
+    void createPlan();
+    void complexFft(float *data) const;
+    void calculateLogPsd(const float *fftData, float *dest) const;
 };
 
 #endif // FASTFOURIERTRANSFORM_H
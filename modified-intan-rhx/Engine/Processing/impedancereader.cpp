@@ -33,15 +33,58 @@
 #include <QString>
 #include <QFile>
 #include <QTextStream>
+#include <algorithm>
 #include <cmath>
 #include <deque>
 #include <iostream>
 #include "signalsources.h"
 #include "impedancereader.h"
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define IMPEDANCE_SSE2
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define IMPEDANCE_NEON
+#endif
+
+namespace {
+
+// Two channels' worth of doubles, processed in lockstep by the impedance kernels.
+#if defined(IMPEDANCE_SSE2)
+typedef __m128d DoublePair;
+inline DoublePair loadPair(const double* p) { return _mm_loadu_pd(p); }
+inline void storePair(double* p, DoublePair a) { _mm_storeu_pd(p, a); }
+inline DoublePair splatPair(double x) { return _mm_set1_pd(x); }
+inline DoublePair addPair(DoublePair a, DoublePair b) { return _mm_add_pd(a, b); }
+inline DoublePair subPair(DoublePair a, DoublePair b) { return _mm_sub_pd(a, b); }
+inline DoublePair mulPair(DoublePair a, DoublePair b) { return _mm_mul_pd(a, b); }
+#elif defined(IMPEDANCE_NEON)
+typedef float64x2_t DoublePair;
+inline DoublePair loadPair(const double* p) { return vld1q_f64(p); }
+inline void storePair(double* p, DoublePair a) { vst1q_f64(p, a); }
+inline DoublePair splatPair(double x) { return vdupq_n_f64(x); }
+inline DoublePair addPair(DoublePair a, DoublePair b) { return vaddq_f64(a, b); }
+inline DoublePair subPair(DoublePair a, DoublePair b) { return vsubq_f64(a, b); }
+inline DoublePair mulPair(DoublePair a, DoublePair b) { return vmulq_f64(a, b); }
+#else
+struct DoublePair { double lo, hi; };
+inline DoublePair loadPair(const double* p) { return { p[0], p[1] }; }
+inline void storePair(double* p, DoublePair a) { p[0] = a.lo; p[1] = a.hi; }
+inline DoublePair splatPair(double x) { return { x, x }; }
+inline DoublePair addPair(DoublePair a, DoublePair b) { return { a.lo + b.lo, a.hi + b.hi }; }
+inline DoublePair subPair(DoublePair a, DoublePair b) { return { a.lo - b.lo, a.hi - b.hi }; }
+inline DoublePair mulPair(DoublePair a, DoublePair b) { return { a.lo * b.lo, a.hi * b.hi }; }
+#endif
+
+const int MaxImpedanceWorkers = 8;
+
+}
+
 ImpedanceReader::ImpedanceReader(SystemState* state_, AbstractRHXController* rhxController_) :
     state(state_),
-    rhxController(rhxController_)
+    rhxController(rhxController_),
+    stopping(false)
 {
 }
 
@@ -152,6 +195,14 @@ bool ImpedanceReader::measureImpedances()
         }
     }
 
+    // Every acquisition has the same length, so the quadrature table and notch filter are computed once.
+    // Each acquisition is then analyzed on a worker thread while the next channel is being acquired.
+    quadrature = createQuadratureTable(RHXDataBlock::samplesPerDataBlock(controllerType) * numBlocks,
+                                       state->sampleRate->getNumericValue(), state->actualImpedanceFreq->getValue(),
+                                       numPeriods);
+    notch = createNotchCoefficients(state->sampleRate->getNumericValue());
+    startWorkers();
+
     // Data files used to examine data used in impedance measurement, only necessary for testing
 //    QFile cap0File("cap0.dat");
 //    cap0File.open(QIODevice::WriteOnly);
@@ -215,6 +266,8 @@ bool ImpedanceReader::measureImpedances()
             std::deque<RHXDataBlock*> dataQueue;
             rhxController->readDataBlocks(numBlocks, dataQueue);
 
+            std::vector<int> streams;
+            std::vector<ComplexPolar*> results;
             for (int stream = 0; stream < rhxController->getNumEnabledDataStreams(); ++stream) {
                 if (state->chipType[stream] != RHD2164MISOBChip) {
                     // Measure impedances, and pass measureComplexAmplitude() a file to write to. Only necessary for testing.
@@ -240,15 +293,11 @@ bool ImpedanceReader::measureImpedances()
 //                            measureComplexAmplitude(dataQueue, stream, channel, state->sampleRate->getNumericValue(),
 //                                                    state->actualImpedanceFreq->getValue(), numPeriods);
 //                    }
-                    measuredImpedance[stream][channel][capRange] =
-                            measureComplexAmplitude(dataQueue, stream, channel, state->sampleRate->getNumericValue(),
-                                                    state->actualImpedanceFreq->getValue(), numPeriods);
+                    streams.push_back(stream);
+                    results.push_back(&measuredImpedance[stream][channel][capRange]);
                 }
             }
-            while (!dataQueue.empty()) {
-                delete dataQueue.back();
-                dataQueue.pop_back();
-            }
+            queueJob(dataQueue, channel, streams, results);
 
             // If an RHD2164 chip is plugged in, we have to set the Zcheck select register to channels 32-63
             // and repeat the previous steps.
@@ -268,21 +317,22 @@ bool ImpedanceReader::measureImpedances()
                 }
                 rhxController->readDataBlocks(numBlocks, dataQueue);
 
+                streams.clear();
+                results.clear();
                 for (int stream = 0; stream < rhxController->getNumEnabledDataStreams(); ++stream) {
                     if (state->chipType[stream] == RHD2164MISOBChip) {
-                        measuredImpedance[stream][channel][capRange] =
-                                measureComplexAmplitude(dataQueue, stream, channel, state->sampleRate->getNumericValue(),
-                                                        state->actualImpedanceFreq->getValue(), numPeriods);
+                        streams.push_back(stream);
+                        results.push_back(&measuredImpedance[stream][channel][capRange]);
                     }
                 }
-                while (!dataQueue.empty()) {
-                    delete dataQueue.back();
-                    dataQueue.pop_back();
-                }
+                queueJob(dataQueue, channel, streams, results);
             }
         }
     }
 
+    // Wait for the last acquisitions to be analyzed.
+    finishJobs();
+
     // Close data files used to examine data used in impedance measurement, only necessary for testing
 //    cap0File.close();
 //    cap1File.close();
@@ -449,80 +499,208 @@ ComplexPolar ImpedanceReader::measureComplexAmplitude(const std::deque<RHXDataBl
     int samplesPerDataBlock = RHXDataBlock::samplesPerDataBlock(state->getControllerTypeEnum());
     int numBlocks = (int) dataQueue.size();
 
-    // Copy waveform data from data blocks.
-    std::vector<double> waveform(samplesPerDataBlock * numBlocks);
-    int index = 0;
-    for (int block = 0; block < numBlocks; ++block) {
-        for (int t = 0; t < samplesPerDataBlock; ++t) {
-            waveform[index++] = 0.195 * (double)(dataQueue[block]->amplifierData(stream, chipChannel, t) - 32768);
-            if (outStream) {
+    if (outStream) {
+        for (int block = 0; block < numBlocks; ++block) {
+            for (int t = 0; t < samplesPerDataBlock; ++t) {
                 *outStream << 0.195 * (double)(dataQueue[block]->amplifierData(stream, chipChannel, t) - 32768);
             }
         }
     }
 
-    if (state->notchFreq->getValue().toLower() != "none") {
-        double notchFreq = state->notchFreq->getNumericValue();
-        applyNotchFilter(waveform, notchFreq, (double) NotchBandwidth, sampleRate);
-    }
+    QuadratureTable table = createQuadratureTable(samplesPerDataBlock * numBlocks, sampleRate, frequency, numPeriods);
+    std::vector<ComplexPolar> results;
+    measureComplexAmplitudes(dataQueue, std::vector<int>(1, stream), chipChannel, table, createNotchCoefficients(sampleRate),
+                             results);
+    return results[0];
+}
 
+ImpedanceReader::QuadratureTable ImpedanceReader::createQuadratureTable(int numSamples, double sampleRate, double frequency,
+                                                                        int numPeriods)
+{
+    QuadratureTable table;
     int period = round(sampleRate / frequency);
-    int startIndex = 0;
-    int endIndex = startIndex + numPeriods * period - 1;
+    table.startIndex = 0;
+    table.endIndex = table.startIndex + numPeriods * period - 1;
 
     // Move the measurement window to the end of the waveform to ignore start-up transient.
-    while (endIndex < samplesPerDataBlock * numBlocks - period) {
-        startIndex += period;
-        endIndex += period;
+    while (table.endIndex < numSamples - period) {
+        table.startIndex += period;
+        table.endIndex += period;
     }
 
-    return amplitudeOfFreqComponent(waveform, startIndex, endIndex, sampleRate, frequency);
+    const double K = TwoPi * frequency / sampleRate;
+    int length = table.endIndex - table.startIndex + 1;
+    table.cosTable.resize(length);
+    table.sinTable.resize(length);
+    for (int i = 0; i < length; ++i) {
+        int t = table.startIndex + i;
+        table.cosTable[i] = cos(K * t);
+        table.sinTable[i] = -1.0 * sin(K * t);
+    }
+    return table;
 }
 
-void ImpedanceReader::applyNotchFilter(std::vector<double> &waveform, double fNotch, double bandwidth, double sampleRate) const
+ImpedanceReader::NotchCoefficients ImpedanceReader::createNotchCoefficients(double sampleRate) const
 {
-    double d = exp(-1.0 * Pi * bandwidth / sampleRate);
+    NotchCoefficients filter;
+    filter.enabled = state->notchFreq->getValue().toLower() != "none";
+    if (!filter.enabled) return filter;
+
+    double fNotch = state->notchFreq->getNumericValue();
+    double d = exp(-1.0 * Pi * (double) NotchBandwidth / sampleRate);
     double b = (1.0 + d * d) * cos(TwoPi * fNotch / sampleRate);
-    double b0 = (1.0 + d * d) / 2.0;
-    double b1 = -b;
-    double b2 = b0;
-    double a1 = b1;
-    double a2 = d * d;
-    int length = (int) waveform.size();
-
-    double prevPrevIn = waveform[0];
-    double prevIn = waveform[1];
-    for (int t = 2; t < length; ++t) {
-        double in = waveform[t];
-        waveform[t] = b0 * in + b1 * prevIn + b2 * prevPrevIn - a1 * waveform[t - 1] - a2 * waveform[t - 2];  // Direct Form 1 implementation
-        prevPrevIn = prevIn;
-        prevIn = in;
+    filter.b0 = (1.0 + d * d) / 2.0;
+    filter.b1 = -b;
+    filter.b2 = filter.b0;
+    filter.a1 = filter.b1;
+    filter.a2 = d * d;
+    return filter;
+}
+
+// Measure the complex amplitude of the test frequency on chipChannel of each of several streams. The
+// streams' waveforms are interleaved ([t][stream], padded to an even count) so that the notch filter
+// and the correlation both advance two streams at a time.
+void ImpedanceReader::measureComplexAmplitudes(const std::deque<RHXDataBlock*> &dataQueue, const std::vector<int> &streams,
+                                               int chipChannel, const QuadratureTable &table,
+                                               const NotchCoefficients &filter, std::vector<ComplexPolar> &results)
+{
+    int numStreams = (int) streams.size();
+    results.resize(numStreams);
+    if (numStreams == 0 || dataQueue.empty()) return;
+
+    int samplesPerDataBlock = dataQueue[0]->samplesPerDataBlock();
+    int numSamples = samplesPerDataBlock * (int) dataQueue.size();
+    int width = (numStreams + 1) & ~1;
+
+    // Copy waveform data from data blocks.
+    std::vector<double> waveform(numSamples * width, 0.0);
+    int index = 0;
+    for (const RHXDataBlock* block : dataQueue) {
+        for (int t = 0; t < samplesPerDataBlock; ++t) {
+            for (int s = 0; s < numStreams; ++s) {
+                waveform[index + s] = 0.195 * (double)(block->amplifierData(streams[s], chipChannel, t) - 32768);
+            }
+            index += width;
+        }
+    }
+
+    // Notch filter, Direct Form 1.
+    if (filter.enabled && numSamples > 2) {
+        const DoublePair b0 = splatPair(filter.b0);
+        const DoublePair b1 = splatPair(filter.b1);
+        const DoublePair b2 = splatPair(filter.b2);
+        const DoublePair a1 = splatPair(filter.a1);
+        const DoublePair a2 = splatPair(filter.a2);
+        for (int s = 0; s < width; s += 2) {
+            double* w = &waveform[s];
+            DoublePair prevPrevIn = loadPair(w);
+            DoublePair prevIn = loadPair(w + width);
+            DoublePair prevPrevOut = prevPrevIn;
+            DoublePair prevOut = prevIn;
+            for (int t = 2; t < numSamples; ++t) {
+                DoublePair in = loadPair(w + t * width);
+                DoublePair out = subPair(subPair(addPair(addPair(mulPair(b0, in), mulPair(b1, prevIn)), mulPair(b2, prevPrevIn)),
+                                                 mulPair(a1, prevOut)), mulPair(a2, prevPrevOut));
+                storePair(w + t * width, out);
+                prevPrevIn = prevIn;
+                prevIn = in;
+                prevPrevOut = prevOut;
+                prevOut = out;
+            }
+        }
+    }
+
+    // Correlate the measurement window with the precomputed cosine and sine.
+    int length = table.endIndex - table.startIndex + 1;
+    for (int s = 0; s < width; s += 2) {
+        const double* w = &waveform[table.startIndex * width + s];
+        DoublePair sumI = splatPair(0.0);
+        DoublePair sumQ = splatPair(0.0);
+        for (int i = 0; i < length; ++i) {
+            DoublePair sample = loadPair(w + i * width);
+            sumI = addPair(sumI, mulPair(sample, splatPair(table.cosTable[i])));
+            sumQ = addPair(sumQ, mulPair(sample, splatPair(table.sinTable[i])));
+        }
+        double meanI[2], meanQ[2];
+        storePair(meanI, sumI);
+        storePair(meanQ, sumQ);
+        for (int lane = 0; lane < 2 && s + lane < numStreams; ++lane) {
+            double realComponent = 2.0 * (meanI[lane] / (double) length);
+            double imagComponent = 2.0 * (meanQ[lane] / (double) length);
+            results[s + lane].magnitude = sqrt(realComponent * realComponent + imagComponent * imagComponent);
+            results[s + lane].phase = RadiansToDegrees * atan2(imagComponent, realComponent);
+        }
+    }
+}
+
+void ImpedanceReader::startWorkers()
+{
+    stopping = false;
+    // Leave a core for the GUI thread, which keeps driving the acquisitions.
+    int numWorkers = std::min(std::max((int) std::thread::hardware_concurrency() - 1, 1), MaxImpedanceWorkers);
+    for (int i = 0; i < numWorkers; ++i) {
+        workers.push_back(std::thread(&ImpedanceReader::workerLoop, this));
+    }
+}
+
+// Hand an acquisition to the workers. Takes ownership of the data blocks and leaves dataQueue empty.
+void ImpedanceReader::queueJob(std::deque<RHXDataBlock*> &dataQueue, int chipChannel, const std::vector<int> &streams,
+                               const std::vector<ComplexPolar*> &results)
+{
+    if (streams.empty()) {
+        while (!dataQueue.empty()) {
+            delete dataQueue.back();
+            dataQueue.pop_back();
+        }
+        return;
+    }
+    ImpedanceJob job;
+    job.dataQueue.swap(dataQueue);
+    job.chipChannel = chipChannel;
+    job.streams = streams;
+    job.results = results;
+    {
+        std::lock_guard<std::mutex> lock(jobMutex);
+        jobs.push_back(std::move(job));
     }
+    jobReady.notify_one();
 }
 
-ComplexPolar ImpedanceReader::amplitudeOfFreqComponent(const std::vector<double> &waveform, int startIndex, int endIndex,
-                                                       double sampleRate, double frequency)
+// Let the workers drain the queue, then stop them. Every result is written once this returns.
+void ImpedanceReader::finishJobs()
 {
-    const double K = TwoPi * frequency / sampleRate;  // precalculate for speed
-
-    // Perform correlation with sine and cosine waveforms.
-    double meanI = 0.0;
-    double meanQ = 0.0;
-    for (int t = startIndex; t <= endIndex; ++t) {
-        meanI += waveform[t] * cos(K * t);
-        meanQ += waveform[t] * -1.0 * sin(K * t);
+    {
+        std::lock_guard<std::mutex> lock(jobMutex);
+        stopping = true;
     }
-    double length = (double)(endIndex - startIndex + 1);
-    meanI /= length;
-    meanQ /= length;
+    jobReady.notify_all();
+    for (std::thread &worker : workers) {
+        worker.join();
+    }
+    workers.clear();
+}
 
-    double realComponent = 2.0 * meanI;
-    double imagComponent = 2.0 * meanQ;
+void ImpedanceReader::workerLoop()
+{
+    std::vector<ComplexPolar> amplitudes;
+    while (true) {
+        ImpedanceJob job;
+        {
+            std::unique_lock<std::mutex> lock(jobMutex);
+            jobReady.wait(lock, [this]() { return stopping || !jobs.empty(); });
+            if (jobs.empty()) return;
+            job = std::move(jobs.front());
+            jobs.pop_front();
+        }
 
-    ComplexPolar result;
-    result.magnitude = sqrt(realComponent * realComponent + imagComponent * imagComponent);
-    result.phase = RadiansToDegrees * atan2(imagComponent, realComponent);
-    return result;
+        measureComplexAmplitudes(job.dataQueue, job.streams, job.chipChannel, quadrature, notch, amplitudes);
+        for (int i = 0; i < (int) job.results.size(); ++i) {
+            *job.results[i] = amplitudes[i];
+        }
+        for (RHXDataBlock* block : job.dataQueue) {
+            delete block;
+        }
+    }
 }
 
 bool ImpedanceReader::saveImpedances()
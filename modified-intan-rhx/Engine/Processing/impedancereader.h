@@ -33,6 +33,9 @@
 
 #include <vector>
 #include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 #include "systemstate.h"
 #include "abstractrhxcontroller.h"
 #include "rhxdatablock.h"
@@ -50,16 +53,57 @@ public:
     bool saveImpedances();
 
 private:
+    // Cosine and negative sine of the test frequency over the measurement window, computed once per sweep
+    // and shared by every channel.
+    struct QuadratureTable {
+        int startIndex;
+        int endIndex;
+        std::vector<double> cosTable;
+        std::vector<double> sinTable;
+    };
+
+    struct NotchCoefficients {
+        bool enabled;
+        double b0, b1, b2, a1, a2;
+    };
+
+    // One acquisition waiting to be analyzed: the data blocks recorded with chipChannel selected, the
+    // streams measured from it, and where each stream's result goes.
+    struct ImpedanceJob {
+        std::deque<RHXDataBlock*> dataQueue;
+        int chipChannel;
+        std::vector<int> streams;
+        std::vector<ComplexPolar*> results;
+    };
+
     SystemState* state;
     AbstractRHXController* rhxController;
 
+    // Analysis workers; they run while the next channel is being acquired.
+    QuadratureTable quadrature;
+    NotchCoefficients notch;
+    std::vector<std::thread> workers;
+    std::mutex jobMutex;
+    std::condition_variable jobReady;
+    std::deque<ImpedanceJob> jobs;
+    bool stopping;
+
     static double approximateSaturationVoltage(double actualZFreq, double highCutoff);
     static ComplexPolar factorOutParallelCapacitance(ComplexPolar impedance, double frequency, double parasiticCapacitance);
     ComplexPolar measureComplexAmplitude(const std::deque<RHXDataBlock*> &dataQueue, int stream, int chipChannel,
                                          double sampleRate, double frequency, int numPeriods, QDataStream *outStream = nullptr) const;
-    void applyNotchFilter(std::vector<double> &waveform, double fNotch, double bandwidth, double sampleRate) const;
-    static ComplexPolar amplitudeOfFreqComponent(const std::vector<double> &waveform, int startIndex, int endIndex,
-                                                 double sampleRate, double frequency);
+    static QuadratureTable createQuadratureTable(int numSamples, double sampleRate, double frequency, int numPeriods);
+    NotchCoefficients createNotchCoefficients(double sampleRate) const;
+    static void measureComplexAmplitudes(const std::deque<RHXDataBlock*> &dataQueue, const std::vector<int> &streams,
+                                         int chipChannel, const QuadratureTable &table, const NotchCoefficients &filter,
+                                         std::vector<ComplexPolar> &results);
+
+    void startWorkers();
+    void queueJob(std::deque<RHXDataBlock*> &dataQueue, int chipChannel, const std::vector<int> &streams,
+                  const std::vector<ComplexPolar*> &results);
+    void finishJobs();
+    void workerLoop();
+
     void runDemoImpedanceMeasurement();
 };
 
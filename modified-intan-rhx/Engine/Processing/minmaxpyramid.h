@@ -0,0 +1,183 @@
+//------------------------------------------------------------------------------
+//
+//  Intan Technologies RHX Data Acquisition Software
+//  Version 3.4.0
+//
+//  Copyright (c) 2020-2025 Intan Technologies
+//
+//  This file is part of the Intan Technologies RHX Data Acquisition Software.
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published
+//  by the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//  This software is provided 'as-is', without any express or implied warranty.
+//  In no event will the authors be held liable for any damages arising from
+//  the use of this software.
+//
+//  See <http://www.intantech.com> for documentation and product information.
+//
+//------------------------------------------------------------------------------
+
+
+#ifndef MINMAXPYRAMID_H
+#define MINMAXPYRAMID_H
+
+#include <vector>
+#include <algorithm>
+#include "minmax.h"
+
+// Multi-resolution min/max cache over a circular sample buffer.  Level 0 holds the min and max of every
+// BaseBinSize consecutive samples, and each higher level combines LevelFactor bins of the level below it.
+// The buffer may hold several interleaved channels ([sample][channel] layout), in which case each bin
+// stores one min and one max per channel, using the same interleaving.
+//
+// Bins are aligned to absolute buffer indices.  After new samples are written to the buffer, update()
+// must be called on the written index range; every bin overlapping that range is recomputed, so a bin
+// that lies entirely inside committed data always describes exactly those samples.  Any samples beyond
+// the last complete bin of a level (when bufferSize is not a multiple of the bin size) are simply read
+// from the raw buffer.
+
+template <class Type> class MinMaxPyramid
+{
+public:
+    static const int BaseBinSize = 8;
+    static const int LevelFactor = 4;
+    static const int MaxLevels = 6;
+
+    MinMaxPyramid() : bufferSize(0), numChannels(0), numLevels(0) {}
+
+    void allocate(int bufferSize_, int numChannels_)
+    {
+        bufferSize = bufferSize_;
+        numChannels = numChannels_;
+        numLevels = 0;
+        int binSize = BaseBinSize;
+        while (numLevels < MaxLevels && binSize <= bufferSize) {
+            binSizes[numLevels] = binSize;
+            numBins[numLevels] = bufferSize / binSize;
+            minData[numLevels].assign((size_t) numBins[numLevels] * numChannels, Type());
+            maxData[numLevels].assign((size_t) numBins[numLevels] * numChannels, Type());
+            binSize *= LevelFactor;
+            ++numLevels;
+        }
+        for (int level = numLevels; level < MaxLevels; ++level) {
+            minData[level].clear();
+            maxData[level].clear();
+        }
+    }
+
+    void release()
+    {
+        for (int level = 0; level < MaxLevels; ++level) {
+            std::vector<Type>().swap(minData[level]);
+            std::vector<Type>().swap(maxData[level]);
+        }
+        numLevels = 0;
+    }
+
+    // Recompute all bins that overlap buffer indices [startIndex, startIndex + numSamples).  The range must not
+    // wrap past the end of the buffer; callers split wrapping writes into two calls.
+    void update(const Type* buffer, int startIndex, int numSamples)
+    {
+        if (numLevels == 0 || numSamples <= 0 || !buffer) return;
+
+        int firstBin = startIndex / binSizes[0];
+        int lastBin = std::min((startIndex + numSamples - 1) / binSizes[0], numBins[0] - 1);
+        for (int bin = firstBin; bin <= lastBin; ++bin) {
+            Type* pMin = &minData[0][(size_t) bin * numChannels];
+            Type* pMax = &maxData[0][(size_t) bin * numChannels];
+            const Type* pRaw = &buffer[(size_t) bin * binSizes[0] * numChannels];
+            std::copy(pRaw, pRaw + numChannels, pMin);
+            std::copy(pRaw, pRaw + numChannels, pMax);
+            for (int i = 1; i < binSizes[0]; ++i) {
+                pRaw += numChannels;
+                for (int channel = 0; channel < numChannels; ++channel) {
+                    pMin[channel] = std::min(pMin[channel], pRaw[channel]);
+                    pMax[channel] = std::max(pMax[channel], pRaw[channel]);
+                }
+            }
+        }
+
+        for (int level = 1; level < numLevels; ++level) {
+            firstBin /= LevelFactor;
+            lastBin = std::min(lastBin / LevelFactor, numBins[level] - 1);
+            for (int bin = firstBin; bin <= lastBin; ++bin) {
+                Type* pMin = &minData[level][(size_t) bin * numChannels];
+                Type* pMax = &maxData[level][(size_t) bin * numChannels];
+                const Type* pChildMin = &minData[level - 1][(size_t) bin * LevelFactor * numChannels];
+                const Type* pChildMax = &maxData[level - 1][(size_t) bin * LevelFactor * numChannels];
+                std::copy(pChildMin, pChildMin + numChannels, pMin);
+                std::copy(pChildMax, pChildMax + numChannels, pMax);
+                for (int i = 1; i < LevelFactor; ++i) {
+                    pChildMin += numChannels;
+                    pChildMax += numChannels;
+                    for (int channel = 0; channel < numChannels; ++channel) {
+                        pMin[channel] = std::min(pMin[channel], pChildMin[channel]);
+                        pMax[channel] = std::max(pMax[channel], pChildMax[channel]);
+                    }
+                }
+            }
+        }
+    }
+
+    // Merge the min and max of numSamples samples of one channel, starting at buffer index 'index' (wrapping at
+    // the end of the buffer), into 'init'.  Whole bins are taken from the coarsest level that fits; only the
+    // unaligned head and tail of the range are read from the raw buffer.
+    void getMinMax(MinMax<Type> &init, const Type* buffer, int channel, int index, int numSamples) const
+    {
+        getMinMaxArray(&init, buffer, &channel, 1, index, numSamples);
+    }
+
+    // Same as getMinMax() for several channels over the same range: init[j] receives the min and max of
+    // channels[j].  The choice of bins depends only on the range, so it is made once for all channels.
+    void getMinMaxArray(MinMax<Type>* init, const Type* buffer, const int* channels, int numQueried, int index,
+                        int numSamples) const
+    {
+        while (numSamples > 0) {
+            int level = numLevels - 1;
+            for (; level >= 0; --level) {
+                int binSize = binSizes[level];
+                if (binSize <= numSamples && index % binSize == 0 && index / binSize < numBins[level]) break;
+            }
+            if (level >= 0) {
+                const Type* pMin = &minData[level][(size_t) (index / binSizes[level]) * numChannels];
+                const Type* pMax = &maxData[level][(size_t) (index / binSizes[level]) * numChannels];
+                for (int j = 0; j < numQueried; ++j) {
+                    init[j].update(pMin[channels[j]]);
+                    init[j].update(pMax[channels[j]]);
+                }
+                index += binSizes[level];
+                numSamples -= binSizes[level];
+            } else {
+                const Type* pRaw = &buffer[(size_t) index * numChannels];
+                for (int j = 0; j < numQueried; ++j) {
+                    init[j].update(pRaw[channels[j]]);
+                }
+                ++index;
+                --numSamples;
+            }
+            if (index >= bufferSize) index -= bufferSize;
+        }
+    }
+
+private:
+    int bufferSize;
+    int numChannels;
+    int numLevels;
+    int binSizes[MaxLevels];
+    int numBins[MaxLevels];
+    std::vector<Type> minData[MaxLevels];
+    std::vector<Type> maxData[MaxLevels];
+};
+
+#endif // MINMAXPYRAMID_H
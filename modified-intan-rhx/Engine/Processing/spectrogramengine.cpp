@@ -0,0 +1,160 @@
+//------------------------------------------------------------------------------
+//
+//  Intan Technologies RHX Data Acquisition Software
+//  Version 3.4.0
+//
+//  Copyright (c) 2020-2025 Intan Technologies
+//
+//  This file is part of the Intan Technologies RHX Data Acquisition Software.
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published
+//  by the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//  This software is provided 'as-is', without any express or implied warranty.
+//  In no event will the authors be held liable for any damages arising from
+//  the use of this software.
+//
+//  See <http://www.intantech.com> for documentation and product information.
+//
+//------------------------------------------------------------------------------
+
+
+#include <cstring>
+#include <algorithm>
+#include <iostream>
+#include "spectrogramengine.h"
+
+SpectrogramEngine::SpectrogramEngine(float sampleRate_, int fftSize_, int numColumns_, int numChannels_) :
+    sampleRate(sampleRate_),
+    fftSize(fftSize_),
+    numColumns(numColumns_)
+{
+    fftEngine = new FastFourierTransform(sampleRate, fftSize);
+    fftInputBuffer.resize(fftSize);
+    channels.resize(numChannels_);
+    reset();
+}
+
+SpectrogramEngine::~SpectrogramEngine()
+{
+    delete fftEngine;
+}
+
+void SpectrogramEngine::setFftSize(int fftSize_)
+{
+    if (fftSize == fftSize_) return;
+    fftSize = fftSize_;
+    fftEngine->setLength(fftSize);
+    fftInputBuffer.resize(fftSize);
+    reset();
+}
+
+void SpectrogramEngine::setNumColumns(int numColumns_)
+{
+    if (numColumns == numColumns_) return;
+    numColumns = numColumns_;
+    reset();
+}
+
+void SpectrogramEngine::setNumChannels(int numChannels_)
+{
+    if ((int) channels.size() == numChannels_) return;
+    channels.resize(numChannels_);
+    reset();
+}
+
+void SpectrogramEngine::reset()
+{
+    for (int i = 0; i < (int) channels.size(); ++i) {
+        resetChannel(channels[i]);
+    }
+}
+
+void SpectrogramEngine::resetChannel(ChannelState& ch)
+{
+    ch.ring.assign(fftSize, 0.0F);
+    ch.ringIndex = 0;
+    ch.samplesUntilColumn = fftSize;  // First column needs a full window of samples.
+    ch.columns.assign((size_t) numColumns * getNumFrequencies(), -10.0F);
+    ch.nextColumn = 0;
+    ch.numValidColumns = 0;
+}
+
+int SpectrogramEngine::addSamples(int channel, const float* samples, int numSamples)
+{
+    if (channel < 0 || channel >= (int) channels.size()) {
+        std::cerr << "Error: SpectrogramEngine::addSamples: channel " << channel << " out of range." << '\n';
+        return 0;
+    }
+    ChannelState& ch = channels[channel];
+
+    int newColumns = 0;
+    while (numSamples > 0) {
+        // Copy as many samples as we can before the next column is due, wrapping around the ring buffer.
+        int chunk = std::min(numSamples, ch.samplesUntilColumn);
+        int firstPart = std::min(chunk, fftSize - ch.ringIndex);
+        memcpy(&ch.ring[ch.ringIndex], samples, firstPart * sizeof(float));
+        if (chunk > firstPart) {
+            memcpy(&ch.ring[0], samples + firstPart, (chunk - firstPart) * sizeof(float));
+        }
+        ch.ringIndex += chunk;
+        if (ch.ringIndex >= fftSize) ch.ringIndex -= fftSize;
+        samples += chunk;
+        numSamples -= chunk;
+
+        ch.samplesUntilColumn -= chunk;
+        if (ch.samplesUntilColumn == 0) {
+            calculateColumn(ch);
+            ch.samplesUntilColumn = getHopSize();
+            ++newColumns;
+        }
+    }
+    return newColumns;
+}
+
+int SpectrogramEngine::addSamplesInterleaved(const float* samples, int numSamples)
+{
+    int numChannels = (int) channels.size();
+    channelScratch.resize(numSamples);
+    int newColumns = 0;
+    for (int channel = 0; channel < numChannels; ++channel) {
+        const float* pRead = samples + channel;
+        for (int t = 0; t < numSamples; ++t) {
+            channelScratch[t] = *pRead;
+            pRead += numChannels;
+        }
+        newColumns = addSamples(channel, channelScratch.data(), numSamples);
+    }
+    return newColumns;
+}
+
+const float* SpectrogramEngine::getLatestColumn(int channel) const
+{
+    int index = channels[channel].nextColumn - 1;
+    if (index < 0) index = numColumns - 1;
+    return getColumn(channel, index);
+}
+
+void SpectrogramEngine::calculateColumn(ChannelState& ch)
+{
+    // Unroll the ring buffer (oldest sample is at ringIndex) into the FFT input buffer.
+    int firstPart = fftSize - ch.ringIndex;
+    memcpy(&fftInputBuffer[0], &ch.ring[ch.ringIndex], firstPart * sizeof(float));
+    memcpy(&fftInputBuffer[firstPart], &ch.ring[0], ch.ringIndex * sizeof(float));
+
+    const float* logPsd = fftEngine->logSqrtPowerSpectralDensity(fftInputBuffer.data());
+    memcpy(&ch.columns[(size_t) ch.nextColumn * getNumFrequencies()], logPsd, getNumFrequencies() * sizeof(float));
+
+    if (++ch.nextColumn == numColumns) ch.nextColumn = 0;
+    if (ch.numValidColumns < numColumns) ++ch.numValidColumns;
+}
@@ -0,0 +1,96 @@
+//------------------------------------------------------------------------------
+//
+//  Intan Technologies RHX Data Acquisition Software
+//  Version 3.4.0
+//
+//  Copyright (c) 2020-2025 Intan Technologies
+//
+//  This file is part of the Intan Technologies RHX Data Acquisition Software.
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published
+//  by the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//  This software is provided 'as-is', without any express or implied warranty.
+//  In no event will the authors be held liable for any damages arising from
+//  the use of this software.
+//
+//  See <http://www.intantech.com> for documentation and product information.
+//
+//------------------------------------------------------------------------------
+
+
+#ifndef SPECTROGRAMENGINE_H
+#define SPECTROGRAMENGINE_H
+
+#include <vector>
+#include <cstddef>
+#include "fastfouriertransform.h"
+
+// Sliding-window spectrogram calculation for one or more channels.  Each channel keeps the most recent fftSize samples
+// in a ring buffer; every fftSize/2 new samples (50% window overlap) a log-PSD column is calculated and written into a
+// circular store of numColumns columns.  Column storage is indexed the same way for all channels, so a display can map
+// column indices directly to image columns and blit the oldest-to-newest range in two pieces.
+
+class SpectrogramEngine
+{
+public:
+    SpectrogramEngine(float sampleRate_, int fftSize_, int numColumns_, int numChannels_ = 1);
+    ~SpectrogramEngine();
+
+    void setFftSize(int fftSize_);
+    void setNumColumns(int numColumns_);
+    void setNumChannels(int numChannels_);
+    void reset();
+
+    // Returns number of new spectrogram columns calculated.
+    int addSamples(int channel, const float* samples, int numSamples);
+    int addSamplesInterleaved(const float* samples, int numSamples);  // [sample][channel] layout, all channels.
+
+    int getFftSize() const { return fftSize; }
+    int getHopSize() const { return fftSize / 2; }
+    int getNumFrequencies() const { return fftSize / 2 + 1; }
+    int getNumColumns() const { return numColumns; }
+    int getNumChannels() const { return (int) channels.size(); }
+    float getFrequency(int index) const { return fftEngine->getFrequency(index); }
+
+    const float* getColumn(int channel, int columnIndex) const
+        { return &channels[channel].columns[(size_t) columnIndex * getNumFrequencies()]; }
+    const float* getLatestColumn(int channel) const;
+    int getNextColumnIndex(int channel) const { return channels[channel].nextColumn; }  // Oldest column, once full.
+    int getNumValidColumns(int channel) const { return channels[channel].numValidColumns; }
+    bool isFull(int channel) const { return channels[channel].numValidColumns == numColumns; }
+
+private:
+    struct ChannelState
+    {
+        std::vector<float> ring;
+        int ringIndex;
+        int samplesUntilColumn;
+        std::vector<float> columns;
+        int nextColumn;
+        int numValidColumns;
+    };
+
+    float sampleRate;
+    int fftSize;
+    int numColumns;
+    FastFourierTransform* fftEngine;
+    std::vector<float> fftInputBuffer;
+    std::vector<float> channelScratch;
+    std::vector<ChannelState> channels;
+
+    void resetChannel(ChannelState& ch);
+    void calculateColumn(ChannelState& ch);
+};
+
+#endif // SPECTROGRAMENGINE_H
@@ -0,0 +1,61 @@
+//------------------------------------------------------------------------------
+//
+//  Intan Technologies RHX Data Acquisition Software
+//  Version 3.4.0
+//
+//  Copyright (c) 2020-2025 Intan Technologies
+//
+//  This file is part of the Intan Technologies RHX Data Acquisition Software.
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published
+//  by the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//  This software is provided 'as-is', without any express or implied warranty.
+//  In no event will the authors be held liable for any damages arising from
+//  the use of this software.
+//
+//  See <http://www.intantech.com> for documentation and product information.
+//
+//------------------------------------------------------------------------------
+
+#ifndef STREAMSUBSCRIPTION_H
+#define STREAMSUBSCRIPTION_H
+
+#include <cstdint>
+#include <vector>
+
+// Subscription masks of WaveformStreamServer (see waveformstreamserver.h), kept free of Qt so they can be tested
+// on their own.
+
+// Amplifier channels selected by a subscription mask, in ascending order.
+inline std::vector<int> channelsFromSubscriptionMask(const uint8_t* mask, uint32_t numMaskBytes)
+{
+    std::vector<int> channels;
+    for (uint32_t channel = 0; channel < 8 * numMaskBytes; ++channel) {
+        if (mask[channel / 8] & (1u << (channel % 8))) {
+            channels.push_back((int) channel);
+        }
+    }
+    return channels;
+}
+
+// True if channels (ascending, as returned by channelsFromSubscriptionMask()) includes every one of
+// numAmplifierChannels, so the subscriber can be sent the full-rate frame.  A mask shorter than the channel
+// count never selects all channels, even if every bit it has is set.
+inline bool selectsAllChannels(const std::vector<int>& channels, int numAmplifierChannels)
+{
+    return numAmplifierChannels > 0 && (int) channels.size() >= numAmplifierChannels &&
+            channels[numAmplifierChannels - 1] == numAmplifierChannels - 1;
+}
+
+#endif // STREAMSUBSCRIPTION_H
@@ -798,6 +798,8 @@ SystemState::SystemState(const AbstractRHXController* controller_, StimStepSize
     testAuxIns = new BooleanItem("TestAuxIns", globalItems, this, getControllerTypeEnum() != ControllerStimRecord, XMLGroupNone);
     testingPort = new StringItem("TestingPort", globalItems, this, "A", XMLGroupNone);
 
+    publishRealtimeParameters();
+
     // Start timer
     timerId = startTimer(20);  // Minimum time between two stateChanged() signals, in milliseconds.
     writeToLog("Started timer. End of SystemState ctor");
@@ -1119,6 +1121,7 @@ void SystemState::timerEvent(QTimerEvent *event)
     if (event->timerId() == timerId) {  // Restrict the frequency at which we send stateChanged() signals.
         if (pendingStateChangedSignal) {
             pendingStateChangedSignal = false;
+            publishRealtimeParameters();
             emit stateChanged();
         }
     } else {
@@ -1126,6 +1129,23 @@ void SystemState::timerEvent(QTimerEvent *event)
     }
 }
 
+// Copy the per-block settings into a new snapshot and make it current. Runs on the GUI thread, which
+// owns the StateItems; readers on other threads only ever see complete snapshots, and the one they
+// replace is freed when its last reader releases it.
+void SystemState::publishRealtimeParameters()
+{
+    std::shared_ptr<RealtimeParameters> parameters = std::make_shared<RealtimeParameters>();
+    parameters->reportSpikes = reportSpikes;
+    parameters->tcpNumDataBlocksWrite = tcpNumDataBlocksWrite->getValue();
+    parameters->tcpFilterBands = signalSources->getTcpFilterBands();
+    parameters->audioVolume = audioVolume->getValue();
+    parameters->audioThreshold = audioThreshold->getValue();
+    parameters->audioFilter = audioFilter->getDisplayValueString();
+    parameters->artifactsShown = artifactsShown->getValue();
+
+    std::atomic_store(&currentRealtimeParameters, std::shared_ptr<const RealtimeParameters>(std::move(parameters)));
+}
+
 void SystemState::setupGlobalSettingsLoadSave(ControllerInterface* controllerInterface)
 {
     // XML interface for saving global settings.
@@ -1221,7 +1241,10 @@ void SystemState::writeToLog(QString message)
 
 void SystemState::setReportSpikes(bool enable)
 {
-    reportSpikes = enable;
+    if (reportSpikes != enable) {
+        reportSpikes = enable;
+        forceUpdate();
+    }
 }
 
 bool SystemState::getReportSpikes()
@@ -35,6 +35,7 @@
 #include <QDoubleSpinBox>
 #include <QFile>
 #include <map>
+#include <memory>
 
 #include "rhxglobals.h"
 #include "abstractrhxcontroller.h"
@@ -71,6 +72,20 @@ struct GPUInfo : public CPUInfo {
 };
 
 
+// Immutable copy of the settings that the acquisition threads read every data block. SystemState
+// publishes a new one each time it emits stateChanged(); worker threads read it through
+// realtimeParameters() instead of the StateItems, which belong to the GUI thread.
+struct RealtimeParameters {
+    bool reportSpikes;
+    int tcpNumDataBlocksWrite;
+    QStringList tcpFilterBands;
+    int audioVolume;
+    int audioThreshold;
+    QString audioFilter;
+    bool artifactsShown;
+};
+
+
 const int SnippetSize = 50;
 const int FramesPerBlock = 128;
 const int NotchBandwidth = 10;
@@ -128,6 +143,13 @@ public:
     void setReportSpikes(bool enable);
     bool getReportSpikes();
 
+    // Latest published snapshot. The returned pointer keeps it alive for as long as the caller holds it, so
+    // load it once per data block (or batch) and keep it until the block is done.  This is not lock-free:
+    // std::atomic_load on a shared_ptr takes one of a small pool of global locks in libstdc++ and libc++.  That
+    // is one short, practically uncontended lock per block, which a raw atomic pointer would only avoid at the
+    // cost of hazard-pointer or epoch reclamation for the old snapshots.
+    std::shared_ptr<const RealtimeParameters> realtimeParameters() const { return std::atomic_load(&currentRealtimeParameters); }
+
     void setDecayTime(double time);
     double getDecayTime();
 
@@ -408,6 +430,9 @@ private:
 
     int timerId;
 
+    std::shared_ptr<const RealtimeParameters> currentRealtimeParameters;  // Only accessed with std::atomic_load/atomic_store
+    void publishRealtimeParameters();
+
     int lastTimestamp;
 
     XMLInterface* globalSettingsInterface;
@@ -30,6 +30,7 @@
 
 #include <cmath>
 #include <cstring>
+#include <algorithm>
 #include "rhxglobals.h"
 #include "rhxdatablock.h"
 #include "waveformfifo.h"
@@ -42,6 +43,7 @@ WaveformFifo::WaveformFifo(SignalSources *signalSources_, int bufferSizeInDataBl
     maxWriteSizeInDataBlocks(maxWriteSizeInDataBlocks_),
     numReaders(NumberOfReaders)
 {
+    allocationCount = 0;
     if (numReaders < 1) {
         std::cerr << "WaveformFifo constructor: numReaders must be one or greater." << '\n';
         numReaders = 1;
@@ -65,6 +67,11 @@ WaveformFifo::WaveformFifo(SignalSources *signalSources_, int bufferSizeInDataBl
     bufferAllocateSizeInBlocks = bufferSizeInDataBlocks + maxWriteSizeInDataBlocks;
 
     usedWordsNewData = new Semaphore[numReaders];
+    spikeEventMask = 0;
+    spikeEventsPublished = 0;
+    samplesCommitted = 0;
+    spikeEventCursor.resize(numReaders);
+    readerSampleIndex.resize(numReaders);
     bufferReadIndex.resize(numReaders);
     bufferMemoryIndex.resize(numReaders);
     numWordsToBeRead.resize(numReaders);
@@ -92,6 +99,9 @@ void WaveformFifo::allocateAnalogBuffer(std::vector<float*> &bufferArray, const
     }
     bufferArray.push_back(buffer);
     analogWaveformIndices[waveName] = buffer;
+    if (buffer) {
+        analogPyramids[buffer].allocate(bufferSize, 1);
+    }
 }
 
 void WaveformFifo::allocateDigitalBuffer(std::vector<uint16_t*> &bufferArray, const std::string& waveName)
@@ -120,10 +130,21 @@ void WaveformFifo::allocateMemory()
     gpuAmplifierHighpassBuffer = nullptr;
     gpuSpikeTimestamps = nullptr;
     gpuSpikeIds = nullptr;
+    ++allocationCount;
+
+    // Room for one spike per channel per data block on average over the whole buffer (about 2% of the amplifier
+    // buffers); denser firing overruns the ring and readers fall back to the rasters for the overrun range.
+    uint64_t spikeEventCapacity = 1024;
+    while (spikeEventCapacity < (uint64_t) bufferAllocateSizeInBlocks * numAmplifierChannels) spikeEventCapacity <<= 1;
+
+    // Highpass statistics keep per-block history for the buffer's time span, capped at MaxStatisticsHistoryBlocks.
+    int statisticsHistoryBlocks = std::min(memorySizeInDataBlocks, (int) MaxStatisticsHistoryBlocks);
 
     memoryNeededGB = (sizeof(uint32_t) * bufferAllocateSize +
                       3 * sizeof(uint16_t) * bufferAllocateSize * numAmplifierChannels +
-                      (sizeof(uint32_t) + sizeof(uint8_t)) * bufferAllocateSizeInBlocks * numAmplifierChannels * maxSpikesPerDataBlock) /
+                      (sizeof(uint32_t) + sizeof(uint8_t)) * bufferAllocateSizeInBlocks * numAmplifierChannels * maxSpikesPerDataBlock +
+                      sizeof(StoredSpikeEvent) * spikeEventCapacity +
+                      (sizeof(double) + sizeof(uint32_t) + 2 * (sizeof(uint64_t) + sizeof(float))) * statisticsHistoryBlocks * numAmplifierChannels) /
                      (1024.0 * 1024.0 * 1024.0);
 
     memoryAllocated = true;
@@ -134,6 +155,9 @@ void WaveformFifo::allocateMemory()
         gpuAmplifierHighpassBuffer = new uint16_t [bufferAllocateSize * numAmplifierChannels];
         gpuSpikeTimestamps = new uint32_t [bufferAllocateSizeInBlocks * numAmplifierChannels * maxSpikesPerDataBlock];
         gpuSpikeIds = new uint8_t [bufferAllocateSizeInBlocks * numAmplifierChannels * maxSpikesPerDataBlock];
+        spikeEvents.assign(spikeEventCapacity, StoredSpikeEvent());
+        spikeEventMask = spikeEventCapacity - 1;
+        highpassStats.allocate(numAmplifierChannels, samplesPerDataBlock, statisticsHistoryBlocks);
     } catch (std::bad_alloc&) {
         memoryAllocated = false;
         std::cerr << "WaveformFifo::allocateMemory(): unable to allocate " << memoryNeededGB << " GB of memory." << '\n';
@@ -147,8 +171,13 @@ void WaveformFifo::allocateMemory()
         std::cerr << "WaveformFifo::allocateMemory(): unable to allocate GPU spike detector output buffer memory." << '\n';
     }
 
+    gpuWidebandPyramid.allocate(bufferSize, numAmplifierChannels);
+    gpuLowpassPyramid.allocate(bufferSize, numAmplifierChannels);
+    gpuHighpassPyramid.allocate(bufferSize, numAmplifierChannels);
+
     allocateDigitalBuffer(boardDigInWordBuffer, "DIGITAL-IN-WORD");
     allocateDigitalBuffer(boardDigOutWordBuffer, "DIGITAL-OUT-WORD");
+    spikeRasterByChannel.assign(numAmplifierChannels, nullptr);
 
     int channelsPerStream = RHXDataBlock::channelsPerStream(signalSources->getControllerType());
     int gpuWaveformIndex = 0;
@@ -165,6 +194,9 @@ void WaveformFifo::allocateMemory()
                 gpuWaveformAddresses[waveName + "|HIGH"] = { GpuWaveformHighpass, gpuWaveformIndex };
                 gpuWaveformAddresses[waveName + "|SPK"] = { GpuWaveformSpike, gpuWaveformIndex };
                 allocateDigitalBuffer(amplifierSpikeBuffer, waveName + "|SPK");
+                if (gpuWaveformIndex < numAmplifierChannels) {
+                    spikeRasterByChannel[gpuWaveformIndex] = amplifierSpikeBuffer.back();
+                }
                 if (signalSources->getControllerType() == ControllerStimRecord) {
                     allocateAnalogBuffer(dcAmplifierBuffer, waveName + "|DC");
                     allocateDigitalBuffer(stimFlagsBuffer, waveName + "|STIM");
@@ -206,6 +238,15 @@ void WaveformFifo::freeMemory()
 
     delete [] gpuSpikeTimestamps;
     delete [] gpuSpikeIds;
+    std::vector<StoredSpikeEvent>().swap(spikeEvents);
+    spikeEventMask = 0;
+    spikeRasterByChannel.clear();
+    highpassStats.release();
+
+    gpuWidebandPyramid.release();
+    gpuLowpassPyramid.release();
+    gpuHighpassPyramid.release();
+    analogPyramids.clear();
 
     for (std::map<std::string, float*>::const_iterator i = analogWaveformIndices.begin(); i != analogWaveformIndices.end(); ++i) {
         delete [] i->second;
@@ -238,6 +279,7 @@ void WaveformFifo::commitNewData()
 {
     std::lock_guard<std::mutex> lock(mtx);
 
+    int writeStartIndex = bufferWriteIndex;
     bufferWriteIndex += numWordsToBeWritten;
     if (bufferWriteIndex == bufferSize) {
         bufferWriteIndex = 0;
@@ -259,7 +301,7 @@ void WaveformFifo::commitNewData()
         uint16_t* digitalWaveformBuffer = nullptr;
         for (std::map<std::string, uint16_t*>::const_iterator i = digitalWaveformIndices.begin(); i != digitalWaveformIndices.end(); ++i) {
             digitalWaveformBuffer = i->second;
-            std::memcpy(digitalWaveformBuffer, &digitalWaveformBuffer[bufferSize], sizeof(float) * (bufferWriteIndex - bufferSize));
+            std::memcpy(digitalWaveformBuffer, &digitalWaveformBuffer[bufferSize], sizeof(uint16_t) * (bufferWriteIndex - bufferSize));
         }
 
         std::memcpy(gpuAmplifierWidebandBuffer, &gpuAmplifierWidebandBuffer[bufferSize * numAmplifierChannels],
@@ -271,11 +313,53 @@ void WaveformFifo::commitNewData()
 
         bufferWriteIndex -= bufferSize;
     }
+
+    // The written range is still contiguous at writeStartIndex (the overhang was copied, not moved).  Each new
+    // spike is counted with the block it falls in; those in the block before this write go with the first block.
+    int numBlocksWritten = numWordsToBeWritten / samplesPerDataBlock;
+    for (int block = 0; block < numBlocksWritten; ++block) {
+        for (const StoredSpikeEvent& e : newSpikeEvents) {
+            int64_t eventBlock = (e.sample - samplesCommitted) / samplesPerDataBlock;
+            if (eventBlock < 0) eventBlock = 0;
+            if (eventBlock > numBlocksWritten - 1) eventBlock = numBlocksWritten - 1;
+            if (eventBlock == block && e.spikeId != SpikeIdLikelyArtifact) highpassStats.addSpike(e.channel);
+        }
+        highpassStats.addDataBlock(&gpuAmplifierHighpassBuffer[(size_t) (writeStartIndex + block * samplesPerDataBlock) *
+                                                               numAmplifierChannels]);
+    }
+
+    // Spikes before the last block just written are now final; publish them with the new data.
+    pendingSpikeEvents.insert(pendingSpikeEvents.end(), newSpikeEvents.begin(), newSpikeEvents.end());
+    newSpikeEvents.clear();
+    publishSpikeEvents(samplesCommitted + numWordsToBeWritten - samplesPerDataBlock);
+    samplesCommitted += numWordsToBeWritten;
+
+    // Bring min/max pyramids up to date before making the new data visible to readers.
+    if (writeStartIndex + numWordsToBeWritten > bufferSize) {
+        updateMinMaxPyramids(writeStartIndex, bufferSize - writeStartIndex);
+        updateMinMaxPyramids(0, bufferWriteIndex);
+    } else {
+        updateMinMaxPyramids(writeStartIndex, numWordsToBeWritten);
+    }
+
     for (int reader = 0; reader < numReaders; ++reader) {
         usedWordsNewData[reader].release(numWordsToBeWritten);
     }
 }
 
+void WaveformFifo::updateMinMaxPyramids(int startIndex, int numWords)
+{
+    if (numWords <= 0) return;
+
+    gpuWidebandPyramid.update(gpuAmplifierWidebandBuffer, startIndex, numWords);
+    gpuLowpassPyramid.update(gpuAmplifierLowpassBuffer, startIndex, numWords);
+    gpuHighpassPyramid.update(gpuAmplifierHighpassBuffer, startIndex, numWords);
+
+    for (std::map<const float*, MinMaxPyramid<float> >::iterator i = analogPyramids.begin(); i != analogPyramids.end(); ++i) {
+        i->second.update(i->first, startIndex, numWords);
+    }
+}
+
 bool WaveformFifo::requestReadNewData(Reader reader, int numWords, bool lastRead)
 {
     std::lock_guard<std::mutex> lock(mtx);
@@ -283,6 +367,9 @@ bool WaveformFifo::requestReadNewData(Reader reader, int numWords, bool lastRead
     int necessaryData = lastRead ? numWords : numWords + samplesPerDataBlock; // Add one data block to allow spike detection
                                                                               // pipeline to complete (as long as this isn't the
                                                                               // last data block in a playback recording session).
+    if (lastRead) {
+        publishSpikeEvents(samplesCommitted);   // no following block will complete the last one's events
+    }
     if (usedWordsNewData[reader].available() >= necessaryData) {
         if (usedWordsNewData[reader].tryAcquire(numWords)) {
             numWordsToBeRead[reader] = numWords;
@@ -313,10 +400,7 @@ MinMax<float> WaveformFifo::getMinMaxData(Reader reader, const float* waveform,
     int index = bufferReadIndex[reader] + timeIndex;
     if (index < 0) index += bufferSize;
     else if (index >= bufferSize) index -= bufferSize;
-    for (int i = 0; i < numSamples; ++i) {
-        result.update(waveform[index]);
-        if (++index == bufferSize) index = 0;
-    }
+    updateMinMaxAnalog(result, waveform, index, numSamples);
     return result;
 }
 
@@ -331,22 +415,51 @@ void WaveformFifo::getMinMaxGpuAmplifierData(MinMax<float> &init, Reader reader,
     int index = bufferReadIndex[reader] + timeIndex;
     if (index < 0) index += bufferSize;
     else if (index >= bufferSize) index -= bufferSize;
-    int channelIndex = waveformAddress.waveformIndex;
+    const MinMaxPyramid<uint16_t>* pyramid = nullptr;
+    const uint16_t* buffer = nullptr;
     if (waveformAddress.waveformType == GpuWaveformWideband) {
-        for (int i = 0; i < numSamples; ++i) {
-            init.update(0.195F * (((float) gpuAmplifierWidebandBuffer[numAmplifierChannels * index + channelIndex]) - 32768.0F));
-            if (++index == bufferSize) index = 0;
-        }
+        pyramid = &gpuWidebandPyramid;
+        buffer = gpuAmplifierWidebandBuffer;
     } else if (waveformAddress.waveformType == GpuWaveformLowpass) {
-        for (int i = 0; i < numSamples; ++i) {
-            init.update(0.195F * (((float) gpuAmplifierLowpassBuffer[numAmplifierChannels * index + channelIndex]) - 32768.0F));
-            if (++index == bufferSize) index = 0;
-        }
+        pyramid = &gpuLowpassPyramid;
+        buffer = gpuAmplifierLowpassBuffer;
     } else if (waveformAddress.waveformType == GpuWaveformHighpass) {
-        for (int i = 0; i < numSamples; ++i) {
-            init.update(0.195F * (((float) gpuAmplifierHighpassBuffer[numAmplifierChannels * index + channelIndex]) - 32768.0F));
-            if (++index == bufferSize) index = 0;
-        }
+        pyramid = &gpuHighpassPyramid;
+        buffer = gpuAmplifierHighpassBuffer;
+    } else {
+        return;
+    }
+
+    // Raw codes map monotonically to microvolts, so the min/max can be found on raw codes and converted once.
+    MinMax<uint16_t> raw;
+    pyramid->getMinMax(raw, buffer, waveformAddress.waveformIndex, index, numSamples);
+    if (numSamples > 0) {
+        init.update(0.195F * (((float) raw.minVal) - 32768.0F));
+        init.update(0.195F * (((float) raw.maxVal) - 32768.0F));
+    }
+}
+
+void WaveformFifo::getMinMaxGpuAmplifierDataArrayRaw(MinMax<uint16_t>* init, Reader reader, GpuWaveformType waveformType,
+                                                     const std::vector<int>& waveformIndices, int timeIndex, int numSamples) const
+{
+    if (timeIndex + numSamples > numWordsToBeRead[reader] || timeIndex < -numWordsInMemory(reader)) {
+        std::cerr << "Error: WaveformFifo::getMinMaxGpuAmplifierDataArrayRaw: timeIndex out of range.  timeIndex = " << timeIndex <<
+             "; numSamples = " << numSamples << '\n';
+        return;
+    }
+
+    int index = bufferReadIndex[reader] + timeIndex;
+    if (index < 0) index += bufferSize;
+    else if (index >= bufferSize) index -= bufferSize;
+    if (waveformType == GpuWaveformWideband) {
+        gpuWidebandPyramid.getMinMaxArray(init, gpuAmplifierWidebandBuffer, waveformIndices.data(), (int) waveformIndices.size(),
+                                          index, numSamples);
+    } else if (waveformType == GpuWaveformLowpass) {
+        gpuLowpassPyramid.getMinMaxArray(init, gpuAmplifierLowpassBuffer, waveformIndices.data(), (int) waveformIndices.size(),
+                                         index, numSamples);
+    } else if (waveformType == GpuWaveformHighpass) {
+        gpuHighpassPyramid.getMinMaxArray(init, gpuAmplifierHighpassBuffer, waveformIndices.data(), (int) waveformIndices.size(),
+                                          index, numSamples);
     }
 }
 
@@ -361,6 +474,16 @@ void WaveformFifo::getMinMaxData(MinMax<float> &init, Reader reader, const float
     int index = bufferReadIndex[reader] + timeIndex;
     if (index < 0) index += bufferSize;
     else if (index >= bufferSize) index -= bufferSize;
+    updateMinMaxAnalog(init, waveform, index, numSamples);
+}
+
+void WaveformFifo::updateMinMaxAnalog(MinMax<float> &init, const float* waveform, int index, int numSamples) const
+{
+    std::map<const float*, MinMaxPyramid<float> >::const_iterator p = analogPyramids.find(waveform);
+    if (p != analogPyramids.end()) {
+        p->second.getMinMax(init, waveform, 0, index, numSamples);
+        return;
+    }
     for (int i = 0; i < numSamples; ++i) {
         init.update(waveform[index]);
         if (++index == bufferSize) index = 0;
@@ -406,69 +529,166 @@ uint16_t WaveformFifo::getRasterData(Reader reader, const uint16_t* rasterData,
     return result;
 }
 
-bool WaveformFifo::extractGpuSpikeDataOneDataBlock(uint16_t* waveform, GpuWaveformAddress waveformAddress, bool firstTime) const
+// Move pending spike events before beforeSample into the ring, in time order.  Call with mtx held.
+void WaveformFifo::publishSpikeEvents(int64_t beforeSample)
+{
+    if (pendingSpikeEvents.empty() || spikeEvents.empty()) return;
+
+    std::vector<StoredSpikeEvent>::iterator ready =
+            std::partition(pendingSpikeEvents.begin(), pendingSpikeEvents.end(),
+                           [beforeSample](const StoredSpikeEvent& e) { return e.sample < beforeSample; });
+    std::sort(pendingSpikeEvents.begin(), ready, [](const StoredSpikeEvent& a, const StoredSpikeEvent& b) {
+        return a.sample < b.sample || (a.sample == b.sample && a.channel < b.channel);
+    });
+
+    uint64_t published = spikeEventsPublished.load(std::memory_order_relaxed);
+    for (std::vector<StoredSpikeEvent>::iterator e = pendingSpikeEvents.begin(); e != ready; ++e) {
+        spikeEvents[published++ & spikeEventMask] = *e;
+    }
+    spikeEventsPublished.store(published, std::memory_order_release);
+    pendingSpikeEvents.erase(pendingSpikeEvents.begin(), ready);
+}
+
+void WaveformFifo::getSpikeEvents(Reader reader, std::vector<SpikeEvent>& events, int timeIndex, int numSamples,
+                                  int channel) const
+{
+    events.clear();
+    if (timeIndex + numSamples > numWordsToBeRead[reader] || timeIndex < -numWordsInMemory(reader)) {
+        std::cerr << "Error: WaveformFifo::getSpikeEvents: timeIndex out of range.  timeIndex = " << timeIndex <<
+             "; numSamples = " << numSamples << '\n';
+        return;
+    }
+    if (spikeEvents.empty()) return;
+
+    int64_t base = readerSampleIndex[reader];
+    int64_t start = base + timeIndex;
+    int64_t end = start + numSamples;
+    uint64_t capacity = spikeEventMask + 1;
+    uint64_t published = spikeEventsPublished.load(std::memory_order_acquire);
+    uint64_t oldest = published > capacity ? published - capacity : 0;
+
+    // The cursor sits at the first event of the read window; step back for reads into memory.
+    uint64_t first = std::max(spikeEventCursor[reader], oldest);
+    while (first > oldest && spikeEvents[(first - 1) & spikeEventMask].sample >= start) {
+        --first;
+    }
+    // Stopping at the oldest slot of a lapped ring means earlier events of the window may have been overwritten.
+    bool complete = first == 0 || first > oldest;
+
+    for (uint64_t i = first; i < published; ++i) {
+        const StoredSpikeEvent& e = spikeEvents[i & spikeEventMask];
+        if (e.sample >= end) break;
+        if (channel < 0 || e.channel == channel) {
+            events.push_back({ (int) (e.sample - base), e.timeStamp, (int) e.channel, e.spikeId });
+        }
+    }
+
+    // If the writer lapped the ring while we were reading (or before), the raster is the only complete record.
+    uint64_t publishedAfter = spikeEventsPublished.load(std::memory_order_acquire);
+    if (!complete || publishedAfter - first > capacity) {
+        getSpikeEventsFromRasters(reader, events, timeIndex, numSamples, channel);
+    }
+}
+
+void WaveformFifo::getSpikeEventsFromRasters(Reader reader, std::vector<SpikeEvent>& events, int timeIndex, int numSamples,
+                                             int channel) const
+{
+    events.clear();
+    int firstChannel = channel < 0 ? 0 : channel;
+    int lastChannel = channel < 0 ? (int) spikeRasterByChannel.size() - 1 : channel;
+    for (int c = firstChannel; c <= lastChannel && c < (int) spikeRasterByChannel.size(); ++c) {
+        const uint16_t* raster = spikeRasterByChannel[c];
+        if (!raster) continue;
+        for (int t = timeIndex; t < timeIndex + numSamples; ++t) {
+            uint16_t spikeId = getDigitalData(reader, raster, t);
+            if (spikeId != SpikeIdNoSpike) {
+                events.push_back({ t, getTimeStamp(reader, t), c, (uint8_t) spikeId });
+            }
+        }
+    }
+    std::stable_sort(events.begin(), events.end(), [](const SpikeEvent& a, const SpikeEvent& b) {
+        return a.timeIndex < b.timeIndex;
+    });
+}
+
+bool WaveformFifo::extractGpuSpikeData(uint16_t* waveform, GpuWaveformAddress waveformAddress, int numDataBlocks,
+                                       bool firstTime)
 {
     bool spikeFound = false;
     if (waveformAddress.waveformType != GpuWaveformSpike) {
-        std::cerr << "Error: WaveformFifo::extractGpuSpikeDataOneDataBlock: waveform is not GpuWaveformSpike type." << '\n';
+        std::cerr << "Error: WaveformFifo::extractGpuSpikeData: waveform is not GpuWaveformSpike type." << '\n';
         return spikeFound;
     }
     if (bufferWriteIndex % samplesPerDataBlock != 0) {
-        std::cerr << "Error: WaveformFifo::extractGpuSpikeDataOneDataBlock: bufferWriteIndex is not an integer multiple of samplesPerDataBlock." << '\n';
+        std::cerr << "Error: WaveformFifo::extractGpuSpikeData: bufferWriteIndex is not an integer multiple of samplesPerDataBlock." << '\n';
         return spikeFound;
     }
 
-    int bufferWriteIndexPrev = bufferWriteIndex - samplesPerDataBlock;
-    if (bufferWriteIndexPrev < 0) bufferWriteIndexPrev += bufferSize;
-
-    // Read GPU spike detector output data and create lists of spike IDs along with corresponding timestamps.
     std::vector<uint32_t> spikeTimeStampList;
     std::vector<uint16_t> spikeIdList;
     uint32_t spikeTimeStamp;
     uint8_t spikeId;
-    int bufferWriteIndexBlock = bufferWriteIndex / samplesPerDataBlock;
-    int index = bufferWriteIndexBlock * numAmplifierChannels * maxSpikesPerDataBlock + waveformAddress.waveformIndex;
-    for (int k = 0; k < maxSpikesPerDataBlock; ++k) {
-        spikeId = gpuSpikeIds[index];
-        if (spikeId != SpikeIdNoSpike) {
-            spikeTimeStamp = gpuSpikeTimestamps[index];
-            spikeFound = true;
-            // cout << "found spike " << (int) spikeId << " at timestamp " << spikeTimeStamp << " in channel " << waveformAddress.waveformIndex << EndOfLine;
-            spikeTimeStampList.push_back(spikeTimeStamp);
-            spikeIdList.push_back((uint16_t) spikeId);
-        }
-        index += numAmplifierChannels;
-        if (index >= bufferAllocateSizeInBlocks * numAmplifierChannels * maxSpikesPerDataBlock) {
-            std::cerr << "Error!  Indexing outside of GPU spike timestamp allocated memory."  << '\n';
-        }
-    }
-
-    // Initialize spike output to all zeros (i.e., no spikes)
-    for (int i = bufferWriteIndex; i < bufferWriteIndex + samplesPerDataBlock; ++i) {
-        waveform[i]= 0;
-    }
 
-    for (int j = 0; j < (int) spikeTimeStampList.size(); ++j) {
-        bool found = false;
-        // First, search for spike timestamp in current datablock.
-        for (int i = bufferWriteIndex; i < bufferWriteIndex + samplesPerDataBlock; ++i) {
-            if (timeStampBuffer[i] == spikeTimeStampList[j]) {
-                found = true;
-                waveform[i] = spikeIdList[j];
-                break;
+    // Blocks of one write are contiguous from bufferWriteIndex (running past bufferSize into the overhang if
+    // necessary), and each block's spikes may land in the block before it.
+    for (int block = 0; block < numDataBlocks; ++block) {
+        int blockWriteIndex = bufferWriteIndex + block * samplesPerDataBlock;
+        int blockWriteIndexPrev = blockWriteIndex - samplesPerDataBlock;
+        if (blockWriteIndexPrev < 0) blockWriteIndexPrev += bufferSize;
+        int64_t blockSample = samplesCommitted + block * samplesPerDataBlock;
+        bool firstBlock = firstTime && block == 0;
+
+        // Read GPU spike detector output data and create lists of spike IDs along with corresponding timestamps.
+        spikeTimeStampList.clear();
+        spikeIdList.clear();
+        int index = (blockWriteIndex / samplesPerDataBlock) * numAmplifierChannels * maxSpikesPerDataBlock +
+                waveformAddress.waveformIndex;
+        for (int k = 0; k < maxSpikesPerDataBlock; ++k) {
+            spikeId = gpuSpikeIds[index];
+            if (spikeId != SpikeIdNoSpike) {
+                spikeTimeStamp = gpuSpikeTimestamps[index];
+                spikeFound = true;
+                spikeTimeStampList.push_back(spikeTimeStamp);
+                spikeIdList.push_back((uint16_t) spikeId);
+            }
+            index += numAmplifierChannels;
+            if (index >= bufferAllocateSizeInBlocks * numAmplifierChannels * maxSpikesPerDataBlock) {
+                std::cerr << "Error!  Indexing outside of GPU spike timestamp allocated memory."  << '\n';
             }
         }
-        if (!found && !firstTime) {   // If we don't find timestamp in current datablock, search previous datablock.
-            for (int i = bufferWriteIndexPrev + samplesPerDataBlock - 1; i >= bufferWriteIndexPrev; --i) {
+
+        // Initialize spike output to all zeros (i.e., no spikes)
+        for (int i = blockWriteIndex; i < blockWriteIndex + samplesPerDataBlock; ++i) {
+            waveform[i]= 0;
+        }
+
+        for (int j = 0; j < (int) spikeTimeStampList.size(); ++j) {
+            bool found = false;
+            // First, search for spike timestamp in current datablock.
+            for (int i = blockWriteIndex; i < blockWriteIndex + samplesPerDataBlock; ++i) {
                 if (timeStampBuffer[i] == spikeTimeStampList[j]) {
                     found = true;
                     waveform[i] = spikeIdList[j];
+                    newSpikeEvents.push_back({ blockSample + (i - blockWriteIndex), spikeTimeStampList[j],
+                                               (uint16_t) waveformAddress.waveformIndex, (uint8_t) spikeIdList[j] });
                     break;
                 }
             }
-        }
-        if (!found && !firstTime) {
-            std::cout << "Error:: WaveformFifo::extractGpuSpikeDataOneDataBlock: timestamp " << spikeTimeStampList[j] << " not found!" << '\n';
+            if (!found && !firstBlock) {   // If we don't find timestamp in current datablock, search previous datablock.
+                for (int i = blockWriteIndexPrev + samplesPerDataBlock - 1; i >= blockWriteIndexPrev; --i) {
+                    if (timeStampBuffer[i] == spikeTimeStampList[j]) {
+                        found = true;
+                        waveform[i] = spikeIdList[j];
+                        newSpikeEvents.push_back({ blockSample - samplesPerDataBlock + (i - blockWriteIndexPrev),
+                                                   spikeTimeStampList[j], (uint16_t) waveformAddress.waveformIndex,
+                                                   (uint8_t) spikeIdList[j] });
+                        break;
+                    }
+                }
+            }
+            if (!found && !firstBlock) {
+                std::cout << "Error:: WaveformFifo::extractGpuSpikeData: timestamp " << spikeTimeStampList[j] << " not found!" << '\n';
+            }
         }
     }
     return spikeFound;
@@ -731,6 +951,54 @@ void WaveformFifo::copyTimeStamps(Reader reader, uint32_t* dest, int timeIndex,
     }
 }
 
+int WaveformFifo::getSpanIndices(Reader reader, int timeIndex, int numSamples, int spanStart[2], int spanSamples[2]) const
+{
+    if (timeIndex + numSamples > numWordsToBeRead[reader] || timeIndex < -numWordsInMemory(reader)) {
+        std::cerr << "Error: WaveformFifo::getSpanIndices: timeIndex out of range." << '\n';
+        return 0;
+    }
+
+    int index = bufferReadIndex[reader] + timeIndex;
+    if (index < 0) index += bufferSize;
+    else if (index >= bufferSize) index -= bufferSize;
+    spanStart[0] = index;
+    spanSamples[0] = std::min(numSamples, bufferSize - index);
+    if (spanSamples[0] == numSamples) return 1;
+    spanStart[1] = 0;
+    spanSamples[1] = numSamples - spanSamples[0];
+    return 2;
+}
+
+int WaveformFifo::getTimeStampSpans(Reader reader, int timeIndex, int numSamples, const uint32_t* spans[2], int spanSamples[2]) const
+{
+    int spanStart[2];
+    int numSpans = getSpanIndices(reader, timeIndex, numSamples, spanStart, spanSamples);
+    for (int i = 0; i < numSpans; ++i) {
+        spans[i] = &timeStampBuffer[spanStart[i]];
+    }
+    return numSpans;
+}
+
+int WaveformFifo::getGpuAmplifierSpans(Reader reader, GpuWaveformType waveformType, int timeIndex, int numSamples,
+                                       const uint16_t* spans[2], int spanSamples[2]) const
+{
+    const uint16_t* buffer;
+    if (waveformType == GpuWaveformWideband) buffer = gpuAmplifierWidebandBuffer;
+    else if (waveformType == GpuWaveformLowpass) buffer = gpuAmplifierLowpassBuffer;
+    else if (waveformType == GpuWaveformHighpass) buffer = gpuAmplifierHighpassBuffer;
+    else {
+        std::cerr << "Error: WaveformFifo::getGpuAmplifierSpans: waveform type has no amplifier buffer." << '\n';
+        return 0;
+    }
+
+    int spanStart[2];
+    int numSpans = getSpanIndices(reader, timeIndex, numSamples, spanStart, spanSamples);
+    for (int i = 0; i < numSpans; ++i) {
+        spans[i] = &buffer[spanStart[i] * numAmplifierChannels];
+    }
+    return numSpans;
+}
+
 // Call once after all reading is complete.
 void WaveformFifo::freeOldData(Reader reader)
 {
@@ -752,6 +1020,15 @@ void WaveformFifo::freeOldData(Reader reader)
     if (bufferReadIndex[reader] >= bufferSize) {
         bufferReadIndex[reader] -= bufferSize;
     }
+    readerSampleIndex[reader] += numWordsToBeRead[reader];
+    uint64_t published = spikeEventsPublished.load(std::memory_order_relaxed);
+    uint64_t& cursor = spikeEventCursor[reader];
+    if (published - cursor > spikeEventMask + 1) {
+        cursor = published - (spikeEventMask + 1);
+    }
+    while (cursor < published && spikeEvents[cursor & spikeEventMask].sample < readerSampleIndex[reader]) {
+        ++cursor;
+    }
     int excess = numWordsInMemory(reader) - memorySize;
     if (excess > 0) {
         bufferMemoryIndex[reader] += excess;
@@ -809,7 +1086,12 @@ void WaveformFifo::resetBuffer()
         bufferReadIndex[reader] = 0;
         bufferMemoryIndex[reader] = 0;
         numWordsToBeRead[reader] = 0;
+        // The processing thread may still be queuing spike events, so sample and event counts keep running;
+        // readers just skip everything before this point.
+        spikeEventCursor[reader] = spikeEventsPublished.load(std::memory_order_relaxed);
+        readerSampleIndex[reader] = samplesCommitted;
     }
+    highpassStats.requestReset();   // done by the processing thread, the statistics' only writer
     bufferWriteIndex = 0;
     numWordsToBeWritten = 0;
     freeWords.release(bufferSize);
@@ -817,6 +1099,10 @@ void WaveformFifo::resetBuffer()
 
 void WaveformFifo::pauseBuffer()
 {
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        publishSpikeEvents(samplesCommitted);   // readers drain the last block too
+    }
     for (int reader = 0; reader < numReaders; ++reader) {
         requestReadNewData((Reader) reader, usedWordsNewData[reader].available() - samplesPerDataBlock);
         // Subtract one data block to compensate for data block added for spike detection pipeline (see requestReadNewData()).
@@ -36,8 +36,11 @@
 #include <map>
 #include <vector>
 #include <mutex>
+#include <atomic>
 #include "semaphore.h"
 #include "minmax.h"
+#include "minmaxpyramid.h"
+#include "channelstatistics.h"
 #include "signalsources.h"
 
 // Multi-waveform FIFO implemented as a circular buffer.  Additional buffer space is allocated
@@ -47,6 +50,13 @@
 //
 // The buffer also has a "memory" that maintains a specified number of old data words from
 // previous writes.
+//
+// Amplifier and analog waveforms are shadowed by min/max pyramids (see minmaxpyramid.h) that are
+// updated as each write is committed, so min/max queries over long time spans (used to draw one
+// display column) cost roughly the number of pyramid bins touched rather than the number of samples.
+//
+// Detected spikes are also published as a sparse, time-ordered event stream next to the dense |SPK
+// rasters, so spike consumers visit only the spikes instead of every sample of every channel.
 
 enum GpuWaveformType {
     GpuWaveformWideband,
@@ -61,6 +71,15 @@ struct GpuWaveformAddress
     int waveformIndex;
 };
 
+// One detected spike, as returned by WaveformFifo::getSpikeEvents()
+struct SpikeEvent
+{
+    int timeIndex;          // position in the reader's window, as used by getDigitalData() etc.
+    uint32_t timeStamp;
+    int channel;            // GpuWaveformAddress::waveformIndex of the channel
+    uint8_t spikeId;
+};
+
 const uint8_t SpikeIdNoSpike = 0x00u;
 const uint8_t SpikeIdSpikeType1 = 0x01u;
 const uint8_t SpikeIdSpikeType2 = 0x02u;
@@ -125,7 +144,10 @@ public:
         return &gpuSpikeIds[(bufferWriteIndex/samplesPerDataBlock) * numAmplifierChannels * maxSpikesPerDataBlock];
     }
 
-    bool extractGpuSpikeDataOneDataBlock(uint16_t* waveform, GpuWaveformAddress waveformAddress, bool firstTime) const;
+    // Spike detector output of the numDataBlocks blocks being written. Also queues the spike events that are
+    // published when the following data block is committed (a spike may be placed in the previous block, so a
+    // block's events are final only once the following block is processed).
+    bool extractGpuSpikeData(uint16_t* waveform, GpuWaveformAddress waveformAddress, int numDataBlocks, bool firstTime);
 
     inline uint32_t* pointerToTimeStampWriteSpace() const
     {
@@ -219,12 +241,34 @@ public:
     void copyDigitalDataArray(Reader reader, uint16_t* dest, const std::vector<uint16_t*>& waveforms, int timeIndex, int numSamples) const;
     void copyTimeStamps(Reader reader, uint32_t* dest, int timeIndex, int numSamples) const;
 
+    // Direct (read-only) access to FIFO memory for zero-copy output.  Each function returns the number of contiguous
+    // spans (1, or 2 if the range wraps around the end of the circular buffer) covering numSamples samples starting at
+    // timeIndex.  GPU amplifier spans hold all amplifier channels for each sample ([sample][channel] layout).
+    int getTimeStampSpans(Reader reader, int timeIndex, int numSamples, const uint32_t* spans[2], int spanSamples[2]) const;
+    int getGpuAmplifierSpans(Reader reader, GpuWaveformType waveformType, int timeIndex, int numSamples,
+                             const uint16_t* spans[2], int spanSamples[2]) const;
+    int getNumAmplifierChannels() const { return numAmplifierChannels; }
+
     MinMax<float> getMinMaxData(Reader reader, const float* waveform, int timeIndex, int numSamples) const;
     void getMinMaxGpuAmplifierData(MinMax<float> &init, Reader reader, GpuWaveformAddress waveformAddress, int timeIndex, int numSamples) const;
+    // Raw-code min/max of several GPU amplifier waveforms of one filter type over the same range; init[j] receives
+    // waveformIndices[j].  Uses the same pyramid query as getMinMaxGpuAmplifierData().
+    void getMinMaxGpuAmplifierDataArrayRaw(MinMax<uint16_t>* init, Reader reader, GpuWaveformType waveformType,
+                                           const std::vector<int>& waveformIndices, int timeIndex, int numSamples) const;
     void getMinMaxData(MinMax<float> &init, Reader reader,  const float* waveform, int timeIndex, int numSamples) const;
     uint16_t getStimData(Reader reader, const uint16_t* stimFlags, int timeIndex, int numSamples) const;
     uint16_t getRasterData(Reader reader, const uint16_t* rasterData, int timeIndex, int numSamples) const;
 
+    // Spike events (of one channel, or of all channels if channel < 0) between timeIndex and timeIndex + numSamples,
+    // in time order; replaces events.  Same timeIndex range as getDigitalData().  Cost is proportional to the number
+    // of spikes; if the event ring has overrun the range, the events are rebuilt from the |SPK rasters instead.
+    void getSpikeEvents(Reader reader, std::vector<SpikeEvent>& events, int timeIndex, int numSamples, int channel = -1) const;
+
+    // Sliding-window RMS, spike count, and min/max of every amplifier channel's highpass signal, indexed by GPU
+    // waveform index.  Updated at each commitNewData(), so it reflects the newest data rather than any reader's
+    // position; readable from any thread without calling requestReadNewData().
+    const ChannelStatistics* highpassStatistics() const { return &highpassStats; }
+
     // 3:
     void freeOldData(Reader reader); // Call once after all reading is complete.
 
@@ -243,6 +287,9 @@ public:
 
     bool memoryWasAllocated(double& memoryRequestedGB) const { memoryRequestedGB += memoryNeededGB; return memoryAllocated; }
 
+    // Incremented every time waveform buffers are (re)allocated; pointers cached by readers are stale once this changes.
+    int getAllocationCount() const { return allocationCount; }
+
 private:
     SystemState *state;
     std::mutex mtx;
@@ -310,13 +357,49 @@ private:
     std::map<std::string, uint16_t*> digitalWaveformIndices;
     std::map<std::string, GpuWaveformAddress> gpuWaveformAddresses;
 
+    // Min/max caches over the GPU amplifier buffers and each analog waveform buffer
+    MinMaxPyramid<uint16_t> gpuWidebandPyramid;
+    MinMaxPyramid<uint16_t> gpuLowpassPyramid;
+    MinMaxPyramid<uint16_t> gpuHighpassPyramid;
+    std::map<const float*, MinMaxPyramid<float> > analogPyramids;
+
+    // Spike event ring, sorted by sample.  Events carry an absolute sample number (samples committed since
+    // resetBuffer()); each reader keeps a cursor at the first event of its current window.
+    struct StoredSpikeEvent
+    {
+        int64_t sample;
+        uint32_t timeStamp;
+        uint16_t channel;
+        uint8_t spikeId;
+    };
+    std::vector<StoredSpikeEvent> spikeEvents;
+    uint64_t spikeEventMask;
+    std::atomic<uint64_t> spikeEventsPublished;
+    std::vector<StoredSpikeEvent> pendingSpikeEvents;   // events of the block being written and the one before
+    std::vector<StoredSpikeEvent> newSpikeEvents;       // writer only: found by extractGpuSpikeData(), moved to
+                                                        // pendingSpikeEvents under mtx by commitNewData()
+    std::vector<uint64_t> spikeEventCursor;
+    std::vector<int64_t> readerSampleIndex;             // absolute sample at bufferReadIndex, per reader
+    int64_t samplesCommitted;
+    std::vector<uint16_t*> spikeRasterByChannel;         // |SPK raster per GPU waveform index, for ring overruns
+
+    static const int MaxStatisticsHistoryBlocks = 1024;  // ~4 s at 30 kS/s
+    ChannelStatistics highpassStats;
+
     bool memoryAllocated;
     double memoryNeededGB;
+    int allocationCount;
 
     void allocateAnalogBuffer(std::vector<float*> &bufferArray, const std::string& waveName);
     void allocateDigitalBuffer(std::vector<uint16_t*> &bufferArray, const std::string& waveName);
     void allocateMemory();
     void freeMemory();
+    void updateMinMaxPyramids(int startIndex, int numWords);
+    void updateMinMaxAnalog(MinMax<float> &init, const float* waveform, int index, int numSamples) const;
+    int getSpanIndices(Reader reader, int timeIndex, int numSamples, int spanStart[2], int spanSamples[2]) const;
+    void publishSpikeEvents(int64_t beforeSample);
+    void getSpikeEventsFromRasters(Reader reader, std::vector<SpikeEvent>& events, int timeIndex, int numSamples,
+                                   int channel) const;
 };
 
 #endif // WAVEFORMFIFO_H
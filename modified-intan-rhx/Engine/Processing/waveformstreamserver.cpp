@@ -0,0 +1,365 @@
+//------------------------------------------------------------------------------
+//
+//  Intan Technologies RHX Data Acquisition Software
+//  Version 3.4.0
+//
+//  Copyright (c) 2020-2025 Intan Technologies
+//
+//  This file is part of the Intan Technologies RHX Data Acquisition Software.
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published
+//  by the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//  This software is provided 'as-is', without any express or implied warranty.
+//  In no event will the authors be held liable for any damages arising from
+//  the use of this software.
+//
+//  See <http://www.intantech.com> for documentation and product information.
+//
+//------------------------------------------------------------------------------
+
+
+#include <cstring>
+#include <iostream>
+#include "waveformstreamserver.h"
+
+#ifndef _WIN32
+
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+#ifdef MSG_NOSIGNAL
+static const int SendFlags = MSG_DONTWAIT | MSG_NOSIGNAL;
+#else
+static const int SendFlags = MSG_DONTWAIT;  // SIGPIPE is suppressed per socket with SO_NOSIGPIPE instead.
+#endif
+
+static const int MaxFrameParts = 5;   // Header, up to two time stamp spans, up to two sample spans
+static const uint32_t MaxMaskBytes = 8192;
+
+WaveformStreamServer::WaveformStreamServer(int maxBacklogBytes_) :
+    listenSocket(-1),
+    maxBacklogBytes(maxBacklogBytes_),
+    totalDroppedFrames(0)
+{
+}
+
+WaveformStreamServer::~WaveformStreamServer()
+{
+    close();
+}
+
+bool WaveformStreamServer::listen(const std::string& address, int port)
+{
+    close();
+
+    listenSocket = socket(AF_INET, SOCK_STREAM, 0);
+    if (listenSocket < 0) {
+        std::cerr << "Error: WaveformStreamServer::listen: could not create socket." << '\n';
+        return false;
+    }
+    int reuse = 1;
+    setsockopt(listenSocket, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+    sockaddr_in socketAddress;
+    memset(&socketAddress, 0, sizeof(socketAddress));
+    socketAddress.sin_family = AF_INET;
+    socketAddress.sin_port = htons((uint16_t) port);
+    if (inet_pton(AF_INET, address.c_str(), &socketAddress.sin_addr) != 1) {
+        std::cerr << "Error: WaveformStreamServer::listen: invalid address " << address << '\n';
+        close();
+        return false;
+    }
+    if (bind(listenSocket, (sockaddr*) &socketAddress, sizeof(socketAddress)) < 0 || ::listen(listenSocket, 8) < 0) {
+        std::cerr << "Error: WaveformStreamServer::listen: could not listen on " << address << ":" << port << '\n';
+        close();
+        return false;
+    }
+    fcntl(listenSocket, F_SETFL, fcntl(listenSocket, F_GETFL, 0) | O_NONBLOCK);
+    return true;
+}
+
+void WaveformStreamServer::close()
+{
+    while (!subscribers.empty()) {
+        removeSubscriber((int) subscribers.size() - 1);
+    }
+    if (listenSocket >= 0) {
+        ::close(listenSocket);
+        listenSocket = -1;
+    }
+}
+
+void WaveformStreamServer::serviceConnections()
+{
+    if (listenSocket < 0) return;
+
+    acceptSubscribers();
+    for (int i = 0; i < (int) subscribers.size(); ) {
+        if (!readRequests(subscribers[i]) || !flushBacklog(subscribers[i])) {
+            removeSubscriber(i);
+        } else {
+            ++i;
+        }
+    }
+}
+
+void WaveformStreamServer::acceptSubscribers()
+{
+    while (true) {
+        int clientSocket = accept(listenSocket, nullptr, nullptr);
+        if (clientSocket < 0) return;   // No more pending connections (EAGAIN), or an error we retry next time.
+
+        fcntl(clientSocket, F_SETFL, fcntl(clientSocket, F_GETFL, 0) | O_NONBLOCK);
+        int enable = 1;
+        setsockopt(clientSocket, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+#ifdef SO_NOSIGPIPE
+        setsockopt(clientSocket, SOL_SOCKET, SO_NOSIGPIPE, &enable, sizeof(enable));
+#endif
+
+        Subscriber* subscriber = new Subscriber;
+        subscriber->socket = clientSocket;
+        subscriber->backlogOffset = 0;
+        subscriber->sequenceNumber = 0;
+        subscriber->droppedFrames = 0;
+        subscriber->subscribed = false;
+        subscribers.push_back(subscriber);
+        std::cout << "WaveformStreamServer: subscriber connected (" << subscribers.size() << " total)" << '\n';
+    }
+}
+
+// Read any pending subscription requests from this subscriber.  Returns false if the subscriber disconnected or sent
+// something that is not a subscription request.
+bool WaveformStreamServer::readRequests(Subscriber* subscriber)
+{
+    uint8_t buffer[1024];
+    while (true) {
+        ssize_t numBytes = recv(subscriber->socket, buffer, sizeof(buffer), MSG_DONTWAIT);
+        if (numBytes == 0) return false;
+        if (numBytes < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) break;
+            return false;
+        }
+        subscriber->request.insert(subscriber->request.end(), buffer, buffer + numBytes);
+    }
+
+    std::vector<uint8_t>& request = subscriber->request;
+    while (request.size() >= 2 * sizeof(uint32_t)) {
+        uint32_t magicNumber, numMaskBytes;
+        memcpy(&magicNumber, &request[0], sizeof(uint32_t));
+        memcpy(&numMaskBytes, &request[sizeof(uint32_t)], sizeof(uint32_t));
+        if (magicNumber != StreamSubscribeMagicNumber || numMaskBytes > MaxMaskBytes) {
+            std::cerr << "Error: WaveformStreamServer::readRequests: invalid subscription request." << '\n';
+            return false;
+        }
+        size_t requestBytes = 2 * sizeof(uint32_t) + numMaskBytes;
+        if (request.size() < requestBytes) break;
+
+        // Whether the mask selects every channel depends on the channel count, so that is decided per frame.
+        subscriber->subscribed = true;
+        subscriber->channels = channelsFromSubscriptionMask(&request[2 * sizeof(uint32_t)], numMaskBytes);
+        subscriber->addresses.clear();
+        request.erase(request.begin(), request.begin() + requestBytes);
+    }
+    return true;
+}
+
+// Send as much of this subscriber's backlog as its socket will take.  Returns false on a socket error.
+bool WaveformStreamServer::flushBacklog(Subscriber* subscriber)
+{
+    std::vector<char>& backlog = subscriber->backlog;
+    while (subscriber->backlogOffset < backlog.size()) {
+        ssize_t numBytes = send(subscriber->socket, &backlog[subscriber->backlogOffset],
+                                backlog.size() - subscriber->backlogOffset, SendFlags);
+        if (numBytes < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) break;
+            return false;
+        }
+        subscriber->backlogOffset += numBytes;
+    }
+
+    if (subscriber->backlogOffset == backlog.size()) {
+        backlog.clear();
+        subscriber->backlogOffset = 0;
+    } else if (subscriber->backlogOffset > backlog.size() / 2) {
+        backlog.erase(backlog.begin(), backlog.begin() + subscriber->backlogOffset);
+        subscriber->backlogOffset = 0;
+    }
+    return true;
+}
+
+// Send one frame, given as numParts memory ranges, to this subscriber.  Whatever the socket cannot take now is copied
+// to the subscriber's backlog.  Returns false on a socket error.
+bool WaveformStreamServer::sendOrQueue(Subscriber* subscriber, const void* const* parts, const size_t* partBytes, int numParts)
+{
+    size_t frameBytes = 0;
+    for (int i = 0; i < numParts; ++i) {
+        frameBytes += partBytes[i];
+    }
+
+    if (!flushBacklog(subscriber)) return false;
+
+    size_t numBytesSent = 0;
+    if (subscriber->backlog.empty()) {
+        iovec iov[MaxFrameParts];
+        for (int i = 0; i < numParts; ++i) {
+            iov[i].iov_base = const_cast<void*>(parts[i]);
+            iov[i].iov_len = partBytes[i];
+        }
+        msghdr message;
+        memset(&message, 0, sizeof(message));
+        message.msg_iov = iov;
+        message.msg_iovlen = numParts;
+        ssize_t result = sendmsg(subscriber->socket, &message, SendFlags);
+        if (result < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) return false;
+            result = 0;
+        }
+        numBytesSent = (size_t) result;
+        if (numBytesSent == frameBytes) return true;
+    } else if (subscriber->backlog.size() - subscriber->backlogOffset + frameBytes > (size_t) maxBacklogBytes) {
+        // Subscriber is too far behind; drop this frame.  (A partially sent frame, above, is always queued so that
+        // the stream never contains a truncated frame.)
+        ++subscriber->droppedFrames;
+        ++totalDroppedFrames;
+        return true;
+    }
+
+    for (int i = 0; i < numParts; ++i) {
+        if (numBytesSent >= partBytes[i]) {
+            numBytesSent -= partBytes[i];
+            continue;
+        }
+        const char* start = static_cast<const char*>(parts[i]) + numBytesSent;
+        subscriber->backlog.insert(subscriber->backlog.end(), start, static_cast<const char*>(parts[i]) + partBytes[i]);
+        numBytesSent = 0;
+    }
+    return true;
+}
+
+void WaveformStreamServer::sendFrame(const WaveformFifo* waveformFifo, WaveformFifo::Reader reader, int numSamples)
+{
+    if (subscribers.empty() || numSamples <= 0) return;
+
+    const uint32_t* timeStampSpans[2];
+    int timeStampSpanSamples[2];
+    int numTimeStampSpans = waveformFifo->getTimeStampSpans(reader, 0, numSamples, timeStampSpans, timeStampSpanSamples);
+    const uint16_t* sampleSpans[2];
+    int sampleSpanSamples[2];
+    int numSampleSpans = waveformFifo->getGpuAmplifierSpans(reader, GpuWaveformWideband, 0, numSamples, sampleSpans,
+                                                            sampleSpanSamples);
+    if (numTimeStampSpans == 0 || numSampleSpans == 0) return;
+    int numAmplifierChannels = waveformFifo->getNumAmplifierChannels();
+
+    for (int i = 0; i < (int) subscribers.size(); ) {
+        Subscriber* subscriber = subscribers[i];
+
+        StreamFrameHeader header;
+        header.magicNumber = StreamFrameMagicNumber;
+        header.sequenceNumber = subscriber->sequenceNumber++;
+        header.droppedFrames = subscriber->droppedFrames;
+        header.numSamples = (uint16_t) numSamples;
+
+        const void* parts[MaxFrameParts];
+        size_t partBytes[MaxFrameParts];
+        int numParts = 0;
+        parts[numParts] = &header;
+        partBytes[numParts++] = sizeof(header);
+        for (int span = 0; span < numTimeStampSpans; ++span) {
+            parts[numParts] = timeStampSpans[span];
+            partBytes[numParts++] = sizeof(uint32_t) * timeStampSpanSamples[span];
+        }
+
+        if (!subscriber->subscribed || selectsAllChannels(subscriber->channels, numAmplifierChannels)) {
+            // All channels: send straight from FIFO memory.
+            header.numChannels = (uint16_t) numAmplifierChannels;
+            for (int span = 0; span < numSampleSpans; ++span) {
+                parts[numParts] = sampleSpans[span];
+                partBytes[numParts++] = sizeof(uint16_t) * sampleSpanSamples[span] * numAmplifierChannels;
+            }
+        } else {
+            if (subscriber->addresses.empty()) {
+                for (int j = 0; j < (int) subscriber->channels.size(); ++j) {
+                    if (subscriber->channels[j] < numAmplifierChannels) {
+                        subscriber->addresses.push_back(GpuWaveformAddress{ GpuWaveformWideband, subscriber->channels[j] });
+                    }
+                }
+            }
+            header.numChannels = (uint16_t) subscriber->addresses.size();
+            subscriber->packedSamples.resize((size_t) numSamples * subscriber->addresses.size());
+            if (!subscriber->addresses.empty()) {
+                waveformFifo->copyGpuAmplifierDataArrayRaw(reader, subscriber->packedSamples.data(), subscriber->addresses,
+                                                           0, numSamples);
+            }
+            parts[numParts] = subscriber->packedSamples.data();
+            partBytes[numParts++] = sizeof(uint16_t) * subscriber->packedSamples.size();
+        }
+
+        if (!sendOrQueue(subscriber, parts, partBytes, numParts)) {
+            removeSubscriber(i);
+        } else {
+            ++i;
+        }
+    }
+}
+
+void WaveformStreamServer::removeSubscriber(int index)
+{
+    Subscriber* subscriber = subscribers[index];
+    ::close(subscriber->socket);
+    if (subscriber->droppedFrames > 0) {
+        std::cout << "WaveformStreamServer: subscriber disconnected after " << subscriber->droppedFrames << " dropped frames" << '\n';
+    }
+    delete subscriber;
+    subscribers.erase(subscribers.begin() + index);
+}
+
+#else   // _WIN32: streaming server not yet available; TCP output continues to use TCPCommunicator only.
+
+WaveformStreamServer::WaveformStreamServer(int maxBacklogBytes_) :
+    listenSocket(-1),
+    maxBacklogBytes(maxBacklogBytes_),
+    totalDroppedFrames(0)
+{
+}
+
+WaveformStreamServer::~WaveformStreamServer()
+{
+}
+
+bool WaveformStreamServer::listen(const std::string& /* address */, int /* port */)
+{
+    std::cerr << "Error: WaveformStreamServer::listen: not supported on this platform." << '\n';
+    return false;
+}
+
+void WaveformStreamServer::close()
+{
+}
+
+void WaveformStreamServer::serviceConnections()
+{
+}
+
+void WaveformStreamServer::sendFrame(const WaveformFifo* /* waveformFifo */, WaveformFifo::Reader /* reader */,
+                                     int /* numSamples */)
+{
+}
+
+#endif
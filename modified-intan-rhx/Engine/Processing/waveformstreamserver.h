@@ -0,0 +1,117 @@
+//------------------------------------------------------------------------------
+//
+//  Intan Technologies RHX Data Acquisition Software
+//  Version 3.4.0
+//
+//  Copyright (c) 2020-2025 Intan Technologies
+//
+//  This file is part of the Intan Technologies RHX Data Acquisition Software.
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published
+//  by the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//  This software is provided 'as-is', without any express or implied warranty.
+//  In no event will the authors be held liable for any damages arising from
+//  the use of this software.
+//
+//  See <http://www.intantech.com> for documentation and product information.
+//
+//------------------------------------------------------------------------------
+
+
+#ifndef WAVEFORMSTREAMSERVER_H
+#define WAVEFORMSTREAMSERVER_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "waveformfifo.h"
+#include "streamsubscription.h"
+
+// Binary streaming server for raw wideband amplifier data, serving any number of subscribers directly from
+// WaveformFifo memory.  Each call to sendFrame() sends one frame to every subscriber:
+//
+//     StreamFrameHeader
+//     uint32_t timeStamps[numSamples]
+//     uint16_t samples[numSamples][numChannels]     (raw ADC codes; microvolts = 0.195 * (code - 32768))
+//
+// All values are in host (little-endian) byte order.  A subscriber receives every amplifier channel (in GPU waveform
+// index order: stream * channels per stream + chip channel) unless it sends a subscription request:
+//
+//     uint32_t StreamSubscribeMagicNumber
+//     uint32_t numMaskBytes
+//     uint8_t mask[numMaskBytes]      (bit i of byte i / 8 set = send amplifier channel i)
+//
+// Full-rate subscribers are written with scatter-gather I/O pointing straight into the FIFO.  Data that a subscriber's
+// socket cannot take immediately is queued in a per-subscriber backlog of bounded size; once the backlog is full, whole
+// frames are dropped for that subscriber (and counted) rather than stalling the stream for everyone else.
+
+const uint32_t StreamFrameMagicNumber = 0x52485853;      // "SXHR"
+const uint32_t StreamSubscribeMagicNumber = 0x42555353;  // "SSUB"
+
+struct StreamFrameHeader
+{
+    uint32_t magicNumber;
+    uint32_t sequenceNumber;    // Per subscriber; increments on every frame, including dropped frames
+    uint32_t droppedFrames;     // Cumulative frames dropped for this subscriber
+    uint16_t numSamples;
+    uint16_t numChannels;
+};
+
+class WaveformStreamServer
+{
+public:
+    static const int DefaultPort = 5010;
+    static const int DefaultMaxBacklogBytes = 32 * 1024 * 1024;
+
+    explicit WaveformStreamServer(int maxBacklogBytes_ = DefaultMaxBacklogBytes);
+    ~WaveformStreamServer();
+
+    bool listen(const std::string& address, int port);
+    void close();
+    bool isListening() const { return listenSocket >= 0; }
+
+    void serviceConnections();  // Accept new subscribers, read subscription requests, and flush backlogs.
+    void sendFrame(const WaveformFifo* waveformFifo, WaveformFifo::Reader reader, int numSamples);
+
+    int numSubscribers() const { return (int) subscribers.size(); }
+    uint64_t getTotalDroppedFrames() const { return totalDroppedFrames; }
+
+private:
+    struct Subscriber
+    {
+        int socket;
+        bool subscribed;                    // Sent a subscription request; until then, all channels are sent
+        std::vector<int> channels;          // Amplifier channels selected by the last subscription request
+        std::vector<uint8_t> request;       // Partially received subscription request
+        std::vector<char> backlog;
+        size_t backlogOffset;
+        uint32_t sequenceNumber;
+        uint32_t droppedFrames;
+        std::vector<GpuWaveformAddress> addresses;
+        std::vector<uint16_t> packedSamples;
+    };
+
+    int listenSocket;
+    int maxBacklogBytes;
+    std::vector<Subscriber*> subscribers;
+    uint64_t totalDroppedFrames;
+
+    void acceptSubscribers();
+    bool readRequests(Subscriber* subscriber);
+    bool flushBacklog(Subscriber* subscriber);
+    bool sendOrQueue(Subscriber* subscriber, const void* const* parts, const size_t* partBytes, int numParts);
+    void removeSubscriber(int index);
+};
+
+#endif // WAVEFORMSTREAMSERVER_H
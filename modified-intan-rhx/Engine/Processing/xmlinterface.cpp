@@ -31,8 +31,13 @@
 #include "xmlinterface.h"
 #include "controllerinterface.h"
 #include <QtXml>
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDir>
+#include <QFileInfo>
 #include <QFileDialog>
 #include <QMessageBox>
+#include <QStandardPaths>
 #include <QTranslator>
 
 
@@ -60,10 +65,29 @@ bool XMLInterface::loadFile(const QString &filename, QString &errorMessage, bool
             return false;
         }
     } else {
+        // Settings that were loaded from this file before can be restored from its binary snapshot.
+        bool snapshot = usesSnapshot() && !probeMap && !stimOnly;
+        QByteArray xmlHash;
+        QByteArray key;
+        bool ignoreStimParameters = false;
+        if (snapshot) {
+            xmlHash = QCryptographicHash::hash(byteArray, QCryptographicHash::Sha1);
+            key = snapshotKey();
+            if (loadSnapshot(filename, xmlHash, key, errorMessage)) {
+                return true;
+            }
+            QString dummyError("");
+            parseDocumentStart(byteArray, dummyError, ignoreStimParameters);
+        }
+
+        int warningsStart = errorMessage.length();
         if (!parseByteArray(byteArray, errorMessage, probeMap, stimOnly)) {
             qDebug() << "Failure parsing XML data. Error message: " << errorMessage;
             return false;
         }
+        if (snapshot) {
+            saveSnapshot(filename, xmlHash, key, byteArray, ignoreStimParameters, errorMessage.mid(warningsStart));
+        }
     }
     return true;
 }
@@ -612,67 +636,8 @@ bool XMLInterface::parseGeneralConfig(const QByteArray &byteArray, QString &erro
 
         // If attribute value is "N/A", then skip.
         if (attributeValue != "N/A") {
-            // Try to find the attribute as a StateSingleItem in globalItems.
-            StateSingleItem *singleItem = state->locateStateSingleItem(state->globalItems, attributeName);
-
-            // If the attribute is a StateSingleItem, set it according to XMLIncludeParameters.
-            if (singleItem) {
-                bool changeItem = false;
-                XMLGroup xmlGroup = singleItem->getXMLGroup();
-
-                switch (includeParameters) {
-                case XMLIncludeSpikeSortingParameters:
-                    if (xmlGroup == XMLGroupSpikeSettings) changeItem = true;
-                    break;
-                case XMLIncludeGlobalParameters:
-                    if (xmlGroup == XMLGroupSpikeSettings || xmlGroup == XMLGroupGeneral) changeItem = true;
-                    break;
-                default:
-                    break;
-                }
-
-                if (changeItem) {
-                    if (!singleItem->setValue(attributeValue)) {
-                        errorMessage.append("Error: Failed to parse " + singleItem->getParameterName());
-                        return false;
-                    } else {
-                        continue;
-                    }
-                }
-            }
-
-            // Try to find the attribute as a StateFilenameItem
-            QString pathOrBase;
-            StateFilenameItem *filenameItem = state->locateStateFilenameItem(state->stateFilenameItems, attributeName.toLower(), pathOrBase);
-
-            // If the attribute is a StateFilenameItem, set it according to XMLIncludeParameters.
-            if (filenameItem) {
-                if (includeParameters == XMLIncludeGlobalParameters) {
-                    if (pathOrBase == filenameItem->getPathParameterName().toLower()) {
-                        filenameItem->setPath(attributeValue);
-                        continue;
-                    } else if (pathOrBase == filenameItem->getBaseFilenameParameterName().toLower()) {
-                        filenameItem->setBaseFilename(attributeValue);
-                        continue;
-                    } else {
-                        qDebug() << "Error: seems to be neither path nor basefilename... pathorbase: " << pathOrBase;
-                        continue;
-                    }
-                }
-            }
-
-            // See if this attribute is the exception TCPDataOutputChannels.
-            if (attributeName.toLower() == "tcpdataoutputchannels") {
-                // Read the attribute value into a QStringList, separated by commas.
-                QStringList tcpChannelList = attributeValue.split(',');
-                // Go through each channel in tcpChannelList and find it in SignalSources
-                for (auto& channelName : tcpChannelList) {
-                    Channel *thisChannel = state->signalSources->channelByName(channelName);
-                    // If this channel couldn't be found, just continue
-                    if (!thisChannel) continue;
-                    // Set this channel to output to TCP
-                    thisChannel->setOutputToTcp(true);
-                }
+            if (!applyGeneralConfigAttribute(attributeName, attributeValue, errorMessage)) {
+                return false;
             }
         }
     }
@@ -1027,6 +992,349 @@ bool XMLInterface::parseStimParameters(const QByteArray &byteArray, QString &err
     return true;
 }
 
+bool XMLInterface::usesSnapshot() const
+{
+    // Stimulation parameter and probe map files are small, and are loaded through their own paths.
+    return includeParameters == XMLIncludeGlobalParameters || includeParameters == XMLIncludeSpikeSortingParameters;
+}
+
+QByteArray XMLInterface::snapshotKey() const
+{
+    // Everything besides the XML file itself that decides whether the XML loads and what warnings it gives:
+    // the header items checked by parseDocumentStart() and the channels checked by checkConsistentChannels().
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(QByteArray::number((int) includeParameters));
+    QVector<StateSingleItem*> headerStateItems = state->getHeaderStateItems();
+    for (int i = 0; i < headerStateItems.size(); i++) {
+        hash.addData((headerStateItems[i]->getParameterName() + "=" + headerStateItems[i]->getValueString() + "\n").toUtf8());
+    }
+    std::vector<std::string> allChannels = state->signalSources->completeChannelsNameList();
+    for (auto& channelName : allChannels) {
+        hash.addData(QByteArray::fromStdString(channelName + "\n"));
+    }
+    return hash.result();
+}
+
+QString XMLInterface::snapshotPath(const QString &filename) const
+{
+    // Kept in the per-user cache directory rather than next to the XML file, under a name derived from the XML
+    // file's absolute path, modification time and size; editing or replacing the file simply misses the cache.
+    QString cacheDir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+    if (cacheDir.isEmpty()) {
+        return QString();
+    }
+    QFileInfo fileInfo(filename);
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(fileInfo.absoluteFilePath().toUtf8());
+    hash.addData(QByteArray::number(fileInfo.lastModified().toMSecsSinceEpoch()));
+    hash.addData(QByteArray::number(fileInfo.size()));
+    return QDir(cacheDir).filePath("settings-snapshots/" + QString::fromLatin1(hash.result().toHex()) + ".snapshot");
+}
+
+bool XMLInterface::loadSnapshot(const QString &filename, const QByteArray &xmlHash, const QByteArray &key, QString &errorMessage) const
+{
+    QString path = snapshotPath(filename);
+    if (path.isEmpty()) {
+        return false;
+    }
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_11);
+
+    quint32 magic = 0;
+    quint32 version = 0;
+    stream >> magic >> version;
+    if (magic != SnapshotMagic || version != SnapshotFormatVersion) {
+        return false;
+    }
+
+    QByteArray savedXmlHash;
+    QByteArray savedKey;
+    stream >> savedXmlHash >> savedKey;
+    if (savedXmlHash != xmlHash || savedKey != key) {
+        return false;
+    }
+
+    bool ignoreStimParameters = false;
+    QString warnings;
+    quint32 numElements = 0;
+    stream >> ignoreStimParameters >> warnings >> numElements;
+    QVector<SnapshotElement> elements;
+    for (quint32 i = 0; i < numElements && stream.status() == QDataStream::Ok; ++i) {
+        SnapshotElement element;
+        stream >> element.kind >> element.target >> element.names >> element.values;
+        if (element.names.size() != element.values.size()) {
+            return false;
+        }
+        elements.append(element);
+    }
+    if (stream.status() != QDataStream::Ok) {
+        return false;
+    }
+
+    QString applyError("");
+    if (!applySnapshot(elements, ignoreStimParameters, applyError)) {
+        qDebug() << "Failure applying settings snapshot, reading XML instead. Error message: " << applyError;
+        return false;
+    }
+    errorMessage.append(warnings);
+    return true;
+}
+
+void XMLInterface::saveSnapshot(const QString &filename, const QByteArray &xmlHash, const QByteArray &key, const QByteArray &byteArray,
+                                bool ignoreStimParameters, const QString &warnings) const
+{
+    QVector<SnapshotElement> elements = compileSnapshot(byteArray);
+
+    // The snapshot is only a cache; if it can't be written (e.g., no cache directory), the XML is read every time.
+    QString path = snapshotPath(filename);
+    if (path.isEmpty() || !QDir().mkpath(QFileInfo(path).absolutePath())) {
+        return;
+    }
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return;
+    }
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_11);
+
+    stream << SnapshotMagic << SnapshotFormatVersion << xmlHash << key << ignoreStimParameters << warnings;
+    stream << (quint32) elements.size();
+    for (auto& element : elements) {
+        stream << element.kind << element.target << element.names << element.values;
+    }
+    file.close();
+}
+
+QVector<XMLInterface::SnapshotElement> XMLInterface::compileSnapshot(const QByteArray &byteArray) const
+{
+    // Collect the elements in one pass, then order them the way parseByteArray() applies them: GeneralConfig,
+    // the first SignalGroup, every Channel from there on, the 'Port' SignalGroups again (parseSignalGroupsAttributes()),
+    // then the StimChannels.
+    QVector<SnapshotElement> generalConfig;
+    QVector<SnapshotElement> firstSignalGroup;
+    QVector<SnapshotElement> channels;
+    QVector<SnapshotElement> portSignalGroups;
+    QVector<SnapshotElement> stimChannels;
+
+    QXmlStreamReader stream(byteArray);
+    while (!stream.atEnd()) {
+        if (stream.readNext() != QXmlStreamReader::StartElement) {
+            continue;
+        }
+
+        SnapshotElement element;
+        QString prefix("");
+        QString nativeChannelName("");
+        QXmlStreamAttributes attributes = stream.attributes();
+        for (auto& attribute : attributes) {
+            QString attributeName = attribute.name().toString();
+            QString attributeValue = attribute.value().toString();
+            if (attributeName.toLower() == "prefix") prefix = attributeValue;
+            if (attributeName.toLower() == "nativechannelname") nativeChannelName = attributeValue;
+
+            // "N/A" values are never applied.
+            if (attributeValue != "N/A") {
+                element.names.append(attributeName);
+                element.values.append(attributeValue);
+            }
+        }
+
+        if (stream.name() == QStringLiteral("GeneralConfig")) {
+            if (generalConfig.isEmpty()) {
+                element.kind = SnapshotGeneralConfig;
+                generalConfig.append(element);
+            }
+        } else if (stream.name() == QStringLiteral("SignalGroup")) {
+            element.kind = SnapshotSignalGroup;
+            if (firstSignalGroup.isEmpty()) {
+                SignalGroup* thisSignalGroup = signalGroupForPrefix(prefix);
+                if (!thisSignalGroup) {
+                    stream.skipCurrentElement();
+                    continue;
+                }
+                element.target = thisSignalGroup->getName();
+                firstSignalGroup.append(element);
+            }
+            if (state->signalSources->groupByName("Port " + prefix)) {
+                element.target = "Port " + prefix;
+                portSignalGroups.append(element);
+            }
+        } else if (stream.name() == QStringLiteral("Channel")) {
+            if (!firstSignalGroup.isEmpty()) {
+                element.kind = SnapshotChannel;
+                element.target = nativeChannelName;
+                channels.append(element);
+            }
+        } else if (stream.name() == QStringLiteral("StimChannel")) {
+            element.kind = SnapshotStimChannel;
+            element.target = nativeChannelName;
+            stimChannels.append(element);
+        }
+    }
+
+    return generalConfig + firstSignalGroup + channels + portSignalGroups + stimChannels;
+}
+
+bool XMLInterface::applySnapshot(const QVector<SnapshotElement> &elements, bool ignoreStimParameters, QString &errorMessage) const
+{
+    state->holdUpdate();
+    for (auto& element : elements) {
+        switch (element.kind) {
+        case SnapshotGeneralConfig:
+            state->signalSources->clearTCPDataOutput();
+            for (int i = 0; i < element.names.size(); ++i) {
+                if (!applyGeneralConfigAttribute(element.names[i], element.values[i], errorMessage)) {
+                    state->releaseUpdate();
+                    return false;
+                }
+            }
+            if (state->getControllerTypeEnum() == ControllerStimRecord) {
+                controllerInterface->uploadAmpSettleSettings();
+                controllerInterface->uploadChargeRecoverySettings();
+            }
+            break;
+
+        case SnapshotSignalGroup:
+        {
+            SignalGroup* thisSignalGroup = state->signalSources->groupByName(element.target);
+            if (!thisSignalGroup) continue;
+            for (int i = 0; i < element.names.size(); ++i) {
+                if (!applyItemAttribute(thisSignalGroup->portItems, element.names[i], element.values[i], false, errorMessage)) {
+                    state->releaseUpdate();
+                    return false;
+                }
+            }
+            break;
+        }
+
+        case SnapshotChannel:
+        case SnapshotStimChannel:
+        {
+            bool stimParameters = element.kind == SnapshotStimChannel;
+            if (stimParameters && (state->getControllerTypeEnum() != ControllerStimRecord || ignoreStimParameters ||
+                                   includeParameters != XMLIncludeGlobalParameters)) {
+                continue;
+            }
+            Channel* thisChannel = state->signalSources->channelByName(element.target);
+            if (!thisChannel) continue;
+            for (int i = 0; i < element.names.size(); ++i) {
+                if (!applyItemAttribute(thisChannel->channelItems, element.names[i], element.values[i], stimParameters, errorMessage)) {
+                    state->releaseUpdate();
+                    return false;
+                }
+            }
+            if (stimParameters) {
+                controllerInterface->uploadStimParameters(thisChannel);
+            }
+            break;
+        }
+
+        default:
+            errorMessage.append("Error: Unknown element in settings snapshot");
+            state->releaseUpdate();
+            return false;
+        }
+    }
+    state->releaseUpdate();
+    return true;
+}
+
+bool XMLInterface::loadsXMLGroup(XMLGroup xmlGroup) const
+{
+    switch (includeParameters) {
+    case XMLIncludeSpikeSortingParameters:
+        return xmlGroup == XMLGroupSpikeSettings;
+    case XMLIncludeGlobalParameters:
+        return xmlGroup == XMLGroupSpikeSettings || xmlGroup == XMLGroupGeneral;
+    default:
+        return false;
+    }
+}
+
+bool XMLInterface::applyGeneralConfigAttribute(const QString &attributeName, const QString &attributeValue, QString &errorMessage) const
+{
+    // Try to find the attribute as a StateSingleItem in globalItems.
+    StateSingleItem *singleItem = state->locateStateSingleItem(state->globalItems, attributeName);
+
+    // If the attribute is a StateSingleItem, set it according to XMLIncludeParameters.
+    if (singleItem && loadsXMLGroup(singleItem->getXMLGroup())) {
+        if (!singleItem->setValue(attributeValue)) {
+            errorMessage.append("Error: Failed to parse " + singleItem->getParameterName());
+            return false;
+        }
+        return true;
+    }
+
+    // Try to find the attribute as a StateFilenameItem
+    QString pathOrBase;
+    StateFilenameItem *filenameItem = state->locateStateFilenameItem(state->stateFilenameItems, attributeName.toLower(), pathOrBase);
+
+    // If the attribute is a StateFilenameItem, set it according to XMLIncludeParameters.
+    if (filenameItem) {
+        if (includeParameters == XMLIncludeGlobalParameters) {
+            if (pathOrBase == filenameItem->getPathParameterName().toLower()) {
+                filenameItem->setPath(attributeValue);
+            } else if (pathOrBase == filenameItem->getBaseFilenameParameterName().toLower()) {
+                filenameItem->setBaseFilename(attributeValue);
+            } else {
+                qDebug() << "Error: seems to be neither path nor basefilename... pathorbase: " << pathOrBase;
+            }
+            return true;
+        }
+    }
+
+    // See if this attribute is the exception TCPDataOutputChannels.
+    if (attributeName.toLower() == "tcpdataoutputchannels") {
+        // Read the attribute value into a QStringList, separated by commas.
+        QStringList tcpChannelList = attributeValue.split(',');
+        // Go through each channel in tcpChannelList and find it in SignalSources
+        for (auto& channelName : tcpChannelList) {
+            Channel *thisChannel = state->signalSources->channelByName(channelName);
+            // If this channel couldn't be found, just continue
+            if (!thisChannel) continue;
+            // Set this channel to output to TCP
+            thisChannel->setOutputToTcp(true);
+        }
+    }
+    return true;
+}
+
+bool XMLInterface::applyItemAttribute(SingleItemList &items, const QString &attributeName, const QString &attributeValue, bool stimParameters,
+                                      QString &errorMessage) const
+{
+    StateSingleItem *singleItem = state->locateStateSingleItem(items, attributeName);
+    if (!singleItem) return true;
+
+    bool changeItem = stimParameters ? singleItem->getXMLGroup() == XMLGroupStimParameters : loadsXMLGroup(singleItem->getXMLGroup());
+    if (changeItem && !singleItem->setValue(attributeValue)) {
+        errorMessage.append("Error: Failed to parse " + singleItem->getParameterName());
+        return false;
+    }
+    return true;
+}
+
+SignalGroup* XMLInterface::signalGroupForPrefix(const QString &prefix) const
+{
+    // Same lookup as parseSignalGroups(): "Port " + prefix, or one of the controller's analog/digital groups.
+    SignalGroup* thisSignalGroup = state->signalSources->groupByName("Port " + prefix);
+    if (!thisSignalGroup) {
+        if (prefix == "ANALOG-IN") {
+            thisSignalGroup = state->signalSources->groupByName("Analog In Ports");
+        } else if (prefix == "ANALOG-OUT") {
+            thisSignalGroup = state->signalSources->groupByName("Analog Out Ports");
+        } else if (prefix == "DIGITAL-IN") {
+            thisSignalGroup = state->signalSources->groupByName("Digital In Ports");
+        } else if (prefix == "DIGITAL-OUT") {
+            thisSignalGroup = state->signalSources->groupByName("Digital Out Ports");
+        }
+    }
+    return thisSignalGroup;
+}
+
 bool XMLInterface::parseStimLegacy(const QByteArray &byteArray, QString &errorMessage) const
 {
     QXmlStreamReader stream(byteArray);
@@ -31,6 +31,7 @@
 #ifndef XMLINTERFACE_H
 #define XMLINTERFACE_H
 #include <QString>
+#include <QStringList>
 #include <QVector>
 
 #include "rhxglobals.h"
@@ -63,8 +64,45 @@ public:
     void saveAsElement(QXmlStreamWriter &stream) const; // Save as an XML element.
 
 private:
+    // A global or spike sorting settings file that loaded successfully from XML is cached in a snapshot file in
+    // the user's cache directory (see snapshotPath()): the attribute assignments the XML load made, in the order
+    // it made them. Later loads of the same file apply these in a single pass without parsing any XML, as long
+    // as the SHA-1 of the XML file and the hardware key (header items, connected channels) still match;
+    // otherwise the XML is parsed and the snapshot rewritten.
+    enum SnapshotElementKind {
+        SnapshotGeneralConfig,
+        SnapshotSignalGroup,
+        SnapshotChannel,
+        SnapshotStimChannel
+    };
+
+    struct SnapshotElement {
+        quint8 kind;
+        QString target;  // Group name or native channel name (empty for GeneralConfig)
+        QStringList names;
+        QStringList values;
+    };
+
+    static const quint32 SnapshotMagic = 0x52485853;  // "RHXS"
+    static const quint32 SnapshotFormatVersion = 1;
+
     QByteArray saveByteArray() const; // Save as a single QByteArray.
 
+    bool usesSnapshot() const;
+    QByteArray snapshotKey() const;
+    QString snapshotPath(const QString &filename) const;
+    bool loadSnapshot(const QString &filename, const QByteArray &xmlHash, const QByteArray &key, QString &errorMessage) const;
+    void saveSnapshot(const QString &filename, const QByteArray &xmlHash, const QByteArray &key, const QByteArray &byteArray,
+                      bool ignoreStimParameters, const QString &warnings) const;
+    QVector<SnapshotElement> compileSnapshot(const QByteArray &byteArray) const;
+    bool applySnapshot(const QVector<SnapshotElement> &elements, bool ignoreStimParameters, QString &errorMessage) const;
+
+    bool loadsXMLGroup(XMLGroup xmlGroup) const;
+    bool applyGeneralConfigAttribute(const QString &attributeName, const QString &attributeValue, QString &errorMessage) const;
+    bool applyItemAttribute(SingleItemList &items, const QString &attributeName, const QString &attributeValue, bool stimParameters,
+                            QString &errorMessage) const;
+    SignalGroup* signalGroupForPrefix(const QString &prefix) const;
+
     bool probeMapDetected(const QByteArray &byteArray, QString &errorMessage) const;
     bool parseDocumentStart(const QByteArray &byteArray, QString &errorMessage, bool &ignoreStimParameters, bool probeMap = false) const;
     bool checkConsistentChannels(const QByteArray &byteArray, QString &errorMessage) const;
@@ -172,8 +172,9 @@ void AudioThread::close()
 bool AudioThread::fillBufferFromWaveformFifo()
 {
     // Update volume and noise slicer threshold values.
-    volume = state->audioVolume->getValue();
-    threshold = state->audioThreshold->getValue();
+    std::shared_ptr<const RealtimeParameters> parameters = state->realtimeParameters();
+    volume = parameters->audioVolume;
+    threshold = parameters->audioThreshold;
 
     // Out of an abundance of caution, bound these values read from state in case of any glitches due to threading issues.
     volume = qBound(minVolume, volume, maxVolume);
@@ -183,7 +184,7 @@ bool AudioThread::fillBufferFromWaveformFifo()
     bool validAudioSource = true;
     QString selectedChannelName = state->signalSources->singleSelectedAmplifierChannelName();
     if (selectedChannelName.isEmpty()) validAudioSource = false;
-    QString selectedChannelFilterName = selectedChannelName + "|" + state->audioFilter->getDisplayValueString();
+    QString selectedChannelFilterName = selectedChannelName + "|" + parameters->audioFilter;
     if (!waveformFifo->gpuWaveformPresent(selectedChannelFilterName.toStdString())) {
         qDebug() << "Failure... channel name: " << selectedChannelFilterName;
         validAudioSource = false;
@@ -34,6 +34,8 @@ TCPDataOutputThread::TCPDataOutputThread(WaveformFifo *waveformFifo_, const doub
     QThread(parent),
     tcpWaveformDataCommunicator(state_->tcpWaveformDataCommunicator),
     tcpSpikeDataCommunicator(state_->tcpSpikeDataCommunicator),
+    streamServer(new WaveformStreamServer),
+    numDataBlocksPerWrite(0),
     previousSample(nullptr),
     waveformFifo(waveformFifo_),
     signalSources(state_->signalSources),
@@ -49,6 +51,7 @@ TCPDataOutputThread::TCPDataOutputThread(WaveformFifo *waveformFifo_, const doub
 
 TCPDataOutputThread::~TCPDataOutputThread()
 {
+    delete streamServer;
 }
 
 void TCPDataOutputThread::run()
@@ -61,7 +64,8 @@ void TCPDataOutputThread::run()
             std::cout << "TCP setup" << '\n';
 
             // Any 'start up' code goes here.
-            updateEnabledChannels();
+            updateEnabledChannels(state->realtimeParameters().get());
+            streamServer->listen(tcpWaveformDataCommunicator->address.toStdString(), WaveformStreamServer::DefaultPort);
 
             while (keepGoing && !stopThread) {
 
@@ -73,10 +77,15 @@ void TCPDataOutputThread::run()
                     closeCompleted = false;
                 }
 
+                // One snapshot per write, so the read size and the array sizes always agree.
+                std::shared_ptr<const RealtimeParameters> parameters = state->realtimeParameters();
+                int numFrames = FramesPerBlock * parameters->tcpNumDataBlocksWrite;
+
                 // If neither waveform nor spike ports are connected, just do a dummy read of the WaveformFifo
                 if (tcpWaveformDataCommunicator->status != TCPCommunicator::Connected &&
                         tcpSpikeDataCommunicator->status != TCPCommunicator::Connected) {
-                    if (waveformFifo->requestReadNewData(WaveformFifo::ReaderTCP, FramesPerBlock * state->tcpNumDataBlocksWrite->getValue())) {
+                    if (waveformFifo->requestReadNewData(WaveformFifo::ReaderTCP, numFrames)) {
+                        streamData(numFrames);
                         waveformFifo->freeOldData(WaveformFifo::ReaderTCP);
                     }
                 }
@@ -84,19 +93,21 @@ void TCPDataOutputThread::run()
                 // If at least one port is connected, get the correct # of filter bands and channels, read data from WaveformFifo, and output it
                 else {
 
-                    if (previousEnabledBands != state->signalSources->getTcpFilterBands()) {
-                        updateEnabledChannels();
+                    if (previousEnabledBands != parameters->tcpFilterBands ||
+                            numDataBlocksPerWrite != parameters->tcpNumDataBlocksWrite) {
+                        updateEnabledChannels(parameters.get());
                     }
 
                     // Wait for 'tcpNumDataBlocksWrite' prior to write
-                    if (waveformFifo->requestReadNewData(WaveformFifo::ReaderTCP, FramesPerBlock * state->tcpNumDataBlocksWrite->getValue())) {
+                    if (waveformFifo->requestReadNewData(WaveformFifo::ReaderTCP, numFrames)) {
+                        streamData(numFrames);
 
                         if (enabledChannelNames.size() == 0) {
                             waveformFifo->freeOldData(WaveformFifo::ReaderTCP);
                             continue;
                         }
 
-                        for (int i = 0; i < FramesPerBlock * state->tcpNumDataBlocksWrite->getValue(); ++i) {
+                        for (int i = 0; i < numFrames; ++i) {
                             if ((i % FramesPerBlock) == 0) {
                                 waveformArray.replace(waveformArrayIndex, sizeof(TCPWaveformMagicNumber), (const char*)(&TCPWaveformMagicNumber), sizeof(TCPWaveformMagicNumber));
                                 waveformArrayIndex += sizeof(TCPWaveformMagicNumber);
@@ -158,30 +169,6 @@ void TCPDataOutputThread::run()
                                         waveformArrayIndex += sizeof(thisSample);
                                     }
 
-                                    if (thisChannel->getOutputToTcpSpike()) {
-                                        std::string waveName = QString(enabledChannelNames[channel] + "|SPK").toStdString();
-                                        uint16_t* spikeWaveform = waveformFifo->getDigitalWaveformPointer(waveName);
-                                        uint8_t spikeId = (uint8_t) waveformFifo->getDigitalData(WaveformFifo::ReaderTCP, spikeWaveform, i);
-                                        if (spikeId != SpikeIdNoSpike) {
-                                            // Create 14-byte chunk with magic num, native name, timestamp, and spike ID
-                                            char nativeName[5];
-                                            memcpy(nativeName, enabledChannelNames[channel].toLocal8Bit().constData(), sizeof(nativeName));
-
-                                            // Put that chunk in spikeArray
-                                            spikeArray.replace(spikeArrayIndex, sizeof(TCPSpikeMagicNumber), (const char*)(&TCPSpikeMagicNumber), sizeof(TCPSpikeMagicNumber));
-                                            spikeArrayIndex += sizeof(TCPSpikeMagicNumber);
-
-                                            spikeArray.replace(spikeArrayIndex, sizeof(nativeName), (const char*)(&nativeName), sizeof(nativeName));
-                                            spikeArrayIndex += sizeof(nativeName);
-
-                                            spikeArray.replace(spikeArrayIndex, sizeof(timestamp), (const char*)(&timestamp), sizeof(timestamp));
-                                            spikeArrayIndex += sizeof(timestamp);
-
-                                            spikeArray.replace(spikeArrayIndex, sizeof(spikeId), (const char*)(&spikeId), sizeof(spikeId));
-                                            spikeArrayIndex += sizeof(spikeId);
-                                        }
-                                    }
-
                                     if (thisChannel->getOutputToTcpDc()) {
                                         std::string waveName = QString(enabledChannelNames[channel] + "|DC").toStdString();
                                         float *dcWaveform = waveformFifo->getAnalogWaveformPointer(waveName);
@@ -312,6 +299,36 @@ void TCPDataOutputThread::run()
                                 }
                             }
                         }
+                        // Spike chunks come from the sparse event stream rather than a scan of every |SPK raster.
+                        if (!spikeChannelNames.empty()) {
+                            waveformFifo->getSpikeEvents(WaveformFifo::ReaderTCP, spikeEvents, 0, numFrames);
+                        } else {
+                            spikeEvents.clear();
+                        }
+                        for (const SpikeEvent& event : spikeEvents) {
+                            std::map<int, QString>::const_iterator name = spikeChannelNames.find(event.channel);
+                            if (name == spikeChannelNames.end()) continue;
+
+                            // Create 14-byte chunk with magic num, native name, timestamp, and spike ID
+                            char nativeName[5];
+                            memcpy(nativeName, name->second.toLocal8Bit().constData(), sizeof(nativeName));
+                            uint32_t spikeTimestamp = event.timeStamp;
+                            uint8_t spikeId = event.spikeId;
+
+                            // Put that chunk in spikeArray
+                            spikeArray.replace(spikeArrayIndex, sizeof(TCPSpikeMagicNumber), (const char*)(&TCPSpikeMagicNumber), sizeof(TCPSpikeMagicNumber));
+                            spikeArrayIndex += sizeof(TCPSpikeMagicNumber);
+
+                            spikeArray.replace(spikeArrayIndex, sizeof(nativeName), (const char*)(&nativeName), sizeof(nativeName));
+                            spikeArrayIndex += sizeof(nativeName);
+
+                            spikeArray.replace(spikeArrayIndex, sizeof(spikeTimestamp), (const char*)(&spikeTimestamp), sizeof(spikeTimestamp));
+                            spikeArrayIndex += sizeof(spikeTimestamp);
+
+                            spikeArray.replace(spikeArrayIndex, sizeof(spikeId), (const char*)(&spikeId), sizeof(spikeId));
+                            spikeArrayIndex += sizeof(spikeId);
+                        }
+
                         if (tcpWaveformDataCommunicator->status == TCPCommunicator::Connected)
                             tcpWaveformDataCommunicator->writeData(waveformArray.data(), waveformArrayIndex);
                         if (tcpSpikeDataCommunicator->status == TCPCommunicator::Connected)
@@ -325,6 +342,7 @@ void TCPDataOutputThread::run()
             }
 
             // Any 'finish up' code goes here.
+            streamServer->close();
 
             delete [] previousSample;
             previousSample = nullptr;
@@ -336,7 +354,15 @@ void TCPDataOutputThread::run()
     }
 }
 
-void TCPDataOutputThread::updateEnabledChannels()
+// Send the data just read from the waveform FIFO to all binary stream subscribers (see WaveformStreamServer).
+void TCPDataOutputThread::streamData(int numSamples)
+{
+    if (!streamServer->isListening()) return;
+    streamServer->serviceConnections();
+    streamServer->sendFrame(waveformFifo, WaveformFifo::ReaderTCP, numSamples);
+}
+
+void TCPDataOutputThread::updateEnabledChannels(const RealtimeParameters* parameters)
 {
     // Always start with a clean slate
     channelNames = signalSources->completeChannelsNameList();
@@ -347,6 +373,7 @@ void TCPDataOutputThread::updateEnabledChannels()
 
     enabledChannelNames.clear();
     enabledStimChannelNames.clear();
+    spikeChannelNames.clear();
 
     posStimAmplitudes.resize(0);
     negStimAmplitudes.resize(0);
@@ -369,6 +396,10 @@ void TCPDataOutputThread::updateEnabledChannels()
             thisChannelBands = thisChannel->getTcpBandNames();
             if (thisChannelBands.size() > 0) enabledChannelNames.append(thisChannel->getNativeName());
             totalEnabledBands += thisChannelBands.size();
+            if (thisChannel->getOutputToTcpSpike()) {
+                GpuWaveformAddress spikeAddress = waveformFifo->getGpuWaveformAddress(thisChannel->getNativeNameString() + "|SPK");
+                if (spikeAddress.waveformIndex >= 0) spikeChannelNames[spikeAddress.waveformIndex] = thisChannel->getNativeName();
+            }
 
             // Get stim amplitudes for this channel
             if (state->getControllerTypeEnum() == ControllerStimRecord) {
@@ -463,7 +494,8 @@ void TCPDataOutputThread::updateEnabledChannels()
     numBytesPerDataBlock = 4 + (FramesPerBlock * numBytesPerFrame);
 
     waveformArray.clear();
-    waveformArray.resize(state->tcpNumDataBlocksWrite->getValue() * numBytesPerDataBlock);
+    numDataBlocksPerWrite = parameters->tcpNumDataBlocksWrite;
+    waveformArray.resize(numDataBlocksPerWrite * numBytesPerDataBlock);
     waveformArrayIndex = 0;
 
     // For each chunk of spike data, there are 4 bytes for magic number, 5 bytes for 5 characters of native channel name,
@@ -474,10 +506,10 @@ void TCPDataOutputThread::updateEnabledChannels()
     maxChunksPerDataBlock = 4 * signalSources->numAmplifierChannels();
 
     spikeArray.clear();
-    spikeArray.resize(state->tcpNumDataBlocksWrite->getValue() * numBytesPerSpikeChunk * maxChunksPerDataBlock);
+    spikeArray.resize(numDataBlocksPerWrite * numBytesPerSpikeChunk * maxChunksPerDataBlock);
     spikeArrayIndex = 0;
 
-    previousEnabledBands = state->signalSources->getTcpFilterBands();
+    previousEnabledBands = parameters->tcpFilterBands;
 
     closeRequested = false;
     closeCompleted = false;
@@ -33,10 +33,13 @@
 
 #include <QThread>
 #include <stdint.h>
+#include <map>
+#include <vector>
 
 #include "systemstate.h"
 #include "waveformfifo.h"
 #include "tcpcommunicator.h"
+#include "waveformstreamserver.h"
 
 class TCPDataOutputThread : public QThread
 {
@@ -59,16 +62,19 @@ signals:
 
 private:
     void closeInternal(); // Close thread from inside this thread.
-    void updateEnabledChannels();
+    void updateEnabledChannels(const RealtimeParameters* parameters);
+    void streamData(int numSamples);
 
     TCPCommunicator *tcpWaveformDataCommunicator;
     TCPCommunicator *tcpSpikeDataCommunicator;
+    WaveformStreamServer *streamServer;
 
     std::vector<std::string> channelNames;
     QVector<QString> enabledChannelNames;
     QVector<QString> enabledStimChannelNames;
 
     QStringList previousEnabledBands;
+    int numDataBlocksPerWrite;  // tcpNumDataBlocksWrite the output arrays are sized for
 
     int totalEnabledBands;
     int numAuxChannels;
@@ -90,6 +96,8 @@ private:
 
     QByteArray spikeArray;
     qint64 spikeArrayIndex;
+    std::map<int, QString> spikeChannelNames;   // amplifier waveform index -> native name, for channels sending spikes
+    std::vector<SpikeEvent> spikeEvents;
 
     int numBytesPerSpikeChunk;
     int maxChunksPerDataBlock;
@@ -29,6 +29,8 @@
 //------------------------------------------------------------------------------
 
 #include <QElapsedTimer>
+#include <algorithm>
+#include <cstring>
 #include <iostream>
 #include "usbdatathread.h"
 
@@ -41,9 +43,13 @@ USBDataThread::USBDataThread(AbstractRHXController* controller_, DataStreamFifo*
     running(false),
     stopThread(false),
     numUsbBlocksToRead(1),
-    usbBufferIndex(0)
+    usbBufferIndex(0),
+    usbBufferEnd(0),
+    numGlitchesRecovered(0)
 {
-    bufferSize = (BufferSizeInBlocks + 1) * BytesPerWord *
+    // Room for two maximum-size reads plus a partial data block left over from the previous read, so the staging
+    // buffer only needs compacting after several reads.
+    bufferSize = (2 * BufferSizeInBlocks + 1) * BytesPerWord *
             RHXDataBlock::dataBlockSizeInWords(controller->getType(), controller->maxNumDataStreams());
     memoryNeededGB = sizeof(uint8_t) * bufferSize / (1024.0 * 1024.0 * 1024.0);
     std::cout << "USBDataThread: Allocating " << bufferSize / 1.0e6 << " MBytes for USB buffer." << std::endl;
@@ -75,11 +81,16 @@ void USBDataThread::run()
             emit hardwareFifoReport(0.0);
             running = true;
             int numBytesRead = 0;
-            int bytesInBuffer = 0;
             ControllerType type = controller->getType();
             int numBytesPerDataFrame = BytesPerWord *
                     RHXDataBlock::dataBlockSizeInWords(type, controller->getNumEnabledDataStreams()) /
                     RHXDataBlock::samplesPerDataBlock(type);
+            int numBytesPerDataBlock = BytesPerWord *
+                    RHXDataBlock::dataBlockSizeInWords(type, controller->getNumEnabledDataStreams());
+            bool resynchronizing = false;
+            int lastGlitchReport = 0;
+            numGlitchesRecovered = 0;
+            emit usbGlitchReport(0);
             int ledArray[8] = {1, 0, 0, 0, 0, 0, 0, 0};
             int ledIndex = 0;
             if (type == ControllerRecordUSB2) {
@@ -97,52 +108,39 @@ void USBDataThread::run()
 //            double usbDataPeriodNsec = 1.0e9 * ((double) numUsbBlocksToRead) * ((double) RHXDataBlock::samplesPerDataBlock(type)) / controller->getSampleRate();
             while (keepGoing && !stopThread) {
 //                workTimer.restart();
+                int maxBytesPerRead = numBytesPerDataBlock * numUsbBlocksToRead;
+                if (usbBufferEnd + maxBytesPerRead > bufferSize) {
+                    compactUsbBuffer();
+                    if (usbBufferEnd + maxBytesPerRead > bufferSize) {
+                        std::cerr << "USBDataThread: USB buffer overrun (3)." << '\n';
+                        usbBufferIndex = 0;
+                        usbBufferEnd = 0;
+                    }
+                }
+
                 // Performance note:  Executing the following command takes around 88% of the total time of this loop,
                 // with or without error checking enabled.
 
-                numBytesRead = (int) controller->readDataBlocksRaw(numUsbBlocksToRead, &usbBuffer[usbBufferIndex]);
+                numBytesRead = (int) controller->readDataBlocksRaw(numUsbBlocksToRead, &usbBuffer[usbBufferEnd]);
                 if (numBytesRead == -1) {
                     break;
                 }
 
-                bytesInBuffer = usbBufferIndex + numBytesRead;
                 if (numBytesRead > 0) {
+                    usbBufferEnd += numBytesRead;
                     if (!errorChecking) {
                         // If not checking for USB data glitches, just write all the data to the FIFO buffer.
-                        if (!usbFifo->writeToBuffer(&usbBuffer[usbBufferIndex], (numBytesRead + usbBufferIndex) / BytesPerWord)) {
+                        if (!usbFifo->writeToBuffer(&usbBuffer[usbBufferIndex], (usbBufferEnd - usbBufferIndex) / BytesPerWord)) {
                             std::cerr << "USBDataThread: USB FIFO overrun (1)." << '\n';
                         }
                         usbBufferIndex = 0;
+                        usbBufferEnd = 0;
                     } else {
-                        usbBufferIndex = 0;
                         // Otherwise, check each USB data block for the correct header bytes before writing.
-                        while (usbBufferIndex <= bytesInBuffer - numBytesPerDataFrame - USBHeaderSizeInBytes) {
-                            if (RHXDataBlock::checkUsbHeader(usbBuffer, usbBufferIndex, type) &&
-                                RHXDataBlock::checkUsbHeader(usbBuffer, usbBufferIndex + numBytesPerDataFrame, type)) {
-                                // If we find two correct headers, assume the data in between is a good data block,
-                                // and write it to the FIFO buffer.
-                                if (!usbFifo->writeToBuffer(&usbBuffer[usbBufferIndex], numBytesPerDataFrame / BytesPerWord)) {
-                                    std::cerr << "USBDataThread: USB FIFO overrun (2)." << '\n';
-                                }
-                                usbBufferIndex += numBytesPerDataFrame;
-                            } else {
-                                // If headers are not found, advance word by word until we find them
-                                usbBufferIndex += 2;
-                            }
-                        }
-                        // If any data remains in usbBuffer, shift it to the front.
-                        if (usbBufferIndex > 0) {
-                            int j = 0;
-                            for (int i = usbBufferIndex; i < bytesInBuffer; ++i) {
-                                usbBuffer[j++] = usbBuffer[i];
-                            }
-                            usbBufferIndex = j;
-                        } else {
-                            // If usbBufferIndex == 0, we didn't have enough data to work with; append more.
-                            usbBufferIndex = bytesInBuffer;
-                        }
-                        if (usbBufferIndex + numBytesRead >= bufferSize) {
-                            std::cerr << "USBDataThread: USB buffer overrun (3)." << '\n';
+                        writeCheckedDataFrames(type, numBytesPerDataFrame, resynchronizing);
+                        if (numGlitchesRecovered != lastGlitchReport) {
+                            lastGlitchReport = numGlitchesRecovered;
+                            emit usbGlitchReport(lastGlitchReport);
                         }
                     }
 
@@ -184,6 +182,7 @@ void USBDataThread::run()
             controller->setMaxTimeStep(0);
             controller->flush();  // Flush USB FIFO on Opal Kelly board.
             usbBufferIndex = 0;
+            usbBufferEnd = 0;
 
             if (type == ControllerRecordUSB2) {
                 // Turn off LEDs.
@@ -198,6 +197,73 @@ void USBDataThread::run()
     }
 }
 
+// Move any unconsumed bytes (normally less than one data frame) to the front of usbBuffer.
+void USBDataThread::compactUsbBuffer()
+{
+    int bytesRemaining = usbBufferEnd - usbBufferIndex;
+    if (bytesRemaining > 0 && usbBufferIndex > 0) {
+        memmove(usbBuffer, &usbBuffer[usbBufferIndex], bytesRemaining);
+    }
+    usbBufferIndex = 0;
+    usbBufferEnd = bytesRemaining > 0 ? bytesRemaining : 0;
+}
+
+// Write every data frame in the staging buffer that is bracketed by two correct USB headers to usbFifo, writing
+// consecutive good frames with a single FIFO write.  When a header mismatch is found, the data are scanned for
+// the next header rather than stepping forward one word at a time.  Each loss of frame alignment counts as one
+// recovered glitch, however many reads it takes to find the next header.  Returns the number of frames written.
+int USBDataThread::writeCheckedDataFrames(ControllerType type, int numBytesPerDataFrame, bool& resynchronizing)
+{
+    int framesWritten = 0;
+    int runStart = usbBufferIndex;
+    bool headerChecked = false;  // The header at usbBufferIndex is known to be correct.
+    while (usbBufferIndex <= usbBufferEnd - numBytesPerDataFrame - USBHeaderSizeInBytes) {
+        if ((headerChecked || RHXDataBlock::checkUsbHeader(usbBuffer, usbBufferIndex, type)) &&
+            RHXDataBlock::checkUsbHeader(usbBuffer, usbBufferIndex + numBytesPerDataFrame, type)) {
+            // If we find two correct headers, assume the data in between is a good data block.
+            usbBufferIndex += numBytesPerDataFrame;
+            ++framesWritten;
+            headerChecked = true;
+            resynchronizing = false;
+            continue;
+        }
+        headerChecked = false;
+
+        // Write the run of good frames preceding the mismatch.
+        if (usbBufferIndex > runStart) {
+            if (!usbFifo->writeToBuffer(&usbBuffer[runStart], (usbBufferIndex - runStart) / BytesPerWord)) {
+                std::cerr << "USBDataThread: USB FIFO overrun (2)." << '\n';
+            }
+        }
+        if (!resynchronizing) {
+            resynchronizing = true;
+            ++numGlitchesRecovered;
+        }
+
+        int headerIndex = RHXDataBlock::findUsbHeader(usbBuffer, usbBufferIndex + BytesPerWord, usbBufferEnd, type);
+        if (headerIndex < 0) {
+            // No complete header left in the buffer; keep only the bytes that could hold the start of one.
+            int keepIndex = usbBufferEnd - (USBHeaderSizeInBytes - BytesPerWord);
+            usbBufferIndex = (std::max)(usbBufferIndex + BytesPerWord, keepIndex);
+        } else {
+            usbBufferIndex = headerIndex;
+            headerChecked = true;
+        }
+        runStart = usbBufferIndex;
+    }
+
+    if (usbBufferIndex > runStart) {
+        if (!usbFifo->writeToBuffer(&usbBuffer[runStart], (usbBufferIndex - runStart) / BytesPerWord)) {
+            std::cerr << "USBDataThread: USB FIFO overrun (2)." << '\n';
+        }
+    }
+    if (usbBufferIndex == usbBufferEnd) {
+        usbBufferIndex = 0;
+        usbBufferEnd = 0;
+    }
+    return framesWritten;
+}
+
 void USBDataThread::startRunning()
 {
     keepGoing = true;
@@ -57,9 +57,11 @@ public:
     void setErrorCheckingEnabled(bool enabled);
 
     bool memoryWasAllocated(double& memoryRequestedGB) const { memoryRequestedGB += memoryNeededGB; return memoryAllocated; }
+    int getNumGlitchesRecovered() const { return numGlitchesRecovered; }
 
 signals:
     void hardwareFifoReport(double percentFull);
+    void usbGlitchReport(int numGlitchesRecovered);
 
 private:
     AbstractRHXController* controller;
@@ -69,9 +71,18 @@ private:
     volatile bool stopThread;
     volatile int numUsbBlocksToRead;
 
+    // USB staging buffer: bytes in [usbBufferIndex, usbBufferEnd) have been read from the controller but not yet
+    // written to usbFifo.  New data is appended at usbBufferEnd; the unconsumed remainder is only moved back to
+    // the start of the buffer when there is no longer room for another full read.
     uint8_t* usbBuffer;
     int bufferSize;
     int usbBufferIndex;
+    int usbBufferEnd;
+
+    volatile int numGlitchesRecovered;
+
+    void compactUsbBuffer();
+    int writeCheckedDataFrames(ControllerType type, int numBytesPerDataFrame, bool& resynchronizing);
 
     bool memoryAllocated;
     double memoryNeededGB;
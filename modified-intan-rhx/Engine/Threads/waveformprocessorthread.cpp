@@ -47,6 +47,8 @@ WaveformProcessorThread::WaveformProcessorThread(SystemState* state_, int numDat
     usbFifo(usbFifo_),
     waveformFifo(waveformFifo_),
     numDataStreams(numDataStreams_),
+    digitalInWordWaveform(nullptr),
+    digitalOutWordWaveform(nullptr),
     xpuController(xpuController_),
     keepGoing(false),
     running(false),
@@ -57,12 +59,11 @@ WaveformProcessorThread::WaveformProcessorThread(SystemState* state_, int numDat
 
 void WaveformProcessorThread::run()
 {
-    const int NumBlocks = 1;  // Note: GPU spike extraction works on single data blocks only; this value must be 1 if spikes are read.
-    const int NumSamples = NumBlocks * RHXDataBlock::samplesPerDataBlock(type);
+    const int SamplesPerBlock = RHXDataBlock::samplesPerDataBlock(type);
     uint16_t* usbData = nullptr;
     bool firstTime = true;
     bool softwareRefInfoUpdated = false;
-    SoftwareReferenceProcessor swRefProcessor(type, numDataStreams, NumSamples, state);
+    SoftwareReferenceProcessor swRefProcessor(type, numDataStreams, SamplesPerBlock, state);
     QElapsedTimer loopTimer, workTimer, reportTimer;
 
     while (!stopThread) {
@@ -81,30 +82,43 @@ void WaveformProcessorThread::run()
 
             xpuController->resetPrev();
 
-            // Determine how many microseconds of data one block represents.
-//            float oneBlockus = (numSamples / sampleRate) * 1e6;
+            RHXDataReader dataReader(type, numDataStreams, nullptr, SamplesPerBlock);
 
             while (keepGoing && !stopThread) {
                 // workTimer.restart();
 
                 if (!softwareRefInfoUpdated) {
-                    // Update software referencing information.
+                    // Update software referencing information and waveform destinations.
                     swRefProcessor.updateReferenceInfo(signalSources);
+                    updateSignalTargets();
                     softwareRefInfoUpdated = true;
                 }
 
-                usbData = usbFifo->pointerToData(numUsbWords);  // Get pointer to new USB data, if available.
+                // Take every data block already waiting, up to MaxBatchDataBlocks. While the thread keeps up this is
+                // one block per pass; when the USB FIFO backs up, larger batches catch up at the cost of a little
+                // latency for the earliest blocks of the batch.
+                int numBlocks = usbFifo->wordsAvailable() / numUsbWords;
+                if (numBlocks > MaxBatchDataBlocks) numBlocks = MaxBatchDataBlocks;
+                else if (numBlocks < 1) numBlocks = 1;
+                int numSamples = numBlocks * SamplesPerBlock;
+
+                usbData = usbFifo->pointerToData(numBlocks * numUsbWords);  // Get pointer to new USB data, if available.
                 if (usbData) {
-                    if (state->getReportSpikes()) {
-                        state->advanceSpikeTimer();
+                    std::shared_ptr<const RealtimeParameters> parameters = state->realtimeParameters();
+                    if (parameters->reportSpikes) {
+                        for (int block = 0; block < numBlocks; ++block) {
+                            state->advanceSpikeTimer();
+                        }
                     }
                     workTimer.restart();
 
                     // Perform any software referencing prior to filtering.
-                    swRefProcessor.applySoftwareReferences(usbData);
+                    for (int block = 0; block < numBlocks; ++block) {
+                        swRefProcessor.applySoftwareReferences(usbData + block * numUsbWords);
+                    }
 
                     // Check for space to write the waveform data.
-                    while (!waveformFifo->requestWriteSpace(NumBlocks)) {
+                    while (!waveformFifo->requestWriteSpace(numBlocks)) {
                         usleep(100);
                     }
 
@@ -116,95 +130,66 @@ void WaveformProcessorThread::run()
                     uint32_t* spike = waveformFifo->pointerToGpuSpikeTimestampsWriteSpace();
                     uint8_t* spikeID = waveformFifo->pointerToGpuSpikeIdsWriteSpace();
 
-                    // Process one data block through GPU, and write the results to WaveformFifo.
-//                    auto start = chrono::steady_clock::now();
-
-                    xpuController->processDataBlock(usbData, low, wide, high, spike, spikeID);
-//                    auto end = chrono::steady_clock::now();
-
-                    // Determine how long this processing took, and report if it's approaching real-time.
-//                    float elapsedus = (float) chrono::duration_cast<chrono::microseconds>(end - start).count();
-//                    float gpuAccel = oneBlockus / elapsedus;
-//                    if (gpuAccel < 2.0)
-//                        qDebug() << "Warning: GPU process time approaching real-time. Real-time data block length: " << oneBlockus << " us. Processing time: " << elapsedus << " us. GPU is " << gpuAccel << "x faster";
+                    // Process the data blocks through the CPU or GPU, and write the results to WaveformFifo.
+                    xpuController->processDataBlocks(usbData, numBlocks, low, wide, high, spike, spikeID);
 
                     // Read and process waveform data from USB buffer, and write data to waveform FIFO.
-                    RHXDataReader dataReader(type, numDataStreams, usbData, NumSamples);
-
-                    float* analogWaveform = nullptr;
-                    uint16_t* digitalWaveform = nullptr;
+                    dataReader.setStart(usbData);
+                    dataReader.setNumSamples(numSamples);
 
                     int lastTimestamp = dataReader.readTimeStampData(waveformFifo->pointerToTimeStampWriteSpace());
                     state->setLastTimestamp(lastTimestamp);
 
                     QString spikingChannelNames("");
 
-                    for (int group = 0; group < signalSources->numGroups(); group++) {
-                        SignalGroup* signalGroup = signalSources->groupByIndex(group);
-                        for (int signal = 0; signal < signalGroup->numChannels(); signal++) {
-                            Channel* channel = signalGroup->channelByIndex(signal);
-                            std::string waveName = channel->getNativeNameString();
-                            if (channel->getSignalType() == AmplifierSignal) {
-                                GpuWaveformAddress gpuWaveformAddress = waveformFifo->getGpuWaveformAddress(waveName + "|SPK");
-                                digitalWaveform = waveformFifo->getDigitalWaveformPointer(waveName + "|SPK");
-                                // Note: GPU spike extraction only works on single data blocks.
-                                bool spikeFound = waveformFifo->extractGpuSpikeDataOneDataBlock(digitalWaveform, gpuWaveformAddress, firstTime);
-
-                                if (state->getReportSpikes()) {
-                                    if (spikeFound) {
-                                        spikingChannelNames.append(QString::fromStdString(waveName) + ",");
-                                        //state->spikeReport(QString::fromStdString(waveName));
-                                    }
-                                    // Find if a spike happened on this channel. If so, get its name
-                                    // If there's a name, send the spikeReport() signal.
-                                    // This signal should be ultimately received by ProbeMapWindow, which will then internally handle the time decay
-                                }
-
-                                if (signalSources->getControllerType() == ControllerStimRecord) {
-                                    // Load DC amplifier data and stimulation markers.
-                                    analogWaveform = waveformFifo->getAnalogWaveformPointer(waveName + "|DC");
-                                    dataReader.readDcAmplifierData(waveformFifo->pointerToAnalogWriteSpace(analogWaveform),
-                                                                   channel->getBoardStream(), channel->getChipChannel());
-                                    digitalWaveform = waveformFifo->getDigitalWaveformPointer(waveName + "|STIM");
-                                    dataReader.readStimParamData(waveformFifo->pointerToDigitalWriteSpace(digitalWaveform),
-                                                              channel->getBoardStream(), channel->getChipChannel());
-                                }
-                            } else if (channel->getSignalType() == AuxInputSignal) {
-                                analogWaveform = waveformFifo->getAnalogWaveformPointer(waveName);
-                                dataReader.readAuxInData(waveformFifo->pointerToAnalogWriteSpace(analogWaveform),
-                                                         channel->getBoardStream(), channel->getChipChannel());
-                            } else if (channel->getSignalType() == SupplyVoltageSignal) {
-                                analogWaveform = waveformFifo->getAnalogWaveformPointer(waveName);
-                                dataReader.readSupplyVoltageData(waveformFifo->pointerToAnalogWriteSpace(analogWaveform),
-                                                                 channel->getBoardStream());
-                            } else if (channel->getSignalType() == BoardAdcSignal) {
-                                analogWaveform = waveformFifo->getAnalogWaveformPointer(waveName);
-                                dataReader.readBoardAdcData(waveformFifo->pointerToAnalogWriteSpace(analogWaveform),
-                                                            channel->getNativeChannelNumber());
-                            } else if (channel->getSignalType() == BoardDacSignal) {
-                                analogWaveform = waveformFifo->getAnalogWaveformPointer(waveName);
-                                dataReader.readBoardDacData(waveformFifo->pointerToAnalogWriteSpace(analogWaveform),
-                                                            channel->getNativeChannelNumber());
-                            } else if (channel->getSignalType() == BoardDigitalInSignal) {
-                                analogWaveform = waveformFifo->getAnalogWaveformPointer(waveName);
-                                dataReader.readDigInData(waveformFifo->pointerToAnalogWriteSpace(analogWaveform),
-                                                         channel->getNativeChannelNumber());
-                            } else if (channel->getSignalType() == BoardDigitalOutSignal) {
-                                analogWaveform = waveformFifo->getAnalogWaveformPointer(waveName);
-                                dataReader.readDigOutData(waveformFifo->pointerToAnalogWriteSpace(analogWaveform),
-                                                         channel->getNativeChannelNumber());
+                    for (const SignalTarget &target : signalTargets) {
+                        switch (target.signalType) {
+                        case AmplifierSignal:
+                            if (waveformFifo->extractGpuSpikeData(target.spikeWaveform, target.spikeAddress, numBlocks, firstTime) &&
+                                    parameters->reportSpikes) {
+                                spikingChannelNames.append(target.name + ",");
+                            }
+                            if (target.stimWaveform) {
+                                // Load DC amplifier data and stimulation markers.
+                                dataReader.readDcAmplifierData(waveformFifo->pointerToAnalogWriteSpace(target.analogWaveform),
+                                                               target.boardStream, target.chipChannel);
+                                dataReader.readStimParamData(waveformFifo->pointerToDigitalWriteSpace(target.stimWaveform),
+                                                             target.boardStream, target.chipChannel);
                             }
+                            break;
+                        case AuxInputSignal:
+                            dataReader.readAuxInData(waveformFifo->pointerToAnalogWriteSpace(target.analogWaveform),
+                                                     target.boardStream, target.chipChannel);
+                            break;
+                        case SupplyVoltageSignal:
+                            dataReader.readSupplyVoltageData(waveformFifo->pointerToAnalogWriteSpace(target.analogWaveform),
+                                                             target.boardStream);
+                            break;
+                        case BoardAdcSignal:
+                            dataReader.readBoardAdcData(waveformFifo->pointerToAnalogWriteSpace(target.analogWaveform),
+                                                        target.nativeChannelNumber);
+                            break;
+                        case BoardDacSignal:
+                            dataReader.readBoardDacData(waveformFifo->pointerToAnalogWriteSpace(target.analogWaveform),
+                                                        target.nativeChannelNumber);
+                            break;
+                        case BoardDigitalInSignal:
+                            dataReader.readDigInData(waveformFifo->pointerToAnalogWriteSpace(target.analogWaveform),
+                                                     target.nativeChannelNumber);
+                            break;
+                        case BoardDigitalOutSignal:
+                            dataReader.readDigOutData(waveformFifo->pointerToAnalogWriteSpace(target.analogWaveform),
+                                                      target.nativeChannelNumber);
+                            break;
                         }
                     }
 
-                    if (state->getReportSpikes()) {
+                    if (parameters->reportSpikes) {
                         state->spikeReport(spikingChannelNames);
                     }
 
-                    digitalWaveform = waveformFifo->getDigitalWaveformPointer("DIGITAL-IN-WORD");
-                    dataReader.readDigInData(waveformFifo->pointerToDigitalWriteSpace(digitalWaveform));
-                    digitalWaveform = waveformFifo->getDigitalWaveformPointer("DIGITAL-OUT-WORD");
-                    dataReader.readDigOutData(waveformFifo->pointerToDigitalWriteSpace(digitalWaveform));
+                    dataReader.readDigInData(waveformFifo->pointerToDigitalWriteSpace(digitalInWordWaveform));
+                    dataReader.readDigOutData(waveformFifo->pointerToDigitalWriteSpace(digitalOutWordWaveform));
 
                     // Done reading and processing all waveforms.
                     waveformFifo->commitNewData();  // Commit waveform data we have just written.
@@ -273,3 +258,41 @@ bool WaveformProcessorThread::isActive() const
 {
     return running;
 }
+
+void WaveformProcessorThread::updateSignalTargets()
+{
+    signalTargets.clear();
+    bool stimController = signalSources->getControllerType() == ControllerStimRecord;
+    for (int group = 0; group < signalSources->numGroups(); group++) {
+        SignalGroup* signalGroup = signalSources->groupByIndex(group);
+        for (int signal = 0; signal < signalGroup->numChannels(); signal++) {
+            Channel* channel = signalGroup->channelByIndex(signal);
+            std::string waveName = channel->getNativeNameString();
+
+            SignalTarget target;
+            target.signalType = channel->getSignalType();
+            target.name = QString::fromStdString(waveName);
+            target.boardStream = channel->getBoardStream();
+            target.chipChannel = channel->getChipChannel();
+            target.nativeChannelNumber = channel->getNativeChannelNumber();
+            target.spikeAddress = GpuWaveformAddress();
+            target.spikeWaveform = nullptr;
+            target.stimWaveform = nullptr;
+            target.analogWaveform = nullptr;
+
+            if (target.signalType == AmplifierSignal) {
+                target.spikeAddress = waveformFifo->getGpuWaveformAddress(waveName + "|SPK");
+                target.spikeWaveform = waveformFifo->getDigitalWaveformPointer(waveName + "|SPK");
+                if (stimController) {
+                    target.analogWaveform = waveformFifo->getAnalogWaveformPointer(waveName + "|DC");
+                    target.stimWaveform = waveformFifo->getDigitalWaveformPointer(waveName + "|STIM");
+                }
+            } else {
+                target.analogWaveform = waveformFifo->getAnalogWaveformPointer(waveName);
+            }
+            signalTargets.push_back(target);
+        }
+    }
+    digitalInWordWaveform = waveformFifo->getDigitalWaveformPointer("DIGITAL-IN-WORD");
+    digitalOutWordWaveform = waveformFifo->getDigitalWaveformPointer("DIGITAL-OUT-WORD");
+}
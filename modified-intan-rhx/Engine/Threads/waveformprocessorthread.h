@@ -52,10 +52,30 @@ public:
     bool isActive() const;
     void close();
 
+    // Most data blocks run() takes from the USB FIFO at once when it has fallen behind. The WaveformFifo it writes
+    // to must accept writes of this many blocks.
+    static const int MaxBatchDataBlocks = 16;
+
 signals:
     void cpuLoadPercent(double percent);
 
 private:
+    // Where one signal's data goes in WaveformFifo, looked up once per run instead of once per data block
+    struct SignalTarget
+    {
+        SignalType signalType;
+        QString name;
+        int boardStream;
+        int chipChannel;
+        int nativeChannelNumber;
+        GpuWaveformAddress spikeAddress;    // amplifier channels
+        uint16_t* spikeWaveform;            // amplifier channels: |SPK
+        uint16_t* stimWaveform;             // amplifier channels on stim controllers: |STIM
+        float* analogWaveform;              // |DC for amplifier channels on stim controllers, else the signal itself
+    };
+
+    void updateSignalTargets();
+
     SystemState* state;
     SignalSources* signalSources;
     ControllerType type;
@@ -65,6 +85,9 @@ private:
     int numDataStreams;
 
     std::vector<double> cpuLoadHistory;
+    std::vector<SignalTarget> signalTargets;
+    uint16_t* digitalInWordWaveform;
+    uint16_t* digitalOutWordWaveform;
 
     XPUController* xpuController;
 
@@ -740,6 +740,7 @@ void BoardSelectDialog::startSoftware(ControllerType controllerType, AmplifierSa
     connect(controllerInterface, SIGNAL(setTimeLabel(QString)), controlWindow, SLOT(updateTimeLabel(QString)));
     connect(controllerInterface, SIGNAL(setTopStatusLabel(QString)), controlWindow, SLOT(updateTopStatusLabel(QString)));
     connect(controllerInterface, SIGNAL(setHardwareFifoStatus(double)), controlWindow, SLOT(updateHardwareFifoStatus(double)));
+    connect(controllerInterface, SIGNAL(setUsbGlitchCount(int)), controlWindow, SLOT(updateUsbGlitchCount(int)));
     connect(controllerInterface, SIGNAL(cpuLoadPercent(double)), controlWindow, SLOT(updateMainCpuLoad(double)));
 
     connect(controllerInterface->saveThread(), SIGNAL(setStatusBar(QString)), controlWindow, SLOT(updateStatusBar(QString)));
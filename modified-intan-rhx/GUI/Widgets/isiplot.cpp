@@ -189,24 +189,22 @@ void ISIPlot::keyPressEvent(QKeyEvent* event)
 bool ISIPlot::updateWaveforms(WaveformFifo *waveformFifo, int numSamples)
 {
     if (!waveformFifo->gpuWaveformPresent(waveName + "|SPK")) return false;
-    uint16_t* spikeTrain = waveformFifo->getDigitalWaveformPointer(waveName + "|SPK");
-    if (!spikeTrain) return false;
-
-    bool foundNewSpikes = false;
-    for (int t = 0; t < numSamples; ++t) {
-        if (waveformFifo->getDigitalData(WaveformFifo::ReaderDisplay, spikeTrain, t) != 0) {
-            foundNewSpikes = true;
-            uint32_t newTimeStamp = waveformFifo->getTimeStamp(WaveformFifo::ReaderDisplay, t);
-            if (lastTimeStamp != 0u) {
-                int newISI = (int)((int64_t)newTimeStamp - (int64_t)lastTimeStamp);
-                if ((newISI < (int) isiCount.size()) && (newISI > 0)) {
-                    ++isiCount[newISI];
-                    ++numISIsRecorded;
-                    if (newISI > largestISIrecorded) largestISIrecorded = newISI;
-                }
+    GpuWaveformAddress waveformAddress = waveformFifo->getGpuWaveformAddress(waveName + "|SPK");
+    if (waveformAddress.waveformIndex < 0) return false;
+
+    waveformFifo->getSpikeEvents(WaveformFifo::ReaderDisplay, spikeEvents, 0, numSamples, waveformAddress.waveformIndex);
+    bool foundNewSpikes = !spikeEvents.empty();
+    for (const SpikeEvent& event : spikeEvents) {
+        uint32_t newTimeStamp = event.timeStamp;
+        if (lastTimeStamp != 0u) {
+            int newISI = (int)((int64_t)newTimeStamp - (int64_t)lastTimeStamp);
+            if ((newISI < (int) isiCount.size()) && (newISI > 0)) {
+                ++isiCount[newISI];
+                ++numISIsRecorded;
+                if (newISI > largestISIrecorded) largestISIrecorded = newISI;
             }
-            lastTimeStamp = newTimeStamp;
         }
+        lastTimeStamp = newTimeStamp;
     }
     if (foundNewSpikes) {
         calculateHistogram();
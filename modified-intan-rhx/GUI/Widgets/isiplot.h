@@ -73,6 +73,7 @@ private:
     std::string waveName;
 
     std::vector<int> isiCount;
+    std::vector<SpikeEvent> spikeEvents;    // reused across updates
     std::vector<float> timeScaleISI;
     int largestISIrecorded;
     int numISIsRecorded;
@@ -1572,11 +1572,20 @@ void MultiWaveformPlot::loadWaveformData(WaveformFifo* waveformFifo)
     }
     bool loadAllFilters = true;
     bool dcWaveformsPreset = state->getControllerTypeEnum() == ControllerStimRecord;
+    visibleAmplifierIndices.clear();
     for (int i = 0; i < displayList.size(); ++i) {
         if (displayList.at(i).isCurrentlyVisible && !displayList.at(i).isDivider()) {
         // Of interest for future improvements to high-efficiency data plotting:
         // inefficient way to make sure all data is plotted immediately after scrolling
         //if (!displayList.at(i).isDivider()) {
+            if (loadAllFilters && displayList.at(i).isAmplifier()) {
+                // Amplifier channels are gathered up and loaded together (all filters) below.
+                int amplifierIndex = waveformManager->amplifierIndex(displayList.at(i).channel);
+                if (amplifierIndex >= 0) {
+                    visibleAmplifierIndices.push_back(amplifierIndex);
+                    continue;
+                }
+            }
             QString waveName = displayList.at(i).waveName;
             if (!loadAllFilters || !waveName.contains('|')) {
                 waveformManager->loadNewData(waveformFifo, waveName);
@@ -1592,6 +1601,7 @@ void MultiWaveformPlot::loadWaveformData(WaveformFifo* waveformFifo)
             }
         }
     }
+    waveformManager->loadNewAmplifierData(waveformFifo, visibleAmplifierIndices);
     // Note: repaint() seems to give slightly smoother animation than update(), but may cause "QWidget::repaint.
     // Recursive repaint detected" crash when columns are added.
 //    repaint();
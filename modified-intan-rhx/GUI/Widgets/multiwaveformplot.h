@@ -147,6 +147,7 @@ private:
 
     QList<DisplayedWaveform> displayList;
     QList<DisplayedWaveform> pinnedList;
+    std::vector<int> visibleAmplifierIndices;  // Scratch list used by loadWaveformData()
     int pinnedYDivider;
     WaveIndex hoverWaveIndex;
     bool showPinned;
@@ -326,6 +326,7 @@ ColorScale::ColorScale(float minValue_, float maxValue_) :
 {
     valueRange = maxValue - minValue;
     colorMap.resize(ColorMapSize);
+    rgbMap.resize(ColorMapSize);
     calculateColorMap();
 }
 
@@ -348,6 +349,17 @@ QColor ColorScale::getColor(double value) const
     return colorMap[index];
 }
 
+QRgb ColorScale::getRgb(float value) const
+{
+    int index = qRound((ColorMapSize - 1) * (value - minValue) / valueRange);
+    if (index < 0) {
+        index = 0;
+    } else if (index >= ColorMapSize) {
+        index = ColorMapSize - 1;
+    }
+    return rgbMap[index];
+}
+
 void ColorScale::copyColorMapToArray(std::vector<std::vector<float> >& mapArray) const
 {
     for (int i = 0; i < (int) mapArray.size(); ++i) {
@@ -409,4 +421,8 @@ void ColorScale::calculateColorMap()
         hue = 355.0;
         colorMap[i] = QColor::fromHsv(hue, saturation, value);
     }
+
+    for (int i = 0; i < ColorMapSize; ++i) {
+        rgbMap[i] = colorMap[i].rgb();
+    }
 }
@@ -224,8 +224,8 @@ void PSTHPlot::keyPressEvent(QKeyEvent* event)
 bool PSTHPlot::updateWaveforms(WaveformFifo* waveformFifo, int numSamples)
 {
     if (!waveformFifo->gpuWaveformPresent(waveName + "|SPK")) return false;
-    uint16_t* spikeTrain = waveformFifo->getDigitalWaveformPointer(waveName + "|SPK");
-    if (!spikeTrain) return false;
+    GpuWaveformAddress waveformAddress = waveformFifo->getGpuWaveformAddress(waveName + "|SPK");
+    if (waveformAddress.waveformIndex < 0) return false;
 
     QString triggerChannelName = state->digitalTriggerPSTH->getValueString();
     bool useAnalogTrigger = triggerChannelName.left(1).toUpper() == "A";
@@ -246,8 +246,11 @@ bool PSTHPlot::updateWaveforms(WaveformFifo* waveformFifo, int numSamples)
         }
     }
 
-    for (int t = 0; t < numSamples; ++t) {
-        spikeTrainQueue.push_back(waveformFifo->getDigitalData(WaveformFifo::ReaderDisplay, spikeTrain, t));
+    int queueStart = (int) spikeTrainQueue.size();
+    spikeTrainQueue.resize(queueStart + numSamples, SpikeIdNoSpike);
+    waveformFifo->getSpikeEvents(WaveformFifo::ReaderDisplay, spikeEvents, 0, numSamples, waveformAddress.waveformIndex);
+    for (const SpikeEvent& event : spikeEvents) {
+        spikeTrainQueue[queueStart + event.timeIndex] = event.spikeId;
     }
 
     bool risingEdge = state->triggerPolarityPSTH->getValue() == "Rising";
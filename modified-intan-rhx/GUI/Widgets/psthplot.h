@@ -78,6 +78,7 @@ private:
     std::deque<uint16_t> digitalWaveformQueue;
     std::vector<std::vector<uint8_t> > rasters;
     std::vector<uint16_t> triggerWaveform;
+    std::vector<SpikeEvent> spikeEvents;    // reused across updates
     std::vector<float> histogram;
     std::vector<float> histogramTScale;
     QImage rasterImage;
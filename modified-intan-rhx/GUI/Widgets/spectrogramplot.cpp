@@ -47,10 +47,8 @@ SpectrogramPlot::SpectrogramPlot(SystemState* state_, QWidget * parent) :
     psdUnitsMicro = " " + MicroVoltsSymbol + "/" + SqrtSymbol + "Hz";
     lastMouseWasInFrame = false;
 
-    int maxFftSize = (int) state->fftSizeSpectrogram->getNumericValue(state->fftSizeSpectrogram->numberOfItems() - 1);
-    fftInputBuffer = new float [maxFftSize];
-
-    fftEngine = new FastFourierTransform(state->sampleRate->getNumericValue());
+    spectrogramEngine = new SpectrogramEngine(state->sampleRate->getNumericValue(),
+                                              (int) state->fftSizeSpectrogram->getNumericValue(), 1);
     setNewFftSize((int) state->fftSizeSpectrogram->getNumericValue());
     setNewTimeScale(state->tScaleSpectrogram->getNumericValue());
     resetSpectrogram();
@@ -60,8 +58,7 @@ SpectrogramPlot::SpectrogramPlot(SystemState* state_, QWidget * parent) :
 
 SpectrogramPlot::~SpectrogramPlot()
 {
-    delete [] fftInputBuffer;
-    delete fftEngine;
+    delete spectrogramEngine;
     delete colorScale;
 }
 
@@ -116,13 +113,13 @@ void SpectrogramPlot::updateFromState()
 void SpectrogramPlot::setNewFftSize(int fftSize_)
 {
     fftSize = fftSize_;
-    fftEngine->setLength(fftSize);
-    int fSize = fftSize/2 + 1;
+    spectrogramEngine->setFftSize(fftSize);
+    int fSize = spectrogramEngine->getNumFrequencies();
     fMinIndex = 0;
     fMaxIndex = fSize - 1;
     frequencyScale.resize(fSize);
     for (int i = 0; i < fSize; ++i) {
-        frequencyScale[i] = fftEngine->getFrequency(i);
+        frequencyScale[i] = spectrogramEngine->getFrequency(i);
     }
     updateFMinMaxIndex();
 }
@@ -152,19 +149,13 @@ void SpectrogramPlot::setNewTimeScale(double tScale_)
     for (int i = 0; i < tSize; ++i) {
         timeScale[i] = i * tStep;
     }
+    spectrogramEngine->setNumColumns(tSize);
 }
 
 void SpectrogramPlot::resetSpectrogram()
 {
-    for (int i = 0; i < (int) psdSpectrogram.size(); ++i) {
-        psdSpectrogram[i].clear();
-    }
-    psdSpectrogram.resize(tSize);
+    spectrogramEngine->reset();
     int fSize = (int) frequencyScale.size();
-    for (int i = 0; i < tSize; ++i) {
-        psdSpectrogram[i].resize(fSize);
-        fill(psdSpectrogram[i].begin(), psdSpectrogram[i].end(), -10.0F);
-    }
     psdSpectrum.clear();
     psdSpectrum.resize(fSize);
     fill(psdSpectrum.begin(), psdSpectrum.end(), -10.0F);
@@ -172,11 +163,6 @@ void SpectrogramPlot::resetSpectrogram()
     psdRawImage = QImage(QSize(tSize, fSize), QImage::Format_ARGB32_Premultiplied);
     psdRawImage.fill(Qt::darkGray);
 
-    tIndex = 0;
-    numValidTStepsInSpectrogram = 0;
-    spectrogramFull = false;
-
-    amplifierWaveformQueue.clear();
     amplifierWaveformRecordQueue.clear();
     digitalWaveformQueue.clear();
     waveformTimeStampQueue.clear();
@@ -223,67 +209,69 @@ bool SpectrogramPlot::updateWaveforms(WaveformFifo* waveformFifo, int numSamples
     QString digitalChannelName = state->digitalDisplaySpectrogram->getValueString();
     bool useAnalogAsDigital = digitalChannelName.left(1).toUpper() == "A";
 
+    digitalWaveform.resize(numSamples);
     if (!useAnalogAsDigital) {  // Get digital signal
         uint16_t* digitalInWaveform = waveformFifo->getDigitalWaveformPointer("DIGITAL-IN-WORD");
-        for (int t = 0; t < numSamples; ++t) {
-            digitalWaveformQueue.push_back(waveformFifo->getDigitalData(WaveformFifo::ReaderDisplay, digitalInWaveform, t));
-        }
+        waveformFifo->copyDigitalData(WaveformFifo::ReaderDisplay, digitalWaveform.data(), digitalInWaveform, 0, numSamples);
     } else {  // Get thresholded analog signal as digital signal
         float* analogInWaveform = waveformFifo->getAnalogWaveformPointer(digitalChannelName.toStdString());
         float logicThreshold = (float)state->triggerAnalogVoltageThreshold->getValue();
         for (int t = 0; t < numSamples; ++t) {
-            digitalWaveformQueue.push_back(waveformFifo->getAnalogDataAsDigital(WaveformFifo::ReaderDisplay,
-                                                                                analogInWaveform, t, logicThreshold));
+            digitalWaveform[t] = waveformFifo->getAnalogDataAsDigital(WaveformFifo::ReaderDisplay, analogInWaveform, t, logicThreshold);
         }
     }
 
-    for (int t = 0; t < numSamples; ++t) {
-        amplifierWaveformQueue.push_back(waveformFifo->getGpuAmplifierData(WaveformFifo::ReaderDisplay, waveformAddress, t));
-        amplifierWaveformRecordQueue.push_back(waveformFifo->getGpuAmplifierData(WaveformFifo::ReaderDisplay, waveformAddress, t));
-        waveformTimeStampQueue.push_back(waveformFifo->getTimeStamp(WaveformFifo::ReaderDisplay, t));
+    amplifierWaveform.resize(numSamples);
+    waveformTimeStamps.resize(numSamples);
+    waveformFifo->copyGpuAmplifierData(WaveformFifo::ReaderDisplay, amplifierWaveform.data(), waveformAddress, 0, numSamples);
+    waveformFifo->copyTimeStamps(WaveformFifo::ReaderDisplay, waveformTimeStamps.data(), 0, numSamples);
+
+    digitalWaveformQueue.insert(digitalWaveformQueue.end(), digitalWaveform.begin(), digitalWaveform.end());
+    amplifierWaveformRecordQueue.insert(amplifierWaveformRecordQueue.end(), amplifierWaveform.begin(), amplifierWaveform.end());
+    waveformTimeStampQueue.insert(waveformTimeStampQueue.end(), waveformTimeStamps.begin(), waveformTimeStamps.end());
+
+    int numValidColumnsBefore = spectrogramEngine->getNumValidColumns(0);
+    int numNewColumns = spectrogramEngine->addSamples(0, amplifierWaveform.data(), numSamples);  // Calculate FFTs and PSDs.
+
+    // Once the spectrogram is full, discard half an FFT window of recorded waveform for each new column so the
+    // recorded waveform spans the same time as the spectrogram.
+    int numColumnsPastFull = std::min(numNewColumns, std::max(0, numValidColumnsBefore + numNewColumns - tSize));
+    if (numColumnsPastFull > 0) {
+        int numToDiscard = numColumnsPastFull * (fftSize / 2);
+        amplifierWaveformRecordQueue.erase(amplifierWaveformRecordQueue.begin(), amplifierWaveformRecordQueue.begin() + numToDiscard);
+        waveformTimeStampQueue.erase(waveformTimeStampQueue.begin(), waveformTimeStampQueue.begin() + numToDiscard);
+        digitalWaveformQueue.erase(digitalWaveformQueue.begin(), digitalWaveformQueue.begin() + numToDiscard);
     }
 
-    float* fftOut;
-    while ((int) amplifierWaveformQueue.size() >= fftSize) {
-        for (int tIndex = 0; tIndex < fftSize; ++tIndex) {
-            fftInputBuffer[tIndex] = amplifierWaveformQueue[tIndex];  // Copy N samples for FFT.
-        }
-
-        for (int i = 0; i < fftSize / 2; ++i) {    // Advance window by N/2 samples.
-            amplifierWaveformQueue.pop_front();
-        }
-        if (spectrogramFull) {
-            for (int i = 0; i < fftSize / 2; ++i) {
-                amplifierWaveformRecordQueue.pop_front();
-                waveformTimeStampQueue.pop_front();
-                digitalWaveformQueue.pop_front();
-            }
-        }
-
-        fftOut = fftEngine->logSqrtPowerSpectralDensity(fftInputBuffer);  // Calculate FFT and PSD.
+    if (numNewColumns > 0) {
+        const float* latestPsd = spectrogramEngine->getLatestColumn(0);
+        std::copy(latestPsd, latestPsd + psdSpectrum.size(), psdSpectrum.begin());
+        drawNewPsdColumns(numNewColumns);
+    }
 
-        int fSize = (int) frequencyScale.size();
-        for (int fIndex = 0; fIndex < fSize; ++fIndex) {
-            psdSpectrum[fIndex] = fftOut[fIndex];
-            psdSpectrogram[tIndex][fIndex] = fftOut[fIndex];   // Read out results of power spectral density (PSD).
-        }
+    update();
+    return true;
+}
 
-        QPainter psdPainter(&psdRawImage);
-        psdPainter.drawImage(QRect(0, 0, tSize - 1, fSize), psdRawImage, QRect(1, 0, tSize - 1, fSize));  // shift existing PSD
+// Color in the most recently calculated spectrogram columns.  Rather than shifting the whole image left for every new
+// column, psdRawImage is written circularly and unrolled when painted.
+void SpectrogramPlot::drawNewPsdColumns(int numNewColumns)
+{
+    int fSize = (int) frequencyScale.size();
+    int numColumns = std::min(numNewColumns, tSize);
+    int column = spectrogramEngine->getNextColumnIndex(0) - numColumns;
+    if (column < 0) column += tSize;
+
+    uchar* bits = psdRawImage.bits();
+    int bytesPerLine = psdRawImage.bytesPerLine();
+    for (int i = 0; i < numColumns; ++i) {
+        const float* psd = spectrogramEngine->getColumn(0, column);
         for (int fIndex = 0; fIndex < fSize; ++fIndex) {
-            // Draw new PSD column.
-            psdRawImage.setPixelColor(tSize - 1, fSize - fIndex - 1, colorScale->getColor(psdSpectrogram[tIndex][fIndex]));
+            QRgb* line = reinterpret_cast<QRgb*>(bits + (fSize - fIndex - 1) * bytesPerLine);
+            line[column] = colorScale->getRgb(psd[fIndex]);
         }
-
-        if (++tIndex == tSize) {
-            tIndex = 0;
-            spectrogramFull = true;
-        }
-        if (++numValidTStepsInSpectrogram > tSize) numValidTStepsInSpectrogram = tSize;
+        if (++column == tSize) column = 0;
     }
-
-    update();
-    return true;
 }
 
 void SpectrogramPlot::resizeEvent(QResizeEvent* /* event */) {
@@ -343,6 +331,7 @@ void SpectrogramPlot::paintEvent(QPaintEvent* /* event */)
             plotDecorator.writeLabel(state->digitalDisplaySpectrogram->getDisplayValueString(),
                                      ctDigital.xLeft() + 2, ctDigital.yTop() - 1, Qt::AlignLeft | Qt::AlignBottom);
             // Draw digital waveform.
+            int numValidTStepsInSpectrogram = spectrogramEngine->getNumValidColumns(0);
             if (numValidTStepsInSpectrogram != 0) {
                 const int YDigitalZero = ctDigital.screenYFromRealY(0);
                 const int YDigitalOne = ctDigital.screenYFromRealY(1);
@@ -440,9 +429,18 @@ void SpectrogramPlot::paintEvent(QPaintEvent* /* event */)
         plotDecorator.drawTickMarkRight(ctColorScale, 3.0 + Log10_2, TickMarkMinorLength);
         plotDecorator.drawTickMarkRight(ctColorScale, 3.0 + Log10_3, TickMarkMinorLength);
 
-        // Scale and insert power spectral density (PSD) image.
-        painter.drawImage(scopeFrame, psdRawImage,
-                          QRect(0, psdRawImage.height() - fMaxIndex - 1, psdRawImage.width(), fMaxIndex - fMinIndex + 1));
+        // Scale and insert power spectral density (PSD) image.  The image is circular in time, with the oldest column
+        // at the engine's next column index, so insert it in two pieces: oldest columns on the left, newest on the right.
+        int oldestColumn = spectrogramEngine->getNextColumnIndex(0);
+        int sourceTop = psdRawImage.height() - fMaxIndex - 1;
+        int sourceHeight = fMaxIndex - fMinIndex + 1;
+        double xSplit = scopeFrame.left() + scopeFrame.width() * (double)(tSize - oldestColumn) / (double)tSize;
+        painter.drawImage(QRectF(scopeFrame.left(), scopeFrame.top(), xSplit - scopeFrame.left(), scopeFrame.height()),
+                          psdRawImage, QRectF(oldestColumn, sourceTop, tSize - oldestColumn, sourceHeight));
+        if (oldestColumn > 0) {
+            painter.drawImage(QRectF(xSplit, scopeFrame.top(), scopeFrame.left() + scopeFrame.width() - xSplit, scopeFrame.height()),
+                              psdRawImage, QRectF(0, sourceTop, oldestColumn, sourceHeight));
+        }
 
         // Label frequency axis.
         painter.setPen(Qt::white);
@@ -566,6 +564,7 @@ void SpectrogramPlot::paintEvent(QPaintEvent* /* event */)
 
 bool SpectrogramPlot::saveMatFile(const QString& fileName) const
 {
+    int numValidTStepsInSpectrogram = spectrogramEngine->getNumValidColumns(0);
     if (numValidTStepsInSpectrogram == 0) return false;
 
     bool spectrogramMode = state->displayModeSpectrogram->getValue() == "Spectrogram";
@@ -610,11 +609,12 @@ bool SpectrogramPlot::saveMatFile(const QString& fileName) const
         }
 
         std::vector<std::vector<float> > psdArray(numValidTStepsInSpectrogram);
-        int index = spectrogramFull ? tIndex : 0;
+        int index = spectrogramEngine->isFull(0) ? spectrogramEngine->getNextColumnIndex(0) : 0;
         for (int i = 0; i < numValidTStepsInSpectrogram; ++i) {
             psdArray[i].resize(fRange);
+            const float* psdColumn = spectrogramEngine->getColumn(0, index);
             for (int j = fMinIndex; j <= fMaxIndex; ++j) {
-                psdArray[i][j - fMinIndex] = psdSpectrogram[index][j];
+                psdArray[i][j - fMinIndex] = psdColumn[j];
             }
             if (++index == tSize) index = 0;
         }
@@ -660,6 +660,7 @@ bool SpectrogramPlot::saveMatFile(const QString& fileName) const
 
 bool SpectrogramPlot::saveCsvFile(QString fileName) const
 {
+    int numValidTStepsInSpectrogram = spectrogramEngine->getNumValidColumns(0);
     if (numValidTStepsInSpectrogram == 0) return false;
 
     if (fileName.right(4).toLower() != ".csv") fileName.append(".csv");
@@ -678,11 +679,12 @@ bool SpectrogramPlot::saveCsvFile(QString fileName) const
         }
         outStream << EndOfLine;
 
-        int index = spectrogramFull ? tIndex : 0;
+        int index = spectrogramEngine->isFull(0) ? spectrogramEngine->getNextColumnIndex(0) : 0;
         for (int i = 0; i < numValidTStepsInSpectrogram; ++i) {
             outStream << i * tStep << ",";
+            const float* psdColumn = spectrogramEngine->getColumn(0, index);
             for (int j = fMinIndex; j <= fMaxIndex; ++j) {
-                outStream << psdSpectrogram[index][j] << ",";
+                outStream << psdColumn[j] << ",";
             }
             if (++index == tSize) index = 0;
             outStream << EndOfLine;
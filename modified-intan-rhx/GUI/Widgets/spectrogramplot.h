@@ -41,7 +41,7 @@
 #include "plotutilities.h"
 #include "waveformfifo.h"
 #include "rhxglobals.h"
-#include "fastfouriertransform.h"
+#include "spectrogramengine.h"
 
 class SpectrogramPlot : public QWidget
 {
@@ -78,29 +78,28 @@ private:
     SystemState* state;
     std::string waveName;
 
-    std::deque<float> amplifierWaveformQueue;
     std::deque<float> amplifierWaveformRecordQueue;
     std::deque<uint16_t> digitalWaveformQueue;
     std::deque<uint32_t> waveformTimeStampQueue;
 
-    FastFourierTransform* fftEngine;
+    // Per-update copies of new waveform FIFO data
+    std::vector<float> amplifierWaveform;
+    std::vector<uint16_t> digitalWaveform;
+    std::vector<uint32_t> waveformTimeStamps;
+
+    SpectrogramEngine* spectrogramEngine;
     int fftSize;
 
     double tScale;
     int tSize;
-    int tIndex;
-    int numValidTStepsInSpectrogram;
-    bool spectrogramFull;
     double tStep;
 
-    float* fftInputBuffer;
     std::vector<float> frequencyScale;
     int fMinIndex;
     int fMaxIndex;
     std::vector<float> timeScale;
     std::vector<float> psdSpectrum;
-    std::vector<std::vector<float> > psdSpectrogram;
-    QImage psdRawImage;
+    QImage psdRawImage;  // Circular in time; column i holds spectrogram engine column i.
 
     double psdScaleMin;
     double psdScaleMax;
@@ -114,6 +113,7 @@ private:
     void setNewFftSize(int fftSize_);
     void updateFMinMaxIndex();
     void setNewTimeScale(double tScale_);
+    void drawNewPsdColumns(int numNewColumns);
 };
 
 #endif // SPECTROGRAMPLOT_H
@@ -396,10 +396,16 @@ bool SpikePlot::updateWaveforms(WaveformFifo* waveformFifo, int numSamples)
     }
     bool showArtifacts = state->artifactsShown->getValue();
     int numSpikesDisplayed = (int) state->numSpikesDisplayed->getNumericValue();
-    int spikeId;
-    for (int t = tStart; t < numSamples - offset; ++t) {
-        spikeId = (int) waveformFifo->getDigitalData(WaveformFifo::ReaderDisplay, spikeRaster, t);
-        if (spikeId != SpikeIdNoSpike && (t - samplesPreDetect >= -numWordsInMemory)) {
+    if (numSamples - offset > tStart) {
+        waveformFifo->getSpikeEvents(WaveformFifo::ReaderDisplay, spikeEvents, tStart, numSamples - offset - tStart,
+                                     waveformAddress.waveformIndex);
+    } else {
+        spikeEvents.clear();
+    }
+    for (const SpikeEvent& event : spikeEvents) {
+        int t = event.timeIndex;
+        int spikeId = event.spikeId;
+        if (t - samplesPreDetect >= -numWordsInMemory) {
             if (showArtifacts || spikeId != SpikeIdLikelyArtifact) {
                 std::vector<float> newSnippet(samplesPreDetect + samplesPostDetect);
                 int index = 0;
@@ -416,26 +422,11 @@ bool SpikePlot::updateWaveforms(WaveformFifo* waveformFifo, int numSamples)
         }
     }
 
-    // Calculate RMS level from recent waveform data.
-    latestRmsCalculation = 0.0;
-    latestSpikeRateCalculation = 0;
-    if (numWordsInMemory > 0) {
-        int numWordsForRms = std::min(numWordsInMemory, (int)ceil(state->sampleRate->getNumericValue()));  // Last one second of data.
-        int numSamples = 0;
-        int numSpikes = 0;
-        double sumOfSquares = 0.0;
-        for (int t = -numWordsForRms; t < 0; ++t) {
-            float sample = waveformFifo->getGpuAmplifierData(WaveformFifo::ReaderDisplay, waveformAddress, t);
-            sumOfSquares += sample * sample;
-            int spikeId = waveformFifo->getDigitalData(WaveformFifo::ReaderDisplay, spikeRaster, t);
-            if (spikeId != SpikeIdNoSpike && spikeId != SpikeIdLikelyArtifact) {
-                ++numSpikes;
-            }
-            ++numSamples;
-        }
-        latestRmsCalculation = sqrt(sumOfSquares / (double)numSamples);
-        latestSpikeRateCalculation = numSpikes;
-    }
+    // RMS level and spike rate over the last second, from the running per-channel statistics.
+    ChannelStats stats = waveformFifo->highpassStatistics()->getStatistics(waveformAddress.waveformIndex,
+                                                                            (int)ceil(state->sampleRate->getNumericValue()));
+    latestRmsCalculation = stats.rms;
+    latestSpikeRateCalculation = stats.spikeCount;
 
     update();
     return true;
@@ -93,6 +93,7 @@ private:
     QImage image;
 
     std::map<std::string, SpikePlotHistory*> spikeHistoryMap;
+    std::vector<SpikeEvent> spikeEvents;    // reused across updates
 
     const QColor SnapshotColor = QColor(140, 83, 25);
 
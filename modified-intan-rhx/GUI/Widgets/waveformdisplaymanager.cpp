@@ -29,6 +29,8 @@
 //------------------------------------------------------------------------------
 
 #include <QPainter>
+#include "rhxdatablock.h"
+#include "signalsources.h"
 #include "waveformdisplaymanager.h"
 
 WaveformDisplayManager::WaveformDisplayManager(SystemState* state_, int maxWidthInPixels_, int numRefreshZones_) :
@@ -90,6 +92,7 @@ bool WaveformDisplayManager::addWaveform(const QString& waveName, bool isStim, b
     if (data.find(name) != data.end()) return false;  // No repeats!  Do not read from the Waveform FIFO twice!
 
     WaveformDisplayDataStore* ds = new WaveformDisplayDataStore;
+    ds->name = name;
     ds->isRaster = isRaster;
     ds->hasStimFlags = (isStim && !isRaster) && !state->testMode->getValue();
     QString filterText = waveName.section('|', 1, 1);
@@ -108,6 +111,7 @@ bool WaveformDisplayManager::addWaveform(const QString& waveName, bool isStim, b
     }
 
     data[name] = ds;
+    setAmplifierData(waveName, ds);
     reset(ds);
     return true;
 }
@@ -116,11 +120,54 @@ bool WaveformDisplayManager::removeWaveform(const QString& waveName)
 {
     std::string name = waveName.toStdString();
     if (data.find(name) == data.end()) return false;
+    setAmplifierData(waveName, nullptr);
     delete data.at(name);
     data.erase(name);
     return true;
 }
 
+void WaveformDisplayManager::removeAllWaveforms()
+{
+    std::map<std::string, WaveformDisplayDataStore*>::const_iterator it = data.begin();
+    while (it != data.end()) {
+        delete it->second;
+        ++it;
+    }
+    data.clear();
+    amplifierData.clear();
+}
+
+// Enter (or clear, if ds is nullptr) the amplifier index table entry for waveName.  Non-amplifier waveforms are ignored.
+void WaveformDisplayManager::setAmplifierData(const QString& waveName, WaveformDisplayDataStore* ds)
+{
+    QString filterText = waveName.section('|', 1, 1);
+    int filter;
+    if (filterText == "WIDE") filter = AmplifierWide;
+    else if (filterText == "LOW") filter = AmplifierLow;
+    else if (filterText == "HIGH") filter = AmplifierHigh;
+    else if (filterText == "SPK") filter = AmplifierSpike;
+    else if (filterText == "DC") filter = AmplifierDC;
+    else return;
+
+    int index = amplifierIndex(state->signalSources->channelByName(waveName.section('|', 0, 0)));
+    if (index < 0) return;
+    if (index >= (int) amplifierData.size()) {
+        if (!ds) return;
+        std::array<WaveformDisplayDataStore*, NumAmplifierFilters> empty;
+        empty.fill(nullptr);
+        amplifierData.resize(index + 1, empty);
+    }
+    amplifierData[index][filter] = ds;
+}
+
+int WaveformDisplayManager::amplifierIndex(const Channel* channel) const
+{
+    if (!channel) return -1;
+    if (channel->getSignalType() != AmplifierSignal) return -1;
+    return channel->getBoardStream() * RHXDataBlock::channelsPerStream(state->getControllerTypeEnum()) +
+            channel->getChipChannel();
+}
+
 // Call this method before calling loadNewData() on waveforms.
 void WaveformDisplayManager::prepForLoadingNewData()
 {
@@ -208,7 +255,70 @@ void WaveformDisplayManager::loadNewData(const WaveformFifo* waveformFifo, const
     WaveformDisplayDataStore* ds = it->second;
     if (!ds) return;
 
-    if (ds->hasAlreadyLoaded) return;   // Don't load the same data twice.
+    if (!prepForNewSegment(waveformFifo, ds)) return;
+    loadDataSegment(waveformFifo, ds, newSegmentStartPos(), newSegmentEndPos(), 0);
+}
+
+// Load new data for all filtered versions of the amplifier channels listed (by GPU waveform index; see amplifierIndex()).
+// GPU-processed waveforms of the same filter type are read from the waveform FIFO in a single pass across all channels,
+// rather than one channel at a time.
+void WaveformDisplayManager::loadNewAmplifierData(const WaveformFifo* waveformFifo, const std::vector<int>& amplifierIndices) const
+{
+    for (int filter = 0; filter < NumAmplifierFilters; ++filter) {
+        batchStores.clear();
+        batchAddresses.clear();
+        for (int i = 0; i < (int) amplifierIndices.size(); ++i) {
+            int index = amplifierIndices[i];
+            if (index < 0 || index >= (int) amplifierData.size()) continue;
+            WaveformDisplayDataStore* ds = amplifierData[index][filter];
+            if (!ds) continue;
+            if (!prepForNewSegment(waveformFifo, ds)) continue;
+            if (ds->gpuWaveformAddress.waveformIndex >= 0 && !ds->hasStimFlags) {
+                batchStores.push_back(ds);
+                batchAddresses.push_back(ds->gpuWaveformAddress);
+            } else {
+                loadDataSegment(waveformFifo, ds, newSegmentStartPos(), newSegmentEndPos(), 0);
+            }
+        }
+        if (!batchStores.empty()) {
+            loadGpuDataSegmentBatch(waveformFifo, newSegmentStartPos(), newSegmentEndPos());
+        }
+    }
+}
+
+// Look up (by name) where this waveform lives in the waveform FIFO, unless already done for the current FIFO allocation.
+void WaveformDisplayManager::resolveFifoAddresses(const WaveformFifo* waveformFifo, WaveformDisplayDataStore* ds) const
+{
+    if (ds->resolvedFifo == waveformFifo && ds->resolvedAllocationCount == waveformFifo->getAllocationCount()) return;
+
+    ds->gpuWaveformAddress = GpuWaveformAddress{ GpuWaveformWideband, -1 };
+    ds->waveform = nullptr;
+    ds->rasterWaveform = nullptr;
+    ds->stimFlagsWaveform = nullptr;
+
+    if (ds->isRaster) {
+        ds->rasterWaveform = waveformFifo->getDigitalWaveformPointer(ds->name);
+    } else {
+        ds->gpuWaveformAddress = waveformFifo->getGpuWaveformAddress(ds->name);
+        if (ds->gpuWaveformAddress.waveformIndex < 0) {
+            ds->waveform = waveformFifo->getAnalogWaveformPointer(ds->name);
+        }
+        if (ds->hasStimFlags) {
+            ds->stimFlagsWaveform = waveformFifo->getDigitalWaveformPointer(ds->name.substr(0, ds->name.find('|')) + "|STIM");
+        }
+    }
+    ds->resolvedFifo = waveformFifo;
+    ds->resolvedAllocationCount = waveformFifo->getAllocationCount();
+}
+
+// Bring ds up to date and make room for the newest display segment.  Marks ds as loaded; returns false (doing nothing)
+// if it was already loaded since the last call to prepForLoadingNewData().
+bool WaveformDisplayManager::prepForNewSegment(const WaveformFifo* waveformFifo, WaveformDisplayDataStore* ds) const
+{
+    if (ds->hasAlreadyLoaded) return false;   // Don't load the same data twice.
+    ds->hasAlreadyLoaded = true;
+
+    resolveFifoAddresses(waveformFifo, ds);
 
     if (ds->isOutOfDate) {  // If display data is out of date, load old data from waveform FIFO to catch up.
         int displayStartPos, displayEndPos, startTime;
@@ -221,12 +331,12 @@ void WaveformDisplayManager::loadNewData(const WaveformFifo* waveformFifo, const
             } else {
                 startTime = -(displayEndPos - displayStartPos);
             }
-            loadDataSegment(waveformFifo, waveName, ds, displayStartPos, displayEndPos, startTime);
+            loadDataSegment(waveformFifo, ds, displayStartPos, displayEndPos, startTime);
         } else {  // Sweep mode
             displayStartPos = 0;
             displayEndPos = std::max(0, validDataIndex - zoneLength);
             startTime = -displayEndPos * samplesPerZone / zoneWidthInPixels;
-            loadDataSegment(waveformFifo, waveName, ds, displayStartPos, displayEndPos, startTime);
+            loadDataSegment(waveformFifo, ds, displayStartPos, displayEndPos, startTime);
             if (!sweepFirstTime) {
                 displayStartPos = displayEndPos;
                 displayEndPos = length;
@@ -235,7 +345,7 @@ void WaveformDisplayManager::loadNewData(const WaveformFifo* waveformFifo, const
                 } else {
                     startTime -= (displayEndPos - displayStartPos);
                 }
-                loadDataSegment(waveformFifo, waveName, ds, displayStartPos, displayEndPos, startTime);
+                loadDataSegment(waveformFifo, ds, displayStartPos, displayEndPos, startTime);
             }
         }
         ds->isOutOfDate = false;
@@ -268,14 +378,19 @@ void WaveformDisplayManager::loadNewData(const WaveformFifo* waveformFifo, const
                 }
             }
         }
-
-        // Now, load new data.
-        loadDataSegment(waveformFifo, waveName, ds, length - zoneLength, length, 0);
-    } else {  // Sweep mode
-        // Load new data.
-        loadDataSegment(waveformFifo, waveName, ds, validDataIndex - zoneLength, validDataIndex, 0);
     }
-    ds->hasAlreadyLoaded = true;
+    return true;
+}
+
+// Display position range where the newest zone of data is loaded.
+int WaveformDisplayManager::newSegmentStartPos() const
+{
+    return state->rollMode->getValue() ? length - zoneLength : validDataIndex - zoneLength;
+}
+
+int WaveformDisplayManager::newSegmentEndPos() const
+{
+    return state->rollMode->getValue() ? length : validDataIndex;
 }
 
 void WaveformDisplayManager::loadOldData(const WaveformFifo* waveformFifo, const QString& waveName, int startTime) const
@@ -291,7 +406,8 @@ void WaveformDisplayManager::loadOldData(const WaveformFifo* waveformFifo, const
     if (ds->hasAlreadyLoaded) return;   // Don't load the same data twice.
 
 
-    loadDataSegment(waveformFifo, waveName, ds, 0, validDataIndex, startTime);
+    resolveFifoAddresses(waveformFifo, ds);
+    loadDataSegment(waveformFifo, ds, 0, validDataIndex, startTime);
     ds->isOutOfDate = false;
     ds->hasAlreadyLoaded = true;
 }
@@ -354,9 +470,9 @@ void WaveformDisplayManager::getMinMaxData(MinMax<float> &init, QVector<double>
     }
 }
 
-void WaveformDisplayManager::loadDataSegment(const WaveformFifo* waveformFifo, const QString& waveName,
-                                             WaveformDisplayDataStore* ds, int displayStartPos, int displayEndPos,
-                                             int startTime) const
+// Note: resolveFifoAddresses() must be called on ds before calling this method.
+void WaveformDisplayManager::loadDataSegment(const WaveformFifo* waveformFifo, WaveformDisplayDataStore* ds,
+                                             int displayStartPos, int displayEndPos, int startTime) const
 {
     int displaySpan = displayEndPos - displayStartPos;
     // Note: displaySpan should be an integer multiple of zoneWidthInPixels if useVerticalLines is true.
@@ -364,25 +480,11 @@ void WaveformDisplayManager::loadDataSegment(const WaveformFifo* waveformFifo, c
 
     if (displaySpan == 0) return;
 
-    bool gpuMode = false;
-    GpuWaveformAddress gpuWaveformAddress;
-    float* waveform = nullptr;
-    uint16_t* rasterData = nullptr;
-    uint16_t* stimFlags = nullptr;
-
-    if (ds->isRaster) {
-        rasterData = waveformFifo->getDigitalWaveformPointer(waveName.toStdString());
-    } else {
-        gpuWaveformAddress = waveformFifo->getGpuWaveformAddress(waveName.toStdString());
-        if (gpuWaveformAddress.waveformIndex >= 0) {
-            gpuMode = true;
-        } else {
-            waveform = waveformFifo->getAnalogWaveformPointer(waveName.toStdString());
-        }
-        if (ds->hasStimFlags) {
-            stimFlags = waveformFifo->getDigitalWaveformPointer(waveName.section('|', 0, 0).toStdString() + "|STIM");
-        }
-    }
+    GpuWaveformAddress gpuWaveformAddress = ds->gpuWaveformAddress;
+    bool gpuMode = !ds->isRaster && gpuWaveformAddress.waveformIndex >= 0;
+    const float* waveform = ds->waveform;
+    const uint16_t* rasterData = ds->rasterWaveform;
+    const uint16_t* stimFlags = ds->stimFlagsWaveform;
 
     if (useVerticalLines) {  // Samples per pixel > 1
         int sampleSpan = (displaySpan / zoneWidthInPixels) * samplesPerZone;
@@ -445,6 +547,70 @@ void WaveformDisplayManager::loadDataSegment(const WaveformFifo* waveformFifo, c
     }
 }
 
+// Load the same display segment (new data only, startTime = 0) for all GPU-processed waveforms in batchStores, which must
+// share a single filter type.  Per-pixel min/max comes from one min/max pyramid query per pixel for all channels (the same
+// decimation path loadDataSegment() uses); at one sample per pixel or less, raw samples are copied in one interleaved pass.
+void WaveformDisplayManager::loadGpuDataSegmentBatch(const WaveformFifo* waveformFifo, int displayStartPos, int displayEndPos) const
+{
+    int displaySpan = displayEndPos - displayStartPos;
+    if (displaySpan <= 0) return;
+
+    const int numWaveforms = (int) batchStores.size();
+
+    if (useVerticalLines) {  // Samples per pixel > 1
+        int sampleSpan = (displaySpan / zoneWidthInPixels) * samplesPerZone;
+        batchWaveformIndices.resize(numWaveforms);
+        for (int j = 0; j < numWaveforms; ++j) {
+            batchWaveformIndices[j] = batchAddresses[j].waveformIndex;
+        }
+        batchMinMax.resize(numWaveforms);
+        int pixelsToGo = displaySpan;
+        int samplesToGo = sampleSpan;
+        int timeIndex = 0;
+
+        for (int x = displayStartPos; x < displayEndPos; ++x) {
+            int samples = round((double)samplesToGo / (double)pixelsToGo);
+            for (int j = 0; j < numWaveforms; ++j) {
+                batchMinMax[j].reset();
+            }
+            waveformFifo->getMinMaxGpuAmplifierDataArrayRaw(batchMinMax.data(), WaveformFifo::ReaderDisplay,
+                                                            batchAddresses[0].waveformType, batchWaveformIndices, timeIndex, samples);
+
+            // Continue each waveform from its previous pixel (see loadDataSegment()) so vertical lines stay connected.
+            int lastIndex = x - 1;
+            if (lastIndex < 0) lastIndex = length - 1;
+            bool continueLine = x > displayStartPos || oldDataPresent;
+            for (int j = 0; j < numWaveforms; ++j) {
+                WaveformDisplayDataStore* ds = batchStores[j];
+                MinMax<float> y;
+                if (continueLine) {
+                    y = ds->yMinMaxData[lastIndex];
+                    y.swap();
+                }
+                if (samples > 0) {
+                    y.update(0.195F * ((float)batchMinMax[j].minVal - 32768.0F));
+                    y.update(0.195F * ((float)batchMinMax[j].maxVal - 32768.0F));
+                }
+                ds->yMinMaxData[x] = y;
+            }
+            timeIndex += samples;
+            samplesToGo -= samples;
+            --pixelsToGo;
+        }
+    } else {  // Samples per pixel <= 1
+        int sampleSpan = displaySpan;
+        batchRawData.resize((size_t) sampleSpan * numWaveforms);
+        waveformFifo->copyGpuAmplifierDataArrayRaw(WaveformFifo::ReaderDisplay, batchRawData.data(), batchAddresses, 0, sampleSpan);
+        const uint16_t* pRead = batchRawData.data();
+        for (int i = 0; i < sampleSpan; ++i) {
+            for (int j = 0; j < numWaveforms; ++j) {
+                batchStores[j]->yData[displayStartPos + i] = 0.195F * ((float)pRead[j] - 32768.0F);
+            }
+            pRead += numWaveforms;
+        }
+    }
+}
+
 float WaveformDisplayManager::getYScaleFactor(const QString& waveName) const
 {
     std::map<std::string, WaveformDisplayDataStore*>::const_iterator it = data.find(waveName.toStdString());
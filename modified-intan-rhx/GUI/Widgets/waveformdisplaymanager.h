@@ -31,8 +31,10 @@
 #ifndef WAVEFORMDISPLAYMANAGER_H
 #define WAVEFORMDISPLAYMANAGER_H
 
+#include <array>
 #include <map>
 #include <string>
+#include <vector>
 #include "minmax.h"
 #include "waveformfifo.h"
 #include "systemstate.h"
@@ -78,16 +80,33 @@ public:
     WaveformDisplayDataStore() :
         hasStimFlags(false),
         isRaster(false),
-        yScaleType(UnknownYScale)
+        yScaleType(UnknownYScale),
+        hasAlreadyLoaded(false),
+        isOutOfDate(false),
+        resolvedFifo(nullptr),
+        resolvedAllocationCount(-1),
+        gpuWaveformAddress{ GpuWaveformWideband, -1 },
+        waveform(nullptr),
+        rasterWaveform(nullptr),
+        stimFlagsWaveform(nullptr)
     {}
 
     // Internal state
+    std::string name;
     bool hasStimFlags;
     bool isRaster;
     YScaleType yScaleType;
     bool hasAlreadyLoaded;
     bool isOutOfDate;
 
+    // Waveform FIFO locations of this waveform, looked up by name once per FIFO allocation
+    const WaveformFifo* resolvedFifo;
+    int resolvedAllocationCount;
+    GpuWaveformAddress gpuWaveformAddress;
+    float* waveform;
+    uint16_t* rasterWaveform;
+    uint16_t* stimFlagsWaveform;
+
     // Data stores: raw y coordinates in sequence
     std::vector<MinMax<float> > yMinMaxData;
     std::vector<float> yData;
@@ -107,7 +126,7 @@ public:
 
     bool addWaveform(const QString& waveName, bool isStim = false, bool isRaster = false);  // Return false if waveName is already in waveform list.
     bool removeWaveform(const QString& waveName);  // Returns false if waveName is not in waveform list.
-    inline void removeAllWaveforms() { data.clear(); }
+    void removeAllWaveforms();
 
     inline void setMaxWidthInPixels(int maxWidthInPixels_) { maxWidthInPixels = maxWidthInPixels_; calculateParameters(); }
     inline void setTScaleInMsec(int tScaleInMsec_, int numRefreshZones_ = 1) { tScaleInMsec = tScaleInMsec_;
@@ -119,10 +138,13 @@ public:
     void prepForLoadingOldData(int startTime);
     void prepForLoadingDataDirect();
     void loadNewData(const WaveformFifo* waveformFifo, const QString& waveName) const;
+    void loadNewAmplifierData(const WaveformFifo* waveformFifo, const std::vector<int>& amplifierIndices) const;
     void loadOldData(const WaveformFifo* waveformFifo, const QString& waveName, int startTime) const;
     void loadDataDirect(QVector<double> &ampData, const QString& waveName);
     YScaleUsed finishLoading();
 
+    int amplifierIndex(const Channel* channel) const;  // Returns -1 if channel is not an amplifier channel.
+
     float getYScaleFactor(YScaleType yScaleType) const;
     float getYScaleFactor(const QString& waveName) const;
 
@@ -180,6 +202,24 @@ private:
     // Waveform data mapped to waveform name
     std::map<std::string, WaveformDisplayDataStore*> data;
 
+    // Amplifier waveform data indexed by GPU waveform index (stream * channels per stream + chip channel), then by filter
+    enum AmplifierFilter {
+        AmplifierWide = 0,
+        AmplifierLow,
+        AmplifierHigh,
+        AmplifierSpike,
+        AmplifierDC,
+        NumAmplifierFilters
+    };
+    std::vector<std::array<WaveformDisplayDataStore*, NumAmplifierFilters> > amplifierData;
+
+    // Scratch space reused by loadNewAmplifierData()
+    mutable std::vector<WaveformDisplayDataStore*> batchStores;
+    mutable std::vector<GpuWaveformAddress> batchAddresses;
+    mutable std::vector<int> batchWaveformIndices;
+    mutable std::vector<uint16_t> batchRawData;
+    mutable std::vector<MinMax<uint16_t> > batchMinMax;
+
     const QColor StimColor = QColor(255, 155, 155);
     const QColor ComplianceLimitColor = QColor(255, 0, 0);
     const QColor AmpSettleColor = QColor(255, 255, 215);
@@ -191,8 +231,14 @@ private:
 
     void getMinMaxData(MinMax<float> &init, QVector<double> &ampData, int timeIndex, int samples) const;
 
-    void loadDataSegment(const WaveformFifo* waveformFifo, const QString& waveName,  WaveformDisplayDataStore* ds,
+    void resolveFifoAddresses(const WaveformFifo* waveformFifo, WaveformDisplayDataStore* ds) const;
+    bool prepForNewSegment(const WaveformFifo* waveformFifo, WaveformDisplayDataStore* ds) const;
+    int newSegmentStartPos() const;
+    int newSegmentEndPos() const;
+    void loadDataSegment(const WaveformFifo* waveformFifo, WaveformDisplayDataStore* ds,
                          int displayStartPos, int displayEndPos, int startTime) const;
+    void loadGpuDataSegmentBatch(const WaveformFifo* waveformFifo, int displayStartPos, int displayEndPos) const;
+    void setAmplifierData(const QString& waveName, WaveformDisplayDataStore* ds);
 
     void loadDataSegmentDirect(QVector<double> &ampData, WaveformDisplayDataStore* ds);
     void reset(WaveformDisplayDataStore* ds);
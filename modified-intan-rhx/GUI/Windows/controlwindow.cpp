@@ -131,6 +131,7 @@ ControlWindow::ControlWindow(SystemState* state_, CommandParser* parser_, Contro
     timeLabel(nullptr),
     topStatusLabel(nullptr),
     statusBarLabel(nullptr),
+    usbGlitchLabel(nullptr),
     statusBars(nullptr),
     controlPanel(nullptr),
     multiColumnDisplay(nullptr),
@@ -793,6 +794,10 @@ void ControlWindow::createStatusBar()
 {
     statusBarLabel = new QLabel(tr(""));
     statusBar()->addWidget(statusBarLabel, 1);
+    usbGlitchLabel = new QLabel(tr(""));
+    usbGlitchLabel->setToolTip(tr("Number of times the USB data stream lost frame alignment and was resynchronized "
+                                  "since the controller was last started"));
+    statusBar()->addPermanentWidget(usbGlitchLabel);
     statusBar()->setSizeGripEnabled(false); // Fixed window size
 }
 
@@ -2256,3 +2261,13 @@ void ControlWindow::updateHardwareFifoStatus(double percentFull)
 
     if (statusBars) statusBars->updateBars(percentFull, swBuffer, cpuLoad);
 }
+
+void ControlWindow::updateUsbGlitchCount(int numGlitchesRecovered)
+{
+    if (!usbGlitchLabel) return;
+    if (numGlitchesRecovered == 0) {
+        usbGlitchLabel->setText("");
+    } else {
+        usbGlitchLabel->setText(tr("USB glitches recovered: ") + QString::number(numGlitchesRecovered));
+    }
+}
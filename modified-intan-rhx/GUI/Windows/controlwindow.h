@@ -112,6 +112,7 @@ public slots:
     void renameChannel();
     void setReference();
     void updateHardwareFifoStatus(double percentFull);
+    void updateUsbGlitchCount(int numGlitchesRecovered);
     void updateMainCpuLoad(double percent) { mainCpuLoad = percent; }
     void hideControlPanel();
 
@@ -303,6 +304,7 @@ private:
     QLabel *timeLabel;
     QLabel *topStatusLabel;
     QLabel *statusBarLabel;
+    QLabel *usbGlitchLabel;
     QString queuedErrorMessage;
 
     StatusBars* statusBars;
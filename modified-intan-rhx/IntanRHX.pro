@@ -51,6 +51,7 @@ SOURCES += main.cpp \
     Engine/Processing/XPUInterfaces/gpuinterface.cpp \
     Engine/Processing/XPUInterfaces/xpucontroller.cpp \
     Engine/Processing/channel.cpp \
+    Engine/Processing/channelstatistics.cpp \
     Engine/Processing/commandparser.cpp \
     Engine/Processing/controllerinterface.cpp \
     Engine/Processing/datastreamfifo.cpp \
@@ -61,12 +62,14 @@ SOURCES += main.cpp \
     Engine/Processing/rhxdatareader.cpp \
     Engine/Processing/signalsources.cpp \
     Engine/Processing/softwarereferenceprocessor.cpp \
+    Engine/Processing/spectrogramengine.cpp \
     Engine/Processing/stateitem.cpp \
     Engine/Processing/stimparameters.cpp \
     Engine/Processing/stimparametersclipboard.cpp \
     Engine/Processing/systemstate.cpp \
     Engine/Processing/tcpcommunicator.cpp \
     Engine/Processing/waveformfifo.cpp \
+    Engine/Processing/waveformstreamserver.cpp \
     Engine/Processing/impedancereader.cpp \
     Engine/Processing/xmlinterface.cpp \
     Engine/Threads/audiothread.cpp \
@@ -168,6 +171,7 @@ HEADERS += \
     Engine/Processing/XPUInterfaces/gpuinterface.h \
     Engine/Processing/XPUInterfaces/xpucontroller.h \
     Engine/Processing/channel.h \
+    Engine/Processing/channelstatistics.h \
     Engine/Processing/commandparser.h \
     Engine/Processing/controllerinterface.h \
     Engine/Processing/datastreamfifo.h \
@@ -176,17 +180,21 @@ HEADERS += \
     Engine/Processing/filter.h \
     Engine/Processing/matfilewriter.h \
     Engine/Processing/minmax.h \
+    Engine/Processing/minmaxpyramid.h \
     Engine/Processing/probemapdatastructures.h \
     Engine/Processing/rhxdatareader.h \
     Engine/Processing/semaphore.h \
     Engine/Processing/signalsources.h \
     Engine/Processing/softwarereferenceprocessor.h \
+    Engine/Processing/spectrogramengine.h \
     Engine/Processing/stateitem.h \
     Engine/Processing/stimparameters.h \
     Engine/Processing/stimparametersclipboard.h \
+    Engine/Processing/streamsubscription.h \
     Engine/Processing/systemstate.h \
     Engine/Processing/tcpcommunicator.h \
     Engine/Processing/waveformfifo.h \
+    Engine/Processing/waveformstreamserver.h \
     Engine/Processing/impedancereader.h \
     Engine/Processing/xmlinterface.h \
     Engine/Threads/audiothread.h \
@@ -0,0 +1,106 @@
+//------------------------------------------------------------------------------
+//
+//  Intan Technologies RHX Data Acquisition Software
+//  Version 3.4.0
+//
+//  Copyright (c) 2020-2025 Intan Technologies
+//
+//  This file is part of the Intan Technologies RHX Data Acquisition Software.
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published
+//  by the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//  This software is provided 'as-is', without any express or implied warranty.
+//  In no event will the authors be held liable for any damages arising from
+//  the use of this software.
+//
+//  See <http://www.intantech.com> for documentation and product information.
+//
+//------------------------------------------------------------------------------
+
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include "fastfouriertransform.h"
+
+// Times the original static realInputFft() against the planned realFft() and realFftBatch() at each FFT size the
+// spectrogram can use, and checks that both produce the same spectrum.
+
+namespace {
+
+const int NumChannels = 32;
+
+double microsecondsPerTransform(std::chrono::steady_clock::time_point start, int numTransforms)
+{
+    std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count() / (double) numTransforms;
+}
+
+}
+
+int main()
+{
+    printf("%6s %14s %14s %14s %10s %12s\n", "points", "original (us)", "planned (us)", "batch32 (us)", "speedup", "max error");
+
+    for (unsigned int length = 256; length <= 8192; length <<= 1) {
+        FastFourierTransform fft(20000.0F, length);
+
+        std::vector<float> input((size_t) length * NumChannels);
+        for (size_t i = 0; i < input.size(); ++i) {
+            input[i] = (float) rand() / (float) RAND_MAX - 0.5F;
+        }
+        std::vector<float> work(input.size());
+        std::vector<float> reference(input.size());
+
+        // Enough repetitions for roughly 64M points per method.
+        int repetitions = std::max(1, (int) ((64u << 20) / (length * NumChannels)));
+
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        for (int r = 0; r < repetitions; ++r) {
+            work = input;
+            for (int c = 0; c < NumChannels; ++c) {
+                FastFourierTransform::realInputFft(&work[(size_t) c * length], length);
+            }
+        }
+        double original = microsecondsPerTransform(start, repetitions * NumChannels);
+        reference = work;
+
+        start = std::chrono::steady_clock::now();
+        for (int r = 0; r < repetitions; ++r) {
+            work = input;
+            for (int c = 0; c < NumChannels; ++c) {
+                fft.realFft(&work[(size_t) c * length]);
+            }
+        }
+        double planned = microsecondsPerTransform(start, repetitions * NumChannels);
+
+        float maxError = 0.0F;
+        for (size_t i = 0; i < work.size(); ++i) {
+            maxError = std::max(maxError, std::fabs(work[i] - reference[i]));
+        }
+
+        start = std::chrono::steady_clock::now();
+        for (int r = 0; r < repetitions; ++r) {
+            work = input;
+            fft.realFftBatch(work.data(), NumChannels);
+        }
+        double batch = microsecondsPerTransform(start, repetitions * NumChannels);
+
+        printf("%6u %14.2f %14.2f %14.2f %9.2fx %12.3g\n", length, original, planned, batch, original / planned, maxError);
+    }
+    return 0;
+}
@@ -0,0 +1,16 @@
+# Console benchmark comparing FastFourierTransform::realInputFft() with the planned realFft() / realFftBatch().
+# Build with:  qmake fftbenchmark.pro && make && ./fftbenchmark
+
+QT -= gui
+CONFIG += c++17 console release
+CONFIG -= app_bundle
+
+TARGET = fftbenchmark
+
+INCLUDEPATH += ../Engine/Processing \
+               ../Engine/API/Hardware
+
+SOURCES += fftbenchmark.cpp \
+           ../Engine/Processing/fastfouriertransform.cpp
+
+HEADERS += ../Engine/Processing/fastfouriertransform.h
@@ -0,0 +1,43 @@
+#include "../Engine/Processing/streamsubscription.h"
+#include <iostream>
+#include <vector>
+
+static int failures = 0;
+
+static void check(bool condition, const char* description) {
+    std::cout << (condition ? "  PASS " : "  FAIL ") << description << std::endl;
+    if (!condition) ++failures;
+}
+
+int main() {
+    std::cout << "=== Waveform Stream Subscription Mask Test ===" << std::endl;
+
+    // Short all-ones mask: one byte covers channels 0-7 only, not all 64
+    uint8_t shortMask[] = { 0xFF };
+    std::vector<int> channels = channelsFromSubscriptionMask(shortMask, sizeof(shortMask));
+    check(channels.size() == 8 && channels.front() == 0 && channels.back() == 7, "0xFF selects channels 0-7");
+    check(!selectsAllChannels(channels, 64), "0xFF with 64 channels is an explicit list");
+    check(selectsAllChannels(channels, 8), "0xFF with 8 channels selects all");
+
+    // Full mask covering every channel
+    std::vector<uint8_t> fullMask(8, 0xFF);
+    channels = channelsFromSubscriptionMask(fullMask.data(), (uint32_t) fullMask.size());
+    check(selectsAllChannels(channels, 64), "64-bit all-ones mask with 64 channels selects all");
+
+    // Full-length mask with one channel missing
+    fullMask[3] = 0xFE;
+    channels = channelsFromSubscriptionMask(fullMask.data(), (uint32_t) fullMask.size());
+    check(channels.size() == 63 && !selectsAllChannels(channels, 64), "64-bit mask without channel 24 is an explicit list");
+
+    // Mask longer than the channel count, with every present channel set
+    uint8_t longMask[] = { 0xFF, 0x0F };
+    channels = channelsFromSubscriptionMask(longMask, sizeof(longMask));
+    check(selectsAllChannels(channels, 8), "12-bit mask with 8 channels selects all");
+
+    // Empty mask selects nothing
+    channels = channelsFromSubscriptionMask(nullptr, 0);
+    check(channels.empty() && !selectsAllChannels(channels, 64), "empty mask selects no channels");
+
+    std::cout << (failures == 0 ? "All tests passed" : "Some tests FAILED") << std::endl;
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,177 @@
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// What a full queue does with the next push
+enum OverflowPolicy {
+    OverflowBlock,        // wait for the consumer (backpressure propagates upstream)
+    OverflowDropNewest    // reject the new item and count it as dropped
+};
+
+// Counters of one edge of the stage graph, readable from any thread while the graph runs
+struct EdgeStats {
+    std::string name;
+    size_t capacity = 0;
+    size_t depth = 0;          // items queued right now
+    size_t maxDepth = 0;       // high-water mark
+    uint64_t pushed = 0;
+    uint64_t popped = 0;
+    uint64_t dropped = 0;      // OverflowDropNewest rejections, pushes after close(), and addDropped()
+    uint64_t blockedNs = 0;    // producer time spent waiting on a full queue (OverflowBlock)
+};
+
+// Untyped part of SpscQueue, so the graph can list and report its edges
+class QueueBase {
+public:
+    virtual ~QueueBase() {}
+    virtual EdgeStats stats() const = 0;
+    virtual void close() = 0;
+};
+
+// Bounded single-producer/single-consumer ring. push() and pop() are lock-free while the queue is neither
+// full nor empty; a side that has to wait parks on a condition variable, and the other side only takes the
+// lock when it sees a parked waiter. close() wakes both sides: pop() then drains what is left and returns
+// false, push() returns false.
+template <typename T>
+class SpscQueue : public QueueBase {
+public:
+    SpscQueue(const std::string& name, size_t capacity, OverflowPolicy policy = OverflowBlock)
+        : name_(name), policy_(policy), head_(0), tail_(0), closed_(false), consumerWaiting_(false),
+          producerWaiting_(false), maxDepth_(0), pushed_(0), popped_(0), dropped_(0), blockedNs_(0) {
+        size_t size = 2;
+        while (size < capacity) size <<= 1;
+        slots_.resize(size);
+        mask_ = size - 1;
+        capacity_ = capacity < 1 ? 1 : capacity;
+    }
+
+    bool push(T&& item) {
+        uint64_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - head_.load(std::memory_order_acquire) >= capacity_) {
+            if (policy_ == OverflowDropNewest) {
+                dropped_.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+            auto start = std::chrono::steady_clock::now();
+            std::unique_lock<std::mutex> lock(mutex_);
+            producerWaiting_ = true;
+            while (!closed_ && tail - head_.load() >= capacity_) {
+                notFull_.wait_for(lock, std::chrono::milliseconds(10));
+            }
+            producerWaiting_ = false;
+            blockedNs_.fetch_add((uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                     std::chrono::steady_clock::now() - start).count(), std::memory_order_relaxed);
+        }
+        if (closed_) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        slots_[tail & mask_] = std::move(item);
+        tail_.store(tail + 1);
+        uint64_t depth = tail + 1 - head_.load(std::memory_order_relaxed);
+        if (depth > maxDepth_.load(std::memory_order_relaxed)) maxDepth_.store(depth, std::memory_order_relaxed);
+        pushed_.fetch_add(1, std::memory_order_relaxed);
+        if (consumerWaiting_.load()) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            notEmpty_.notify_one();
+        }
+        return true;
+    }
+
+    bool pop(T& item) {
+        uint64_t head = head_.load(std::memory_order_relaxed);
+        if (head == tail_.load(std::memory_order_acquire)) {
+            std::unique_lock<std::mutex> lock(mutex_);
+            consumerWaiting_ = true;
+            while (head == tail_.load() && !closed_) {
+                notEmpty_.wait_for(lock, std::chrono::milliseconds(10));
+            }
+            consumerWaiting_ = false;
+            if (head == tail_.load()) {
+                return false;   // closed and drained
+            }
+        }
+        item = std::move(slots_[head & mask_]);
+        head_.store(head + 1);
+        popped_.fetch_add(1, std::memory_order_relaxed);
+        if (producerWaiting_.load()) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            notFull_.notify_one();
+        }
+        return true;
+    }
+
+    // Non-blocking pop: false if nothing is queued right now
+    bool tryPop(T& item) {
+        uint64_t head = head_.load(std::memory_order_relaxed);
+        if (head == tail_.load(std::memory_order_acquire)) {
+            return false;
+        }
+        item = std::move(slots_[head & mask_]);
+        head_.store(head + 1);
+        popped_.fetch_add(1, std::memory_order_relaxed);
+        if (producerWaiting_.load()) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            notFull_.notify_one();
+        }
+        return true;
+    }
+
+    // Count items the producer lost before they reached this edge (e.g. a source that missed frames upstream)
+    void addDropped(uint64_t count) {
+        dropped_.fetch_add(count, std::memory_order_relaxed);
+    }
+
+    void close() override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        closed_ = true;
+        notEmpty_.notify_all();
+        notFull_.notify_all();
+    }
+
+    EdgeStats stats() const override {
+        EdgeStats s;
+        s.name = name_;
+        s.capacity = capacity_;
+        s.depth = (size_t)(tail_.load() - head_.load());
+        s.maxDepth = (size_t)maxDepth_.load(std::memory_order_relaxed);
+        s.pushed = pushed_.load(std::memory_order_relaxed);
+        s.popped = popped_.load(std::memory_order_relaxed);
+        s.dropped = dropped_.load(std::memory_order_relaxed);
+        s.blockedNs = blockedNs_.load(std::memory_order_relaxed);
+        return s;
+    }
+
+private:
+    std::string name_;
+    OverflowPolicy policy_;
+    std::vector<T> slots_;
+    size_t mask_;
+    size_t capacity_;
+
+    // Producer and consumer indices on separate cache lines; both only ever increase
+    alignas(64) std::atomic<uint64_t> head_;
+    alignas(64) std::atomic<uint64_t> tail_;
+    alignas(64) std::atomic<bool> closed_;
+    std::atomic<bool> consumerWaiting_;
+    std::atomic<bool> producerWaiting_;
+    std::mutex mutex_;
+    std::condition_variable notEmpty_;
+    std::condition_variable notFull_;
+
+    std::atomic<uint64_t> maxDepth_;
+    std::atomic<uint64_t> pushed_;
+    std::atomic<uint64_t> popped_;
+    std::atomic<uint64_t> dropped_;
+    std::atomic<uint64_t> blockedNs_;
+};
+
+#endif // SPSC_QUEUE_H
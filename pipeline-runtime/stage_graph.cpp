@@ -0,0 +1,117 @@
+#include "stage_graph.h"
+#include "../intan-reader/latency_trace.h"
+#include <iomanip>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#elif defined(__APPLE__)
+#include <mach/mach.h>
+#include <mach/thread_policy.h>
+#endif
+
+bool pinCurrentThread(int cpu) {
+    if (cpu < 0) {
+        return false;
+    }
+#if defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#elif defined(__APPLE__)
+    // macOS has no hard affinity; threads with different tags are spread over different cores
+    thread_affinity_policy_data_t policy = { cpu + 1 };
+    return thread_policy_set(mach_thread_self(), THREAD_AFFINITY_POLICY, (thread_policy_t)&policy,
+                             THREAD_AFFINITY_POLICY_COUNT) == KERN_SUCCESS;
+#else
+    return false;
+#endif
+}
+
+StageGraph::StageGraph() : stopping_(false), activeStages_(0), startTimeNs_(0) {
+}
+
+StageGraph::~StageGraph() {
+    stop();
+    join();
+}
+
+StageGraph::Stage* StageGraph::addStage(const std::string& name, const StageOptions& options) {
+    std::unique_ptr<Stage> stage(new Stage());
+    stage->name = name;
+    stage->options = options;
+    stages_.push_back(std::move(stage));
+    return stages_.back().get();
+}
+
+void StageGraph::start() {
+    stopping_ = false;
+    startTimeNs_ = traceNowNs();
+    activeStages_ = (int)stages_.size();
+    for (auto& stage : stages_) {
+        stage->thread = std::thread(&StageGraph::runStage, this, stage.get());
+    }
+}
+
+void StageGraph::runStage(Stage* stage) {
+    if (stage->options.cpu >= 0 && !pinCurrentThread(stage->options.cpu)) {
+        std::cerr << "Warning: could not pin stage " << stage->name << " to CPU " << stage->options.cpu << std::endl;
+    }
+    stage->body();
+    if (stage->options.onFinish) {
+        stage->options.onFinish();
+    }
+    --activeStages_;
+}
+
+void StageGraph::join() {
+    for (auto& stage : stages_) {
+        if (stage->thread.joinable()) {
+            stage->thread.join();
+        }
+    }
+}
+
+std::vector<StageStats> StageGraph::stageStats() const {
+    std::vector<StageStats> stats;
+    for (const auto& stage : stages_) {
+        StageStats s;
+        s.name = stage->name;
+        s.cpu = stage->options.cpu;
+        s.calls = stage->calls;
+        s.emitted = stage->emitted;
+        s.busyNs = stage->busyNs;
+        stats.push_back(s);
+    }
+    return stats;
+}
+
+std::vector<EdgeStats> StageGraph::edgeStats() const {
+    std::vector<EdgeStats> stats;
+    for (const auto& queue : queues_) {
+        stats.push_back(queue->stats());
+    }
+    return stats;
+}
+
+void StageGraph::printStats(std::ostream& out) const {
+    double elapsedS = startTimeNs_ > 0 ? (traceNowNs() - startTimeNs_) / 1e9 : 0.0;
+    std::ios::fmtflags flags = out.flags();
+    out << std::fixed << std::setprecision(1);
+    out << "Stage graph (" << elapsedS << " s):" << std::endl;
+    for (const StageStats& s : stageStats()) {
+        double busy = elapsedS > 0 ? 100.0 * s.busyNs / 1e9 / elapsedS : 0.0;
+        out << "  stage " << std::left << std::setw(10) << s.name << std::right << " calls " << std::setw(8) << s.calls
+            << "  emitted " << std::setw(8) << s.emitted << "  busy " << std::setw(5) << busy << "%";
+        if (s.cpu >= 0) out << "  cpu " << s.cpu;
+        out << std::endl;
+    }
+    for (const EdgeStats& e : edgeStats()) {
+        double rate = elapsedS > 0 ? e.pushed / elapsedS : 0.0;
+        out << "  edge  " << std::left << std::setw(18) << e.name << std::right << " depth " << e.depth << "/" << e.capacity
+            << " (max " << e.maxDepth << ")  " << rate << "/s  pushed " << e.pushed << "  dropped " << e.dropped
+            << "  blocked " << e.blockedNs / 1e6 << " ms" << std::endl;
+    }
+    out.flags(flags);
+}
@@ -0,0 +1,165 @@
+#ifndef STAGE_GRAPH_H
+#define STAGE_GRAPH_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "spsc_queue.h"
+
+// A small dataflow runtime for the pipeline: every stage runs on its own thread (optionally pinned to a
+// CPU) and stages are connected by bounded SpscQueues. A slow stage only backs up its own input edge; the
+// per-edge counters show where that happens.
+//
+// Shutdown drains front to back: stop() ends the sources, and each stage exits once its input queue is
+// closed and empty, closing its output queue in turn.
+
+// What a source or transform did with one call
+enum StageResult {
+    StageEmit,     // `out` is ready; push it downstream
+    StageSkip,     // nothing to forward this time
+    StageFinish    // the stage is done; close its output
+};
+
+struct StageOptions {
+    int cpu = -1;                         // pin the stage thread to this CPU; -1 = let the OS schedule it
+    int pollIntervalUs = 0;               // sources: sleep this long before each call (not counted as busy)
+    std::function<void()> onFinish;       // runs on the stage thread after the stage's last item
+};
+
+// Counters of one stage, readable while the graph runs
+struct StageStats {
+    std::string name;
+    int cpu = -1;
+    uint64_t calls = 0;        // invocations of the stage function
+    uint64_t emitted = 0;
+    uint64_t busyNs = 0;       // time inside the stage function
+};
+
+class StageGraph {
+public:
+    StageGraph();
+    ~StageGraph();
+
+    // Edges are owned by the graph and live as long as it does
+    template <typename T>
+    SpscQueue<T>& addQueue(const std::string& name, size_t capacity, OverflowPolicy policy = OverflowBlock) {
+        SpscQueue<T>* queue = new SpscQueue<T>(name, capacity, policy);
+        queues_.emplace_back(queue);
+        return *queue;
+    }
+
+    // Called until it returns StageFinish or the graph is stopped; a source that has nothing yet returns
+    // StageSkip and is called again after options.pollIntervalUs.
+    template <typename Out>
+    void addSource(const std::string& name, SpscQueue<Out>& out, std::function<StageResult(Out&)> produce,
+                   const StageOptions& options = StageOptions()) {
+        Stage* stage = addStage(name, options);
+        stage->body = [this, stage, &out, produce]() {
+            Out item;
+            while (!stopping_) {
+                if (stage->options.pollIntervalUs > 0) {
+                    std::this_thread::sleep_for(std::chrono::microseconds(stage->options.pollIntervalUs));
+                }
+                StageResult result = timed(stage, [&]() { return produce(item); });
+                if (result == StageEmit) {
+                    ++stage->emitted;
+                    out.push(std::move(item));
+                    item = Out();
+                } else if (result == StageFinish) {
+                    break;
+                }
+            }
+            out.close();
+        };
+    }
+
+    template <typename In, typename Out>
+    void addTransform(const std::string& name, SpscQueue<In>& in, SpscQueue<Out>& out,
+                      std::function<StageResult(In&, Out&)> transform, const StageOptions& options = StageOptions()) {
+        Stage* stage = addStage(name, options);
+        stage->body = [stage, &in, &out, transform]() {
+            In item;
+            Out result;
+            while (in.pop(item)) {
+                StageResult status = timed(stage, [&]() { return transform(item, result); });
+                if (status == StageEmit) {
+                    ++stage->emitted;
+                    out.push(std::move(result));
+                    result = Out();
+                } else if (status == StageFinish) {
+                    break;
+                }
+            }
+            in.close();
+            out.close();
+        };
+    }
+
+    template <typename In>
+    void addSink(const std::string& name, SpscQueue<In>& in, std::function<void(In&)> consume,
+                 const StageOptions& options = StageOptions()) {
+        Stage* stage = addStage(name, options);
+        stage->body = [stage, &in, consume]() {
+            In item;
+            while (in.pop(item)) {
+                timed(stage, [&]() { consume(item); return StageSkip; });
+            }
+        };
+    }
+
+    void start();
+    // Ask the sources to finish; the rest of the graph drains behind them. Safe to call from a stage.
+    void stop() { stopping_ = true; }
+    // Wait for every stage thread to exit (call after stop(), or once the sources finish on their own)
+    void join();
+    bool isStopping() const { return stopping_; }
+    // True while any stage thread is still running
+    bool isRunning() const { return activeStages_ > 0; }
+
+    std::vector<StageStats> stageStats() const;
+    std::vector<EdgeStats> edgeStats() const;
+    // Per-stage utilization and per-edge depth/throughput/drops since start()
+    void printStats(std::ostream& out) const;
+
+private:
+    struct Stage {
+        std::string name;
+        StageOptions options;
+        std::function<void()> body;
+        std::thread thread;
+        std::atomic<uint64_t> calls { 0 };
+        std::atomic<uint64_t> emitted { 0 };
+        std::atomic<uint64_t> busyNs { 0 };
+    };
+
+    std::vector<std::unique_ptr<Stage>> stages_;
+    std::vector<std::unique_ptr<QueueBase>> queues_;
+    std::atomic<bool> stopping_;
+    std::atomic<int> activeStages_;
+    uint64_t startTimeNs_;
+
+    Stage* addStage(const std::string& name, const StageOptions& options);
+    void runStage(Stage* stage);
+
+    template <typename F>
+    static StageResult timed(Stage* stage, F&& fn) {
+        auto start = std::chrono::steady_clock::now();
+        StageResult result = fn();
+        stage->busyNs += (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+                             std::chrono::steady_clock::now() - start).count();
+        ++stage->calls;
+        return result;
+    }
+};
+
+// Pin the calling thread to one CPU (Linux), or give it its own affinity tag (macOS, a scheduler hint only)
+bool pinCurrentThread(int cpu);
+
+#endif // STAGE_GRAPH_H